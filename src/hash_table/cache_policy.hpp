@@ -0,0 +1,778 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: cache_policy.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: eviction policies for LruCache: LRU, SLRU, 2Q, ARC, W-TinyLFU
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_CACHE_POLICY_HPP_
+#define GLIB_CACHE_POLICY_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint8_t uint32_t uint64_t
+#include <deque>
+#include <type_traits> // std::enable_if std::integral_constant
+#include <utility>     // std::pair
+#include <vector>
+#include "hash.hpp"
+#include "flat_hash_map.hpp"
+
+//! \brief LruCache 的淘汰策略（模板参数 _Policy），策略只管理常驻数据的顺序，数据本身由 LruCache 保存
+//!     1）LruPolicy：最近最少使用，一个链表
+//!     2）SlruPolicy：分段 LRU，新数据进入试用段（probation），再次命中后进入保护段（protected，80%）
+//!     3）TwoQueuePolicy：2Q，新数据进入先进先出的 A1in（25%），从 A1in 淘汰的键值记录在幽灵队列 A1out（50%）中，
+//!        在 A1out 中的键值再次插入时进入 LRU 队列 Am
+//!     4）ArcPolicy：自适应替换缓存，T1（只访问过一次）、T2（访问过多次）两个常驻队列和 B1、B2 两个幽灵队列，
+//!        根据幽灵队列的命中自动调整 T1 的目标大小 p
+//!     5）TinyLfuPolicy：W-TinyLFU，1% 的窗口 LRU + 99% 的分段 LRU 主区，窗口淘汰的数据只有在访问频率
+//!        （count-min sketch 估计）高于主区淘汰对象时才能进入主区
+//!
+//!     策略接口（LruCache 调用，Index 为节点下标，hash 为键值打散之后的哈希值）：
+//!         1）Resize(node_count)：节点数组大小变化，节点下标不变；set_capacity(capacity)：缓存容量变化；Clear()
+//!         2）Insert(index, hash)：新数据；Access(index, hash)：命中
+//!         3）Victim(protect, hash_of)：缓存超出容量时选择淘汰的数据，不能是刚插入的 protect，
+//!            hash_of(index) 返回节点的哈希值
+//!         4）Remove(index, hash, evicted)：数据被删除，evicted 表示是淘汰（幽灵队列只记录淘汰的数据）
+//!         5）Relocate(from, to)：节点数组缩小时数据从 from 移动到 to
+//!         6）ForEach(function)：按照策略的顺序遍历常驻数据的下标
+//!         7）memory_usage()：策略数组占用的字节数
+//!         8）可选：kConcurrentAccess 为 true 时，Access(index) 是 const 且线程安全的（多个读者可以在共享锁内
+//!            同时调用，比如 CLOCK 只设置引用位），ShardedLruCache 命中时直接调用，不经过读缓冲区
+//!
+//! \Note
+//!     1）纯 LRU 在一次性的大范围扫描（比如批处理任务遍历冷数据）之后，热点数据全部被挤出。
+//!        SLRU、2Q、ARC 要求数据被访问两次才能进入受保护的区域，TinyLFU 根据历史频率决定是否接纳新数据，
+//!        扫描只会替换试用区 / A1in / T1 / 窗口中的数据
+//!     2）所有链表都用节点下标串联，链接放在策略自己的数组中（每个数据 8 字节，多段策略再加 1 字节段号）。
+//!        幽灵队列只记录 64 位哈希值，不保存键值
+//!     3）count-min sketch：4 行 4 位计数器，共约 4 × 容量个计数器（每个数据 2 ~ 4 字节），
+//!        计数器增加的次数达到容量的 10 倍时所有计数器减半（老化），过去的热点会逐渐冷却
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \benchmark
+//!     cache_trace_replay.cc：用访问记录文件或者内置的 Zipf、Zipf + 扫描、循环序列比较各个策略的命中率
+//!
+//! \reference
+//!     1）Karedla et al., Caching strategies to improve disk system performance, 1994（SLRU）
+//!     2）Johnson, Shasha, 2Q: A low overhead high performance buffer management replacement algorithm, VLDB 1994
+//!     3）Megiddo, Modha, ARC: A self-tuning, low overhead replacement cache, FAST 2003
+//!     4）Einziger, Friedman, Manes, TinyLFU: A highly efficient cache admission policy, 2017
+
+namespace glib {
+
+namespace cache_policy_internal {
+
+using Index = uint32_t;
+const Index kNil = static_cast<Index>(-1);
+
+//! \brief 下标双链表：链接保存在外部数组 links 中，一个节点同一时间只在一个链表里
+struct Links {
+    Index prev;
+    Index next;
+};
+
+class IndexList {
+public:
+    IndexList() : head_(kNil), tail_(kNil), size_(0) {}
+
+    void PushFront(std::vector<Links> &links, Index index) {
+        links[index].prev = kNil;
+        links[index].next = head_;
+        if (kNil != head_)
+            links[head_].prev = index;
+        else
+            tail_ = index;
+        head_ = index;
+        size_++;
+    }
+
+    void Unlink(std::vector<Links> &links, Index index) {
+        const Index prev = links[index].prev, next = links[index].next;
+        if (kNil != prev)
+            links[prev].next = next;
+        else
+            head_ = next;
+        if (kNil != next)
+            links[next].prev = prev;
+        else
+            tail_ = prev;
+        size_--;
+    }
+
+    void MoveToFront(std::vector<Links> &links, Index index) {
+        if (head_ == index)
+            return;
+        Unlink(links, index);
+        PushFront(links, index);
+    }
+
+    //! \brief 节点从 from 移动到 to：复制链接，修改相邻节点和头尾
+    void Relocate(std::vector<Links> &links, Index from, Index to) {
+        links[to] = links[from];
+        if (kNil != links[to].prev)
+            links[links[to].prev].next = to;
+        else
+            head_ = to;
+        if (kNil != links[to].next)
+            links[links[to].next].prev = to;
+        else
+            tail_ = to;
+    }
+
+    //! \brief 最久的节点，跳过 protect（刚插入的数据不能被淘汰），没有时返回 kNil
+    Index BackExcept(const std::vector<Links> &links, Index protect) const {
+        return (kNil == tail_ || tail_ != protect) ? tail_ : links[tail_].prev;
+    }
+
+    template <typename _Function>
+    void ForEach(const std::vector<Links> &links, _Function function) const {
+        for (Index index = head_; kNil != index; index = links[index].next)
+            function(index);
+    }
+
+    void   Clear()        { head_ = tail_ = kNil; size_ = 0; }
+    Index  back()  const  { return tail_;                    }
+    size_t size()  const  { return size_;                    }
+    bool   empty() const  { return 0 == size_;               }
+
+private:
+    Index  head_;
+    Index  tail_;
+    size_t size_;
+};
+
+//! \brief 幽灵队列：按照插入顺序记录被淘汰数据的哈希值，用于判断一个新数据是否「最近被淘汰过」
+//! \note 删除时只从哈希表中删除，队列中的记录在弹出时跳过（每个记录带有插入序号）
+class GhostList {
+public:
+    explicit GhostList(size_t capacity = 1) : capacity_(capacity), stamp_(0) {}
+
+    bool Contains(uint64_t hash) const { return nullptr != stamps_.FindPtr(hash); }
+
+    void Erase(uint64_t hash) { stamps_.Delete(hash); }
+
+    //! \brief 记录一个哈希值，超过容量时丢弃最早的记录
+    void Push(uint64_t hash) {
+        stamps_.InsertOrAssign(hash, ++stamp_);
+        order_.push_back(std::make_pair(hash, stamp_));
+        while (stamps_.size() > capacity_)
+            PopOldest();
+        if (order_.size() > 2 * stamps_.size() + 64)
+            Compact();
+    }
+
+    //! \brief 丢弃最早的记录
+    void PopOldest() {
+        while (!order_.empty()) {
+            std::pair<uint64_t, uint64_t> oldest = order_.front();
+            order_.pop_front();
+            const uint64_t *stamp = stamps_.FindPtr(oldest.first);
+            if (nullptr != stamp && *stamp == oldest.second) {
+                stamps_.Delete(oldest.first);
+                return;
+            }
+        }
+    }
+
+    void Clear() {
+        stamps_.Clear();
+        order_.clear();
+    }
+
+    void   set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        while (stamps_.size() > capacity_)
+            PopOldest();
+    }
+    size_t size() const { return stamps_.size(); }
+
+private:
+    // 去掉队列中已经删除、重复的记录
+    void Compact() {
+        std::deque<std::pair<uint64_t, uint64_t> > live;
+        for (const auto &entry: order_) {
+            const uint64_t *stamp = stamps_.FindPtr(entry.first);
+            if (nullptr != stamp && *stamp == entry.second)
+                live.push_back(entry);
+        }
+        order_.swap(live);
+    }
+
+    size_t                                         capacity_;
+    uint64_t                                       stamp_;
+    FlatHashMap<uint64_t, uint64_t>                stamps_;    // 哈希值 -> 最近一次记录的序号
+    std::deque<std::pair<uint64_t, uint64_t> >     order_;     // 记录顺序
+};
+
+//! \brief 调整每个节点一项的数组，缩小时释放多余的内存
+template <typename _Type>
+void ResizeArray(std::vector<_Type> &array, size_t node_count) {
+    array.resize(node_count);
+    if (array.capacity() > node_count)
+        array.shrink_to_fit();
+}
+
+//! \brief 策略是否声明了 kConcurrentAccess = true
+template <typename _Policy, typename = void>
+struct HasConcurrentAccess : std::false_type {};
+
+template <typename _Policy>
+struct HasConcurrentAccess<_Policy, typename std::enable_if<_Policy::kConcurrentAccess>::type>
+    : std::true_type {};
+
+} // namespace cache_policy_internal
+
+//! \brief count-min sketch 频率估计：4 行 4 位计数器（最大 15），定期减半老化
+class FrequencySketch {
+public: // 构造函数相关
+    explicit FrequencySketch(size_t capacity = 16) { set_capacity(capacity); }
+
+public: // 外部调用核心函数
+    //! \brief 重新设置宽度（清空计数）：计数器总数为不小于 4 × capacity 的 2 的幂，老化周期为 10 倍容量
+    void set_capacity(size_t capacity) {
+        size_t words = 1;
+        while (words * kCountersPerWord < capacity * kRows)
+            words *= 2;
+        table_.assign(words, 0);
+        sample_size_ = 10 * (capacity > 0 ? capacity : 1);
+        additions_   = 0;
+    }
+
+    //! \brief 频率估计：4 个计数器中的最小值
+    unsigned Frequency(uint64_t hash) const {
+        unsigned frequency = kMaxCount;
+        for (unsigned row = 0; row < kRows; row++) {
+            unsigned count = Counter(hash, row);
+            if (count < frequency)
+                frequency = count;
+        }
+        return frequency;
+    }
+
+    //! \brief 访问一次：没有饱和的计数器加一，计数增加的次数达到老化周期时所有计数器减半
+    void Increment(uint64_t hash) {
+        bool added = false;
+        for (unsigned row = 0; row < kRows; row++) {
+            size_t word, shift;
+            Locate(hash, row, word, shift);
+            if (((table_[word] >> shift) & kMaxCount) < kMaxCount) {
+                table_[word] += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions_ >= sample_size_)
+            Age();
+    }
+
+    void Clear() {
+        table_.assign(table_.size(), 0);
+        additions_ = 0;
+    }
+
+    size_t additions()   const { return additions_;   } // 上次老化之后计数增加的次数
+    size_t sample_size() const { return sample_size_; } // 老化周期
+    size_t memory_usage() const { return table_.size() * sizeof(uint64_t); } // 计数器占用的字节数
+
+private: // helper functions
+    // 第 row 行计数器所在的字和位移：每行用不同的种子重新打散哈希值
+    void Locate(uint64_t hash, unsigned row, size_t &word, size_t &shift) const {
+        uint64_t mixed = hash::Mix64(hash + (row + 1) * kRowSeed);
+        word  = static_cast<size_t>(mixed) & (table_.size() - 1);
+        shift = static_cast<size_t>(mixed >> 60) * 4;
+    }
+
+    unsigned Counter(uint64_t hash, unsigned row) const {
+        size_t word, shift;
+        Locate(hash, row, word, shift);
+        return static_cast<unsigned>((table_[word] >> shift) & kMaxCount);
+    }
+
+    // 所有计数器减半
+    void Age() {
+        for (auto &word: table_)
+            word = (word >> 1) & 0x7777777777777777ULL;
+        additions_ /= 2;
+    }
+
+private:
+    static const unsigned kRows            = 4;
+    static const unsigned kMaxCount        = 15;
+    static const size_t   kCountersPerWord = 16;
+    static const uint64_t kRowSeed         = 0x9E3779B97F4A7C15ULL;  // 每行的种子为它的倍数
+
+    std::vector<uint64_t> table_;        // 计数器，每个字 16 个 4 位计数器
+    size_t                sample_size_;  // 老化周期
+    size_t                additions_;    // 上次老化之后计数增加的次数
+};
+
+//! \brief 最近最少使用：命中移到链表头，淘汰链表尾
+class LruPolicy {
+public:
+    using Index = cache_policy_internal::Index;
+
+    void Resize(size_t node_count)   { cache_policy_internal::ResizeArray(links_, node_count); }
+    void set_capacity(size_t)        {}
+    void Clear()                     { list_.Clear(); }
+
+    void Insert(Index index, uint64_t) { list_.PushFront(links_, index); }
+    void Access(Index index, uint64_t) { list_.MoveToFront(links_, index); }
+
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf) const { return list_.BackExcept(links_, protect); }
+
+    void Remove(Index index, uint64_t, bool)   { list_.Unlink(links_, index); }
+    void Relocate(Index from, Index to)        { list_.Relocate(links_, from, to); }
+
+    // 从最近使用到最久未使用
+    template <typename _Function>
+    void ForEach(_Function function) const { list_.ForEach(links_, function); }
+
+    // 链接数组占用的字节数
+    size_t memory_usage() const { return links_.capacity() * sizeof(cache_policy_internal::Links); }
+
+private:
+    std::vector<cache_policy_internal::Links> links_;
+    cache_policy_internal::IndexList          list_;
+};
+
+//! \brief 分段 LRU：试用段 + 保护段（容量的 80%），试用段中的数据再次命中才进入保护段，
+//!        保护段满时最久未使用的数据降级回试用段，淘汰总是先从试用段开始
+class SlruPolicy {
+public:
+    using Index = cache_policy_internal::Index;
+
+    void Resize(size_t node_count) {
+        cache_policy_internal::ResizeArray(links_, node_count);
+        cache_policy_internal::ResizeArray(segments_, node_count);
+    }
+    void set_capacity(size_t capacity) { protected_capacity_ = capacity * 4 / 5; }
+    void Clear() {
+        probation_.Clear();
+        protected_.Clear();
+    }
+
+    void Insert(Index index, uint64_t) {
+        segments_[index] = kProbation;
+        probation_.PushFront(links_, index);
+    }
+
+    void Access(Index index, uint64_t) {
+        if (kProtected == segments_[index]) {
+            protected_.MoveToFront(links_, index);
+            return;
+        }
+        probation_.Unlink(links_, index);
+        segments_[index] = kProtected;
+        protected_.PushFront(links_, index);
+        if (protected_.size() > protected_capacity_) {
+            Index demoted = protected_.back();
+            protected_.Unlink(links_, demoted);
+            segments_[demoted] = kProbation;
+            probation_.PushFront(links_, demoted);
+        }
+    }
+
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf) const {
+        Index victim = probation_.empty() ? cache_policy_internal::kNil : probation_.BackExcept(links_, protect);
+        return cache_policy_internal::kNil != victim ? victim : protected_.BackExcept(links_, protect);
+    }
+
+    void Remove(Index index, uint64_t, bool) { ListOf(index).Unlink(links_, index); }
+
+    void Relocate(Index from, Index to) {
+        segments_[to] = segments_[from];
+        ListOf(to).Relocate(links_, from, to);
+    }
+
+    // 先保护段，再试用段，各自从最近使用到最久未使用
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        protected_.ForEach(links_, function);
+        probation_.ForEach(links_, function);
+    }
+
+    // 链接数组、段号数组占用的字节数（不包括幽灵队列）
+    size_t memory_usage() const {
+        return links_.capacity() * sizeof(cache_policy_internal::Links) + segments_.capacity();
+    }
+
+private:
+    static const uint8_t kProbation = 0;
+    static const uint8_t kProtected = 1;
+
+    cache_policy_internal::IndexList& ListOf(Index index) {
+        return kProtected == segments_[index] ? protected_ : probation_;
+    }
+
+    std::vector<cache_policy_internal::Links> links_;
+    std::vector<uint8_t>                      segments_;
+    cache_policy_internal::IndexList          probation_;
+    cache_policy_internal::IndexList          protected_;
+    size_t                                    protected_capacity_ = 0;
+};
+
+//! \brief 2Q：新数据进入先进先出的 A1in（容量的 25%），在 A1in 中的命中不改变顺序（过滤短时间内的重复访问）；
+//!        从 A1in 淘汰的数据记录到幽灵队列 A1out（容量的 50%），A1out 中的键值再次插入时直接进入 LRU 队列 Am
+class TwoQueuePolicy {
+public:
+    using Index = cache_policy_internal::Index;
+
+    void Resize(size_t node_count) {
+        cache_policy_internal::ResizeArray(links_, node_count);
+        cache_policy_internal::ResizeArray(segments_, node_count);
+    }
+    void set_capacity(size_t capacity) {
+        in_capacity_ = capacity / 4 > 0 ? capacity / 4 : 1;
+        out_.set_capacity(capacity / 2 > 0 ? capacity / 2 : 1);
+    }
+    void Clear() {
+        in_.Clear();
+        main_.Clear();
+        out_.Clear();
+    }
+
+    void Insert(Index index, uint64_t hash) {
+        if (out_.Contains(hash)) {
+            out_.Erase(hash);
+            segments_[index] = kMain;
+            main_.PushFront(links_, index);
+        } else {
+            segments_[index] = kIn;
+            in_.PushFront(links_, index);
+        }
+    }
+
+    void Access(Index index, uint64_t) {
+        if (kMain == segments_[index])
+            main_.MoveToFront(links_, index);
+    }
+
+    //! \brief A1in 超过目标大小时淘汰 A1in 最早的数据，否则淘汰 Am 最久未使用的数据
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf) const {
+        Index victim = cache_policy_internal::kNil;
+        if (in_.size() > in_capacity_ || main_.empty())
+            victim = in_.BackExcept(links_, protect);
+        if (cache_policy_internal::kNil == victim && !main_.empty())
+            victim = main_.BackExcept(links_, protect);
+        if (cache_policy_internal::kNil == victim && !in_.empty())
+            victim = in_.BackExcept(links_, protect);
+        return victim;
+    }
+
+    void Remove(Index index, uint64_t hash, bool evicted) {
+        if (kIn == segments_[index]) {
+            in_.Unlink(links_, index);
+            if (evicted)
+                out_.Push(hash);
+        } else {
+            main_.Unlink(links_, index);
+        }
+    }
+
+    void Relocate(Index from, Index to) {
+        segments_[to] = segments_[from];
+        (kMain == segments_[to] ? main_ : in_).Relocate(links_, from, to);
+    }
+
+    // 先 Am（从最近使用到最久未使用），再 A1in（从新到旧）
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        main_.ForEach(links_, function);
+        in_.ForEach(links_, function);
+    }
+
+    // 链接数组、段号数组占用的字节数（不包括幽灵队列）
+    size_t memory_usage() const {
+        return links_.capacity() * sizeof(cache_policy_internal::Links) + segments_.capacity();
+    }
+
+private:
+    static const uint8_t kIn   = 0;
+    static const uint8_t kMain = 1;
+
+    std::vector<cache_policy_internal::Links> links_;
+    std::vector<uint8_t>                      segments_;
+    cache_policy_internal::IndexList          in_;        // A1in，先进先出
+    cache_policy_internal::IndexList          main_;      // Am，LRU
+    cache_policy_internal::GhostList          out_;       // A1out，幽灵队列
+    size_t                                    in_capacity_ = 1;
+};
+
+//! \brief ARC：T1 保存只访问过一次的数据，T2 保存访问过至少两次的数据，B1、B2 记录从 T1、T2 淘汰的键值。
+//!        B1 命中说明 T1 太小，p 增大；B2 命中说明 T2 太小，p 减小。淘汰时 |T1| > p 则淘汰 T1，否则淘汰 T2
+class ArcPolicy {
+public:
+    using Index = cache_policy_internal::Index;
+
+    void Resize(size_t node_count) {
+        cache_policy_internal::ResizeArray(links_, node_count);
+        cache_policy_internal::ResizeArray(segments_, node_count);
+    }
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        if (target_ > capacity_)
+            target_ = capacity_;
+        TrimGhosts();
+    }
+    void Clear() {
+        t1_.Clear();
+        t2_.Clear();
+        b1_.Clear();
+        b2_.Clear();
+        target_ = 0;
+    }
+
+    //! \brief 新数据：在幽灵队列中时先调整 p，并直接进入 T2，否则进入 T1
+    void Insert(Index index, uint64_t hash) {
+        last_in_b2_ = false;
+        if (b1_.Contains(hash)) {
+            size_t delta = b2_.size() > b1_.size() ? b2_.size() / b1_.size() : 1;
+            target_ = target_ + delta < capacity_ ? target_ + delta : capacity_;
+            b1_.Erase(hash);
+            segments_[index] = kT2;
+            t2_.PushFront(links_, index);
+        } else if (b2_.Contains(hash)) {
+            size_t delta = b1_.size() > b2_.size() ? b1_.size() / b2_.size() : 1;
+            target_ = target_ > delta ? target_ - delta : 0;
+            b2_.Erase(hash);
+            last_in_b2_ = true;
+            segments_[index] = kT2;
+            t2_.PushFront(links_, index);
+        } else {
+            segments_[index] = kT1;
+            t1_.PushFront(links_, index);
+        }
+    }
+
+    // 命中：移动到 T2 头部
+    void Access(Index index, uint64_t) {
+        if (kT2 == segments_[index]) {
+            t2_.MoveToFront(links_, index);
+            return;
+        }
+        t1_.Unlink(links_, index);
+        segments_[index] = kT2;
+        t2_.PushFront(links_, index);
+    }
+
+    //! \brief ARC 的 REPLACE：不计刚插入的数据，|T1| > p（或者新数据来自 B2 且 |T1| == p）时淘汰 T1，否则淘汰 T2
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf) const {
+        size_t t1_size = t1_.size();
+        if (t1_size > 0 && kT1 == SegmentOf(protect))
+            t1_size--;
+        bool from_t1 = t1_size > 0 && (t1_size > target_ || (last_in_b2_ && t1_size == target_));
+        Index victim = cache_policy_internal::kNil;
+        if (from_t1 || t2_.empty())
+            victim = t1_.BackExcept(links_, protect);
+        if (cache_policy_internal::kNil == victim && !t2_.empty())
+            victim = t2_.BackExcept(links_, protect);
+        if (cache_policy_internal::kNil == victim && !t1_.empty())
+            victim = t1_.BackExcept(links_, protect);
+        return victim;
+    }
+
+    //! \brief 淘汰的数据记录到对应的幽灵队列，并保证 |T1| + |B1| <= c、|B1| + |B2| <= c
+    void Remove(Index index, uint64_t hash, bool evicted) {
+        if (kT1 == segments_[index]) {
+            t1_.Unlink(links_, index);
+            if (evicted)
+                b1_.Push(hash);
+        } else {
+            t2_.Unlink(links_, index);
+            if (evicted)
+                b2_.Push(hash);
+        }
+        if (evicted)
+            TrimGhosts();
+    }
+
+    void Relocate(Index from, Index to) {
+        segments_[to] = segments_[from];
+        (kT2 == segments_[to] ? t2_ : t1_).Relocate(links_, from, to);
+    }
+
+    // 先 T2，再 T1，各自从最近使用到最久未使用
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        t2_.ForEach(links_, function);
+        t1_.ForEach(links_, function);
+    }
+
+    // 链接数组、段号数组占用的字节数（不包括幽灵队列）
+    size_t memory_usage() const {
+        return links_.capacity() * sizeof(cache_policy_internal::Links) + segments_.capacity();
+    }
+
+    size_t target() const { return target_; } // T1 的目标大小 p
+
+private:
+    static const uint8_t kT1 = 0;
+    static const uint8_t kT2 = 1;
+
+    uint8_t SegmentOf(Index index) const {
+        return cache_policy_internal::kNil != index ? segments_[index] : kT2;
+    }
+
+    void TrimGhosts() {
+        while (b1_.size() > 0 && t1_.size() + b1_.size() > capacity_)
+            b1_.PopOldest();
+        while (b1_.size() + b2_.size() > capacity_)
+            (b2_.size() > 0 ? b2_ : b1_).PopOldest();
+    }
+
+    std::vector<cache_policy_internal::Links> links_;
+    std::vector<uint8_t>                      segments_;
+    cache_policy_internal::IndexList          t1_;
+    cache_policy_internal::IndexList          t2_;
+    cache_policy_internal::GhostList          b1_{static_cast<size_t>(-1)};   // 大小由 TrimGhosts() 控制
+    cache_policy_internal::GhostList          b2_{static_cast<size_t>(-1)};
+    size_t                                    capacity_   = 1;
+    size_t                                    target_     = 0;       // p
+    bool                                      last_in_b2_ = false;   // 最近插入的数据是否来自 B2
+};
+
+//! \brief W-TinyLFU：窗口 LRU（容量的 1%）+ 主区分段 LRU（试用段 20%、保护段 80%）+ 频率估计。
+//!        新数据先进入窗口，窗口满时最久未使用的数据成为候选，只有估计频率高于主区淘汰对象（试用段尾部）
+//!        时才能进入主区，否则直接被淘汰。一次性扫描的数据频率低，进不了主区
+class TinyLfuPolicy {
+public:
+    using Index = cache_policy_internal::Index;
+
+    void Resize(size_t node_count) {
+        cache_policy_internal::ResizeArray(links_, node_count);
+        cache_policy_internal::ResizeArray(segments_, node_count);
+    }
+    void set_capacity(size_t capacity) {
+        window_capacity_    = capacity / 100 > 0 ? capacity / 100 : 1;
+        main_capacity_      = capacity > window_capacity_ ? capacity - window_capacity_ : 0;
+        protected_capacity_ = main_capacity_ * 4 / 5;
+        sketch_.set_capacity(capacity);
+    }
+    void Clear() {
+        window_.Clear();
+        probation_.Clear();
+        protected_.Clear();
+        sketch_.Clear();
+    }
+
+    void Insert(Index index, uint64_t hash) {
+        sketch_.Increment(hash);
+        segments_[index] = kWindow;
+        window_.PushFront(links_, index);
+    }
+
+    void Access(Index index, uint64_t hash) {
+        sketch_.Increment(hash);
+        switch (segments_[index]) {
+            case kWindow:
+                window_.MoveToFront(links_, index);
+                break;
+            case kProtected:
+                protected_.MoveToFront(links_, index);
+                break;
+            default:
+                probation_.Unlink(links_, index);
+                segments_[index] = kProtected;
+                protected_.PushFront(links_, index);
+                if (protected_.size() > protected_capacity_) {
+                    Index demoted = protected_.back();
+                    protected_.Unlink(links_, demoted);
+                    segments_[demoted] = kProbation;
+                    probation_.PushFront(links_, demoted);
+                }
+        }
+    }
+
+    //! \brief 窗口超出时候选（窗口尾部）与主区淘汰对象比较频率，输的一方被淘汰；候选胜出时进入试用段
+    //! \note 这里会移动候选，不是 const
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf hash_of) {
+        while (window_.size() > window_capacity_) {
+            Index candidate = window_.BackExcept(links_, protect);
+            if (cache_policy_internal::kNil == candidate)
+                break;
+            if (probation_.size() + protected_.size() < main_capacity_) {
+                MoveToProbation(candidate);        // 主区没满，直接进入
+                continue;
+            }
+            if (probation_.empty() && protected_.empty())
+                return candidate;
+            Index victim = !probation_.empty() ? probation_.back() : protected_.back();
+            if (sketch_.Frequency(hash_of(candidate)) > sketch_.Frequency(hash_of(victim))) {
+                MoveToProbation(candidate);
+                return victim;
+            }
+            return candidate;
+        }
+        Index victim = probation_.empty() ? cache_policy_internal::kNil : probation_.BackExcept(links_, protect);
+        if (cache_policy_internal::kNil == victim && !protected_.empty())
+            victim = protected_.BackExcept(links_, protect);
+        if (cache_policy_internal::kNil == victim)
+            victim = window_.BackExcept(links_, protect);
+        return victim;
+    }
+
+    void Remove(Index index, uint64_t, bool) { ListOf(index).Unlink(links_, index); }
+
+    void Relocate(Index from, Index to) {
+        segments_[to] = segments_[from];
+        ListOf(to).Relocate(links_, from, to);
+    }
+
+    // 先保护段，再试用段，最后窗口
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        protected_.ForEach(links_, function);
+        probation_.ForEach(links_, function);
+        window_.ForEach(links_, function);
+    }
+
+    // 链接数组、段号数组、频率计数器占用的字节数
+    size_t memory_usage() const {
+        return links_.capacity() * sizeof(cache_policy_internal::Links) + segments_.capacity() +
+               sketch_.memory_usage();
+    }
+
+    const FrequencySketch& sketch() const { return sketch_; }
+
+private:
+    static const uint8_t kWindow    = 0;
+    static const uint8_t kProbation = 1;
+    static const uint8_t kProtected = 2;
+
+    cache_policy_internal::IndexList& ListOf(Index index) {
+        switch (segments_[index]) {
+            case kWindow:    return window_;
+            case kProtected: return protected_;
+            default:         return probation_;
+        }
+    }
+
+    void MoveToProbation(Index index) {
+        window_.Unlink(links_, index);
+        segments_[index] = kProbation;
+        probation_.PushFront(links_, index);
+    }
+
+    std::vector<cache_policy_internal::Links> links_;
+    std::vector<uint8_t>                      segments_;
+    cache_policy_internal::IndexList          window_;
+    cache_policy_internal::IndexList          probation_;
+    cache_policy_internal::IndexList          protected_;
+    FrequencySketch                           sketch_;
+    size_t                                    window_capacity_    = 1;
+    size_t                                    main_capacity_      = 0;
+    size_t                                    protected_capacity_ = 0;
+};
+
+} // namespace glib
+
+#endif // GLIB_CACHE_POLICY_HPP_
@@ -0,0 +1,94 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: cache_policy.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: test eviction policies of LruCache: correctness, scan resistance, frequency sketch, stats
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./lru_cache.hpp"
+#include "../internal/test_util.h"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+using namespace std;
+using glib::test_internal::CacheRandomTest;
+using glib::test_internal::HotKeysAfterScan;
+
+namespace {
+
+template <typename _Policy>
+using Cache = glib::LruCache<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, _Policy>;
+
+} // namespace
+
+//! \brief 淘汰策略测试：各个策略的随机操作结果正确，SLRU/2Q/ARC/TinyLFU 在一次扫描之后保留大部分热点数据
+//!        （LRU 全部丢失），频率估计的饱和与老化，命中、未命中、淘汰次数
+//! \run
+//!     g++ cache_policy.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    bool all_ok = true;
+
+    // 1）随机操作
+    cout << "随机操作" << endl;
+    all_ok = CacheRandomTest<Cache<glib::LruPolicy> >("lru") && all_ok;
+    all_ok = CacheRandomTest<Cache<glib::SlruPolicy> >("slru") && all_ok;
+    all_ok = CacheRandomTest<Cache<glib::TwoQueuePolicy> >("2q") && all_ok;
+    all_ok = CacheRandomTest<Cache<glib::ArcPolicy> >("arc") && all_ok;
+    all_ok = CacheRandomTest<Cache<glib::TinyLfuPolicy> >("tinylfu") && all_ok;
+
+    // 2）扫描之后的热点数据（共 500 个）
+    cout << "扫描" << endl;
+    size_t lru       = HotKeysAfterScan<Cache<glib::LruPolicy> >();
+    size_t slru      = HotKeysAfterScan<Cache<glib::SlruPolicy> >();
+    size_t two_queue = HotKeysAfterScan<Cache<glib::TwoQueuePolicy> >();
+    size_t arc       = HotKeysAfterScan<Cache<glib::ArcPolicy> >();
+    size_t tiny_lfu  = HotKeysAfterScan<Cache<glib::TinyLfuPolicy> >();
+    cout << " lru " << lru << ", slru " << slru << ", 2q " << two_queue << ", arc " << arc
+         << ", tinylfu " << tiny_lfu << endl;
+    bool scan_ok = 0 == lru && slru >= 450 && two_queue >= 450 && arc >= 450 && tiny_lfu >= 450;
+    cout << (scan_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && scan_ok;
+
+    // 3）频率估计：计数饱和于 15，计数增加次数达到 10 倍容量时减半
+    cout << "频率估计" << endl;
+    glib::FrequencySketch sketch(64);
+    const uint64_t hot = glib::hash::Mix64(42);
+    for (int i = 0; i < 20; i++)
+        sketch.Increment(hot);
+    bool sketch_ok = 15 == sketch.Frequency(hot) && 640 == sketch.sample_size();
+    uint64_t other = 0;
+    for (size_t previous = 0; sketch.additions() >= previous; ) {     // 直到发生一次老化
+        previous = sketch.additions();
+        sketch.Increment(glib::hash::Mix64(++other + 1000));
+    }
+    sketch_ok = sketch_ok && sketch.Frequency(hot) >= 7 && sketch.Frequency(hot) < 15 &&
+                sketch.additions() < sketch.sample_size() / 2 + 1;
+    sketch.Clear();
+    sketch_ok = sketch_ok && 0 == sketch.Frequency(hot);
+    cout << (sketch_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && sketch_ok;
+
+    // 4）命中、未命中、淘汰次数
+    cout << "统计" << endl;
+    Cache<glib::ArcPolicy> counted(2);
+    counted.Put(1, 1);
+    counted.Put(2, 2);
+    counted.Get(1);
+    counted.Get(3);
+    counted.Put(3, 3);           // 淘汰 2（只访问过一次）
+    counted.Erase(1);            // 删除不算淘汰
+    bool stats_ok = 1 == counted.stats().hits && 1 == counted.stats().misses && 1 == counted.stats().evictions &&
+                    !counted.Contains(2) && counted.Contains(3) && 0.5 == counted.stats().hit_rate();
+    counted.set_capacity(1);     // 还有 1 个数据，不需要淘汰
+    counted.ResetStats();
+    stats_ok = stats_ok && 0 == counted.stats().evictions && 0 == counted.stats().hits && 1 == counted.size();
+    cout << (stats_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && stats_ok;
+
+    return all_ok ? 0 : 1;
+}
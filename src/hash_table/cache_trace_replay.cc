@@ -0,0 +1,163 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: cache_trace_replay.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: replay an access trace through every eviction policy of LruCache and compare hit rates
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "lru_cache.hpp"
+#include "clock_cache.hpp"
+#include "hash.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm> // std::lower_bound
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+//! \brief 访问记录回放：同一个访问序列依次经过 LRU、SLRU、2Q、ARC、TinyLFU、CLOCK、CLOCK-Pro 七种策略的 LruCache，
+//!        未命中时插入（cache-aside），比较不同容量下的命中率与回放速度
+//! \run
+//!     g++ cache_trace_replay.cc -std=c++11 -O2 && ./a.out              # 内置的合成访问序列
+//!     g++ cache_trace_replay.cc -std=c++11 -O2 && ./a.out trace.txt    # 访问记录文件，每行一个键值
+//! \note
+//!     1）访问记录中的键值按照字节计算 64 位哈希值（hash::HashBytes()），缓存中只保存哈希值
+//!     2）容量取不同键值个数的 1%、5%、10%、25%
+//!     3）内置序列：
+//!        zipf        Zipf 分布（s = 0.99），100 万个键值
+//!        zipf+scan   同上，每 20 万次访问插入一次 20 万个新键值的顺序扫描（批处理任务）
+//!        loop        循环访问 10 万个键值（比缓存稍大的循环会让 LRU 一直未命中）
+
+namespace {
+
+using Trace = vector<uint64_t>;
+
+// 随机数发生器（xorshift64*）
+struct FastRandom {
+    explicit FastRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t operator()() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+    uint64_t state;
+};
+
+//! \brief 按照 Zipf 分布（s）生成 count 个 [0, n) 中的键值，每 scan_period 次访问插入 scan_length 个新键值的扫描
+Trace ZipfTrace(uint64_t n, double s, size_t count, size_t scan_period, size_t scan_length) {
+    vector<double> cdf(n);
+    double sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sum += 1.0 / pow(static_cast<double>(i + 1), s);
+        cdf[i] = sum;
+    }
+    FastRandom random(2019);
+    uint64_t next_scan_key = n;
+    Trace trace;
+    trace.reserve(count + (0 != scan_period ? count / scan_period * scan_length : 0));
+    for (size_t i = 0; i < count; i++) {
+        if (0 != scan_period && i > 0 && 0 == i % scan_period) {
+            for (size_t j = 0; j < scan_length; j++)
+                trace.push_back(next_scan_key++);
+        }
+        double u = static_cast<double>(random() >> 11) / static_cast<double>(uint64_t(1) << 53) * sum;
+        trace.push_back(static_cast<uint64_t>(lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin()));
+    }
+    return trace;
+}
+
+// 循环访问 [0, n)
+Trace LoopTrace(uint64_t n, size_t count) {
+    Trace trace(count);
+    for (size_t i = 0; i < count; i++)
+        trace[i] = i % n;
+    return trace;
+}
+
+//! \brief 读取访问记录文件，每行一个键值（任意字符串），空行忽略
+bool ReadTrace(const char *path, Trace &trace) {
+    ifstream input(path);
+    if (!input)
+        return false;
+    string line;
+    while (getline(input, line)) {
+        if (!line.empty())
+            trace.push_back(glib::hash::HashBytes(line.data(), line.size()));
+    }
+    return true;
+}
+
+//! \brief 用策略 _Policy 的缓存回放访问序列
+//! \return first:命中率，second:每秒访问次数（百万）
+template <typename _Policy>
+pair<double, double> Replay(const Trace &trace, size_t capacity) {
+    glib::LruCache<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, _Policy> cache(capacity);
+    TicToc timer;
+    for (uint64_t key: trace) {
+        if (nullptr == cache.Get(key))
+            cache.Put(key, key);
+    }
+    double elapsed = timer.toc();
+    return make_pair(cache.stats().hit_rate(), static_cast<double>(trace.size()) / elapsed / 1000.0);
+}
+
+void ReplayAll(const string &name, const Trace &trace) {
+    unordered_set<uint64_t> distinct(trace.begin(), trace.end());
+    cout << name << ": " << trace.size() << " accesses, " << distinct.size() << " distinct keys" << endl;
+    cout << setw(10) << "capacity" << setw(10) << "lru" << setw(10) << "slru" << setw(10) << "2q"
+         << setw(10) << "arc" << setw(10) << "tinylfu" << setw(10) << "clock" << setw(10) << "clock-pro"
+         << "   (hit %, Mops/s)" << endl;
+    for (double fraction: {0.01, 0.05, 0.10, 0.25}) {
+        size_t capacity = static_cast<size_t>(static_cast<double>(distinct.size()) * fraction);
+        if (0 == capacity)
+            capacity = 1;
+        pair<double, double> results[] = {
+            Replay<glib::LruPolicy>(trace, capacity),
+            Replay<glib::SlruPolicy>(trace, capacity),
+            Replay<glib::TwoQueuePolicy>(trace, capacity),
+            Replay<glib::ArcPolicy>(trace, capacity),
+            Replay<glib::TinyLfuPolicy>(trace, capacity),
+            Replay<glib::ClockPolicy>(trace, capacity),
+            Replay<glib::ClockProPolicy>(trace, capacity),
+        };
+        cout << setw(10) << capacity;
+        for (const auto &result: results)
+            cout << setw(10) << result.first * 100;
+        cout << endl << setw(10) << "";
+        for (const auto &result: results)
+            cout << setw(10) << result.second;
+        cout << endl;
+    }
+    cout << endl;
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    cout << fixed << setprecision(2);
+    if (argc > 1) {
+        Trace trace;
+        if (!ReadTrace(argv[1], trace) || trace.empty()) {
+            cerr << "cannot read trace " << argv[1] << endl;
+            return 1;
+        }
+        ReplayAll(argv[1], trace);
+        return 0;
+    }
+    ReplayAll("zipf", ZipfTrace(1000000, 0.99, 4000000, 0, 0));
+    ReplayAll("zipf+scan", ZipfTrace(1000000, 0.99, 4000000, 200000, 200000));
+    ReplayAll("loop", LoopTrace(100000, 2000000));
+    return 0;
+}
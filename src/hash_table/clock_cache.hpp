@@ -0,0 +1,452 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: clock_cache.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: CLOCK and CLOCK-Pro eviction policies for LruCache, hits only set a reference byte
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_CLOCK_CACHE_HPP_
+#define GLIB_CLOCK_CACHE_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint8_t uint32_t uint64_t
+#include <atomic>
+#include <functional>  // std::hash std::equal_to
+#include <memory>      // std::unique_ptr
+#include <stdexcept>   // std::length_error
+#include <vector>
+#include "lru_cache.hpp"
+#include "cache_policy.hpp"
+#include "flat_hash_map.hpp"
+
+//! \brief 近似 LRU 的 CLOCK、CLOCK-Pro 淘汰策略，作为 LruCache 的 _Policy 使用（接口见 cache_policy.hpp），
+//!        ClockCache、ClockProCache 为对应的 LruCache 别名
+//!     1）ClockPolicy：每个节点一个字节的状态（空闲 / 使用中 / 使用中且被引用），命中只写这个字节。
+//!        淘汰时指针按照节点数组的顺序扫描，被引用的数据清除引用位、得到第二次机会，第一个未被引用的数据被淘汰
+//!     2）ClockProPolicy：数据分为冷、热两类，一个时钟环上有三个指针。冷数据被淘汰之后在环上留下一个
+//!        只记录哈希值的测试项（非常驻）；测试项被再次插入时说明冷数据的空间不够，冷数据的目标大小加一并且
+//!        新数据直接成为热数据，测试项过期时目标大小减一。热指针把未被引用的热数据降级为冷数据，
+//!        冷指针淘汰未被引用的冷数据（被引用的冷数据升级为热数据），测试指针删除过期的测试项。
+//!        比 CLOCK 更能抵抗扫描和大于缓存的循环访问
+//!
+//! \Note
+//!     1）LruPolicy 每次命中都要把节点移动到链表头，修改 2 ~ 3 个节点的链接（两三个缓存行），
+//!        读操作必须独占缓存。CLOCK 命中时只对一个字节做一次 relaxed 原子写（已经被引用时只读不写），
+//!        所以 Access() 是 const 的，声明了 kConcurrentAccess：ShardedLruCache 使用这两个策略时，
+//!        命中在分片读锁内直接设置引用位，不经过读缓冲区，也不会丢弃命中
+//!     2）内存：ClockPolicy 每个数据 1 字节（没有链表），<uint64_t, uint64_t> 的 ClockCache 每个数据约 29 字节，
+//!        LruCache（LRU）约 36 字节，LruHash 约 56 字节。ClockProPolicy 每个数据 10 字节（环的链接、类型、引用位），
+//!        另外最多容量个测试项（每项约 30 字节）
+//!     3）ClockPolicy 的节点数组中可能有空闲节点，扫描时跳过；每次淘汰最多扫描两圈，均摊 O(1)
+//!     4）ClockProPolicy 的容量不能超过 2^31 - 2（下标最高位用来区分测试项）。简化：测试指针追上冷指针时，
+//!        冷指针只是前进一步（原算法会让冷指针执行一次，可能多淘汰一个数据）
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \benchmark
+//!     clock_cache_benchmark.cc：读多写少的 Zipf 访问下与 LruHash、LruCache 的吞吐量、内存、命中率对比，
+//!     以及多线程下 ShardedLruCache 使用 CLOCK 与 LRU 的对比
+//!
+//! \reference
+//!     1）Corbato, A paging experiment with the Multics system, 1968（CLOCK）
+//!     2）Jiang, Chen, Zhang, CLOCK-Pro: An effective improvement of the CLOCK replacement, USENIX ATC 2005
+//!
+//! example
+//!     glib::ClockCache<uint64_t, std::string> pages(100000);
+//!     glib::ShardedLruCache<uint64_t, std::string, std::hash<uint64_t>, std::equal_to<uint64_t>,
+//!                           glib::ClockProPolicy> shared_pages(100000);
+
+namespace glib {
+
+namespace clock_cache_internal {
+
+using Index = cache_policy_internal::Index;
+
+//! \brief 每个节点一个原子字节，大小可以调整（std::vector 不能保存 std::atomic）
+class AtomicBytes {
+public:
+    AtomicBytes() : size_(0) {}
+
+    //! \brief 调整大小，保留前面的值，新增的值为 0。不能与 Load()/Store() 同时调用
+    void Resize(size_t size) {
+        std::unique_ptr<std::atomic<uint8_t>[]> bytes(0 != size ? new std::atomic<uint8_t>[size] : nullptr);
+        for (size_t i = 0; i < size; i++)
+            bytes[i].store(i < size_ ? Load(i) : 0, std::memory_order_relaxed);
+        bytes_.swap(bytes);
+        size_ = size;
+    }
+
+    uint8_t Load(size_t i) const { return bytes_[i].load(std::memory_order_relaxed); }
+    void Store(size_t i, uint8_t value) const { bytes_[i].store(value, std::memory_order_relaxed); }
+
+    //! \brief 值不同时才写，避免热点数据的每次命中都把缓存行变脏
+    void Set(size_t i, uint8_t value) const {
+        if (Load(i) != value)
+            Store(i, value);
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    std::unique_ptr<std::atomic<uint8_t>[]> bytes_;
+    size_t                                  size_;
+};
+
+} // namespace clock_cache_internal
+
+//! \brief CLOCK：按照节点数组的顺序扫描，命中设置引用位
+class ClockPolicy {
+public:
+    using Index = cache_policy_internal::Index;
+    static constexpr bool kConcurrentAccess = true;
+
+    ClockPolicy() : hand_(0) {}
+
+    void Resize(size_t node_count) {
+        states_.Resize(node_count);
+        if (hand_ >= node_count)
+            hand_ = 0;
+    }
+    void set_capacity(size_t) {}
+    void Clear() {
+        for (size_t i = 0; i < states_.size(); i++)
+            states_.Store(i, kFree);
+        hand_ = 0;
+    }
+
+    // 新数据不设置引用位，只访问一次的数据第一圈就会被淘汰
+    void Insert(Index index, uint64_t)      { states_.Store(index, kLive); }
+    void Access(Index index, uint64_t = 0) const { states_.Set(index, kReferenced); }
+
+    //! \brief 从指针位置开始扫描：跳过空闲节点和 protect，被引用的数据清除引用位，返回第一个未被引用的数据
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf) {
+        for (;;) {
+            Index index = static_cast<Index>(hand_);
+            hand_ = hand_ + 1 < states_.size() ? hand_ + 1 : 0;
+            uint8_t state = states_.Load(index);
+            if (kFree == state || protect == index)
+                continue;
+            if (kReferenced == state) {
+                states_.Store(index, kLive);
+                continue;
+            }
+            return index;
+        }
+    }
+
+    void Remove(Index index, uint64_t, bool) { states_.Store(index, kFree); }
+
+    void Relocate(Index from, Index to) {
+        states_.Store(to, states_.Load(from));
+        states_.Store(from, kFree);
+    }
+
+    // 从指针位置开始，按照扫描的顺序
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        for (size_t i = 0; i < states_.size(); i++) {
+            size_t index = hand_ + i < states_.size() ? hand_ + i : hand_ + i - states_.size();
+            if (kFree != states_.Load(index))
+                function(static_cast<Index>(index));
+        }
+    }
+
+    // 状态数组占用的字节数
+    size_t memory_usage() const { return states_.size(); }
+
+private:
+    static const uint8_t kFree       = 0;
+    static const uint8_t kLive       = 1;
+    static const uint8_t kReferenced = 2;
+
+    clock_cache_internal::AtomicBytes states_;   // 每个节点的状态
+    size_t                            hand_;     // 下一个检查的节点
+};
+
+//! \brief CLOCK-Pro：冷数据、热数据、测试项（被淘汰的冷数据的哈希值）在同一个时钟环上，
+//!        新数据插入在热指针之前（热指针最后才会经过它）
+class ClockProPolicy {
+public:
+    using Index = cache_policy_internal::Index;
+    static constexpr bool kConcurrentAccess = true;
+
+    void Resize(size_t node_count) {
+        cache_policy_internal::ResizeArray(links_, node_count);
+        cache_policy_internal::ResizeArray(types_, node_count);
+        refs_.Resize(node_count);
+    }
+
+    void set_capacity(size_t capacity) {
+        if (capacity >= kGhostBit - 1)
+            throw std::length_error("ClockProPolicy: capacity exceeds 31-bit node index");
+        capacity_ = capacity;
+        if (cold_target_ > capacity_ || 0 == cold_target_)
+            cold_target_ = capacity_;
+        while (count_test_ > capacity_)
+            RunHandTest();
+    }
+
+    void Clear() {
+        hand_hot_ = hand_cold_ = hand_test_ = kNil;
+        count_hot_ = count_cold_ = count_test_ = 0;
+        cold_target_ = capacity_;
+        ghost_links_.clear();
+        ghost_hashes_.clear();
+        ghost_free_ = kNil;
+        ghosts_.Clear();
+    }
+
+    //! \brief 新数据：有测试项时冷数据的目标大小加一，删除测试项，新数据成为热数据；否则成为冷数据
+    void Insert(Index index, uint64_t hash) {
+        const Index *ghost = ghosts_.FindPtr(hash);
+        refs_.Store(index, 0);
+        if (nullptr != ghost) {
+            if (cold_target_ < capacity_)
+                cold_target_++;
+            RemoveGhost(*ghost);
+            types_[index] = kHot;
+            count_hot_++;
+        } else {
+            types_[index] = kCold;
+            count_cold_++;
+        }
+        RingInsert(index);
+    }
+
+    void Access(Index index, uint64_t = 0) const { refs_.Set(index, 1); }
+
+    //! \brief 冷指针前进，直到遇到未被引用的冷数据（不是 protect）；经过的被引用的冷数据升级为热数据，
+    //!        热数据超过 容量 - 冷数据目标大小 时热指针降级热数据
+    template <typename _HashOf>
+    Index Victim(Index protect, _HashOf) {
+        for (;;) {
+            Index index = hand_cold_;
+            hand_cold_ = links_of(index).next;
+            if (!IsGhost(index) && kCold == types_[index] && protect != index) {
+                if (0 == refs_.Load(index)) {
+                    BalanceHot();
+                    return index;
+                }
+                refs_.Store(index, 0);
+                types_[index] = kHot;
+                count_cold_--;
+                count_hot_++;
+            }
+            BalanceHot();
+        }
+    }
+
+    //! \brief 被淘汰的冷数据在环上原地变成测试项；删除的数据直接从环上摘下
+    void Remove(Index index, uint64_t hash, bool evicted) {
+        if (kHot == types_[index])
+            count_hot_--;
+        else
+            count_cold_--;
+        if (!evicted || kHot == types_[index]) {
+            RingErase(index);
+            return;
+        }
+        Index ghost = AcquireGhost(hash);
+        ReplaceInRing(index, ghost);
+        count_test_++;
+        while (count_test_ > capacity_)
+            RunHandTest();
+    }
+
+    void Relocate(Index from, Index to) {
+        types_[to] = types_[from];
+        refs_.Store(to, refs_.Load(from));
+        ReplaceInRing(from, to);
+    }
+
+    // 从热指针开始沿着环遍历常驻数据
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        if (kNil == hand_hot_)
+            return;
+        Index index = hand_hot_;
+        do {
+            Index next = links_of(index).next;
+            if (!IsGhost(index))
+                function(index);
+            index = next;
+        } while (index != hand_hot_);
+    }
+
+    // 环的链接、类型、引用位、测试项占用的字节数（不包括测试项的哈希表）
+    size_t memory_usage() const {
+        return links_.capacity() * sizeof(cache_policy_internal::Links) + types_.capacity() + refs_.size() +
+               ghost_links_.capacity() * sizeof(cache_policy_internal::Links) +
+               ghost_hashes_.capacity() * sizeof(uint64_t);
+    }
+
+    size_t cold_target() const { return cold_target_; } // 冷数据的目标大小
+    size_t hot_count()   const { return count_hot_;   } // 热数据个数
+    size_t test_count()  const { return count_test_;  } // 测试项个数
+
+private:
+    using Links = cache_policy_internal::Links;
+
+    static const Index   kNil      = cache_policy_internal::kNil;
+    static const Index   kGhostBit = Index(1) << 31;   // 测试项的下标带有最高位
+    static const uint8_t kCold     = 0;
+    static const uint8_t kHot      = 1;
+
+    static bool IsGhost(Index id) { return 0 != (id & kGhostBit); }
+
+    Links& links_of(Index id) {
+        return IsGhost(id) ? ghost_links_[id & ~kGhostBit] : links_[id];
+    }
+    const Links& links_of(Index id) const {
+        return IsGhost(id) ? ghost_links_[id & ~kGhostBit] : links_[id];
+    }
+
+    // 插入在热指针之前；环为空时三个指针都指向它
+    void RingInsert(Index id) {
+        if (kNil == hand_hot_) {
+            links_of(id).prev = links_of(id).next = id;
+            hand_hot_ = hand_cold_ = hand_test_ = id;
+            return;
+        }
+        Index prev = links_of(hand_hot_).prev;
+        links_of(id).prev = prev;
+        links_of(id).next = hand_hot_;
+        links_of(prev).next = id;
+        links_of(hand_hot_).prev = id;
+    }
+
+    // 从环上摘下，指向它的指针退回前一项（调用者之后会前进）
+    void RingErase(Index id) {
+        Index prev = links_of(id).prev, next = links_of(id).next;
+        if (next == id) {
+            hand_hot_ = hand_cold_ = hand_test_ = kNil;
+            return;
+        }
+        links_of(prev).next = next;
+        links_of(next).prev = prev;
+        if (hand_hot_ == id)
+            hand_hot_ = prev;
+        if (hand_cold_ == id)
+            hand_cold_ = prev;
+        if (hand_test_ == id)
+            hand_test_ = prev;
+    }
+
+    // 环上的 from 换成 to，位置不变
+    void ReplaceInRing(Index from, Index to) {
+        Index prev = links_of(from).prev, next = links_of(from).next;
+        if (next == from) {
+            links_of(to).prev = links_of(to).next = to;
+        } else {
+            links_of(to).prev = prev;
+            links_of(to).next = next;
+            links_of(prev).next = to;
+            links_of(next).prev = to;
+        }
+        if (hand_hot_ == from)
+            hand_hot_ = to;
+        if (hand_cold_ == from)
+            hand_cold_ = to;
+        if (hand_test_ == from)
+            hand_test_ = to;
+    }
+
+    Index AcquireGhost(uint64_t hash) {
+        Index slot;
+        if (kNil != ghost_free_) {
+            slot = ghost_free_;
+            ghost_free_ = ghost_links_[slot].next;
+            ghost_hashes_[slot] = hash;
+        } else {
+            slot = static_cast<Index>(ghost_links_.size());
+            ghost_links_.push_back(Links());
+            ghost_hashes_.push_back(hash);
+        }
+        Index ghost = slot | kGhostBit;
+        const Index *old = ghosts_.FindPtr(hash);
+        if (nullptr != old)                  // 哈希值相同的旧测试项作废
+            RemoveGhost(*old);
+        ghosts_.InsertOrAssign(hash, ghost);
+        return ghost;
+    }
+
+    void RemoveGhost(Index ghost) {
+        Index slot = ghost & ~kGhostBit;
+        ghosts_.Delete(ghost_hashes_[slot]);
+        RingErase(ghost);
+        ghost_links_[slot].next = ghost_free_;
+        ghost_free_ = slot;
+        count_test_--;
+    }
+
+    // 热数据超过 容量 - 冷数据目标大小 时运行热指针
+    void BalanceHot() {
+        while (count_hot_ > 0 && count_hot_ > capacity_ - cold_target_)
+            RunHandHot();
+    }
+
+    // 热指针：被引用的热数据清除引用位，未被引用的降级为冷数据
+    void RunHandHot() {
+        if (hand_hot_ == hand_test_)
+            RunHandTest();
+        Index index = hand_hot_;
+        if (!IsGhost(index) && kHot == types_[index]) {
+            if (0 != refs_.Load(index)) {
+                refs_.Store(index, 0);
+            } else {
+                types_[index] = kCold;
+                count_hot_--;
+                count_cold_++;
+            }
+        }
+        hand_hot_ = links_of(hand_hot_).next;
+    }
+
+    // 测试指针：删除经过的测试项，冷数据的目标大小减一
+    void RunHandTest() {
+        if (hand_test_ == hand_cold_)
+            hand_cold_ = links_of(hand_cold_).next;
+        Index index = hand_test_;
+        if (IsGhost(index)) {
+            RemoveGhost(index);               // 测试指针退回前一项
+            if (cold_target_ > 1)
+                cold_target_--;
+            if (kNil == hand_test_)
+                return;
+        }
+        hand_test_ = links_of(hand_test_).next;
+    }
+
+    std::vector<Links>                links_;            // 常驻数据在环上的链接
+    std::vector<uint8_t>              types_;            // 冷 / 热
+    clock_cache_internal::AtomicBytes refs_;             // 引用位
+    std::vector<Links>                ghost_links_;      // 测试项在环上的链接
+    std::vector<uint64_t>             ghost_hashes_;     // 测试项的哈希值
+    Index                             ghost_free_  = kNil;
+    FlatHashMap<uint64_t, Index>      ghosts_;           // 哈希值 -> 测试项
+    Index                             hand_hot_    = kNil;
+    Index                             hand_cold_   = kNil;
+    Index                             hand_test_   = kNil;
+    size_t                            count_hot_   = 0;
+    size_t                            count_cold_  = 0;
+    size_t                            count_test_  = 0;
+    size_t                            capacity_    = 1;
+    size_t                            cold_target_ = 0;      // 0 表示还没有设置容量
+};
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key> >
+using ClockCache = LruCache<_Key, _Value, _Hash, _KeyEqual, ClockPolicy>;
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key> >
+using ClockProCache = LruCache<_Key, _Value, _Hash, _KeyEqual, ClockProPolicy>;
+
+} // namespace glib
+
+#endif // GLIB_CLOCK_CACHE_HPP_
@@ -0,0 +1,112 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: clock_cache.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: test CLOCK and CLOCK-Pro caches
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./clock_cache.hpp"
+#include "./sharded_lru_cache.hpp"
+#include "./lru_hash.hpp"
+#include "../internal/test_util.h"
+#include <cstdint>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+using glib::test_internal::CacheRandomTest;
+using glib::test_internal::HotKeysAfterScan;
+using glib::test_internal::RunThreads;
+
+//! \brief CLOCK / CLOCK-Pro 测试：随机操作结果正确、第二次机会的淘汰顺序、扫描之后保留热点数据、
+//!        分片缓存多线程命中（TSan 下无数据竞争）、每个数据占用的内存
+//! \run
+//!     g++ clock_cache.test.cc -std=c++11 -O2 -pthread && ./a.out
+int main(int argc, char const *argv[]) {
+    bool all_ok = true;
+
+    // 1）随机操作
+    cout << "随机操作" << endl;
+    all_ok = CacheRandomTest<glib::ClockCache<uint64_t, uint64_t> >("clock") && all_ok;
+    all_ok = CacheRandomTest<glib::ClockProCache<uint64_t, uint64_t> >("clock-pro") && all_ok;
+
+    // 2）第二次机会：a 被引用，插入 d 时跳过 a（清除引用位）淘汰 b；
+    //    插入 e 时指针从 c 继续，c 被引用（清除引用位），淘汰 d
+    cout << "淘汰顺序" << endl;
+    glib::ClockCache<string, int> clock(3);
+    clock.Put("a", 1);
+    clock.Put("b", 2);
+    clock.Put("c", 3);
+    bool order_ok = 1 == *clock.Get("a");
+    clock.Put("d", 4);
+    order_ok = order_ok && !clock.Contains("b") && clock.Contains("a") && 1 == clock.stats().evictions;
+    clock.Get("c");
+    clock.Put("e", 5);
+    order_ok = order_ok && !clock.Contains("d") && clock.Contains("a") && clock.Contains("c") && 3 == clock.size();
+    cout << (order_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && order_ok;
+
+    // 3）扫描：CLOCK 与 LRU 一样丢掉热点数据，CLOCK-Pro 保留
+    cout << "扫描" << endl;
+    size_t clock_hot = HotKeysAfterScan<glib::ClockCache<uint64_t, uint64_t> >();
+    size_t clock_pro_hot = HotKeysAfterScan<glib::ClockProCache<uint64_t, uint64_t> >();
+    bool scan_ok = clock_pro_hot >= 450;
+    cout << " clock " << clock_hot << ", clock-pro " << clock_pro_hot << " / 500" << (scan_ok ? " ok" : " error")
+         << endl;
+    all_ok = all_ok && scan_ok;
+
+    // 4）分片缓存：读线程在读锁内直接设置引用位，不丢弃命中；写线程不断插入、删除
+    cout << "多线程" << endl;
+    glib::ShardedLruCache<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                          glib::ClockProPolicy> shared(512, 8);
+    atomic<size_t> bad_reads(0), hits(0);
+    RunThreads(6, [&](size_t index) {
+        mt19937_64 engine(index);
+        for (size_t i = 0; i < 100000; i++) {
+            uint64_t key = engine() % 2048;
+            if (index < 2) {
+                if (engine() % 8)
+                    shared.Put(key, key * 3);
+                else
+                    shared.Erase(key);
+            } else {
+                auto result = shared.Get(key);
+                if (result.first) {
+                    hits++;
+                    bad_reads += key * 3 != result.second ? 1 : 0;
+                }
+            }
+        }
+    });
+    bool shared_ok = 0 == bad_reads && hits > 0 && 0 == shared.dropped_promotions() &&
+                     shared.size() <= shared.capacity();
+    cout << " hits " << hits << (shared_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && shared_ok;
+
+    // 5）内存：ClockCache < LruCache < LruHash
+    cout << "内存" << endl;
+    const size_t kNum = 1 << 16;
+    glib::ClockCache<uint64_t, uint64_t> clock_memory(kNum);
+    glib::LruCache<uint64_t, uint64_t> lru_memory(kNum);
+    for (uint64_t key = 0; key < kNum; key++) {
+        clock_memory.Put(key, key);
+        lru_memory.Put(key, key);
+    }
+    double clock_bytes  = static_cast<double>(clock_memory.memory_usage()) / kNum;
+    double lru_bytes    = static_cast<double>(lru_memory.memory_usage()) / kNum;
+    double legacy_bytes = sizeof(glib::LruHash<uint64_t>::HashNode) + 2.0 * sizeof(void*);
+    bool memory_ok = clock_bytes < lru_bytes && lru_bytes < legacy_bytes;
+    cout << "  ClockCache " << clock_bytes << ", LruCache " << lru_bytes << ", LruHash " << legacy_bytes
+         << " bytes/entry" << (memory_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && memory_ok;
+
+    return all_ok ? 0 : 1;
+}
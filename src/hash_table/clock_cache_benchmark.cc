@@ -0,0 +1,174 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: clock_cache_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: read-heavy throughput, memory and hit rate of CLOCK caches vs LruHash and LruCache
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "clock_cache.hpp"
+#include "sharded_lru_cache.hpp"
+#include "lru_hash.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm> // std::lower_bound
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! \brief CLOCK 缓存测试：键值服从 Zipf 分布（s = 0.99），缓存容量为键值范围的 10%，未命中时插入（读多写少）
+//!     1）单线程：LruHash、LruCache（LRU）、ClockCache、ClockProCache 的吞吐量、每个数据的内存、命中率。
+//!        LruHash::Find() 不提升，命中后再调用 Insert() 移动到链表头
+//!     2）多线程：ShardedLruCache 使用 LRU（读缓冲区批量提升）与 CLOCK（读锁内设置引用位）的吞吐量与命中率
+//! \run
+//!     g++ clock_cache_benchmark.cc -std=c++11 -O2 -pthread && ./a.out [访问次数]
+
+namespace {
+
+const uint64_t kKeyRange = 1 << 18;             // 键值范围
+const size_t   kCapacity = kKeyRange / 10;      // 缓存容量
+
+struct FastRandom {
+    explicit FastRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t operator()() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+    uint64_t state;
+};
+
+//! \brief 按照 Zipf 分布生成 count 个键值，排名打散到整个键值范围
+vector<uint64_t> ZipfKeys(size_t count, uint64_t seed) {
+    static vector<double> cdf;
+    if (cdf.empty()) {
+        cdf.resize(kKeyRange);
+        double sum = 0;
+        for (uint64_t i = 0; i < kKeyRange; i++) {
+            sum += 1.0 / pow(static_cast<double>(i + 1), 0.99);
+            cdf[i] = sum;
+        }
+        for (auto &value: cdf)
+            value /= sum;
+    }
+    FastRandom random(seed);
+    vector<uint64_t> keys(count);
+    for (auto &key: keys) {
+        double u = static_cast<double>(random() >> 11) / static_cast<double>(uint64_t(1) << 53);
+        uint64_t rank = static_cast<uint64_t>(lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        key = (rank * 0x9E3779B97F4A7C15ull) >> 20;
+    }
+    return keys;
+}
+
+void PrintRow(const char *name, double elapsed, size_t ops, size_t hits, double bytes_per_entry) {
+    cout << setw(16) << name << setw(12) << static_cast<double>(ops) / elapsed / 1000.0
+         << setw(10) << 100.0 * static_cast<double>(hits) / static_cast<double>(ops)
+         << setw(14) << bytes_per_entry << endl;
+}
+
+template <typename _Cache>
+void RunCache(const char *name, const vector<uint64_t> &keys) {
+    _Cache cache(kCapacity);
+    TicToc timer;
+    for (uint64_t key: keys) {
+        if (nullptr == cache.Get(key))
+            cache.Put(key, key);
+    }
+    double elapsed = timer.toc();
+    PrintRow(name, elapsed, keys.size(), cache.stats().hits,
+             static_cast<double>(cache.memory_usage()) / static_cast<double>(cache.size()));
+}
+
+void RunLruHash(const vector<uint64_t> &keys) {
+    glib::LruHash<uint64_t> cache(kCapacity);
+    size_t hits = 0;
+    TicToc timer;
+    for (uint64_t key: keys) {
+        if (cache.Find(key).first)
+            hits++;
+        cache.Insert(key);          // 命中时移动到链表头，未命中时插入
+    }
+    double elapsed = timer.toc();
+    PrintRow("LruHash", elapsed, keys.size(), hits,
+             sizeof(glib::LruHash<uint64_t>::HashNode) + 2.0 * sizeof(void*));
+}
+
+//! \brief num_threads 个线程同时回放各自的访问序列
+//! \return first:吞吐量（百万次操作/秒），second:命中率
+template <typename _Cache>
+pair<double, double> RunShared(const vector<vector<uint64_t> > &streams, size_t num_threads) {
+    _Cache cache(kCapacity);
+    atomic<size_t> ready(0), hits(0);
+    atomic<bool>   start(false);
+    vector<thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            size_t local_hits = 0;
+            ready++;
+            while (!start.load(memory_order_acquire))
+                this_thread::yield();
+            for (uint64_t key: streams[t]) {
+                if (cache.Get(key).first)
+                    local_hits++;
+                else
+                    cache.Put(key, key);
+            }
+            hits += local_hits;
+        });
+    }
+    while (ready.load() < num_threads)
+        this_thread::yield();
+    TicToc timer;
+    start.store(true, memory_order_release);
+    for (auto &t: threads)
+        t.join();
+    double elapsed = timer.toc();
+    size_t total = streams[0].size() * num_threads;
+    return make_pair(static_cast<double>(total) / elapsed / 1000.0, static_cast<double>(hits) / total);
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    size_t total_ops = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4000000;
+    cout << "operations = " << total_ops << ", keys = " << kKeyRange << ", capacity = " << kCapacity
+         << ", hardware threads = " << glib::utils::ThreadPool::HardwareConcurrency() << endl;
+    cout << fixed << setprecision(2);
+
+    cout << "single thread" << endl;
+    cout << setw(16) << "cache" << setw(12) << "Mops/s" << setw(10) << "hit%" << setw(14) << "bytes/entry" << endl;
+    vector<uint64_t> keys = ZipfKeys(total_ops, 1);
+    RunLruHash(keys);
+    RunCache<glib::LruCache<uint64_t, uint64_t> >("LruCache", keys);
+    RunCache<glib::ClockCache<uint64_t, uint64_t> >("ClockCache", keys);
+    RunCache<glib::ClockProCache<uint64_t, uint64_t> >("ClockProCache", keys);
+
+    using ShardedLru   = glib::ShardedLruCache<uint64_t, uint64_t>;
+    using ShardedClock = glib::ShardedLruCache<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                               glib::ClockPolicy>;
+    cout << "sharded" << endl;
+    cout << setw(8) << "threads" << setw(14) << "lru Mops/s" << setw(10) << "hit%"
+         << setw(16) << "clock Mops/s" << setw(10) << "hit%" << setw(10) << "speedup" << endl;
+    for (size_t num_threads = 1; num_threads <= 16; num_threads *= 2) {
+        vector<vector<uint64_t> > streams;
+        for (size_t t = 0; t < num_threads; t++)
+            streams.push_back(ZipfKeys(total_ops / num_threads, t + 1));
+        pair<double, double> lru = RunShared<ShardedLru>(streams, num_threads);
+        pair<double, double> clock = RunShared<ShardedClock>(streams, num_threads);
+        cout << setw(8) << num_threads << setw(14) << lru.first << setw(10) << lru.second * 100
+             << setw(16) << clock.first << setw(10) << clock.second * 100
+             << setw(10) << clock.first / lru.first << endl;
+    }
+    return 0;
+}
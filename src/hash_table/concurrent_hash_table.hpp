@@ -0,0 +1,370 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: concurrent_hash_table.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/17
+ * Description: sharded thread-safe hash table with reader-writer shard locks
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_CONCURRENT_HASH_TABLE_HPP_
+#define GLIB_CONCURRENT_HASH_TABLE_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t uint64_t
+#include <atomic>
+#include <functional>  // std::hash
+#include <mutex>       // std::lock_guard
+#include <new>         // operator new、placement new
+#include <thread>      // std::this_thread::yield
+#include <utility>     // std::pair
+#include "hash_table.hpp"
+#include "../utils/thread_pool.hpp"
+#include "../internal/macros.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h> // _mm_pause
+#endif
+
+//! \brief 线程安全的哈希表：数据按照哈希值分到 N 个分片（shard），每个分片是一个 HashTable 加一把读写锁
+//!     外部调用核心函数：
+//!         1）查询：Find() 返回映射值的拷贝，Contains()，Visit() 在读锁内访问映射值（不拷贝）
+//!         2）原子地插入或更新：InsertOrUpdate()，键值不存在时才构造：ComputeIfAbsent()
+//!         3）插入、删除：Insert()、Delete()
+//!         4）遍历：ForEach()，传入线程池时多个分片并行遍历
+//!         5）预留容量：Reserve()
+//!     外部调用状态函数：
+//!         1）哈希表状态：size()、empty()、num_shards()
+//!
+//! \Note
+//!     1）不同分片的操作互不影响，只有落在同一个分片上的写操作才会互相等待。分片个数是 2 的指数次幂，
+//!        默认为硬件线程数的 4 倍（至少 16），线程越多、分片越多，冲突的概率越小
+//!     2）每个分片按缓存行（64 字节）对齐，锁和哈希表头部不会与相邻分片共享缓存行（没有伪共享）
+//!     3）读操作只加读锁（一次原子加法），多个线程同时读同一个分片不会互相等待，只有写操作持有写锁时才需要等待。
+//!        写操作排队时新的读操作会让路，写操作不会被连续的读操作饿死
+//!     4）读锁不是无锁（lock-free）读：HashTable 搬移桶、删除节点时会释放内存，
+//!        不加锁读取需要安全的内存回收（epoch / hazard pointer），序列锁（seqlock）的乐观读
+//!        也只适用于可以按位拷贝的数据，读到一半被释放的节点仍然是未定义行为
+//!     5）InsertOrUpdate()、ComputeIfAbsent() 的查找和修改在同一次写锁内完成，是原子的；
+//!        ComputeIfAbsent() 先在读锁下查找，已存在时不需要写锁
+//!     6）传入的 update、factory、Visit()/ForEach() 的 function 都在分片锁内执行，应该尽量短，
+//!        并且不能再访问同一个哈希表（会死锁）。并行 ForEach() 时 function 会在多个线程中同时调用
+//!     7）选择分片用哈希值打散后的高位，分片内部的 HashTable 用哈希值的低位选择桶，两者互不相关
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \benchmark
+//!     concurrent_hash_table_benchmark.cc：1 ~ 64 个线程、不同读写比例下与「互斥锁 + HashTable」的吞吐量对比
+//!
+//! example
+//!     glib::ConcurrentHashTable<string, int> counters;
+//!     // 多个线程中
+//!     counters.InsertOrUpdate("page-1", 1, [](int &count) { count++; });
+//!     int value = counters.ComputeIfAbsent("page-2", [] { return LoadFromDisk(); });
+//!     auto result = counters.Find("page-1");
+
+namespace glib {
+
+namespace concurrent_hash_internal {
+
+const size_t kCacheLineSize = 64;
+
+// 自旋等待时降低 CPU 占用，超线程时让出执行资源给同一个核上的另一个线程
+inline void CpuRelax() {
+#if defined(__SSE2__)
+    _mm_pause();
+#endif
+}
+
+// 先自旋一小段时间，之后让出时间片：线程数多于核数时，持有锁的线程可能正在等待调度
+inline void Backoff(size_t &spins) {
+    const size_t kSpinLimit = 64;
+    if (spins++ < kSpinLimit)
+        CpuRelax();
+    else
+        std::this_thread::yield();
+}
+
+} // namespace concurrent_hash_internal
+
+//! \brief 读写自旋锁：一个 32 位原子变量，最低位为写锁，次低位为「有写操作在等待」，其余位为读者个数
+//! \note 接口与 std::shared_mutex 相同，可以直接用于 std::lock_guard。写操作等待时阻止新的读者进入
+class SharedSpinLock {
+public: // 构造函数相关
+    SharedSpinLock() noexcept : state_(0) {}
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(SharedSpinLock);
+
+public: // 外部调用核心函数
+    //! \brief 加写锁：没有读者、没有写者时才能获得
+    void lock() {
+        size_t spins = 0;
+        while (true) {
+            uint32_t state = state_.load(std::memory_order_relaxed);
+            if (0 == (state & ~kWriterWaiting)) {
+                // 获得写锁的同时清除等待标记，其他等待的写操作会重新设置
+                if (state_.compare_exchange_weak(state, kWriter, std::memory_order_acquire,
+                                                 std::memory_order_relaxed))
+                    return;
+            } else if (0 == (state & kWriterWaiting)) {
+                state_.fetch_or(kWriterWaiting, std::memory_order_relaxed);
+            }
+            concurrent_hash_internal::Backoff(spins);
+        }
+    }
+
+    //! \brief 尝试加写锁，不等待：有读者、写者时返回 false
+    bool try_lock() {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        return 0 == (state & ~kWriterWaiting) &&
+               state_.compare_exchange_strong(state, kWriter, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() { state_.fetch_and(~kWriter, std::memory_order_release); }
+
+    //! \brief 加读锁：没有写者持有、也没有写者等待时，读者个数加一
+    void lock_shared() {
+        size_t spins = 0;
+        while (true) {
+            uint32_t state = state_.load(std::memory_order_relaxed);
+            if (0 == (state & (kWriter | kWriterWaiting)) &&
+                state_.compare_exchange_weak(state, state + kReader, std::memory_order_acquire,
+                                             std::memory_order_relaxed))
+                return;
+            concurrent_hash_internal::Backoff(spins);
+        }
+    }
+
+    void unlock_shared() { state_.fetch_sub(kReader, std::memory_order_release); }
+
+private:
+    static const uint32_t kWriter        = 1;
+    static const uint32_t kWriterWaiting = 2;
+    static const uint32_t kReader        = 4;
+
+    std::atomic<uint32_t> state_;
+}; // class SharedSpinLock
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _Allocator = NodePool<std::pair<const _Key, _Value> > >
+class ConcurrentHashTable {
+public: // 类型声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+    using TableType  = HashTable<_Key, _Value, _Hash, _Allocator>;
+
+public: // 构造函数相关
+    //! \param num_shards 分片个数，向上取整到 2 的指数次幂，0 表示硬件线程数的 4 倍（至少 16）
+    //! \param shard_capacity 每个分片的初始容量
+    explicit
+    ConcurrentHashTable(size_t num_shards = 0, size_t shard_capacity = 8) : hasher_() {
+        if (0 == num_shards) {
+            num_shards = 4 * utils::ThreadPool::HardwareConcurrency();
+            if (num_shards < kMinShards)
+                num_shards = kMinShards;
+        }
+        num_shards_ = 1;
+        while (num_shards_ < num_shards)
+            num_shards_ *= 2;
+
+        // 多申请一个缓存行的内存，保证第一个分片按缓存行对齐（C++17 之前 new 不保证超过 16 字节的对齐）
+        buffer_ = ::operator new(num_shards_ * sizeof(Shard) + concurrent_hash_internal::kCacheLineSize);
+        uintptr_t address = reinterpret_cast<uintptr_t>(buffer_);
+        address = (address + concurrent_hash_internal::kCacheLineSize - 1) &
+                  ~static_cast<uintptr_t>(concurrent_hash_internal::kCacheLineSize - 1);
+        shards_ = reinterpret_cast<Shard*>(address);
+        size_t constructed = 0;
+        try {
+            for (; constructed < num_shards_; constructed++)
+                new (shards_ + constructed) Shard(shard_capacity);
+        } catch (...) {
+            DestroyShards(constructed);
+            throw;
+        }
+    }
+
+    ~ConcurrentHashTable() { DestroyShards(num_shards_); }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(ConcurrentHashTable);
+
+public: // 外部调用核心函数
+    //! \brief 按照键值查询，返回映射值的拷贝
+    //! \complexity O(1)，只加读锁
+    //! \return first:是否找到，second:映射值的拷贝
+    std::pair<bool, MappedType> Find(const KeyType &key) const {
+        const Shard &shard = ShardFor(key);
+        ReadGuard guard(shard.lock);
+        return shard.table.Find(key);
+    }
+
+    //! \brief 是否存在键值 key
+    bool Contains(const KeyType &key) const {
+        const Shard &shard = ShardFor(key);
+        ReadGuard guard(shard.lock);
+        return nullptr != shard.table.FindPtr(key);
+    }
+
+    //! \brief 在读锁内访问映射值，function(const MappedType&)，不拷贝映射值
+    //! \return 是否找到
+    template <typename _Function>
+    bool Visit(const KeyType &key, _Function function) const {
+        const Shard &shard = ShardFor(key);
+        ReadGuard guard(shard.lock);
+        const MappedType *value = shard.table.FindPtr(key);
+        if (nullptr == value)
+            return false;
+        function(*value);
+        return true;
+    }
+
+    //! \brief 键值不存在时插入 value，存在时调用 update(MappedType&) 原地修改，查找和修改是原子的
+    //! \complexity O(1)
+    //! \return 是否插入了新数据
+    template <typename _Update>
+    bool InsertOrUpdate(const KeyType &key, const MappedType &value, _Update update) {
+        Shard &shard = ShardFor(key);
+        std::lock_guard<SharedSpinLock> guard(shard.lock);
+        MappedType *existing = shard.table.FindPtr(key);
+        if (nullptr != existing) {
+            update(*existing);
+            return false;
+        }
+        shard.table.TryEmplace(key, value);
+        return true;
+    }
+    // 键值已存在时用 value 替换映射值
+    bool InsertOrUpdate(const KeyType &key, const MappedType &value) {
+        Shard &shard = ShardFor(key);
+        std::lock_guard<SharedSpinLock> guard(shard.lock);
+        return shard.table.InsertOrAssign(key, value).second;
+    }
+
+    //! \brief 键值不存在时调用 factory() 构造映射值并插入，多个线程同时调用时 factory 只会执行一次
+    //! \complexity O(1)，已存在时只加读锁
+    //! \return 映射值的拷贝（已存在的或者新插入的）
+    template <typename _Factory>
+    MappedType ComputeIfAbsent(const KeyType &key, _Factory factory) {
+        Shard &shard = ShardFor(key);
+        {
+            ReadGuard guard(shard.lock);
+            const MappedType *value = shard.table.FindPtr(key);
+            if (nullptr != value)
+                return *value;
+        }
+        std::lock_guard<SharedSpinLock> guard(shard.lock);
+        MappedType *value = shard.table.FindPtr(key);   // 读锁释放之后可能被其他线程插入了
+        if (nullptr == value)
+            value = shard.table.TryEmplace(key, factory()).first;
+        return *value;
+    }
+
+    //! \brief 插入数据，键值已存在时替换映射值
+    //! \return 是否插入了新数据
+    bool Insert(const KeyType &key, const MappedType &value) { return InsertOrUpdate(key, value); }
+    bool Insert(const std::pair<KeyType, MappedType> &data)  { return InsertOrUpdate(data.first, data.second); }
+
+    //! \brief 删除键值为 key 的数据
+    //! \return 是否删除了数据
+    bool Delete(const KeyType &key) {
+        Shard &shard = ShardFor(key);
+        std::lock_guard<SharedSpinLock> guard(shard.lock);
+        return shard.table.Delete(key);
+    }
+
+    //! \brief 遍历所有数据（无序），function(const KeyType&, const MappedType&)，逐个分片加读锁
+    //! \note 不是整个哈希表的快照：遍历过程中其他分片仍然可以修改
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        for (size_t i = 0; i < num_shards_; i++) {
+            ReadGuard guard(shards_[i].lock);
+            shards_[i].table.ForEach(function);
+        }
+    }
+    //! \brief 并行遍历：每个分片一个任务，在线程池中执行，function 会在多个线程中同时调用
+    template <typename _Function>
+    void ForEach(_Function function, utils::ThreadPool &pool) const {
+        utils::TaskGroup group(pool);
+        for (size_t i = 0; i < num_shards_; i++) {
+            const Shard *shard = shards_ + i;
+            group.Run([shard, &function]() {
+                ReadGuard guard(shard->lock);
+                shard->table.ForEach(function);
+            });
+        }
+        group.Wait();
+    }
+
+    //! \brief 预留容量：n 个数据均匀分到各个分片，插入过程中一般不会扩容
+    void Reserve(size_t n) {
+        size_t per_shard = (n + num_shards_ - 1) / num_shards_;
+        for (size_t i = 0; i < num_shards_; i++) {
+            std::lock_guard<SharedSpinLock> guard(shards_[i].lock);
+            shards_[i].table.Reserve(per_shard);
+        }
+    }
+
+    //! \brief 数据量：逐个分片加读锁求和，有并发修改时只是近似值
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < num_shards_; i++) {
+            ReadGuard guard(shards_[i].lock);
+            total += shards_[i].table.size();
+        }
+        return total;
+    }
+
+    bool   empty()      const { return 0 == size(); }  // 是否为空
+    size_t num_shards() const { return num_shards_; }  // 分片个数
+
+private: // 类型声明
+    // 一个分片：读写锁 + 哈希表，按缓存行对齐，大小也是缓存行的整数倍
+    struct alignas(concurrent_hash_internal::kCacheLineSize) Shard {
+        explicit Shard(size_t capacity) : table(capacity) {}
+
+        mutable SharedSpinLock lock;
+        TableType              table;
+    };
+
+    // 读锁的 RAII 封装（std::shared_lock 需要 C++14）
+    class ReadGuard {
+    public:
+        explicit ReadGuard(SharedSpinLock &lock) : lock_(lock) { lock_.lock_shared(); }
+        ~ReadGuard() { lock_.unlock_shared(); }
+
+        GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(ReadGuard);
+
+    private:
+        SharedSpinLock &lock_;
+    };
+
+private: // helper functions
+    size_t ShardIndex(const KeyType &key) const {
+        uint64_t hash = hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)));
+        return static_cast<size_t>(hash >> 32) & (num_shards_ - 1);
+    }
+
+    Shard&       ShardFor(const KeyType &key)       { return shards_[ShardIndex(key)]; }
+    const Shard& ShardFor(const KeyType &key) const { return shards_[ShardIndex(key)]; }
+
+    void DestroyShards(size_t count) {
+        for (size_t i = 0; i < count; i++)
+            shards_[i].~Shard();
+        ::operator delete(buffer_);
+    }
+
+private:
+    static const size_t kMinShards = 16; // 默认最少的分片个数
+
+    Hasher  hasher_;      // 选择分片用的哈希函数，分片内部的 HashTable 再单独计算一次
+    size_t  num_shards_;  // 分片个数，2 的指数次幂
+    Shard  *shards_;      // 按缓存行对齐的分片数组，位于 buffer_ 中
+    void   *buffer_;      // 分片数组所在的原始内存
+
+}; // class ConcurrentHashTable
+
+} // namespace glib
+
+#endif // GLIB_CONCURRENT_HASH_TABLE_HPP_
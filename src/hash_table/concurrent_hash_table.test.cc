@@ -0,0 +1,136 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: concurrent_hash_table.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/17
+ * Description: test concurrent hash table
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./concurrent_hash_table.hpp"
+#include "../internal/test_util.h"
+#include <cstdint>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+using glib::test_internal::RunThreads;
+
+//! \brief 并发哈希表测试：基本操作、多线程插入、原子更新、ComputeIfAbsent、读写混合、并行遍历
+//! \run
+//!     g++ concurrent_hash_table.test.cc -std=c++11 -O2 -pthread && ./a.out
+int main(int argc, char const *argv[]) {
+    const size_t kThreads = 8;
+    bool all_ok = true;
+
+    // 1）单线程基本操作
+    cout << "基本操作" << endl;
+    glib::ConcurrentHashTable<string, string> table(5);
+    table.Insert("1", "n");
+    table.Insert(std::make_pair("2", "c"));
+    bool basic_ok = !table.Insert("2", "u") && "u" == table.Find("2").second && 8 == table.num_shards();
+    basic_ok = basic_ok && table.Contains("1") && table.Delete("1") && !table.Delete("1") && !table.Contains("1");
+    basic_ok = basic_ok && table.Visit("2", [](const string &value) { cout << " 2 -> " << value << endl; });
+    basic_ok = basic_ok && 1 == table.size() && !table.empty();
+    cout << (basic_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && basic_ok;
+
+    // 2）多个线程插入不同的键值，之后全部能查到
+    cout << "多线程插入" << endl;
+    const uint64_t kPerThread = 50000;
+    glib::ConcurrentHashTable<uint64_t, uint64_t> numbers;
+    RunThreads(kThreads, [&](size_t index) {
+        for (uint64_t i = 0; i < kPerThread; i++) {
+            uint64_t key = index * kPerThread + i;
+            numbers.Insert(key, key * 2);
+        }
+    });
+    bool insert_ok = kThreads * kPerThread == numbers.size();
+    for (uint64_t key = 0; key < kThreads * kPerThread; key++)
+        insert_ok = insert_ok && key * 2 == numbers.Find(key).second;
+    cout << " size " << numbers.size() << (insert_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && insert_ok;
+
+    // 3）InsertOrUpdate 原子计数：所有线程对同一组键值加一，总数不会丢失
+    cout << "InsertOrUpdate 原子计数" << endl;
+    const size_t kIncrements = 20000;
+    glib::ConcurrentHashTable<int, uint64_t> counters(4);
+    RunThreads(kThreads, [&](size_t index) {
+        for (size_t i = 0; i < kIncrements; i++)
+            counters.InsertOrUpdate(static_cast<int>((i + index) % 100), 1, [](uint64_t &count) { count++; });
+    });
+    uint64_t total = 0;
+    counters.ForEach([&](int, uint64_t count) { total += count; });
+    bool counter_ok = kThreads * kIncrements == total && 100 == counters.size();
+    cout << " total " << total << (counter_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && counter_ok;
+
+    // 4）ComputeIfAbsent：多个线程同时请求同一组键值，每个键值只构造一次，所有线程得到相同的值
+    cout << "ComputeIfAbsent" << endl;
+    atomic<size_t> factory_calls(0);
+    atomic<size_t> mismatches(0);
+    glib::ConcurrentHashTable<int, string> cache;
+    RunThreads(kThreads, [&](size_t index) {
+        for (int key = 0; key < 1000; key++) {
+            string value = cache.ComputeIfAbsent(key, [&]() {
+                factory_calls++;
+                return "value-" + to_string(key) + "-" + to_string(index);
+            });
+            if (value != cache.Find(key).second)
+                mismatches++;
+        }
+    });
+    bool compute_ok = 1000 == factory_calls && 0 == mismatches && 1000 == cache.size();
+    cout << " factory calls " << factory_calls << (compute_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && compute_ok;
+
+    // 5）读写混合：写线程反复插入、删除（映射值总是键值的 3 倍），读线程查到的值必须一致
+    cout << "读写混合" << endl;
+    glib::ConcurrentHashTable<uint64_t, uint64_t> mixed(16);
+    atomic<size_t> bad_reads(0);
+    atomic<size_t> hits(0);
+    RunThreads(kThreads, [&](size_t index) {
+        mt19937_64 engine(index);
+        for (size_t i = 0; i < 100000; i++) {
+            uint64_t key = engine() % 4096;
+            if (index < 2) {        // 两个写线程，插入、删除导致分片内部不断扩容、缩容
+                if (engine() & 1)
+                    mixed.Insert(key, key * 3);
+                else
+                    mixed.Delete(key);
+            } else {
+                auto result = mixed.Find(key);
+                if (result.first) {
+                    hits++;
+                    if (key * 3 != result.second)
+                        bad_reads++;
+                }
+            }
+        }
+    });
+    bool mixed_ok = 0 == bad_reads && hits > 0;
+    cout << " hits " << hits << (mixed_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && mixed_ok;
+
+    // 6）并行遍历：与串行遍历的结果相同
+    cout << "并行 ForEach" << endl;
+    glib::utils::ThreadPool pool(4);
+    atomic<uint64_t> parallel_sum(0);
+    atomic<size_t> parallel_count(0);
+    numbers.ForEach([&](uint64_t key, uint64_t value) {
+        parallel_sum += value - key;
+        parallel_count++;
+    }, pool);
+    uint64_t serial_sum = 0;
+    numbers.ForEach([&](uint64_t key, uint64_t) { serial_sum += key; });
+    bool foreach_ok = parallel_sum == serial_sum && numbers.size() == parallel_count;
+    cout << (foreach_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && foreach_ok;
+
+    return all_ok ? 0 : 1;
+}
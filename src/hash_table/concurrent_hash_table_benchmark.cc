@@ -0,0 +1,137 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: concurrent_hash_table_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/17
+ * Description: throughput benchmark of concurrent hash table vs mutex + HashTable
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "concurrent_hash_table.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! \brief 并发哈希表吞吐量测试：线程数从 1 到 64，读操作占 50%、90%、99%，
+//!        与「一个 std::mutex + HashTable」对比，写操作一半插入、一半删除，数据量基本不变
+//! \run
+//!     g++ concurrent_hash_table_benchmark.cc -std=c++11 -O2 -pthread && ./a.out [每个配置的总操作数]
+
+namespace {
+
+const uint64_t kKeyRange = 1 << 20;   // 键值范围，预先插入一半
+
+// 所有请求都经过一把互斥锁，作为对比的基准
+class MutexHashTable {
+public:
+    pair<bool, uint64_t> Find(uint64_t key) {
+        lock_guard<mutex> guard(mutex_);
+        return table_.Find(key);
+    }
+    void Insert(uint64_t key, uint64_t value) {
+        lock_guard<mutex> guard(mutex_);
+        table_.Insert(key, value);
+    }
+    void Delete(uint64_t key) {
+        lock_guard<mutex> guard(mutex_);
+        table_.Delete(key);
+    }
+
+private:
+    mutex                              mutex_;
+    glib::HashTable<uint64_t, uint64_t> table_;
+};
+
+// 每个线程独立的随机数发生器（xorshift64*），不占用测试时间
+struct FastRandom {
+    explicit FastRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t operator()() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+    uint64_t state;
+};
+
+//! \brief num_threads 个线程同时执行 total_ops 个操作，read_percent% 为查询
+//! \return 吞吐量，百万次操作/秒
+template <typename _Table>
+double Throughput(_Table &table, size_t num_threads, size_t total_ops, unsigned read_percent) {
+    for (uint64_t key = 0; key < kKeyRange; key += 2)
+        table.Insert(key, key);
+
+    atomic<size_t> ready(0);
+    atomic<bool>   start(false);
+    atomic<uint64_t> checksum(0);
+    vector<thread> threads;
+    size_t ops_per_thread = total_ops / num_threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            FastRandom random(t + 1);
+            uint64_t sum = 0;
+            ready++;
+            while (!start.load(memory_order_acquire))
+                this_thread::yield();
+            for (size_t i = 0; i < ops_per_thread; i++) {
+                uint64_t r = random();
+                uint64_t key = (r >> 8) & (kKeyRange - 1);
+                if (r % 100 < read_percent)
+                    sum += table.Find(key).second;
+                else if (r & (1 << 7))
+                    table.Insert(key, key);
+                else
+                    table.Delete(key);
+            }
+            checksum += sum;
+        });
+    }
+    while (ready.load() < num_threads)
+        this_thread::yield();
+    TicToc timer;
+    start.store(true, memory_order_release);
+    for (auto &t: threads)
+        t.join();
+    double elapsed = timer.toc();
+    return static_cast<double>(ops_per_thread * num_threads) / elapsed / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    size_t total_ops = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4000000;
+    const unsigned read_percents[] = {50, 90, 99};
+
+    cout << "operations = " << total_ops << ", keys = " << kKeyRange
+         << ", hardware threads = " << glib::utils::ThreadPool::HardwareConcurrency() << endl;
+    cout << fixed << setprecision(2);
+    cout << setw(8) << "threads" << setw(8) << "read%"
+         << setw(16) << "mutex Mops/s" << setw(18) << "sharded Mops/s" << setw(10) << "speedup" << endl;
+    for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+        for (unsigned read_percent: read_percents) {
+            double mutex_mops, sharded_mops;
+            {
+                MutexHashTable table;
+                mutex_mops = Throughput(table, num_threads, total_ops, read_percent);
+            }
+            {
+                glib::ConcurrentHashTable<uint64_t, uint64_t> table;
+                sharded_mops = Throughput(table, num_threads, total_ops, read_percent);
+            }
+            cout << setw(8) << num_threads << setw(8) << read_percent
+                 << setw(16) << mutex_mops << setw(18) << sharded_mops
+                 << setw(10) << sharded_mops / mutex_mops << endl;
+        }
+    }
+    return 0;
+}
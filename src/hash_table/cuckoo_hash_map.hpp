@@ -0,0 +1,694 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: cuckoo_hash_map.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/21
+ * Description: bucketized cuckoo hash map with bounded lookup cost
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_CUCKOO_HASH_MAP_HPP_
+#define GLIB_CUCKOO_HASH_MAP_HPP_
+#include <cstdint>     // uint8_t、uint32_t、uint64_t
+#include <cstring>     // memcpy memset
+#include <iostream>
+#include <functional>  // std::hash std::equal_to
+#include <memory>      // std::allocator
+#include <new>         // placement new
+#include <stdexcept>   // std::length_error
+#include <type_traits>
+#include <utility>     // std::pair std::move std::forward
+#include <vector>
+#include "hash_table.hpp" // hash_table_internal::IsTransparent、StringHash、StringEqual、hash::FibonacciMix
+
+//! \brief 布谷鸟哈希表（bucketized cuckoo hashing）：每个键值只可能在两个桶中，查找最多比较两个桶
+//!     外部调用核心函数：
+//!         1）往哈希表中添加一个数据：Insert()，键值已存在时替换映射值
+//!            键值不存在时才构造映射值：TryEmplace()，插入或者替换映射值：InsertOrAssign()
+//!         2）从哈希表中删除一个数据：Delete()
+//!         3）在哈希表中查找一个数据：Find() 返回拷贝，FindPtr() 返回映射值的指针
+//!         4）预留容量：Reserve()、清空：Clear()、遍历：ForEach()
+//!     外部调用状态函数：
+//!         1）打印哈希表数据：print_value()
+//!         2）哈希表状态：size()、empty()、capacity()、bucket_count()、load_factor()、stash_size()
+//!         3）插入统计：stats()，搬移次数、最长搬移路径、插入失败（找不到搬移路径）、放入备用区、扩容次数
+//!     内部辅助核心函数：
+//!         1）查找：FindData()，查找插入位置：FindInsertSlot()，搬移路径：SearchPath()
+//!         2）重新分配底层数组：Rehash()
+//!
+//! \Note
+//!     1）每个桶 4 个槽。哈希值经过两个不同的打散函数得到两个桶 b1、b2，键值只能放在这两个桶的 8 个槽中，
+//!        或者放在很小的备用区（stash）里。所以查找最多比较 8 个槽 + 备用区，与数据量、装载因子无关，
+//!        没有拉链法那样偶尔很长的链，也没有线性探测那样偶尔很长的探测序列，尾延迟有上界
+//!     2）每个槽有一个 8 位的标签（哈希值的高 8 位，0 表示空槽），一个桶的 4 个标签放在一个 32 位整数中，
+//!        一次比较就能找出标签相同的槽，只有这些槽才需要比较键值。两个桶在查找开始时一起预取，缓存缺失重叠
+//!     3）插入：两个桶都满时用广度优先搜索找一条最短的搬移路径（最长 kMaxPathLength 步、最多 kMaxSearchNodes 个桶）：
+//!        路径末端的桶有空槽，沿路径把每个元素搬到它的另一个桶，最后在 b1 或 b2 中空出一个槽。
+//!        广度优先得到的路径最短，搬移的元素最少
+//!     4）找不到路径时算一次插入失败：备用区没满时放入备用区，否则扩容为两倍，所有元素重新插入。
+//!        删除之后备用区中的元素如果能放回它的桶，会马上放回，备用区一般一直是空的。
+//!        装载因子超过 kMaxLoadFactor 时也会扩容，4 路布谷鸟哈希在 95% 左右才开始频繁失败
+//!     5）扩容一次性搬移所有元素（不是渐进式的），扩容那次插入很慢；对插入延迟也有要求时先 Reserve()
+//!     6）插入会搬移其他元素，插入、删除之后之前得到的元素地址（包括 FindPtr() 的结果）都会失效
+//!     7）很多键值的哈希值完全相同时（哈希函数有问题），再怎么扩容也放不下，这时抛出 std::length_error
+//!
+//! \complexity
+//!     查找最坏 O(1)：两个桶 + 备用区。插入均摊 O(1)，单次插入最多搬移 kMaxPathLength 个元素（不扩容时）
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!     1）Pagh, Rodler, Cuckoo hashing, 2001
+//!     2）Li et al., Algorithmic improvements for fast concurrent cuckoo hashing, EuroSys 2014（libcuckoo，广度优先搜索）
+//!     3）Kirsch et al., More robust hashing: cuckoo hashing with a stash, 2009
+//!
+//! example
+//!     CuckooHashMap<uint64_t, uint32_t> sessions;
+//!     sessions.Reserve(1000000);
+//!     sessions.Insert(42, 7);
+//!     if (const uint32_t *value = sessions.FindPtr(42))
+//!         ...
+
+namespace glib {
+
+//! \brief 布谷鸟哈希表的插入统计
+struct CuckooStats {
+    size_t displacements   = 0;  // 搬移路径上搬移元素的总次数
+    size_t path_searches   = 0;  // 两个桶都满、需要搜索搬移路径的次数
+    size_t max_path_length = 0;  // 最长的搬移路径
+    size_t insert_failures = 0;  // 找不到搬移路径的次数
+    size_t stash_inserts   = 0;  // 放入备用区的次数
+    size_t resizes         = 0;  // 扩容次数
+
+    void print(std::ostream &os = std::cout) const {
+        os << "  displacements " << displacements << ", path searches " << path_searches
+           << ", max path " << max_path_length << ", failures " << insert_failures
+           << ", stash inserts " << stash_inserts << ", resizes " << resizes << std::endl;
+    }
+};
+
+namespace cuckoo_hash_internal {
+
+const size_t kSlotsPerBucket = 4;
+
+// 一个桶的 4 个标签中与 tag 相同的位置，每个相同的标签对应的字节最高位为 1
+// 只会多报（比较键值时排除），不会漏报
+inline uint32_t MatchTag(uint32_t tags, uint8_t tag) {
+    uint32_t x = tags ^ (0x01010101u * tag);
+    return (x - 0x01010101u) & ~x & 0x80808080u;
+}
+
+// 掩码中最低位的 1 对应的槽
+inline size_t LowestSlot(uint32_t mask) {
+    return static_cast<size_t>(__builtin_ctz(mask)) / 8;
+}
+
+} // namespace cuckoo_hash_internal
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key> >
+class CuckooHashMap {
+public: // 类型、结构声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+    using KeyEqual   = _KeyEqual;
+
+    // 槽中存储的数据
+    struct HashData {
+        KeyType key;        // 键值
+        MappedType value;   // 映射值
+    };
+
+private:
+    using Allocator = std::allocator<HashData>;
+
+    // 键值可能所在的两个桶以及标签
+    struct Position {
+        size_t  first;
+        size_t  second;
+        uint8_t tag;
+    };
+
+    // 广度优先搜索中的一个桶
+    struct PathNode {
+        size_t bucket;
+        int    parent;      // 上一个桶在队列中的下标，起点为 -1
+        int    slot;        // 上一个桶中要搬到这个桶的元素所在的槽
+        int    depth;
+    };
+
+    // 哈希函数、比较函数都支持异构查询时，才能用其他类型的键值查询
+    template <typename _LookupKey>
+    using EnableIfTransparent = typename std::enable_if<
+        hash_table_internal::IsTransparent<Hasher>::value &&
+        hash_table_internal::IsTransparent<KeyEqual>::value &&
+        !std::is_same<typename std::decay<_LookupKey>::type, KeyType>::value>::type;
+
+public: // 构造函数相关
+    //! \param capacity 初始槽数，向上取整到 4 × 2 的幂
+    //! \param stash_capacity 备用区大小，0 表示不使用备用区（找不到搬移路径时直接扩容）
+    explicit
+    CuckooHashMap(size_t capacity = 16, size_t stash_capacity = 4,
+                  const Hasher &hasher = Hasher(), const KeyEqual &key_equal = KeyEqual())
+        : hasher_(hasher), key_equal_(key_equal), tags_(nullptr), slots_(nullptr),
+          bucket_count_(0), current_size_(0), stash_capacity_(stash_capacity) {
+        Allocate(RoundBuckets(capacity));
+        stash_.reserve(stash_capacity_);
+    }
+
+    ~CuckooHashMap() {
+        Destroy();
+    }
+
+    CuckooHashMap(const CuckooHashMap &other) = delete;
+    CuckooHashMap(CuckooHashMap &&other) = delete;
+    CuckooHashMap& operator=(const CuckooHashMap &other) = delete;
+    CuckooHashMap& operator=(CuckooHashMap &&other) = delete;
+
+public: // 外部调用核心函数
+    //! \brief 按照键值查询给定数据，不可修改内部数据
+    //! \complexity 最坏 O(1)
+    //! \return 查询信息，first:是否成功找到，second:成功找到后的映射值
+    std::pair<bool, MappedType> Find(const KeyType &key) const {
+        const HashData *data = FindData(key);
+        return std::make_pair(nullptr != data, (nullptr != data ? data->value : MappedType()));
+    }
+
+    //! \brief 按照键值查询，返回映射值的指针，不拷贝映射值
+    //! \complexity 最坏 O(1)：两个桶 + 备用区
+    //! \return 映射值的地址，没有找到返回 nullptr。插入、删除之后失效
+    MappedType* FindPtr(const KeyType &key) {
+        HashData *data = FindData(key);
+        return nullptr != data ? &data->value : nullptr;
+    }
+    const MappedType* FindPtr(const KeyType &key) const {
+        const HashData *data = FindData(key);
+        return nullptr != data ? &data->value : nullptr;
+    }
+    // 异构查询
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    MappedType* FindPtr(const _LookupKey &key) {
+        HashData *data = FindData(key);
+        return nullptr != data ? &data->value : nullptr;
+    }
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    const MappedType* FindPtr(const _LookupKey &key) const {
+        const HashData *data = FindData(key);
+        return nullptr != data ? &data->value : nullptr;
+    }
+
+    bool Contains(const KeyType &key) const { return nullptr != FindData(key); }
+
+    //! \brief 键值不存在时，用 args 原地构造映射值并插入；键值已存在时什么都不做
+    //! \complexity 均摊 O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename... _Args>
+    std::pair<MappedType*, bool> TryEmplace(const KeyType &key, _Args&&... args) {
+        return TryEmplaceImpl(key, std::forward<_Args>(args)...);
+    }
+    template <typename... _Args>
+    std::pair<MappedType*, bool> TryEmplace(KeyType &&key, _Args&&... args) {
+        return TryEmplaceImpl(std::move(key), std::forward<_Args>(args)...);
+    }
+
+    //! \brief 键值不存在时插入，已存在时替换映射值，value 按照完美转发移动或拷贝
+    //! \complexity 均摊 O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssign(const KeyType &key, _MappedArg &&value) {
+        return InsertOrAssignImpl(key, std::forward<_MappedArg>(value));
+    }
+    template <typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssign(KeyType &&key, _MappedArg &&value) {
+        return InsertOrAssignImpl(std::move(key), std::forward<_MappedArg>(value));
+    }
+
+    //! \brief 在哈希表中插入指定数据，键值已存在时替换映射值
+    //! \complexity 均摊 O(1)
+    //! \return true:插入了新的键值，false:替换了已有键值的映射值
+    bool Insert(const std::pair<KeyType, MappedType> &data) {
+        return InsertOrAssign(data.first, data.second).second;
+    }
+    // 右值版本：键值、映射值都移动到槽中
+    bool Insert(std::pair<KeyType, MappedType> &&data) {
+        return InsertOrAssign(std::move(data.first), std::move(data.second)).second;
+    }
+    // 同上另一种插入方法
+    bool Insert(const KeyType &key, const MappedType &value) {
+        return InsertOrAssign(key, value).second;
+    }
+
+    //! \brief 在哈希表中删除指定值，空出的槽可以放回备用区中的元素
+    //! \complexity 最坏 O(1)
+    //! \return 是否删除了数据
+    bool Delete(const KeyType &key) {
+        const Position position = Locate(key);
+        size_t slot = FindSlot(key, position);
+        if (npos != slot) {
+            slots_[slot].~HashData();
+            tags_[slot] = 0;
+            current_size_--;
+            DrainStash(slot / cuckoo_hash_internal::kSlotsPerBucket);
+            return true;
+        }
+        for (size_t i = 0; i < stash_.size(); i++) {
+            if (key_equal_(stash_[i].key, key)) {
+                RemoveFromStash(i);
+                current_size_--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! \brief 预留容量，保证插入 n 个数据的过程中装载因子不超过 kMaxLoadFactor
+    //! \complexity O(capacity)
+    void Reserve(size_t n) {
+        size_t bucket_count = RoundBuckets(static_cast<size_t>(n / kMaxLoadFactor) + 1);
+        if (bucket_count > bucket_count_)
+            Rehash(bucket_count);
+    }
+
+    //! \brief 删除所有数据，保留底层数组，不清空统计
+    void Clear() {
+        for (size_t i = 0; i < capacity(); i++) {
+            if (0 != tags_[i])
+                slots_[i].~HashData();
+        }
+        memset(tags_, 0, capacity());
+        stash_.clear();
+        current_size_ = 0;
+    }
+
+    //! \brief 遍历所有数据（无序），function(const KeyType&, MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) {
+        for (size_t i = 0; i < capacity(); i++) {
+            if (0 != tags_[i])
+                function(static_cast<const KeyType&>(slots_[i].key), slots_[i].value);
+        }
+        for (auto &data: stash_)
+            function(static_cast<const KeyType&>(data.key), data.value);
+    }
+    // 只读遍历，function(const KeyType&, const MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        for (size_t i = 0; i < capacity(); i++) {
+            if (0 != tags_[i])
+                function(static_cast<const KeyType&>(slots_[i].key), static_cast<const MappedType&>(slots_[i].value));
+        }
+        for (const auto &data: stash_)
+            function(data.key, data.value);
+    }
+
+    // 打印哈希表内容（无序打印）
+    void print_value() const {
+        std::cout << "print start:" << std::endl;
+        if (current_size_ > 0) {
+            ForEach([](const KeyType &key, const MappedType &value) {
+                std::cout << "key: " << key << " " << "value: " << value << std::endl;
+            });
+        } else {
+            std::cout << "哈希表为空!" << std::endl;
+        }
+        std::cout << "print end." << std::endl;
+    }
+
+    size_t size()         const { return current_size_;                                           } // 当前数据量
+    size_t capacity()     const { return bucket_count_ * cuckoo_hash_internal::kSlotsPerBucket;   } // 槽的个数
+    size_t bucket_count() const { return bucket_count_;                                           } // 桶的个数
+    bool   empty()        const { return 0 == current_size_;                                      } // 是否为空
+    double load_factor()  const { return static_cast<double>(size()) / capacity();                } // 当前装载因子
+    size_t stash_size()   const { return stash_.size();                                           } // 备用区中的元素个数
+    // 插入统计
+    const CuckooStats& stats() const { return stats_; }
+
+private: // helper functions
+    //! \brief 计算键值可能所在的两个桶以及标签
+    //! \note 同一个哈希值经过两个不同的打散函数（FibonacciMix、Mix64）得到两个独立的桶，
+    //!       两个桶相同时取相邻的桶，保证是两个不同的桶
+    template <typename _LookupKey>
+    Position Locate(const _LookupKey &key) const {
+        const uint64_t hash  = static_cast<uint64_t>(hasher_(key));
+        const uint64_t first = hash::FibonacciMix(hash);
+        const size_t   mask  = bucket_count_ - 1;
+        Position position;
+        position.first  = static_cast<size_t>(first) & mask;
+        position.second = static_cast<size_t>(hash::Mix64(hash)) & mask;
+        if (position.second == position.first)
+            position.second ^= 1;
+        position.tag = static_cast<uint8_t>(first >> 56);
+        if (0 == position.tag)
+            position.tag = 1;
+        return position;
+    }
+
+    // 桶中 4 个标签
+    uint32_t BucketTags(size_t bucket) const {
+        uint32_t tags;
+        memcpy(&tags, tags_ + bucket * cuckoo_hash_internal::kSlotsPerBucket, sizeof(tags));
+        return tags;
+    }
+
+    //! \brief 在两个桶中查找键值
+    //! \return 槽的下标，没有找到时返回 npos
+    template <typename _LookupKey>
+    size_t FindSlot(const _LookupKey &key, const Position &position) const {
+        const size_t kSlots = cuckoo_hash_internal::kSlotsPerBucket;
+        // 两个桶的槽同时预取，两次缓存不命中重叠
+        __builtin_prefetch(slots_ + position.first * kSlots);
+        __builtin_prefetch(slots_ + position.second * kSlots);
+        const size_t buckets[2] = {position.first, position.second};
+        for (size_t bucket: buckets) {
+            uint32_t match = cuckoo_hash_internal::MatchTag(BucketTags(bucket), position.tag);
+            for (; 0 != match; match &= match - 1) {
+                size_t slot = bucket * kSlots + cuckoo_hash_internal::LowestSlot(match);
+                if (tags_[slot] == position.tag && key_equal_(slots_[slot].key, key))
+                    return slot;
+            }
+        }
+        return npos;
+    }
+
+    //! \brief 在两个桶和备用区中查找键值
+    template <typename _LookupKey>
+    HashData* FindData(const _LookupKey &key) const {
+        size_t slot = FindSlot(key, Locate(key));
+        if (npos != slot)
+            return slots_ + slot;
+        for (const auto &data: stash_) {
+            if (key_equal_(data.key, key))
+                return const_cast<HashData*>(&data);
+        }
+        return nullptr;
+    }
+
+    template <typename _KeyArg, typename... _Args>
+    std::pair<MappedType*, bool> TryEmplaceImpl(_KeyArg &&key, _Args&&... args) {
+        HashData *data = FindData(key);
+        if (nullptr != data)
+            return std::make_pair(&data->value, false);
+        data = EmplaceNew(std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+        return std::make_pair(&data->value, true);
+    }
+
+    template <typename _KeyArg, typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssignImpl(_KeyArg &&key, _MappedArg &&value) {
+        HashData *data = FindData(key);
+        if (nullptr != data) {
+            data->value = std::forward<_MappedArg>(value);
+            return std::make_pair(&data->value, false);
+        }
+        data = EmplaceNew(std::forward<_KeyArg>(key), std::forward<_MappedArg>(value));
+        return std::make_pair(&data->value, true);
+    }
+
+    //! \brief 插入一个不存在的键值：找到空槽（必要时搬移其他元素），找不到时放入备用区或者扩容
+    //! \note 两个桶中有空槽、不需要扩容时直接原地构造；否则搬移、扩容会移动、析构表中的元素，
+    //!       参数可能引用它们（比如 TryEmplace(k2, *FindPtr(k1))），所以先构造好新元素再插入
+    template <typename _KeyArg, typename... _Args>
+    HashData* EmplaceNew(_KeyArg &&key, _Args&&... args) {
+        if (current_size_ + 1 <= static_cast<size_t>(capacity() * kMaxLoadFactor)) {
+            const Position position = Locate(key);
+            size_t slot = EmptySlot(position.first);
+            if (npos == slot)
+                slot = EmptySlot(position.second);
+            if (npos != slot) {
+                new (slots_ + slot) HashData{KeyType(std::forward<_KeyArg>(key)),
+                                             MappedType(std::forward<_Args>(args)...)};
+                tags_[slot] = position.tag;
+                current_size_++;
+                return slots_ + slot;
+            }
+        }
+        return InsertData(HashData{KeyType(std::forward<_KeyArg>(key)), MappedType(std::forward<_Args>(args)...)});
+    }
+
+    //! \brief 插入已经构造好的新元素，必要时搬移、放入备用区或者扩容
+    HashData* InsertData(HashData &&data) {
+        if (current_size_ + 1 > static_cast<size_t>(capacity() * kMaxLoadFactor))
+            Rehash(bucket_count_ * 2);
+        while (true) {
+            const Position position = Locate(data.key);
+            size_t slot = FindInsertSlot(position);
+            if (npos != slot) {
+                new (slots_ + slot) HashData(std::move(data));
+                tags_[slot] = position.tag;
+                current_size_++;
+                return slots_ + slot;
+            }
+            stats_.insert_failures++;
+            if (stash_.size() < stash_capacity_) {
+                stash_.push_back(std::move(data));
+                stats_.stash_inserts++;
+                current_size_++;
+                return &stash_.back();
+            }
+            // 装载因子不高却找不到位置，说明大量键值的哈希值相同，扩容也解决不了
+            if (load_factor() < kMinGrowLoadFactor)
+                throw std::length_error("CuckooHashMap: too many keys share the same hash value");
+            Rehash(bucket_count_ * 2);
+        }
+    }
+
+    //! \brief 为 position 找一个空槽：先看两个桶，都满时搜索搬移路径并搬移
+    //! \return 空槽的下标，找不到时返回 npos（表没有被修改）
+    size_t FindInsertSlot(const Position &position) {
+        size_t slot = EmptySlot(position.first);
+        if (npos != slot)
+            return slot;
+        slot = EmptySlot(position.second);
+        if (npos != slot)
+            return slot;
+        stats_.path_searches++;
+        return SearchPath(position);
+    }
+
+    // 桶中的第一个空槽，没有时返回 npos
+    size_t EmptySlot(size_t bucket) const {
+        uint32_t empty = cuckoo_hash_internal::MatchTag(BucketTags(bucket), 0);
+        return 0 != empty ? bucket * cuckoo_hash_internal::kSlotsPerBucket + cuckoo_hash_internal::LowestSlot(empty)
+                          : npos;
+    }
+
+    //! \brief 广度优先搜索最短的搬移路径，找到后从路径末端开始依次把元素搬到它的另一个桶
+    //! \note 路径上的桶互不相同（入队时检查祖先），搬移时不会覆盖路径上还没有搬走的元素
+    //! \return 起点桶中空出来的槽，找不到路径时返回 npos
+    size_t SearchPath(const Position &position) {
+        const size_t kSlots = cuckoo_hash_internal::kSlotsPerBucket;
+        PathNode queue[kMaxSearchNodes];
+        size_t head = 0, tail = 0;
+        queue[tail++] = PathNode{position.first, -1, -1, 0};
+        queue[tail++] = PathNode{position.second, -1, -1, 0};
+        while (head < tail) {
+            const int index = static_cast<int>(head);
+            const PathNode node = queue[head++];
+            size_t hole = EmptySlot(node.bucket);
+            if (npos != hole)
+                return MoveAlongPath(queue, index, hole);
+            if (node.depth >= static_cast<int>(kMaxPathLength))
+                continue;
+            for (size_t i = 0; i < kSlots && tail < kMaxSearchNodes; i++) {
+                size_t next = OtherBucket(slots_[node.bucket * kSlots + i].key, node.bucket);
+                if (!OnPath(queue, index, next))
+                    queue[tail++] = PathNode{next, index, static_cast<int>(i), node.depth + 1};
+            }
+        }
+        return npos;
+    }
+
+    // bucket 是否已经在以 index 结尾的路径上
+    static bool OnPath(const PathNode *queue, int index, size_t bucket) {
+        for (; index >= 0; index = queue[index].parent) {
+            if (queue[index].bucket == bucket)
+                return true;
+        }
+        return false;
+    }
+
+    // 键值的另一个桶
+    size_t OtherBucket(const KeyType &key, size_t bucket) const {
+        const Position position = Locate(key);
+        return position.first == bucket ? position.second : position.first;
+    }
+
+    //! \brief 从路径末端开始，把上一个桶中的元素搬到当前桶的空槽，空槽随之前移，直到起点桶
+    size_t MoveAlongPath(const PathNode *queue, int index, size_t hole) {
+        const size_t kSlots = cuckoo_hash_internal::kSlotsPerBucket;
+        size_t length = static_cast<size_t>(queue[index].depth);
+        for (; queue[index].parent >= 0; index = queue[index].parent) {
+            size_t from = queue[queue[index].parent].bucket * kSlots + static_cast<size_t>(queue[index].slot);
+            MoveSlot(from, hole);
+            hole = from;
+        }
+        stats_.displacements += length;
+        if (length > stats_.max_path_length)
+            stats_.max_path_length = length;
+        return hole;
+    }
+
+    // 把槽 from 中的元素移动到空槽 to
+    void MoveSlot(size_t from, size_t to) {
+        new (slots_ + to) HashData(std::move(slots_[from]));
+        slots_[from].~HashData();
+        tags_[to]   = tags_[from];
+        tags_[from] = 0;
+    }
+
+    //! \brief 桶 bucket 空出了槽，把备用区中属于这个桶的元素放回去
+    void DrainStash(size_t bucket) {
+        for (size_t i = 0; i < stash_.size(); i++) {
+            const Position position = Locate(stash_[i].key);
+            if (position.first != bucket && position.second != bucket)
+                continue;
+            size_t slot = EmptySlot(bucket);
+            if (npos == slot)
+                return;
+            new (slots_ + slot) HashData(std::move(stash_[i]));
+            tags_[slot] = position.tag;
+            RemoveFromStash(i);
+            return;
+        }
+    }
+
+    void RemoveFromStash(size_t index) {
+        if (index + 1 != stash_.size())
+            stash_[index] = std::move(stash_.back());
+        stash_.pop_back();
+    }
+
+    //! \brief 重新分配 bucket_count 个桶，所有元素（包括备用区）重新插入
+    //! \note 极少数情况下新数组也放不下（备用区也满），再扩大一倍重来。
+    //!       装载因子低于 kMinGrowLoadFactor 还放不下说明哈希函数有问题，扩容没有用，
+    //!       剩下的元素放入备用区（超过备用区大小），保证不丢数据，由 EmplaceNew() 抛出异常
+    //! \complexity O(capacity)
+    void Rehash(size_t bucket_count) {
+        std::vector<HashData> elements;
+        elements.reserve(current_size_);
+        TakeAll(elements);
+        while (true) {
+            Allocate(bucket_count);
+            size_t i = 0;
+            for (; i < elements.size(); i++) {
+                if (!Place(std::move(elements[i])))
+                    break;
+            }
+            if (i == elements.size())
+                break;
+            if (load_factor() < kMinGrowLoadFactor) {
+                for (; i < elements.size(); i++)
+                    stash_.push_back(std::move(elements[i]));
+                break;
+            }
+            std::vector<HashData> rest;
+            rest.reserve(elements.size());
+            TakeAll(rest);
+            for (; i < elements.size(); i++)
+                rest.push_back(std::move(elements[i]));
+            elements.swap(rest);
+            bucket_count *= 2;
+        }
+        stats_.resizes++;
+    }
+
+    //! \brief 扩容时放入一个元素：空槽、搬移路径、备用区，都不行时返回 false（data 没有被移动）
+    bool Place(HashData &&data) {
+        const Position position = Locate(data.key);
+        size_t slot = FindInsertSlot(position);
+        if (npos != slot) {
+            new (slots_ + slot) HashData(std::move(data));
+            tags_[slot] = position.tag;
+            return true;
+        }
+        stats_.insert_failures++;
+        if (stash_.size() < stash_capacity_) {
+            stash_.push_back(std::move(data));
+            stats_.stash_inserts++;
+            return true;
+        }
+        return false;
+    }
+
+    //! \brief 把所有元素（包括备用区）移动到 elements 中，释放底层数组，current_size_ 不变
+    void TakeAll(std::vector<HashData> &elements) {
+        for (size_t i = 0; i < capacity(); i++) {
+            if (0 != tags_[i]) {
+                elements.push_back(std::move(slots_[i]));
+                slots_[i].~HashData();
+            }
+        }
+        for (auto &data: stash_)
+            elements.push_back(std::move(data));
+        stash_.clear();
+        delete[] tags_;
+        Allocator().deallocate(slots_, capacity());
+        tags_  = nullptr;
+        slots_ = nullptr;
+    }
+
+    // 不小于 capacity 个槽的桶数，2 的幂，至少 2 个桶
+    static size_t RoundBuckets(size_t capacity) {
+        size_t bucket_count = 2;
+        while (bucket_count * cuckoo_hash_internal::kSlotsPerBucket < capacity)
+            bucket_count *= 2;
+        return bucket_count;
+    }
+
+    // 分配 bucket_count 个桶（槽未构造），标签都为 0
+    void Allocate(size_t bucket_count) {
+        bucket_count_ = bucket_count;
+        tags_  = new uint8_t[capacity()];
+        memset(tags_, 0, capacity());
+        slots_ = Allocator().allocate(capacity());
+    }
+
+    void Destroy() {
+        if (nullptr == tags_)
+            return;
+        Clear();
+        delete[] tags_;
+        Allocator().deallocate(slots_, capacity());
+        tags_  = nullptr;
+        slots_ = nullptr;
+    }
+
+private:
+    static constexpr size_t npos               = static_cast<size_t>(-1);
+    static constexpr double kMaxLoadFactor     = 0.95;  // 超过时扩容，再高搬移路径变长、插入失败变多
+    static constexpr double kMinGrowLoadFactor = 0.5;   // 低于这个装载因子还放不下时不再扩容，抛出异常
+    static constexpr size_t kMaxPathLength     = 5;     // 搬移路径最多搬移的元素个数
+    static constexpr size_t kMaxSearchNodes    = 256;   // 广度优先搜索最多访问的桶数
+    Hasher                hasher_;          // 哈希函数，结果经过两个打散函数得到两个桶
+    KeyEqual              key_equal_;       // 键值比较函数
+    uint8_t              *tags_;            // 每个槽的标签，0 表示空槽
+    HashData             *slots_;           // 槽数组，只有标签非 0 的槽中有构造好的元素
+    size_t                bucket_count_;    // 桶的个数，2 的幂
+    size_t                current_size_;    // 当前元素个数（包括备用区）
+    size_t                stash_capacity_;  // 备用区大小
+    std::vector<HashData> stash_;           // 备用区：找不到搬移路径的元素
+    CuckooStats           stats_;           // 插入统计
+
+}; // class CuckooHashMap
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr size_t CuckooHashMap<_Key, _Value, _Hash, _KeyEqual>::npos;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr double CuckooHashMap<_Key, _Value, _Hash, _KeyEqual>::kMaxLoadFactor;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr double CuckooHashMap<_Key, _Value, _Hash, _KeyEqual>::kMinGrowLoadFactor;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr size_t CuckooHashMap<_Key, _Value, _Hash, _KeyEqual>::kMaxPathLength;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr size_t CuckooHashMap<_Key, _Value, _Hash, _KeyEqual>::kMaxSearchNodes;
+
+} // namespace glib
+
+#endif // GLIB_CUCKOO_HASH_MAP_HPP_
@@ -0,0 +1,159 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: cuckoo_hash_map.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/21
+ * Description: test cuckoo hash map
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./cuckoo_hash_map.hpp"
+#include "../internal/test_util.h"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+using glib::test_internal::BadHash;
+using glib::test_internal::MapRandomTest;
+
+//! \brief 布谷鸟哈希表测试：随机操作、高装载因子、备用区、异构查询、只能移动的映射值、坏哈希函数
+//! \run
+//!     g++ cuckoo_hash_map.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    mt19937_64 engine(2019);
+    bool all_ok = true;
+
+    // 1）随机操作：整数键值（从很小的表开始，多次扩容）、字符串键值、不使用备用区
+    cout << "随机操作" << endl;
+    vector<uint64_t> integer_keys(20000);
+    for (auto &key: integer_keys) key = engine();
+    vector<string> string_keys;
+    for (int i = 0; i < 5000; i++)
+        string_keys.push_back("key-" + to_string(engine() % 100000) + string(i % 20, 'x'));
+    glib::CuckooHashMap<uint64_t, uint64_t> integers(4);
+    glib::CuckooHashMap<string, uint64_t> strings;
+    glib::CuckooHashMap<uint64_t, uint64_t> no_stash(16, 0);
+    bool random_ok = MapRandomTest(integers, integer_keys, 300000, engine) &&
+                     MapRandomTest(strings, string_keys, 100000, engine) &&
+                     MapRandomTest(no_stash, integer_keys, 300000, engine) && 0 == no_stash.stash_size();
+    integers.stats().print();
+    cout << (random_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && random_ok;
+
+    // 2）高装载因子：预留之后插到 kMaxLoadFactor 附近不扩容，搬移路径不超过 5，所有键值都能查到
+    cout << "高装载因子" << endl;
+    const size_t kNum = 1000000;
+    glib::CuckooHashMap<uint64_t, uint64_t> dense;
+    dense.Reserve(kNum);
+    const size_t capacity = dense.capacity(), reserved_resizes = dense.stats().resizes;
+    const size_t fill = static_cast<size_t>(capacity * 0.94);
+    vector<uint64_t> dense_keys(fill);
+    for (size_t i = 0; i < fill; i++) {
+        dense_keys[i] = engine();
+        dense.Insert(dense_keys[i], i);
+    }
+    bool dense_ok = capacity == dense.capacity() && fill == dense.size() &&
+                    reserved_resizes == dense.stats().resizes &&
+                    dense.stats().max_path_length <= 5 && dense.stats().displacements > 0;
+    for (size_t i = 0; i < fill; i++) {
+        const uint64_t *value = dense.FindPtr(dense_keys[i]);
+        dense_ok = dense_ok && nullptr != value && i == *value;
+    }
+    cout << "  load factor " << dense.load_factor() << ", stash " << dense.stash_size() << endl;
+    dense.stats().print();
+    // 删除一半后再插入同样多的新键值，表不变大
+    for (size_t i = 0; i < fill; i += 2)
+        dense_ok = dense_ok && dense.Delete(dense_keys[i]);
+    for (size_t i = 0; i < fill; i += 2)
+        dense.Insert(engine(), i);
+    for (size_t i = 1; i < fill; i += 2)
+        dense_ok = dense_ok && dense.Contains(dense_keys[i]);
+    dense_ok = dense_ok && fill == dense.size() && capacity == dense.capacity();
+    cout << (dense_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && dense_ok;
+
+    // 3）备用区：固定大小的小表插满（装载因子上限之前就会找不到搬移路径），备用区中的元素能查到、能删除，
+    //    删除桶中元素后备用区中的元素会放回桶中
+    cout << "备用区" << endl;
+    bool stash_ok = false;
+    for (int attempt = 0; attempt < 100 && !stash_ok; attempt++) {
+        glib::CuckooHashMap<uint64_t, uint64_t> small(64, 8);
+        vector<uint64_t> keys;
+        while (0 == small.stash_size() && small.stats().resizes == 0) {
+            keys.push_back(engine());
+            small.Insert(keys.back(), keys.size());
+        }
+        if (0 == small.stats().resizes) {
+            bool found = true;
+            for (size_t i = 0; i < keys.size(); i++)
+                found = found && i + 1 == small.Find(keys[i]).second;
+            // 删除所有桶中的元素，备用区中的元素最终都会回到桶中
+            const uint64_t stashed = keys.back();
+            for (size_t i = 0; i + 1 < keys.size(); i++)
+                small.Delete(keys[i]);
+            stash_ok = found && 1 == small.stats().stash_inserts && 0 == small.stash_size() &&
+                       1 == small.size() && keys.size() == small.Find(stashed).second && small.Delete(stashed) &&
+                       small.empty();
+        }
+    }
+    cout << (stash_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && stash_ok;
+
+    // 4）异构查询、TryEmplace、只能移动的映射值、Clear
+    cout << "接口" << endl;
+    glib::CuckooHashMap<string, int, glib::StringHash, glib::StringEqual> words;
+    words.Insert("apple", 1);
+    words.InsertOrAssign(string("banana"), 2);
+    bool api_ok = 1 == *words.FindPtr("apple") && nullptr == words.FindPtr("cherry") &&
+                  !words.TryEmplace("apple", 10).second && 1 == *words.FindPtr(string("apple")) &&
+                  words.TryEmplace("cherry", 3).second && 3 == words.size();
+    glib::CuckooHashMap<int, unique_ptr<int> > owners;
+    for (int i = 0; i < 1000; i++)
+        owners.TryEmplace(i, new int(i));
+    for (int i = 0; i < 1000; i++)
+        api_ok = api_ok && i == **owners.FindPtr(i);
+    owners.InsertOrAssign(7, unique_ptr<int>(new int(70)));
+    api_ok = api_ok && 70 == **owners.FindPtr(7) && owners.Delete(8) && !owners.Contains(8);
+    owners.Clear();
+    api_ok = api_ok && owners.empty() && !owners.Contains(7);
+    cout << (api_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && api_ok;
+
+    // 5）映射值引用表中的元素：插入时的搬移、扩容不能使用已经移动、析构的元素
+    cout << "插入自身的元素" << endl;
+    glib::CuckooHashMap<int, string> blobs;
+    blobs.TryEmplace(0, string(100, 'x'));
+    bool alias_ok = true;
+    for (int i = 1; i < 20000 && alias_ok; i++) {
+        const string &source = *blobs.FindPtr(static_cast<int>(engine() % static_cast<uint64_t>(i)));
+        alias_ok = (i % 2 ? blobs.TryEmplace(i, source) : blobs.InsertOrAssign(i, source)).second;
+    }
+    for (int i = 0; i < 20000 && alias_ok; i++)
+        alias_ok = string(100, 'x') == *blobs.FindPtr(i);
+    alias_ok = alias_ok && blobs.stats().resizes > 0 && blobs.stats().displacements > 0;
+    cout << (alias_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && alias_ok;
+
+    // 6）哈希函数只有 4 种取值：最多放 8 个桶槽 + 备用区，之后抛出异常而不是无限扩容
+    cout << "坏哈希函数" << endl;
+    glib::CuckooHashMap<uint64_t, uint64_t, BadHash> bad;
+    bool bad_ok = false;
+    try {
+        for (uint64_t i = 0; i < 1000; i++)
+            bad.Insert(i, i);
+    } catch (const std::length_error &error) {
+        cout << "  " << error.what() << ", size " << bad.size() << endl;
+        bad_ok = bad.size() > 0 && bad.Contains(0);
+    }
+    cout << (bad_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && bad_ok;
+
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: cuckoo_hash_map_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/21
+ * Description: tail latency benchmark of CuckooHashMap vs chained HashTable
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "cuckoo_hash_map.hpp"
+#include "hash_table.hpp"
+#include <algorithm> // std::sort
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! \brief 尾延迟测试：逐次计时每个操作，输出 p50/p90/p99/p99.9/max（纳秒）
+//!        1）查询命中、查询不命中：表插入完成（HashTable 搬移完旧桶）之后随机查询
+//!        2）插入：不预留容量（包括扩容），以及先 Reserve() 再插入
+//!        计时本身有几十纳秒的开销，比较相对值即可。数据量大于缓存时查询延迟主要是缓存缺失：
+//!        HashTable 查询 = 桶 + 链上每个节点各一次缺失，CuckooHashMap 查询最多 = 两个桶的标签和槽
+//! \run
+//!     g++ cuckoo_hash_map_benchmark.cc -std=c++11 -O2 && ./a.out [数据量，默认 4M]
+
+namespace {
+
+const size_t kSamples = 1 << 21;   // 查询计时次数
+
+// xorshift 随机数，比 mt19937 快，不影响测量
+struct FastRandom {
+    uint64_t state;
+    explicit FastRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint64_t operator()() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// 单个操作的耗时（纳秒）
+template <typename _Function>
+uint32_t TimeOne(_Function function) {
+    auto start = chrono::steady_clock::now();
+    function();
+    auto end = chrono::steady_clock::now();
+    return static_cast<uint32_t>(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+}
+
+// 打印一组延迟的分位数
+void PrintPercentiles(const string &name, vector<uint32_t> &latency) {
+    sort(latency.begin(), latency.end());
+    auto at = [&](double p) { return latency[static_cast<size_t>(p * (latency.size() - 1))]; };
+    cout << setw(30) << left << name << right << setw(8) << at(0.5) << setw(8) << at(0.9) << setw(8) << at(0.99)
+         << setw(9) << at(0.999) << setw(10) << latency.back() << endl;
+}
+
+//! \brief 查询延迟：keys 中随机取一个（hit）或者随机数（miss）
+template <typename _Map>
+void LookupLatency(const string &name, const _Map &map, const vector<uint64_t> &keys, bool hit,
+                   uint64_t &checksum) {
+    FastRandom random(keys.size() + hit);
+    vector<uint64_t> lookups(kSamples);
+    for (auto &key: lookups)
+        key = hit ? keys[random() % keys.size()] : random();
+    vector<uint32_t> latency(kSamples);
+    for (size_t i = 0; i < kSamples; i++) {
+        latency[i] = TimeOne([&]() {
+            const uint64_t *value = map.FindPtr(lookups[i]);
+            checksum += nullptr != value ? *value : 1;
+        });
+    }
+    PrintPercentiles(name + (hit ? " find hit" : " find miss"), latency);
+}
+
+//! \brief 插入延迟：依次插入 keys，reserve 为 true 时先预留容量
+template <typename _Map>
+void InsertLatency(const string &name, _Map &map, const vector<uint64_t> &keys, bool reserve) {
+    if (reserve)
+        map.Reserve(keys.size());
+    vector<uint32_t> latency(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+        latency[i] = TimeOne([&]() { map.InsertOrAssign(keys[i], i); });
+    PrintPercentiles(name + (reserve ? " insert reserved" : " insert"), latency);
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    const size_t size = argc > 1 ? strtoull(argv[1], nullptr, 10) : (size_t(1) << 22);
+    FastRandom random(2019);
+    vector<uint64_t> keys(size);
+    for (auto &key: keys) key = random();
+
+    cout << "size " << size << ", latency in ns" << endl;
+    cout << setw(30) << left << "operation" << right << setw(8) << "p50" << setw(8) << "p90" << setw(8) << "p99"
+         << setw(9) << "p99.9" << setw(10) << "max" << endl;
+
+    glib::HashTable<uint64_t, uint64_t> chained;
+    glib::CuckooHashMap<uint64_t, uint64_t> cuckoo;
+    InsertLatency("HashTable", chained, keys, false);
+    InsertLatency("CuckooHashMap", cuckoo, keys, false);
+    {
+        glib::HashTable<uint64_t, uint64_t> chained_reserved;
+        glib::CuckooHashMap<uint64_t, uint64_t> cuckoo_reserved;
+        InsertLatency("HashTable", chained_reserved, keys, true);
+        InsertLatency("CuckooHashMap", cuckoo_reserved, keys, true);
+    }
+    while (chained.RehashStep(1024)) {}
+
+    uint64_t checksum = 0;
+    LookupLatency("HashTable", chained, keys, true, checksum);
+    LookupLatency("CuckooHashMap", cuckoo, keys, true, checksum);
+    LookupLatency("HashTable", chained, keys, false, checksum);
+    LookupLatency("CuckooHashMap", cuckoo, keys, false, checksum);
+
+    const glib::CuckooStats &stats = cuckoo.stats();
+    cout << "cuckoo: load factor " << cuckoo.load_factor() << ", displacements " << stats.displacements
+         << ", max path " << stats.max_path_length << ", insert failures " << stats.insert_failures
+         << ", stash " << cuckoo.stash_size() << ", resizes " << stats.resizes
+         << " (checksum " << (checksum & 0xFF) << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,551 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: flat_hash_map.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/15
+ * Description: open addressing hash map with SIMD control byte groups
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_FLAT_HASH_MAP_HPP_
+#define GLIB_FLAT_HASH_MAP_HPP_
+#include <cstdint>     // int8_t、uint64_t
+#include <cstring>     // memset memcpy
+#include <iostream>
+#include <functional>  // std::hash std::equal_to
+#include <memory>      // std::allocator
+#include <new>         // placement new
+#include <type_traits>
+#include <utility>     // std::pair std::move std::forward
+#include <vector>      // hash_diagnostics
+#include "hash_table.hpp" // hash_table_internal::IsTransparent、StringHash、StringEqual、hash::FibonacciMix
+
+#if defined(__SSE2__)
+#define GLIB_FLAT_HASH_MAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+//! \brief 开放寻址哈希表（参考 SwissTable）：数据直接存放在连续的槽（slot）数组中，不需要为每个元素分配节点
+//!     外部调用核心函数：
+//!         1）往哈希表中添加一个数据：Insert()，两种插入方法，键值已存在时替换映射值
+//!            键值不存在时才构造映射值：TryEmplace()，插入或者替换映射值：InsertOrAssign()
+//!         2）从哈希表中删除一个数据：Delete()
+//!         3）在哈希表中查找一个数据：Find() 返回拷贝，FindPtr() 返回映射值的指针
+//!         4）预留容量：Reserve()、清空：Clear()、遍历：ForEach()
+//!     外部调用状态函数：
+//!         1）打印哈希表数据：print_value()
+//!         2）哈希表状态：size()、empty()、capacity()、load_factor()、max_load_factor()、memory_usage()
+//!         3）哈希质量诊断：hash_diagnostics()，探测距离分布
+//!     内部辅助核心函数：
+//!         1）查找键值所在的槽：FindSlot()，查找插入位置：FindEmptySlot()
+//!         2）删除后向前搬移：BackwardShift()，重新分配底层数组：Rehash()
+//!
+//! \Note
+//!     1）每个槽对应一个控制字节：空槽为 kEmpty（最高位为 1），有数据时保存哈希值的低 7 位（H2）。
+//!        哈希值的其他位（H1）决定起始位置，查找时一次读入 16 个控制字节（SSE2），
+//!        用一条比较指令找出 H2 相同的槽，只有这些槽才需要比较键值；组内有空槽说明查找结束
+//!     2）线性探测 + 删除时向前搬移（backward shift），没有墓碑（tombstone）标记：
+//!        删除后把后面「可以更靠近起始位置」的元素依次前移，所以任何元素从起始位置到所在槽之间都没有空槽，
+//!        删除很多数据之后查找也不会变慢，不需要定期清理墓碑
+//!     3）控制字节数组末尾多复制 16 个字节（前 16 个控制字节的副本），从任意位置读入 16 个字节都不会越界，
+//!        回绕到数组开头时也不需要特殊处理
+//!     4）与 HashTable（拉链法）的接口兼容：Insert()/Find()/Delete()/TryEmplace()/InsertOrAssign()/FindPtr()。
+//!        不会自动缩容，需要时调用 Reserve()
+//!     5）元素按值存放在槽中，扩容会移动元素，插入、删除后之前得到的元素地址（包括 FindPtr() 的结果）都会失效
+//!     6）异构查询：哈希函数和比较函数都定义了 is_transparent（比如 StringHash + StringEqual）时，
+//!        FindPtr() 可以直接用 const char*、string_view 查询 string 键值
+//!
+//! \complexity
+//!     查找、插入、删除平均 O(1)。成功查找通常只需要读一组控制字节 + 起始位置附近的一个槽，
+//!     读控制字节的同时预取起始位置的槽，两次缓存不命中重叠，延迟接近一次
+//!
+//! \memory
+//!     每个元素占用 (sizeof(key) + sizeof(value) + 1) / 装载因子 个字节，装载因子在 7/16 ~ 7/8 之间。
+//!     uint64 -> uint64 时 19~39 字节；拉链法的 HashTable 每个元素一次 new（24 字节节点，
+//!     加上分配器头部后 32 字节）+ 8/装载因子 字节的桶，43~53 字节。键值、映射值越大，节省的比例越小
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!     1）Abseil Swiss Tables：https://abseil.io/about/design/swisstables
+//!     2）线性探测的删除：Knuth, The Art of Computer Programming Vol.3, 6.4 Algorithm R
+//!
+//! example
+//!     FlatHashMap<uint64_t, uint32_t> sessions;
+//!     sessions.Reserve(1000000);
+//!     sessions.Insert(42, 7);
+//!     auto target = sessions.Find(42);
+//!     if (target.first)
+//!         sessions.Insert(42, target.second + 1);
+
+namespace glib {
+
+namespace flat_hash_internal {
+
+using ControlByte = int8_t;
+
+const ControlByte kEmpty      = -128;  // 0b10000000，有数据时最高位为 0
+const size_t      kGroupWidth = 16;    // 一次比较的控制字节个数
+
+inline size_t      H1(uint64_t hash) { return static_cast<size_t>(hash >> 7);             } // 起始位置
+inline ControlByte H2(uint64_t hash) { return static_cast<ControlByte>(hash & 0x7F);      } // 控制字节
+
+//! \brief 一组 16 个控制字节，比较结果是 16 位的掩码，第 i 位为 1 表示第 i 个控制字节满足条件
+struct Group {
+    explicit Group(const ControlByte *control) {
+#if GLIB_FLAT_HASH_MAP_SSE2
+        bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+#else
+        memcpy(bytes, control, kGroupWidth);
+#endif
+    }
+
+    // 控制字节等于 h2 的位置
+    uint32_t Match(ControlByte h2) const {
+#if GLIB_FLAT_HASH_MAP_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(h2))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++)
+            mask |= static_cast<uint32_t>(bytes[i] == h2) << i;
+        return mask;
+#endif
+    }
+
+    // 空槽的位置：只有 kEmpty 的最高位为 1，直接取每个字节的符号位
+    uint32_t MatchEmpty() const {
+#if GLIB_FLAT_HASH_MAP_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+#else
+        return Match(kEmpty);
+#endif
+    }
+
+#if GLIB_FLAT_HASH_MAP_SSE2
+    __m128i bytes;
+#else
+    ControlByte bytes[kGroupWidth];
+#endif
+};
+
+// 掩码中最低位 1 的位置
+inline size_t LowestBit(uint32_t mask) {
+    return static_cast<size_t>(__builtin_ctz(mask));
+}
+
+} // namespace flat_hash_internal
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key> >
+class FlatHashMap {
+public: // 类型、结构声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+    using KeyEqual   = _KeyEqual;
+
+    // 槽中存储的数据
+    struct HashData {
+        KeyType key;        // 键值
+        MappedType value;   // 映射值
+    };
+
+private:
+    using ControlByte = flat_hash_internal::ControlByte;
+    using Group       = flat_hash_internal::Group;
+    using Allocator   = std::allocator<HashData>;
+
+    // 哈希函数、比较函数都支持异构查询时，才能用其他类型的键值查询
+    template <typename _LookupKey>
+    using EnableIfTransparent = typename std::enable_if<
+        hash_table_internal::IsTransparent<Hasher>::value &&
+        hash_table_internal::IsTransparent<KeyEqual>::value &&
+        !std::is_same<typename std::decay<_LookupKey>::type, KeyType>::value>::type;
+
+public: // 构造函数相关
+    // 容量是 2 的指数次幂，至少为一组控制字节的大小
+    explicit
+    FlatHashMap(size_t capacity = 16, double max_load_factor = 0.875,
+                const Hasher &hasher = Hasher(), const KeyEqual &key_equal = KeyEqual())
+        : hasher_(hasher), key_equal_(key_equal), max_load_factor_(max_load_factor),
+          control_(nullptr), slots_(nullptr), capacity_(0), current_size_(0) {
+        if (max_load_factor_ <= 0 || max_load_factor_ > kMaxLoadFactor)
+            max_load_factor_ = kMaxLoadFactor;
+        Allocate(RoundCapacity(capacity));
+    }
+
+    ~FlatHashMap() {
+        Destroy();
+    }
+
+    FlatHashMap(const FlatHashMap &other) = delete;
+    FlatHashMap(FlatHashMap &&other) = delete;
+    FlatHashMap& operator=(const FlatHashMap &other) = delete;
+    FlatHashMap& operator=(FlatHashMap &&other) = delete;
+
+public: // 外部调用核心函数
+    //! \brief 按照键值查询给定数据，不可修改内部数据
+    //! \complexity average case O(1)
+    //! \return 查询信息，first:是否成功找到，second:成功找到后的映射值
+    std::pair<bool, MappedType> Find(const KeyType &key) const {
+        size_t index = FindSlot(key, Hash(key));
+        return std::make_pair(npos != index, (npos != index ? slots_[index].value : MappedType()));
+    }
+
+    //! \brief 按照键值查询，返回映射值的指针，不拷贝映射值
+    //! \complexity average case O(1)
+    //! \return 映射值的地址，没有找到返回 nullptr。插入、删除之后失效
+    MappedType* FindPtr(const KeyType &key) {
+        size_t index = FindSlot(key, Hash(key));
+        return npos != index ? &slots_[index].value : nullptr;
+    }
+    const MappedType* FindPtr(const KeyType &key) const {
+        size_t index = FindSlot(key, Hash(key));
+        return npos != index ? &slots_[index].value : nullptr;
+    }
+    // 异构查询
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    MappedType* FindPtr(const _LookupKey &key) {
+        size_t index = FindSlot(key, Hash(key));
+        return npos != index ? &slots_[index].value : nullptr;
+    }
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    const MappedType* FindPtr(const _LookupKey &key) const {
+        size_t index = FindSlot(key, Hash(key));
+        return npos != index ? &slots_[index].value : nullptr;
+    }
+
+    //! \brief 键值不存在时，用 args 原地构造映射值并插入；键值已存在时什么都不做
+    //! \complexity average case O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename... _Args>
+    std::pair<MappedType*, bool> TryEmplace(const KeyType &key, _Args&&... args) {
+        return TryEmplaceImpl(key, std::forward<_Args>(args)...);
+    }
+    template <typename... _Args>
+    std::pair<MappedType*, bool> TryEmplace(KeyType &&key, _Args&&... args) {
+        return TryEmplaceImpl(std::move(key), std::forward<_Args>(args)...);
+    }
+
+    //! \brief 键值不存在时插入，已存在时替换映射值，value 按照完美转发移动或拷贝
+    //! \complexity average case O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssign(const KeyType &key, _MappedArg &&value) {
+        return InsertOrAssignImpl(key, std::forward<_MappedArg>(value));
+    }
+    template <typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssign(KeyType &&key, _MappedArg &&value) {
+        return InsertOrAssignImpl(std::move(key), std::forward<_MappedArg>(value));
+    }
+
+    //! \brief 在哈希表中插入指定数据，键值已存在时替换映射值
+    //! \complexity average case O(1)
+    //! \return true:插入了新的键值，false:替换了已有键值的映射值
+    bool Insert(const std::pair<KeyType, MappedType> &data) {
+        return InsertOrAssign(data.first, data.second).second;
+    }
+    // 右值版本：键值、映射值都移动到槽中
+    bool Insert(std::pair<KeyType, MappedType> &&data) {
+        return InsertOrAssign(std::move(data.first), std::move(data.second)).second;
+    }
+    // 同上另一种插入方法
+    bool Insert(const KeyType &key, const MappedType &value) {
+        return InsertOrAssign(key, value).second;
+    }
+
+    //! \brief 在哈希表中删除指定值，后面的元素向前搬移填补空槽
+    //! \complexity average case O(1)
+    //! \return 是否删除了数据
+    bool Delete(const KeyType &key) {
+        size_t index = FindSlot(key, Hash(key));
+        if (npos == index)
+            return false;
+        slots_[index].~HashData();
+        BackwardShift(index);
+        current_size_--;
+        return true;
+    }
+
+    //! \brief 预留容量，保证插入 n 个数据的过程中不会扩容
+    //! \complexity O(capacity)
+    void Reserve(size_t n) {
+        size_t capacity = RoundCapacity(static_cast<size_t>(n / max_load_factor_) + 1);
+        if (capacity > capacity_)
+            Rehash(capacity);
+    }
+
+    //! \brief 删除所有数据，保留底层数组
+    void Clear() {
+        for (size_t i = 0; i < capacity_; i++) {
+            if (IsFull(control_[i]))
+                slots_[i].~HashData();
+        }
+        memset(control_, flat_hash_internal::kEmpty, capacity_ + flat_hash_internal::kGroupWidth);
+        current_size_ = 0;
+    }
+
+    //! \brief 遍历所有数据（无序），function(const KeyType&, MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) {
+        for (size_t i = 0; i < capacity_; i++) {
+            if (IsFull(control_[i]))
+                function(static_cast<const KeyType&>(slots_[i].key), slots_[i].value);
+        }
+    }
+    // 只读遍历，function(const KeyType&, const MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        for (size_t i = 0; i < capacity_; i++) {
+            if (IsFull(control_[i]))
+                function(static_cast<const KeyType&>(slots_[i].key), static_cast<const MappedType&>(slots_[i].value));
+        }
+    }
+
+    // 打印哈希表内容（无序打印）
+    void print_value() const {
+        std::cout << "print start:" << std::endl;
+        if (current_size_ > 0) {
+            for (size_t i = 0; i < capacity_; i++) {
+                if (IsFull(control_[i])) {
+                    std::cout << "key: " << slots_[i].key << " "
+                              << "index: " << i << " "
+                              << "value: " << slots_[i].value << std::endl;
+                }
+            }
+        } else {
+            std::cout << "哈希表为空!" << std::endl;
+        }
+        std::cout << "print end." << std::endl;
+    }
+
+    size_t size()            const { return current_size_;                             } // 当前哈希表数据量
+    size_t capacity()        const { return capacity_;                                 } // 槽的个数
+    bool   empty()           const { return 0 == current_size_;                        } // 当前哈希表是否为空
+    double load_factor()     const { return static_cast<double>(size()) / capacity();  } // 当前装载因子
+    double max_load_factor() const { return max_load_factor_;                          } // 最大装载因子
+    // 底层数组占用的字节数（不包括键值、映射值自己分配的内存，比如 string 的堆内存）
+    size_t memory_usage()    const {
+        return capacity_ * sizeof(HashData) + capacity_ + flat_hash_internal::kGroupWidth;
+    }
+
+    //! \brief 哈希质量诊断：探测距离分布、最远的探测距离、成功查找平均比较的槽数与理论值
+    //! \note 线性探测成功查找的理论值为 (1 + 1 / (1 - 装载因子)) / 2（Knuth）
+    //! \complexity O(capacity)
+    hash::Diagnostics hash_diagnostics() const {
+        hash::Diagnostics diagnostics;
+        diagnostics.size    = current_size_;
+        diagnostics.buckets = capacity_;
+        const size_t mask = capacity_ - 1;
+        std::vector<bool> used_home(capacity_, false);
+        size_t total_probes = 0;
+        for (size_t i = 0; i < capacity_; i++) {
+            if (!IsFull(control_[i]))
+                continue;
+            size_t home = flat_hash_internal::H1(Hash(slots_[i].key)) & mask;
+            size_t distance = (i - home) & mask;
+            if (distance >= diagnostics.histogram.size())
+                diagnostics.histogram.resize(distance + 1, 0);
+            diagnostics.histogram[distance]++;
+            if (!used_home[home]) {
+                used_home[home] = true;
+                diagnostics.used_buckets++;
+            }
+            if (distance + 1 > diagnostics.max_probe) {
+                diagnostics.max_probe    = distance + 1;
+                diagnostics.worst_bucket = home;
+            }
+            total_probes += distance + 1;
+        }
+        if (current_size_ > 0) {
+            diagnostics.average_probes  = static_cast<double>(total_probes) / current_size_;
+            diagnostics.expected_probes = (1.0 + 1.0 / (1.0 - load_factor())) / 2.0;
+        }
+        return diagnostics;
+    }
+
+private: // helper functions
+    static bool IsFull(ControlByte control) { return control >= 0; }
+
+    template <typename _LookupKey>
+    uint64_t Hash(const _LookupKey &key) const {
+        // 打散哈希值：std::hash 对整数是恒等映射，低 7 位、起始位置直接取自键值会造成大量冲突
+        return hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)));
+    }
+
+    template <typename _KeyArg, typename... _Args>
+    std::pair<MappedType*, bool> TryEmplaceImpl(_KeyArg &&key, _Args&&... args) {
+        uint64_t hash = Hash(key);
+        size_t index = FindSlot(key, hash);
+        if (npos != index)
+            return std::make_pair(&slots_[index].value, false);
+        index = InsertNew(hash, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+        return std::make_pair(&slots_[index].value, true);
+    }
+
+    template <typename _KeyArg, typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssignImpl(_KeyArg &&key, _MappedArg &&value) {
+        uint64_t hash = Hash(key);
+        size_t index = FindSlot(key, hash);
+        if (npos != index) {
+            slots_[index].value = std::forward<_MappedArg>(value);
+            return std::make_pair(&slots_[index].value, false);
+        }
+        index = InsertNew(hash, std::forward<_KeyArg>(key), std::forward<_MappedArg>(value));
+        return std::make_pair(&slots_[index].value, true);
+    }
+
+    //! \brief 插入不存在的键值，必要时扩容，返回插入的槽
+    //! \note 参数可能引用表中的元素（比如 TryEmplace(k2, *FindPtr(k1))），扩容会移动、析构它们，
+    //!       所以需要扩容时先构造好新元素，再重新分配
+    template <typename _KeyArg, typename... _Args>
+    size_t InsertNew(uint64_t hash, _KeyArg &&key, _Args&&... args) {
+        size_t index;
+        if (current_size_ + 1 > GrowthThreshold()) {
+            HashData data{KeyType(std::forward<_KeyArg>(key)), MappedType(std::forward<_Args>(args)...)};
+            Rehash(capacity_ * 2);
+            index = FindEmptySlot(hash);
+            new (slots_ + index) HashData(std::move(data));
+        } else {
+            index = FindEmptySlot(hash);
+            new (slots_ + index) HashData{KeyType(std::forward<_KeyArg>(key)), MappedType(std::forward<_Args>(args)...)};
+        }
+        SetControl(index, flat_hash_internal::H2(hash));
+        current_size_++;
+        return index;
+    }
+
+    size_t GrowthThreshold() const {
+        return static_cast<size_t>(capacity_ * max_load_factor_);
+    }
+
+    // 不小于 capacity 的 2 的幂，至少为 kGroupWidth
+    static size_t RoundCapacity(size_t capacity) {
+        size_t result = flat_hash_internal::kGroupWidth;
+        while (result < capacity)
+            result *= 2;
+        return result;
+    }
+
+    //! \brief 设置控制字节，前 kGroupWidth 个控制字节同时更新末尾的副本
+    void SetControl(size_t index, ControlByte control) {
+        control_[index] = control;
+        if (index < flat_hash_internal::kGroupWidth)
+            control_[capacity_ + index] = control;
+    }
+
+    //! \brief 按照键值查找所在的槽
+    //! \complexity average case O(1)
+    //! \return 槽的下标，没有找到时返回 npos
+    template <typename _LookupKey>
+    size_t FindSlot(const _LookupKey &key, uint64_t hash) const {
+        const size_t mask = capacity_ - 1;
+        const ControlByte h2 = flat_hash_internal::H2(hash);
+        size_t position = flat_hash_internal::H1(hash) & mask;
+        // 线性探测时元素通常就在起始位置附近，读控制字节的同时预取槽，两次缓存不命中可以重叠
+        __builtin_prefetch(slots_ + position);
+        while (true) {
+            Group group(control_ + position);
+            for (uint32_t match = group.Match(h2); 0 != match; match &= match - 1) {
+                size_t index = (position + flat_hash_internal::LowestBit(match)) & mask;
+                if (key_equal_(slots_[index].key, key))
+                    return index;
+            }
+            if (0 != group.MatchEmpty())   // 从起始位置到元素所在槽之间没有空槽
+                return npos;
+            position = (position + flat_hash_internal::kGroupWidth) & mask;
+        }
+    }
+
+    //! \brief 从起始位置开始的第一个空槽，装载因子小于 1，一定能找到
+    size_t FindEmptySlot(uint64_t hash) const {
+        const size_t mask = capacity_ - 1;
+        size_t position = flat_hash_internal::H1(hash) & mask;
+        while (true) {
+            uint32_t empty = Group(control_ + position).MatchEmpty();
+            if (0 != empty)
+                return (position + flat_hash_internal::LowestBit(empty)) & mask;
+            position = (position + flat_hash_internal::kGroupWidth) & mask;
+        }
+    }
+
+    //! \brief 删除 hole 中的元素之后（已析构），把后面的元素向前搬移，保持「起始位置到所在槽之间没有空槽」
+    //! \note 槽 next 中的元素起始位置为 home，如果 home 不在 (hole, next] 之间，就可以搬移到 hole
+    //! \complexity 平均 O(1)，与删除位置之后连续非空槽的个数成正比
+    void BackwardShift(size_t hole) {
+        const size_t mask = capacity_ - 1;
+        for (size_t next = (hole + 1) & mask; IsFull(control_[next]); next = (next + 1) & mask) {
+            size_t home = flat_hash_internal::H1(Hash(slots_[next].key)) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                new (slots_ + hole) HashData(std::move(slots_[next]));
+                slots_[next].~HashData();
+                SetControl(hole, control_[next]);
+                hole = next;
+            }
+        }
+        SetControl(hole, flat_hash_internal::kEmpty);
+    }
+
+    //! \brief 重新分配底层数组，并把所有元素移动过去
+    //! \complexity O(capacity)
+    void Rehash(size_t new_capacity) {
+        ControlByte *old_control  = control_;
+        HashData    *old_slots    = slots_;
+        size_t       old_capacity = capacity_;
+        Allocate(new_capacity);
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (IsFull(old_control[i])) {
+                uint64_t hash = Hash(old_slots[i].key);
+                size_t index = FindEmptySlot(hash);
+                new (slots_ + index) HashData(std::move(old_slots[i]));
+                old_slots[i].~HashData();
+                SetControl(index, flat_hash_internal::H2(hash));
+            }
+        }
+        delete[] old_control;
+        Allocator().deallocate(old_slots, old_capacity);
+    }
+
+    // 分配 capacity 个槽（未构造）以及控制字节，控制字节都为空
+    void Allocate(size_t capacity) {
+        capacity_ = capacity;
+        control_  = new ControlByte[capacity_ + flat_hash_internal::kGroupWidth];
+        memset(control_, flat_hash_internal::kEmpty, capacity_ + flat_hash_internal::kGroupWidth);
+        slots_    = Allocator().allocate(capacity_);
+    }
+
+    void Destroy() {
+        if (nullptr == control_)
+            return;
+        Clear();
+        delete[] control_;
+        Allocator().deallocate(slots_, capacity_);
+        control_ = nullptr;
+        slots_   = nullptr;
+    }
+
+private:
+    static constexpr size_t npos           = static_cast<size_t>(-1);
+    static constexpr double kMaxLoadFactor = 0.875;   // 线性探测，装载因子再大查找长度增长很快
+    Hasher       hasher_;           // 哈希函数，结果再经过 FibonacciMix 打散
+    KeyEqual     key_equal_;        // 键值比较函数
+    double       max_load_factor_;  // 最大装载因子
+    ControlByte *control_;          // 控制字节，capacity_ + kGroupWidth 个
+    HashData    *slots_;            // 槽数组，只有控制字节非空的槽中有构造好的元素
+    size_t       capacity_;         // 槽的个数，2 的幂
+    size_t       current_size_;     // 当前元素个数
+
+}; // class FlatHashMap
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr size_t FlatHashMap<_Key, _Value, _Hash, _KeyEqual>::npos;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual>
+constexpr double FlatHashMap<_Key, _Value, _Hash, _KeyEqual>::kMaxLoadFactor;
+
+} // namespace glib
+
+#endif // GLIB_FLAT_HASH_MAP_HPP_
@@ -0,0 +1,151 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: flat_hash_map.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/15
+ * Description: test flat hash map
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./flat_hash_map.hpp"
+#include "./hash_table.hpp"
+#include "../internal/test_util.h"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <algorithm> // std::shuffle
+#include <vector>
+using namespace std;
+using glib::test_internal::BadHash;
+using glib::test_internal::MapRandomTest;
+
+//! \brief 开放寻址哈希表测试：基本操作、与 unordered_map 的随机对比、内存占用和查找速度与拉链法的对比
+//! \run
+//!     g++ flat_hash_map.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    mt19937_64 engine(2019);
+    bool all_ok = true;
+
+    // 1）与 HashTable 相同的用法
+    cout << "基本操作" << endl;
+    glib::FlatHashMap<string, string> map;
+    map.Insert("1", "n");
+    map.Insert(std::make_pair("2", "c"));
+    map.Insert(std::make_pair("3", "u"));
+    map.Insert(std::make_pair("5", "c"));
+    map.Insert(std::make_pair("5", "G"));   // 替换
+    map.print_value();
+    auto result = map.Find("5");
+    bool basic_ok = result.first && "G" == result.second && 4 == map.size();
+    basic_ok = basic_ok && map.Delete("5") && !map.Delete("5") && !map.Find("5").first && 3 == map.size();
+    cout << " capacity " << map.capacity() << " size " << map.size() << (basic_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && basic_ok;
+
+    // 2）随机操作：整数、字符串、冲突严重的哈希函数
+    cout << "随机对比测试" << endl;
+    vector<uint64_t> int_keys(20000);
+    for (auto &key: int_keys) key = engine();
+    vector<string> string_keys;
+    for (size_t i = 0; i < 5000; i++) string_keys.push_back("session-" + to_string(engine() % 100000));
+    vector<uint64_t> bad_keys;
+    for (uint64_t i = 0; i < 300; i++) bad_keys.push_back(i);
+
+    glib::FlatHashMap<uint64_t, uint64_t> int_map;
+    glib::FlatHashMap<string, uint64_t> string_map(4);
+    glib::FlatHashMap<uint64_t, uint64_t, BadHash> bad_map;
+    bool int_ok    = MapRandomTest(int_map, int_keys, 500000, engine);
+    bool string_ok = MapRandomTest(string_map, string_keys, 200000, engine);
+    bool bad_ok    = MapRandomTest(bad_map, bad_keys, 50000, engine);
+    cout << " int " << (int_ok ? "ok" : "error") << " string " << (string_ok ? "ok" : "error")
+         << " bad hash " << (bad_ok ? "ok" : "error") << endl;
+    all_ok = all_ok && int_ok && string_ok && bad_ok;
+
+    // 3）Reserve 之后插入不会扩容，Clear 之后可以继续使用
+    cout << "Reserve/Clear 测试" << endl;
+    glib::FlatHashMap<uint64_t, uint64_t> reserved;
+    reserved.Reserve(100000);
+    size_t capacity = reserved.capacity();
+    for (uint64_t i = 0; i < 100000; i++) reserved.Insert(i, i);
+    bool reserve_ok = capacity == reserved.capacity() && reserved.load_factor() <= reserved.max_load_factor();
+    reserved.Clear();
+    reserve_ok = reserve_ok && reserved.empty() && !reserved.Find(7).first;
+    reserved.Insert(7, 8);
+    reserve_ok = reserve_ok && 8 == reserved.Find(7).second;
+    cout << (reserve_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && reserve_ok;
+
+    // 4）内存占用与查找速度：100 万个 uint64 -> uint64
+    cout << "与拉链法对比（100 万个 uint64 -> uint64）" << endl;
+    const size_t kNum = 1000000;
+    vector<uint64_t> keys(kNum);
+    for (auto &key: keys) key = engine();
+    glib::FlatHashMap<uint64_t, uint64_t> flat;
+    glib::HashTable<uint64_t, uint64_t> chained;
+    for (size_t i = 0; i < kNum; i++) {
+        flat.Insert(keys[i], i);
+        chained.Insert(keys[i], i);
+    }
+    // 拉链法：每个节点一次 new（malloc 按 16 字节对齐，另有 8 字节头部），再加上桶数组
+    size_t node_bytes = (sizeof(glib::HashTable<uint64_t, uint64_t>::HashNode) + 8 + 15) / 16 * 16;
+    size_t chained_bytes = kNum * node_bytes + chained.capacity() * sizeof(void*);
+    cout << " flat:    " << static_cast<double>(flat.memory_usage()) / kNum << " bytes/entry" << endl;
+    cout << " chained: " << static_cast<double>(chained_bytes) / kNum << " bytes/entry" << endl;
+
+    std::shuffle(keys.begin(), keys.end(), engine);
+    uint64_t sum = 0;
+    TicToc timer;
+    for (auto key: keys) sum += flat.Find(key).second;
+    double flat_ms = timer.toc();
+    timer.tic();
+    for (auto key: keys) sum -= chained.Find(key).second;
+    double chained_ms = timer.toc();
+    cout << " lookup flat " << flat_ms << " ms, chained " << chained_ms << " ms" << endl;
+    bool lookup_ok = 0 == sum;
+    cout << (lookup_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && lookup_ok;
+
+    // 5）不拷贝的接口：TryEmplace 原地构造，InsertOrAssign 移动，FindPtr 异构查询
+    cout << "TryEmplace/InsertOrAssign/FindPtr 测试" << endl;
+    glib::FlatHashMap<string, vector<int>, glib::StringHash, glib::StringEqual> sessions;
+    bool emplace_ok = sessions.TryEmplace("session-1", 1000, 7).second;
+    emplace_ok = emplace_ok && !sessions.TryEmplace("session-1", 5, 5).second;
+    vector<int> data(10, 1);
+    emplace_ok = emplace_ok && sessions.InsertOrAssign("session-2", std::move(data)).second && data.empty();
+    emplace_ok = emplace_ok && !sessions.InsertOrAssign("session-2", vector<int>(20, 2)).second;
+    const char *lookup_key = "session-1";
+    const auto &const_sessions = sessions;
+    emplace_ok = emplace_ok && 1000 == const_sessions.FindPtr(lookup_key)->size()
+                            && 20 == sessions.FindPtr(string("session-2"))->size()
+                            && nullptr == sessions.FindPtr("session-3");
+    sessions.FindPtr("session-1")->push_back(8);
+    emplace_ok = emplace_ok && 1001 == sessions.Find("session-1").second.size();
+    cout << (emplace_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && emplace_ok;
+
+    // 6）插入时扩容，映射值引用表中的元素：先构造新元素再重新分配
+    cout << "插入自身的元素测试" << endl;
+    glib::FlatHashMap<int, string> blobs;
+    int next_key = 0;
+    auto fill_to_limit = [&]() {                               // 再插入一个就会扩容
+        while (static_cast<double>(blobs.size() + 1) <= blobs.capacity() * blobs.max_load_factor()) {
+            blobs.InsertOrAssign(next_key, string(100, static_cast<char>('a' + next_key % 26)));
+            next_key++;
+        }
+    };
+    fill_to_limit();
+    size_t old_capacity = blobs.capacity();
+    bool alias_ok = blobs.TryEmplace(-1, *blobs.FindPtr(3)).second && blobs.capacity() > old_capacity;
+    fill_to_limit();
+    alias_ok = alias_ok && blobs.InsertOrAssign(-2, *blobs.FindPtr(5)).second;
+    alias_ok = alias_ok && string(100, 'd') == *blobs.FindPtr(-1) && string(100, 'f') == *blobs.FindPtr(-2) &&
+               string(100, 'd') == *blobs.FindPtr(3);
+    cout << (alias_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && alias_ok;
+
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: hash.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/19
+ * Description: fast hash functions (integer mixers, wyhash style string hash, bulk hash) and hash diagnostics
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_HASH_HPP_
+#define GLIB_HASH_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <cstring>     // memcpy strlen
+#include <functional>  // std::hash
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GLIB_HASH_X86 1
+#include <immintrin.h>
+#endif
+
+//! \brief 哈希函数族：整数打散、字符串哈希、批量哈希，以及哈希表的哈希质量诊断
+//!     外部调用核心函数：
+//!         1）整数打散：Mix64()（murmur3 finalizer）、FibonacciMix()（一次乘法）、FibonacciBucket()
+//!         2）字符串（任意字节）哈希：HashBytes()，wyhash 风格，每 16 字节一次 64x64->128 位乘法
+//!         3）批量哈希：HashBulk()，整数键值在支持 AVX2 的 CPU 上一次处理 4 个（运行时检测）
+//!         4）哈希函数对象：Hash<_Key>，整数、指针用 Mix64()，字符串用 HashBytes()（支持异构查询），
+//!            其他类型用 std::hash 的结果再 Mix64()
+//!         5）哈希质量诊断：Diagnostics，由 HashTable::hash_diagnostics()、FlatHashMap::hash_diagnostics() 生成
+//!
+//! \Note
+//!     1）libstdc++ 的 std::hash 对整数是恒等映射，桶数是 2 的指数次幂时只用到低位，
+//!        步长为 2^k 的 ID（比如 1024、2048、3072...）全部落到同一个桶。Mix64()/FibonacciMix() 让每一位都影响低位
+//!     2）HashBytes() 不是加密哈希，不能抵御精心构造的碰撞攻击（需要时传入随机 seed）
+//!     3）Diagnostics 中 average_probes 为成功查找平均需要比较的元素个数，expected_probes 为哈希值
+//!        完全均匀时的理论值，quality() = 两者之比，接近 1 说明分布良好，远大于 1 说明有病态键值，
+//!        worst_bucket/max_probe 指出最长的链（或者最远的探测距离）
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!     1）wyhash：https://github.com/wangyi-fudan/wyhash
+//!     2）murmur3 fmix64：https://github.com/aappleby/smhasher
+//!     3）Fibonacci hashing：Knuth, The Art of Computer Programming Vol.3, 6.4
+//!
+//! \example
+//!     glib::HashTable<uint64_t, Order, glib::hash::Hash<uint64_t> > orders;
+//!     glib::HashTable<std::string, int, glib::hash::Hash<std::string> > words;
+//!     words.hash_diagnostics().print();
+
+namespace glib {
+namespace hash {
+
+//! \brief murmur3 的 64 位 finalizer：每一位输入都会影响每一位输出（雪崩）
+inline uint64_t Mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+}
+
+//! \brief 只用一次乘法的打散：高位先折叠到低位，乘以 2^64 / 黄金分割比，再把高位折叠回低位，
+//!        结果的低位（& (capacity - 1)）和高位都可以用来选择桶
+inline uint64_t FibonacciMix(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0x9E3779B97F4A7C15ull;
+    return x ^ (x >> 29);
+}
+
+//! \brief Fibonacci hashing：乘积的最高 bits 位作为桶下标，桶数为 2^bits（0 < bits < 64）
+inline size_t FibonacciBucket(uint64_t x, unsigned bits) {
+    return static_cast<size_t>((x * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+namespace hash_internal {
+
+const uint64_t kSecret0 = 0xA0761D6478BD642Full;
+const uint64_t kSecret1 = 0xE7037ED1A0B428DBull;
+const uint64_t kSecret2 = 0x8EBC6AF09C88C6E3ull;
+
+// 64x64 -> 128 位乘法，返回低 64 位和高 64 位
+inline void Multiply128(uint64_t a, uint64_t b, uint64_t &low, uint64_t &high) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    low  = static_cast<uint64_t>(product);
+    high = static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t a_low = a & 0xFFFFFFFFull, a_high = a >> 32;
+    uint64_t b_low = b & 0xFFFFFFFFull, b_high = b >> 32;
+    uint64_t ll = a_low * b_low, lh = a_low * b_high, hl = a_high * b_low, hh = a_high * b_high;
+    uint64_t middle = (ll >> 32) + (lh & 0xFFFFFFFFull) + (hl & 0xFFFFFFFFull);
+    low  = (ll & 0xFFFFFFFFull) | (middle << 32);
+    high = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+#endif
+}
+
+// 128 位乘积的低位异或高位
+inline uint64_t MultiplyMix(uint64_t a, uint64_t b) {
+    uint64_t low, high;
+    Multiply128(a, b, low, high);
+    return low ^ high;
+}
+
+// 小端读取，memcpy 避免未对齐访问和严格别名问题，编译器会优化为一条 mov
+inline uint64_t Read64(const unsigned char *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint64_t Read32(const unsigned char *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+// 1~3 个字节：首、中、尾三个字节拼起来
+inline uint64_t Read3(const unsigned char *p, size_t length) {
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+}
+
+} // namespace hash_internal
+
+//! \brief 任意字节序列的 64 位哈希（wyhash 风格）
+//! \note 16 字节以内不循环，两次重叠读取覆盖全部字节；更长时每 16 字节一次 128 位乘法，
+//!       超过 48 字节时三路并行，乘法之间没有依赖
+//! \complexity O(length)
+inline uint64_t HashBytes(const void *data, size_t length, uint64_t seed = 0) {
+    using namespace hash_internal;
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    seed ^= MultiplyMix(seed ^ kSecret0, kSecret1);
+    uint64_t a, b;
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t offset = (length >> 3) << 2;     // 4~7 字节时为 0，8~16 字节时为 4
+            a = (Read32(p) << 32) | Read32(p + offset);
+            b = (Read32(p + length - 4) << 32) | Read32(p + length - 4 - offset);
+        } else if (length > 0) {
+            a = Read3(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t remaining = length;
+        if (remaining > 48) {
+            uint64_t lane1 = seed, lane2 = seed;
+            do {
+                seed  = MultiplyMix(Read64(p) ^ kSecret1,      Read64(p + 8)  ^ seed);
+                lane1 = MultiplyMix(Read64(p + 16) ^ kSecret2, Read64(p + 24) ^ lane1);
+                lane2 = MultiplyMix(Read64(p + 32) ^ kSecret0, Read64(p + 40) ^ lane2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (remaining > 16) {
+            seed = MultiplyMix(Read64(p) ^ kSecret1, Read64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        // 最后 16 个字节（可能与前面重叠）
+        a = Read64(p + remaining - 16);
+        b = Read64(p + remaining - 8);
+    }
+    uint64_t low, high;
+    Multiply128(a ^ kSecret1, b ^ seed, low, high);
+    return MultiplyMix(low ^ kSecret0 ^ length, high ^ kSecret1);
+}
+
+#ifdef GLIB_HASH_X86
+
+namespace hash_internal {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi" // 向量类型作为参数的 ABI 提示，这些函数都会被内联
+
+#define GLIB_HASH_TARGET_AVX2 __attribute__((target("avx2")))
+
+//! \brief CPU 是否支持 AVX2，只检测一次
+inline bool HasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+//! \brief 4 个 64 位整数分别乘以常数，取乘积的低 64 位
+//!        x * c 的低 64 位 = lo(x)*lo(c) + ((hi(x)*lo(c) + lo(x)*hi(c)) << 32)
+GLIB_HASH_TARGET_AVX2 inline __m256i MultiplyLow64Avx2(__m256i x, __m256i c_low, __m256i c_high) {
+    __m256i low   = _mm256_mul_epu32(x, c_low);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), c_low),
+                                     _mm256_mul_epu32(x, c_high));
+    return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+//! \brief 用 AVX2 计算前 n / 4 * 4 个键值的 Mix64()
+//! \return 已经计算的个数，剩下的由调用者逐个计算
+GLIB_HASH_TARGET_AVX2 inline size_t HashBulkAvx2(const uint64_t *keys, size_t n, uint64_t *out) {
+    const __m256i c1_low  = _mm256_set1_epi64x(0xED558CCDll);
+    const __m256i c1_high = _mm256_set1_epi64x(0xFF51AFD7ll);
+    const __m256i c2_low  = _mm256_set1_epi64x(0x1A85EC53ll);
+    const __m256i c2_high = _mm256_set1_epi64x(0xC4CEB9FEll);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+        x = MultiplyLow64Avx2(x, c1_low, c1_high);
+        x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+        x = MultiplyLow64Avx2(x, c2_low, c2_high);
+        x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+    }
+    return i;
+}
+
+#undef GLIB_HASH_TARGET_AVX2
+
+#pragma GCC diagnostic pop
+
+} // namespace hash_internal
+
+#endif // GLIB_HASH_X86
+
+//! \brief 批量计算整数键值的 Mix64()，out[i] = Mix64(keys[i])
+//! \note AVX2 没有 64 位乘法，用三次 32x32->64 位乘法拼出乘积的低 64 位，一次处理 4 个。
+//!       运行时检测 CPU 是否支持 AVX2，AVX2 函数用 GCC 的 target 属性单独编译，不需要 -mavx2 编译选项；
+//!       不支持时是彼此独立的标量循环，CPU 可以同时执行多个乘法
+inline void HashBulk(const uint64_t *keys, size_t n, uint64_t *out) {
+    size_t i = 0;
+#ifdef GLIB_HASH_X86
+    if (hash_internal::HasAvx2())
+        i = hash_internal::HashBulkAvx2(keys, n, out);
+#endif
+    for (; i < n; i++)
+        out[i] = Mix64(keys[i]);
+}
+
+//! \brief 批量计算任意键值的哈希值，out[i] = hasher(keys[i])
+template <typename _Key, typename _Hash>
+void HashBulk(const _Key *keys, size_t n, uint64_t *out, const _Hash &hasher) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = static_cast<uint64_t>(hasher(keys[i]));
+}
+
+namespace hash_internal {
+
+// 整数、枚举、指针直接打散，其他类型先用 std::hash 再打散
+enum class KeyKind { kInteger, kPointer, kOther };
+
+template <typename _Key>
+using KindOf = std::integral_constant<KeyKind,
+    (std::is_integral<_Key>::value || std::is_enum<_Key>::value) ? KeyKind::kInteger :
+    std::is_pointer<_Key>::value ? KeyKind::kPointer : KeyKind::kOther>;
+
+template <typename _Key>
+uint64_t HashValue(const _Key &key, std::integral_constant<KeyKind, KeyKind::kInteger>) {
+    return Mix64(static_cast<uint64_t>(key));
+}
+template <typename _Key>
+uint64_t HashValue(const _Key &key, std::integral_constant<KeyKind, KeyKind::kPointer>) {
+    return Mix64(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)));
+}
+template <typename _Key>
+uint64_t HashValue(const _Key &key, std::integral_constant<KeyKind, KeyKind::kOther>) {
+    return Mix64(static_cast<uint64_t>(std::hash<_Key>()(key)));
+}
+
+} // namespace hash_internal
+
+//! \brief 哈希函数对象，可以作为 HashTable、FlatHashMap 等的 _Hash 模板参数
+template <typename _Key>
+struct Hash {
+    size_t operator()(const _Key &key) const {
+        return static_cast<size_t>(hash_internal::HashValue(key, hash_internal::KindOf<_Key>()));
+    }
+};
+
+//! \brief 字符串：string、const char*、string_view（C++17）的哈希值相同，支持异构查询
+template <>
+struct Hash<std::string> {
+    using is_transparent = void;
+
+    size_t operator()(const char *data, size_t length) const {
+        return static_cast<size_t>(HashBytes(data, length));
+    }
+    size_t operator()(const std::string &key) const { return (*this)(key.data(), key.size()); }
+    size_t operator()(const char *key)        const { return (*this)(key, strlen(key));        }
+#if __cplusplus >= 201703L
+    size_t operator()(std::string_view key)   const { return (*this)(key.data(), key.size()); }
+#endif
+};
+
+//! \brief 哈希质量诊断
+struct Diagnostics {
+    size_t size         = 0;   // 数据量
+    size_t buckets      = 0;   // 桶（槽）数
+    size_t used_buckets = 0;   // 非空的桶数（开放寻址时为起始位置互不相同的个数）
+    size_t max_probe    = 0;   // 最长的链（开放寻址时为最远的探测距离 + 1）
+    size_t worst_bucket = 0;   // 最长的链所在的桶（开放寻址时为探测距离最远的元素的起始位置）
+    double average_probes  = 0; // 成功查找平均比较的元素个数
+    double expected_probes = 0; // 哈希值完全均匀时的理论值
+    // 拉链法：histogram[i] 为长度为 i 的链的个数；开放寻址：histogram[i] 为需要比较 i + 1 次的元素个数
+    std::vector<size_t> histogram;
+
+    //! \brief 实际平均比较次数与理论值之比，接近 1 说明分布良好
+    double quality() const { return expected_probes > 0 ? average_probes / expected_probes : 1.0; }
+
+    void print(std::ostream &os = std::cout) const {
+        os << "size " << size << ", buckets " << buckets << ", used " << used_buckets
+           << ", max probe " << max_probe << " (bucket " << worst_bucket << ")"
+           << ", average probes " << average_probes << ", expected " << expected_probes
+           << ", quality " << quality() << std::endl;
+        os << "histogram:";
+        for (size_t i = 0; i < histogram.size(); i++) {
+            if (histogram[i] > 0)
+                os << " [" << i << "]=" << histogram[i];
+        }
+        os << std::endl;
+    }
+};
+
+} // namespace hash
+} // namespace glib
+
+#endif // GLIB_HASH_HPP_
@@ -0,0 +1,171 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: hash.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/19
+ * Description: test hash functions and hash diagnostics
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./hash.hpp"
+#include "./hash_table.hpp"
+#include "./flat_hash_map.hpp"
+#include "../internal/test_util.h"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm> // std::sort std::unique
+using namespace std;
+using glib::test_internal::BadHash;
+
+namespace {
+
+// 64 位整数中 1 的个数
+int PopCount(uint64_t x) { return __builtin_popcountll(x); }
+
+//! \brief 雪崩测试：翻转输入的每一位，输出平均变化的位数，理想值为 32
+template <typename _Function>
+double Avalanche(_Function hash_function, mt19937_64 &engine) {
+    const int kSamples = 2000;
+    uint64_t changed = 0;
+    for (int i = 0; i < kSamples; i++) {
+        uint64_t key = engine();
+        uint64_t base = hash_function(key);
+        for (int bit = 0; bit < 64; bit++)
+            changed += PopCount(base ^ hash_function(key ^ (uint64_t(1) << bit)));
+    }
+    return static_cast<double>(changed) / (kSamples * 64);
+}
+
+} // namespace
+
+//! \brief 哈希函数测试：字符串哈希的碰撞与一致性、雪崩、批量哈希、步长键值的诊断，以及速度对比
+//! \run
+//!     g++ hash.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    mt19937_64 engine(2019);
+    bool all_ok = true;
+
+    // 1）字符串哈希：每个长度（包括 0）、不同内容都没有碰撞，string/const char* 的哈希值相同
+    cout << "字符串哈希" << endl;
+    string buffer;
+    for (int i = 0; i < 200; i++)
+        buffer.push_back(static_cast<char>('a' + engine() % 26));
+    vector<uint64_t> hashes;
+    for (size_t length = 0; length <= buffer.size(); length++)
+        hashes.push_back(glib::hash::HashBytes(buffer.data(), length));
+    for (int i = 0; i < 200000; i++) {
+        string key = "user-" + to_string(i);
+        hashes.push_back(glib::hash::HashBytes(key.data(), key.size()));
+    }
+    std::sort(hashes.begin(), hashes.end());
+    bool string_ok = std::unique(hashes.begin(), hashes.end()) == hashes.end();
+    glib::hash::Hash<string> string_hash;
+    glib::StringHash legacy_hash;
+    string_ok = string_ok && string_hash("session-42") == string_hash(string("session-42")) &&
+                string_hash("session-42") == legacy_hash("session-42") &&
+                glib::hash::HashBytes("abc", 3, 1) != glib::hash::HashBytes("abc", 3, 2);
+    cout << (string_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && string_ok;
+
+    // 2）雪崩：翻转一位输入，输出平均变化 32 位左右
+    cout << "雪崩测试" << endl;
+    double mix_bits = Avalanche([](uint64_t key) { return glib::hash::Mix64(key); }, engine);
+    double bytes_bits = Avalanche([](uint64_t key) { return glib::hash::HashBytes(&key, sizeof(key)); }, engine);
+    double fibonacci_bits = Avalanche([](uint64_t key) { return glib::hash::FibonacciMix(key); }, engine);
+    cout << " Mix64 " << mix_bits << " HashBytes " << bytes_bits << " FibonacciMix " << fibonacci_bits << endl;
+    bool avalanche_ok = mix_bits > 31.5 && mix_bits < 32.5 && bytes_bits > 31.5 && bytes_bits < 32.5 &&
+                        fibonacci_bits > 24;
+    cout << (avalanche_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && avalanche_ok;
+
+    // 3）批量哈希与逐个计算的结果相同（个数不是 4 的倍数，覆盖尾部；AVX2 在运行时检测）
+    cout << "批量哈希" << endl;
+#ifdef GLIB_HASH_X86
+    cout << " avx2 " << (glib::hash::hash_internal::HasAvx2() ? "yes" : "no") << endl;
+#endif
+    vector<uint64_t> keys(1000003), bulk(keys.size()), scalar(keys.size());
+    for (auto &key: keys) key = engine();
+    glib::hash::HashBulk(keys.data(), keys.size(), bulk.data());
+    bool bulk_ok = true;
+    for (size_t i = 0; i < keys.size(); i++)
+        bulk_ok = bulk_ok && bulk[i] == glib::hash::Mix64(keys[i]);
+    for (size_t n = 0; n < 9; n++) {                          // 只有尾部、不足一个向量
+        glib::hash::HashBulk(keys.data() + n, n, scalar.data());
+        for (size_t i = 0; i < n; i++)
+            bulk_ok = bulk_ok && scalar[i] == glib::hash::Mix64(keys[n + i]);
+    }
+    vector<string> words = {"a", "bb", "ccc", "dddd"};
+    vector<uint64_t> word_hashes(words.size());
+    glib::hash::HashBulk(words.data(), words.size(), word_hashes.data(), string_hash);
+    bulk_ok = bulk_ok && word_hashes[2] == string_hash("ccc");
+    cout << (bulk_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && bulk_ok;
+
+    // 4）诊断：步长为 1024 的 ID 在打散之后分布均匀；哈希函数只有 4 种取值时诊断结果明显异常
+    cout << "哈希质量诊断" << endl;
+    glib::HashTable<uint64_t, uint64_t> strided;
+    glib::FlatHashMap<uint64_t, uint64_t> flat_strided;
+    glib::HashTable<uint64_t, uint64_t, BadHash> bad;
+    glib::FlatHashMap<uint64_t, uint64_t, BadHash> flat_bad;
+    for (uint64_t i = 0; i < 100000; i++) {
+        strided.Insert(i * 1024, i);
+        flat_strided.Insert(i * 1024, i);
+    }
+    for (uint64_t i = 0; i < 1000; i++) {
+        bad.Insert(i, i);
+        flat_bad.Insert(i, i);
+    }
+    glib::hash::Diagnostics chained = strided.hash_diagnostics();
+    glib::hash::Diagnostics flat = flat_strided.hash_diagnostics();
+    glib::hash::Diagnostics chained_bad = bad.hash_diagnostics();
+    glib::hash::Diagnostics flat_bad_diagnostics = flat_bad.hash_diagnostics();
+    cout << " chained, stride 1024:" << endl;
+    chained.print();
+    cout << " flat, stride 1024:" << endl;
+    flat.print();
+    cout << " chained, bad hash: quality " << chained_bad.quality() << ", max probe " << chained_bad.max_probe
+         << " (bucket " << chained_bad.worst_bucket << ")" << endl;
+    cout << " flat, bad hash: quality " << flat_bad_diagnostics.quality() << ", max probe "
+         << flat_bad_diagnostics.max_probe << endl;
+    bool diagnostics_ok = chained.quality() < 1.1 && flat.quality() < 1.5 && 100000 == chained.size &&
+                          chained.max_probe < 12 && chained_bad.quality() > 10 &&
+                          4 == chained_bad.used_buckets && flat_bad_diagnostics.quality() > 10;
+    cout << (diagnostics_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && diagnostics_ok;
+
+    // 5）速度：字符串哈希与 std::hash<string>，批量整数哈希与逐个计算
+    cout << "速度对比" << endl;
+    vector<string> strings;
+    for (int i = 0; i < 1000000; i++)
+        strings.push_back("key-" + to_string(engine() % 100000000) + string(engine() % 32, 'x'));
+    uint64_t checksum = 0;
+    TicToc timer;
+    for (const auto &key: strings) checksum += string_hash(key);
+    double fast_ms = timer.toc();
+    timer.tic();
+    std::hash<string> std_hash;
+    for (const auto &key: strings) checksum += std_hash(key);
+    double std_ms = timer.toc();
+    timer.tic();
+    for (int repeat = 0; repeat < 10; repeat++)
+        glib::hash::HashBulk(keys.data(), keys.size(), bulk.data());
+    double bulk_ms = timer.toc();
+    timer.tic();
+    for (int repeat = 0; repeat < 10; repeat++) {
+        for (size_t i = 0; i < keys.size(); i++)
+            scalar[i] = glib::hash::Mix64(keys[i] + repeat);
+    }
+    double scalar_ms = timer.toc();
+    checksum += bulk[7] + scalar[7];
+    cout << " 100 万个字符串 hash::Hash " << fast_ms << " ms, std::hash " << std_ms << " ms" << endl;
+    cout << " 1000 万个整数 HashBulk " << bulk_ms << " ms, 逐个 Mix64 " << scalar_ms << " ms"
+         << " (checksum " << (checksum & 0xFF) << ")" << endl;
+
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,567 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: hash_snapshot.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/20
+ * Description: read-only memory-mapped snapshot of a hash table
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_HASH_SNAPSHOT_HPP_
+#define GLIB_HASH_SNAPSHOT_HPP_
+#include <cstddef>     // size_t offsetof
+#include <cstdint>     // uint64_t
+#include <cstdio>      // std::rename std::remove
+#include <cstring>     // memcpy memcmp strlen strerror
+#include <cerrno>
+#include <stdexcept>   // runtime_error
+#include <string>
+#include <type_traits> // is_trivially_copyable
+#include <utility>     // std::pair std::move
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap munmap madvise msync
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close ftruncate
+#include "hash.hpp"
+#include "hash_table.hpp"
+#include "../internal/macros.h"
+
+//! \brief 哈希表快照：把哈希表保存成一个只读、可以直接 mmap 的文件，打开时不需要反序列化
+//!     外部调用核心函数：
+//!         1）保存：SaveSnapshot(table, path)，table 可以是 HashTable、FlatHashMap 或者任何有只读 ForEach() 的表
+//!         2）打开：OpenSnapshot<_Key, _Value>(path, options)，或者构造 HashSnapshot 对象
+//!         3）查询：Find()、FindPtr()、Contains()，遍历：ForEach()
+//!         4）校验整个文件：VerifyChecksum()，预读整个文件：WarmUp()
+//!     外部调用状态函数：
+//!         1）size()、empty()、bucket_count()、file_bytes()、is_open()
+//!
+//! \Note
+//!     1）文件格式（所有位置都是相对文件开头的偏移，不保存指针，映射到任何地址都可以直接使用）：
+//!            [文件头 128 字节][桶数组 uint64_t × (bucket_count + 1)][条目数组][字符串区]
+//!        条目按桶排好序，桶 b 的条目为 entries[buckets[b], buckets[b + 1])，没有空槽。
+//!        查询先读两个相邻的桶下标，再顺序比较这个桶的条目，一般两次缓存缺失
+//!     2）打开是 O(1) 的：只 mmap 并检查文件头（魔数、版本、键值/映射值的大小、文件头校验和、各区域的边界），
+//!        以及抽查几个条目是否落在按当前哈希函数算出的桶中（发现保存、打开时哈希函数不一致）。
+//!        数据页在第一次访问时才由操作系统读入，之后多个进程共享同一份页缓存
+//!     3）整个文件内容的校验和保存在文件头中，检查需要读完整个文件，所以默认不检查：
+//!        SnapshotOptions::verify_checksum 或者 VerifyChecksum()。不可信的文件必须先校验再查询
+//!     4）映射值必须是可以按字节拷贝的类型（trivially copyable），键值是这样的类型或者 std::string，
+//!        字符串保存在字符串区，条目中只保存偏移和长度。按本机字节序保存，不能跨字节序使用
+//!     5）桶下标由 _Hash（默认 hash::Hash<_Key>，结果与进程无关）计算，与保存的表自己的哈希函数无关。
+//!        不能使用依赖进程内随机种子或者地址的哈希函数
+//!     6）保存时先写到 path + ".tmp"，写完后 rename，已经打开旧快照的进程不受影响
+//!     7）依赖 POSIX 接口（mmap、madvise），出错时抛出 std::runtime_error
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \example
+//!     glib::HashTable<uint64_t, Record> table;
+//!     ...
+//!     glib::SaveSnapshot(table, "/data/records.snapshot");
+//!
+//!     glib::SnapshotOptions options;
+//!     options.warm_up = true;                     // 后台预读，首次查询不用等磁盘
+//!     auto snapshot = glib::OpenSnapshot<uint64_t, Record>("/data/records.snapshot", options);
+//!     if (const Record *record = snapshot.FindPtr(42))
+//!         ...
+
+namespace glib {
+
+//! \brief 打开快照的参数
+struct SnapshotOptions {
+    bool verify_checksum = false;   // 打开时校验整个文件，O(文件大小)
+    bool warm_up         = false;   // madvise(MADV_WILLNEED)：让操作系统在后台预读整个文件
+    bool random_access   = true;    // madvise(MADV_RANDOM)：查询是随机访问，关闭按顺序的预读，冷启动时不读入用不到的页
+};
+
+namespace snapshot_internal {
+
+const char     kMagic[8]  = {'G', 'L', 'I', 'B', 'H', 'S', 'N', 'P'};
+const uint32_t kVersion   = 1;
+const uint64_t kAlignment = 64;     // 各区域按缓存行对齐
+const uint32_t kStringKey = 1;      // 文件头 flags：键值是字符串
+
+//! \brief 文件头，固定 128 字节
+struct Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    uint32_t key_bytes;         // 键值在条目中占用的字节数
+    uint32_t value_bytes;       // 映射值的字节数
+    uint32_t entry_bytes;       // 条目的字节数
+    uint32_t flags;
+    uint64_t size;              // 条目个数
+    uint64_t bucket_count;      // 桶个数，2 的指数次幂
+    uint64_t buckets_offset;
+    uint64_t entries_offset;
+    uint64_t strings_offset;
+    uint64_t file_bytes;
+    uint64_t reserved[4];
+    uint64_t body_checksum;     // 文件头之后所有内容的校验和
+    uint64_t header_checksum;   // 文件头中这个字段之前所有内容的校验和，放在最后
+};
+static_assert(sizeof(Header) == 128, "snapshot header must be 128 bytes");
+
+inline void ThrowError(const std::string &message, const std::string &path) {
+    throw std::runtime_error("HashSnapshot: " + message + " " + path);
+}
+
+// 系统调用出错时抛出异常，带上系统错误信息
+inline void ThrowIoError(const std::string &message, const std::string &path) {
+    throw std::runtime_error("HashSnapshot: " + message + " " + path + ": " + std::strerror(errno));
+}
+
+// 出错之后关闭文件，保留原来的 errno 用于错误信息
+inline void CloseKeepErrno(int fd) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+}
+
+inline uint64_t AlignUp(uint64_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+inline uint64_t HeaderChecksum(const Header &header) {
+    return hash::HashBytes(&header, offsetof(Header, header_checksum));
+}
+
+//! \brief 键值在文件中的表示：定长类型直接保存在条目中
+template <typename _Key>
+struct KeyCodec {
+    using Stored = _Key;
+    static const uint32_t kFlags = 0;
+
+    static uint64_t StringBytes(const _Key &) { return 0; }
+    static void Encode(const _Key &key, Stored &stored, char *, uint64_t &) {
+        std::memcpy(&stored, &key, sizeof(_Key));
+    }
+    static bool Equal(const Stored &stored, const char *, const _Key &key) { return stored == key; }
+    static const _Key& Decode(const Stored &stored, const char *) { return stored; }
+};
+
+//! \brief 字符串保存在字符串区，条目中只保存偏移和长度
+template <>
+struct KeyCodec<std::string> {
+    struct Stored {
+        uint64_t offset;
+        uint64_t length;
+    };
+    static const uint32_t kFlags = kStringKey;
+
+    static uint64_t StringBytes(const std::string &key) { return key.size(); }
+    static void Encode(const std::string &key, Stored &stored, char *base, uint64_t &string_offset) {
+        std::memcpy(base + string_offset, key.data(), key.size());
+        stored.offset  = string_offset;
+        stored.length  = key.size();
+        string_offset += key.size();
+    }
+    static bool Equal(const Stored &stored, const char *base, const char *data, size_t length) {
+        return stored.length == length && 0 == std::memcmp(base + stored.offset, data, length);
+    }
+    static bool Equal(const Stored &stored, const char *base, const std::string &key) {
+        return Equal(stored, base, key.data(), key.size());
+    }
+    static bool Equal(const Stored &stored, const char *base, const char *key) {
+        return Equal(stored, base, key, std::strlen(key));
+    }
+    static std::string Decode(const Stored &stored, const char *base) {
+        return std::string(base + stored.offset, stored.length);
+    }
+};
+
+//! \brief 只读或者读写映射一个文件，析构时解除映射
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), bytes_(0) {}
+    ~MappedFile() { Unmap(); }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(MappedFile);
+
+    //! \brief 只读映射整个文件
+    void MapForRead(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            ThrowIoError("cannot open", path);
+        struct stat status;
+        if (0 != ::fstat(fd, &status)) {
+            CloseKeepErrno(fd);
+            ThrowIoError("cannot stat", path);
+        }
+        if (status.st_size < static_cast<off_t>(sizeof(Header))) {
+            ::close(fd);
+            ThrowError("file is too small", path);
+        }
+        Map(fd, static_cast<size_t>(status.st_size), PROT_READ, path);
+    }
+
+    //! \brief 新建 bytes 字节的文件并读写映射（文件内容全部为 0）
+    void MapForWrite(const std::string &path, size_t bytes) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            ThrowIoError("cannot create", path);
+        if (0 != ::ftruncate(fd, static_cast<off_t>(bytes))) {
+            CloseKeepErrno(fd);
+            ThrowIoError("cannot resize", path);
+        }
+        Map(fd, bytes, PROT_READ | PROT_WRITE, path);
+    }
+
+    //! \brief 把修改写回磁盘
+    void Sync(const std::string &path) {
+        if (0 != ::msync(data_, bytes_, MS_SYNC))
+            ThrowIoError("cannot sync", path);
+    }
+
+    void Unmap() {
+        if (nullptr != data_)
+            ::munmap(data_, bytes_);
+        data_  = nullptr;
+        bytes_ = 0;
+    }
+
+    // 交出映射，之后由调用者 munmap
+    char* Release() {
+        char *data = static_cast<char*>(data_);
+        data_  = nullptr;
+        bytes_ = 0;
+        return data;
+    }
+
+    char*  data()  const { return static_cast<char*>(data_); }
+    size_t bytes() const { return bytes_;                     }
+
+private:
+    // 映射之后文件描述符就可以关闭了，映射一直有效
+    void Map(int fd, size_t bytes, int protection, const std::string &path) {
+        void *data = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+        CloseKeepErrno(fd);
+        if (MAP_FAILED == data)
+            ThrowIoError("cannot mmap", path);
+        data_  = data;
+        bytes_ = bytes;
+    }
+
+    void   *data_;
+    size_t  bytes_;
+};
+
+} // namespace snapshot_internal
+
+template <typename _Key, typename _Value, typename _Hash = hash::Hash<_Key> >
+class HashSnapshot {
+public: // 类型声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+
+    static_assert(std::is_trivially_copyable<_Value>::value, "HashSnapshot: value must be trivially copyable");
+    static_assert(std::is_same<_Key, std::string>::value ||
+                  (std::is_trivially_copyable<_Key>::value && !std::is_pointer<_Key>::value),
+                  "HashSnapshot: key must be std::string or a trivially copyable non-pointer type");
+
+private:
+    using Codec = snapshot_internal::KeyCodec<_Key>;
+    using Header = snapshot_internal::Header;
+
+    struct Entry {
+        typename Codec::Stored key;
+        MappedType             value;
+    };
+    static_assert(alignof(Entry) <= snapshot_internal::kAlignment, "HashSnapshot: entry alignment is too large");
+
+    // 只有哈希函数支持异构查询时，才能用其他类型的键值查询（比如用 const char* 查询 string 键值）
+    template <typename _LookupKey>
+    using EnableIfTransparent = typename std::enable_if<
+        hash_table_internal::IsTransparent<Hasher>::value &&
+        !std::is_same<typename std::decay<_LookupKey>::type, KeyType>::value>::type;
+
+public: // 构造函数相关
+    HashSnapshot() : data_(nullptr), bytes_(0), header_(nullptr), buckets_(nullptr), entries_(nullptr) {}
+
+    //! \brief 打开快照文件，见 Open()
+    explicit
+    HashSnapshot(const std::string &path, const SnapshotOptions &options = SnapshotOptions())
+        : HashSnapshot() {
+        Open(path, options);
+    }
+
+    ~HashSnapshot() { Close(); }
+
+    HashSnapshot(HashSnapshot &&other) : HashSnapshot() { Swap(other); }
+    HashSnapshot& operator=(HashSnapshot &&other) {
+        if (this != &other) {
+            Close();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(HashSnapshot);
+
+public: // 外部调用核心函数
+    //! \brief 把 table 中的所有数据保存为快照文件，table 需要提供 size() 和只读的 ForEach(function(key, value))
+    //! \note 直接在映射的文件中按桶排好条目：先遍历一遍统计每个桶的条目数，再遍历一遍把条目放到各自的位置，
+    //!       内存中不保存数据的副本，保存大表时内存占用不会翻倍。字符串键值多遍历一次统计字符串总长度
+    //! \complexity O(n)
+    template <typename _Table>
+    static void Save(const _Table &table, const std::string &path) {
+        using namespace snapshot_internal;
+        const uint64_t size = table.size();
+        uint64_t bucket_count = 1;
+        while (bucket_count < size)
+            bucket_count *= 2;
+        uint64_t string_bytes = 0;
+        if (0 != Codec::kFlags) {
+            table.ForEach([&](const KeyType &key, const MappedType &) { string_bytes += Codec::StringBytes(key); });
+        }
+
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version        = kVersion;
+        header.header_bytes   = sizeof(Header);
+        header.key_bytes      = sizeof(typename Codec::Stored);
+        header.value_bytes    = sizeof(MappedType);
+        header.entry_bytes    = sizeof(Entry);
+        header.flags          = Codec::kFlags;
+        header.size           = size;
+        header.bucket_count   = bucket_count;
+        header.buckets_offset = AlignUp(sizeof(Header));
+        header.entries_offset = AlignUp(header.buckets_offset + (bucket_count + 1) * sizeof(uint64_t));
+        header.strings_offset = header.entries_offset + size * sizeof(Entry);
+        header.file_bytes     = header.strings_offset + string_bytes;
+
+        const std::string temp_path = path + ".tmp";
+        MappedFile file;
+        try {
+            file.MapForWrite(temp_path, header.file_bytes);
+            char *base = file.data();
+            uint64_t *buckets = reinterpret_cast<uint64_t*>(base + header.buckets_offset);
+            Entry *entries = reinterpret_cast<Entry*>(base + header.entries_offset);
+            const Hasher hasher = Hasher();
+            auto bucket_of = [&](const KeyType &key) {
+                return hash::FibonacciMix(static_cast<uint64_t>(hasher(key))) & (bucket_count - 1);
+            };
+
+            // 1）统计每个桶的条目数，前缀和得到每个桶的起始位置
+            uint64_t visited = 0;
+            table.ForEach([&](const KeyType &key, const MappedType &) {
+                buckets[bucket_of(key)]++;
+                visited++;
+            });
+            if (visited != size)
+                ThrowError("table size does not match ForEach()", path);
+            uint64_t start = 0;
+            for (uint64_t b = 0; b < bucket_count; b++) {
+                uint64_t count = buckets[b];
+                buckets[b] = start;
+                start += count;
+            }
+            // 2）把条目放到桶的位置，buckets[b] 随之后移，结束时等于下一个桶的起始位置
+            uint64_t string_offset = header.strings_offset;
+            table.ForEach([&](const KeyType &key, const MappedType &value) {
+                Entry &entry = entries[buckets[bucket_of(key)]++];
+                Codec::Encode(key, entry.key, base, string_offset);
+                std::memcpy(&entry.value, &value, sizeof(MappedType));
+            });
+            for (uint64_t b = bucket_count; b > 0; b--)
+                buckets[b] = buckets[b - 1];
+            buckets[0] = 0;
+
+            header.body_checksum   = hash::HashBytes(base + sizeof(Header), header.file_bytes - sizeof(Header));
+            header.header_checksum = HeaderChecksum(header);
+            std::memcpy(base, &header, sizeof(Header));
+            file.Sync(temp_path);
+            file.Unmap();
+            if (0 != std::rename(temp_path.c_str(), path.c_str()))
+                ThrowIoError("cannot rename to", path);
+        } catch (...) {
+            file.Unmap();
+            std::remove(temp_path.c_str());
+            throw;
+        }
+    }
+
+    //! \brief 打开快照文件，已经打开的快照先关闭
+    //! \note 只映射文件、检查文件头，不读取数据，O(1)（options.verify_checksum 时 O(文件大小)）
+    void Open(const std::string &path, const SnapshotOptions &options = SnapshotOptions()) {
+        using namespace snapshot_internal;
+        Close();
+        MappedFile file;
+        file.MapForRead(path);
+        Header header;
+        std::memcpy(&header, file.data(), sizeof(Header));
+        if (0 != std::memcmp(header.magic, kMagic, sizeof(kMagic)))
+            ThrowError("not a snapshot file", path);
+        if (kVersion != header.version || sizeof(Header) != header.header_bytes)
+            ThrowError("unsupported snapshot version", path);
+        if (HeaderChecksum(header) != header.header_checksum)
+            ThrowError("header checksum mismatch", path);
+        if (Codec::kFlags != header.flags || sizeof(typename Codec::Stored) != header.key_bytes ||
+            sizeof(MappedType) != header.value_bytes || sizeof(Entry) != header.entry_bytes)
+            ThrowError("key or value type does not match", path);
+        const uint64_t bucket_count = header.bucket_count;
+        if (file.bytes() != header.file_bytes || 0 == bucket_count || 0 != (bucket_count & (bucket_count - 1)) ||
+            header.buckets_offset + (bucket_count + 1) * sizeof(uint64_t) > header.entries_offset ||
+            header.entries_offset + header.size * sizeof(Entry) > header.strings_offset ||
+            header.strings_offset > header.file_bytes || 0 != header.entries_offset % kAlignment)
+            ThrowError("corrupted header", path);
+
+        if (options.random_access)
+            ::madvise(file.data(), file.bytes(), MADV_RANDOM);
+        bytes_   = file.bytes();
+        data_    = file.Release();
+        header_  = reinterpret_cast<const Header*>(data_);
+        buckets_ = reinterpret_cast<const uint64_t*>(data_ + header.buckets_offset);
+        entries_ = reinterpret_cast<const Entry*>(data_ + header.entries_offset);
+        if (options.verify_checksum && !VerifyChecksum()) {
+            Close();
+            ThrowError("body checksum mismatch", path);
+        }
+        if (!CheckLayout()) {
+            Close();
+            ThrowError("entries do not match the hash function", path);
+        }
+        if (options.warm_up)
+            WarmUp();
+    }
+
+    //! \brief 解除映射
+    void Close() {
+        if (nullptr != data_)
+            ::munmap(data_, bytes_);
+        data_    = nullptr;
+        bytes_   = 0;
+        header_  = nullptr;
+        buckets_ = nullptr;
+        entries_ = nullptr;
+    }
+
+    //! \brief 按照键值查询，返回文件中映射值的地址（只读），没有找到返回 nullptr
+    //! \complexity O(1)
+    const MappedType* FindPtr(const KeyType &key) const { return FindEntry(key); }
+    // 异构查询：比如用 const char* 查询 string 键值，需要哈希函数定义 is_transparent
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    const MappedType* FindPtr(const _LookupKey &key) const { return FindEntry(key); }
+
+    //! \brief 按照键值查询，返回映射值的拷贝
+    //! \return first:是否找到，second:映射值
+    std::pair<bool, MappedType> Find(const KeyType &key) const {
+        const MappedType *value = FindEntry(key);
+        return nullptr != value ? std::make_pair(true, *value) : std::make_pair(false, MappedType());
+    }
+
+    bool Contains(const KeyType &key) const { return nullptr != FindEntry(key); }
+
+    //! \brief 按桶的顺序遍历所有数据，function(const KeyType&, const MappedType&)
+    //! \complexity O(n)
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        for (uint64_t i = 0; i < size(); i++)
+            function(Codec::Decode(entries_[i].key, data_), entries_[i].value);
+    }
+
+    //! \brief 重新计算文件头之后所有内容的校验和，与文件头中保存的比较
+    //! \complexity O(文件大小)，会读入整个文件
+    bool VerifyChecksum() const {
+        if (nullptr == header_)
+            return false;
+        return hash::HashBytes(data_ + sizeof(Header), bytes_ - sizeof(Header)) == header_->body_checksum;
+    }
+
+    //! \brief 让操作系统在后台把整个文件读入页缓存，不阻塞当前线程
+    void WarmUp() const {
+        if (nullptr != data_)
+            ::madvise(data_, bytes_, MADV_WILLNEED);
+    }
+
+    size_t   size()         const { return nullptr != header_ ? header_->size : 0;         } // 条目个数
+    bool     empty()        const { return 0 == size();                                    }
+    uint64_t bucket_count() const { return nullptr != header_ ? header_->bucket_count : 0; }
+    size_t   file_bytes()   const { return bytes_;                                         } // 映射的字节数
+    bool     is_open()      const { return nullptr != data_;                               }
+
+private: // helper functions
+    template <typename _LookupKey>
+    const MappedType* FindEntry(const _LookupKey &key) const {
+        if (nullptr == header_)
+            return nullptr;
+        const uint64_t bucket = BucketOf(key);
+        const Entry *end = entries_ + buckets_[bucket + 1];
+        for (const Entry *entry = entries_ + buckets_[bucket]; entry != end; entry++) {
+            if (Codec::Equal(entry->key, data_, key))
+                return &entry->value;
+        }
+        return nullptr;
+    }
+
+    template <typename _LookupKey>
+    uint64_t BucketOf(const _LookupKey &key) const {
+        return hash::FibonacciMix(static_cast<uint64_t>(hasher_(key))) & (header_->bucket_count - 1);
+    }
+
+    //! \brief 抽查第一个、中间、最后一个条目：条目个数与桶数组一致，条目落在按当前哈希函数算出的桶中
+    //! \note 只读几个页，发现保存、打开时使用了不同的哈希函数或者不同的键值类型
+    bool CheckLayout() const {
+        const uint64_t size = header_->size;
+        if (buckets_[header_->bucket_count] != size)
+            return false;
+        if (0 == size)
+            return true;
+        const uint64_t samples[3] = {0, size / 2, size - 1};
+        for (uint64_t i: samples) {
+            const Entry &entry = entries_[i];
+            if (0 != Codec::kFlags && !StringInRange(entry.key))
+                return false;
+            const uint64_t bucket = BucketOf(Codec::Decode(entry.key, data_));
+            if (buckets_[bucket] > i || i >= buckets_[bucket + 1])
+                return false;
+        }
+        return true;
+    }
+
+    // 字符串键值的位置在字符串区之内，定长键值不需要检查
+    template <typename _Stored>
+    bool StringInRange(const _Stored &stored) const {
+        return stored.offset >= header_->strings_offset && stored.offset <= bytes_ &&
+               stored.length <= bytes_ - stored.offset;
+    }
+    bool StringInRange(const KeyType &) const { return true; }
+
+    void Swap(HashSnapshot &other) {
+        std::swap(data_, other.data_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(header_, other.header_);
+        std::swap(buckets_, other.buckets_);
+        std::swap(entries_, other.entries_);
+    }
+
+private:
+    const Hasher    hasher_ = Hasher();
+    char           *data_;      // 映射的起始地址
+    size_t          bytes_;     // 映射的字节数
+    const Header   *header_;
+    const uint64_t *buckets_;   // 桶 b 的条目为 entries_[buckets_[b], buckets_[b + 1])
+    const Entry    *entries_;
+}; // class HashSnapshot
+
+//! \brief 把 table 保存为快照文件，键值、映射值类型与 table 相同，桶下标使用 hash::Hash<_Key>
+template <typename _Table>
+void SaveSnapshot(const _Table &table, const std::string &path) {
+    HashSnapshot<typename _Table::KeyType, typename _Table::MappedType>::Save(table, path);
+}
+
+//! \brief 打开快照文件，O(1)
+template <typename _Key, typename _Value, typename _Hash = hash::Hash<_Key> >
+HashSnapshot<_Key, _Value, _Hash> OpenSnapshot(const std::string &path,
+                                               const SnapshotOptions &options = SnapshotOptions()) {
+    return HashSnapshot<_Key, _Value, _Hash>(path, options);
+}
+
+} // namespace glib
+
+#endif // GLIB_HASH_SNAPSHOT_HPP_
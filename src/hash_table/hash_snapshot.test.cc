@@ -0,0 +1,184 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: hash_snapshot.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/20
+ * Description: test memory-mapped hash table snapshot
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./hash_snapshot.hpp"
+#include "./flat_hash_map.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>   // getpid
+using namespace std;
+
+namespace {
+
+struct Record {
+    uint64_t id;
+    double   score;
+    char     tag[8];
+};
+
+// 在 /tmp 下生成本进程专用的文件名
+string TempPath(const string &name) {
+    return "/tmp/glib_snapshot_" + to_string(getpid()) + "_" + name;
+}
+
+// 修改文件中 offset 处的一个字节
+void CorruptByte(const string &path, long offset) {
+    FILE *file = fopen(path.c_str(), "r+b");
+    fseek(file, offset, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(byte ^ 0x5A, file);
+    fclose(file);
+}
+
+//! \brief 打开快照，返回是否抛出了异常
+bool OpenThrows(const string &path, bool verify_checksum) {
+    glib::SnapshotOptions options;
+    options.verify_checksum = verify_checksum;
+    try {
+        glib::OpenSnapshot<uint64_t, Record>(path, options);
+    } catch (const std::runtime_error &error) {
+        cout << "  " << error.what() << endl;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+//! \brief 快照测试：整数、字符串键值保存后打开与原表一致，文件损坏、类型不一致时打开失败，以及打开速度
+//! \run
+//!     g++ hash_snapshot.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    bool all_ok = true;
+    mt19937_64 engine(2019);
+
+    // 1）整数键值：保存 HashTable，打开之后每个键值都能查到，不存在的键值查不到
+    cout << "整数键值快照" << endl;
+    const size_t kNum = 1000000;
+    const string records_path = TempPath("records");
+    glib::HashTable<uint64_t, Record> records;
+    uint64_t last_id = 0;
+    for (size_t i = 0; i < kNum; i++) {
+        last_id = engine();
+        records.Insert(last_id, Record{last_id, i * 0.5, {'r', 'e', 'c', 0}});
+    }
+    TicToc timer;
+    glib::SaveSnapshot(records, records_path);
+    double save_ms = timer.toc();
+    timer.tic();
+    auto snapshot = glib::OpenSnapshot<uint64_t, Record>(records_path);
+    double open_ms = timer.toc();
+    bool integer_ok = snapshot.is_open() && kNum == snapshot.size() && snapshot.bucket_count() >= kNum;
+    records.ForEach([&](uint64_t id, const Record &record) {
+        const Record *found = snapshot.FindPtr(id);
+        integer_ok = integer_ok && nullptr != found && found->id == id && found->score == record.score &&
+                     'r' == found->tag[0];
+    });
+    size_t missing = 0;
+    for (int i = 0; i < 100000; i++)
+        missing += snapshot.Contains(engine()) ? 0 : 1;
+    size_t listed = 0;
+    snapshot.ForEach([&](uint64_t id, const Record &record) { listed += id == record.id ? 1 : 0; });
+    integer_ok = integer_ok && 100000 == missing && kNum == listed && snapshot.VerifyChecksum() &&
+                 !snapshot.Find(12345).first;
+    cout << " 保存 " << save_ms << " ms，打开 " << open_ms << " ms，文件 " << snapshot.file_bytes() / 1024 / 1024
+         << " MB" << (integer_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && integer_ok;
+
+    // 2）字符串键值：从 FlatHashMap 保存，string、const char* 查询结果相同；空表
+    cout << "字符串键值快照" << endl;
+    const string words_path = TempPath("words");
+    glib::FlatHashMap<string, int, glib::StringHash, glib::StringEqual> words;
+    for (int i = 0; i < 50000; i++)
+        words.Insert("word-" + to_string(i) + string(i % 40, 'x'), i);
+    words.Insert("", -1);
+    glib::SaveSnapshot(words, words_path);
+    glib::SnapshotOptions options;
+    options.verify_checksum = true;
+    options.warm_up         = true;
+    glib::HashSnapshot<string, int> word_snapshot(words_path, options);
+    bool string_ok = 50001 == word_snapshot.size();
+    for (int i = 0; i < 50000; i++) {
+        string key = "word-" + to_string(i) + string(i % 40, 'x');
+        const int *value = word_snapshot.FindPtr(key.c_str());
+        string_ok = string_ok && nullptr != value && i == *value && i == word_snapshot.Find(key).second;
+    }
+    string_ok = string_ok && -1 == *word_snapshot.FindPtr("") && nullptr == word_snapshot.FindPtr("word-1xx") &&
+                nullptr == word_snapshot.FindPtr("word-50000");
+    const string empty_path = TempPath("empty");
+    glib::HashTable<string, int> empty_table;
+    glib::SaveSnapshot(empty_table, empty_path);
+    auto empty_snapshot = glib::OpenSnapshot<string, int>(empty_path);
+    string_ok = string_ok && empty_snapshot.empty() && !empty_snapshot.Contains("a");
+    // 移动之后原对象为空，新对象可以继续查询
+    glib::HashSnapshot<string, int> moved(std::move(word_snapshot));
+    string_ok = string_ok && !word_snapshot.is_open() && 7 == *moved.FindPtr("word-7xxxxxxx");
+    cout << (string_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && string_ok;
+
+    // 3）出错：文件不存在、类型不一致、哈希函数不一致、文件头损坏、内容损坏（只有校验时才能发现）
+    cout << "错误检查" << endl;
+    bool error_ok = OpenThrows(TempPath("not-exist"), false);
+    try {
+        glib::OpenSnapshot<string, int>(records_path);
+        error_ok = false;
+    } catch (const std::runtime_error &error) {
+        cout << "  " << error.what() << endl;
+    }
+    try {
+        glib::OpenSnapshot<uint64_t, int>(records_path);
+        error_ok = false;
+    } catch (const std::runtime_error &error) {
+        cout << "  " << error.what() << endl;
+    }
+    try {
+        glib::HashSnapshot<uint64_t, Record, std::hash<uint64_t> > other_hash(records_path);   // 哈希函数不同
+        error_ok = false;
+    } catch (const std::runtime_error &error) {
+        cout << "  " << error.what() << endl;
+    }
+    snapshot.Close();
+    const long kHeaderOffset = 20, kBodyOffset = 4096 * 100;
+    CorruptByte(records_path, kHeaderOffset);
+    error_ok = error_ok && OpenThrows(records_path, false);
+    CorruptByte(records_path, kHeaderOffset);          // 再异或一次，恢复原来的内容
+    error_ok = error_ok && !OpenThrows(records_path, true);
+    CorruptByte(records_path, kBodyOffset);
+    error_ok = error_ok && !OpenThrows(records_path, false) && OpenThrows(records_path, true);
+    CorruptByte(records_path, kBodyOffset);
+    cout << (error_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && error_ok;
+
+    // 4）启动耗时：打开快照并完成第一次查询，与重新插入所有数据对比
+    cout << "打开与重建耗时对比" << endl;
+    timer.tic();
+    snapshot.Open(records_path);
+    bool first_ok = snapshot.Contains(last_id);
+    double reopen_ms = timer.toc();
+    timer.tic();
+    glib::HashTable<uint64_t, Record> rebuilt;
+    snapshot.ForEach([&](uint64_t id, const Record &record) { rebuilt.Insert(id, record); });
+    double rebuild_ms = timer.toc();
+    first_ok = first_ok && kNum == rebuilt.size();
+    cout << " 打开 " << reopen_ms << " ms，重建 " << rebuild_ms << " ms" << (first_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && first_ok;
+
+    remove(records_path.c_str());
+    remove(words_path.c_str());
+    remove(empty_path.c_str());
+    return all_ok ? 0 : 1;
+}
@@ -11,36 +11,72 @@
 
 #ifndef GLIB_HASH_TABLE_HPP_
 #define GLIB_HASH_TABLE_HPP_
+#include <cstdlib>    // std::calloc std::free
 #include <iostream>
 #include <string>
+#include <cstdint>    // uint64_t
+#include <cstring>    // strlen
 #include <functional> // 使用 std::hash 函数
 #include <typeinfo>   // 用来判断类型
+#include <new>        // std::bad_alloc
+#include <memory>     // std::allocator_traits
+#include <type_traits>
+#include <utility>    // std::forward std::move
+#include "node_pool.hpp"
+#include "hash.hpp"
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 //! \brief 简单实现哈希表——拉链法
 //!     外部调用核心函数：
 //!         1）往哈希表中添加一个数据：Insert()，两种插入方法
+//!            键值不存在时才构造映射值：TryEmplace()，插入或者替换映射值：InsertOrAssign()，都支持移动、原地构造
 //!         2）从哈希表中删除一个数据：Delete()
-//!         3）在哈希表中查找一个数据：Find()
-//!         4）设置 LRU 缓存大小：set_size()
+//!         3）在哈希表中查找一个数据：Find() 返回映射值的拷贝，FindPtr() 返回映射值的指针（不拷贝）
+//!         4）搬移一部分旧桶中的数据：RehashStep()
+//!         5）预留容量：Reserve()，同时预留桶数组和节点池
+//!         6）遍历所有数据：ForEach()
+//!         7）批量查询、插入：FindBatch()、InsertBatch()，软件预取，适合表远大于缓存的场景
 //!     外部调用状态函数：
 //!         1）打印哈希表数据：print_value()
-//!         2）哈希表状态：size()、empty()、capacity()、max_load_factor()、min_load_factor()
+//!         2）哈希表状态：size()、empty()、capacity()、max_load_factor()、min_load_factor()、rehashing()
+//!         3）内存分配统计：allocation_stats()
+//!         4）哈希质量诊断：hash_diagnostics()，链长分布、最长的链，用来发现病态的键值或者哈希函数
 //!     内部辅助核心函数：
-//!         1）调节底层哈希容量：AdjustCapacity()
+//!         1）调节底层哈希容量：AdjustCapacity()，开始渐进式搬移
 //!         2）查询函数：FindInertial()
 //!
 //! \Note
 //!     1）仅适用于内置数据类型，比如 string int ...
 //!     2）只能通过 Insert() 函数来修改 key 对应的 value。参考如下 example
-//!
-//! \TODO
-//!     1）扩容底层哈希表规的则需要修改，下面使用的是一次性扩容-低效。
+//!     3）渐进式扩容、缩容：装载因子越界时只分配新的桶数组，旧桶数组保留，
+//!        之后每次 Insert()/Delete() 搬移 kRehashBucketsPerOp 个旧桶，搬移完成后释放旧桶数组。
+//!        搬移期间查询、删除同时检查新旧两个桶数组，新插入的数据只放到新桶数组中。
+//!        这样单次插入的最坏耗时与数据量无关，不会在越过最大装载因子的那次插入上停顿很久。
+//!        空闲时也可以主动调用 RehashStep() 加快搬移
+//!     4）Find() 是 const 函数，不搬移数据，多个线程同时只读查询是安全的
+//!     5）异构查询：哈希函数定义了 is_transparent（比如 StringHash）时，FindPtr() 可以直接用
+//!        const char*、std::string_view（C++17）查询 std::string 键值，不需要构造临时 string，查询时没有内存分配
+//!     6）节点搬移时只修改指针，FindPtr()、TryEmplace() 得到的指针在该数据被删除之前一直有效
+//!     7）节点的内存由分配器模板参数 _Allocator 分配（内部转换为节点类型），默认使用节点池 NodePool：
+//!        按块申请内存，删除的节点放入空闲链表复用，频繁插入、删除时不再调用 malloc/free。
+//!        也可以传入 std::allocator<std::pair<const _Key, _Value>>，每个节点单独 new
+//!     8）桶下标为 FibonacciMix(hash) & (capacity - 1)，哈希值先打散再取低位，整数键值的 std::hash 也不会聚集。
+//!        更快的哈希函数见 hash.hpp 中的 hash::Hash<_Key>
+//!     9）批量查询：逐个查询时，每次查询先等桶、再等节点，两次缓存缺失串行，CPU 大部分时间在等内存。
+//!        FindBatch() 同时进行 kBatchGroup 个查询，每个查询拆成「读桶、比较节点、比较下一个节点...」的若干步，
+//!        每一步先预取下一步要访问的内存，然后切换到其他查询（AMAC），不同查询的缓存缺失互相重叠。
+//!        和分组预取（group prefetching）相比，链表长短不一、有的键值不存在时也没有整组等待。
+//!        InsertBatch() 会修改表，只按组预取桶和链表头，然后逐个插入
 //!
 //! \platform
 //!     ubuntu16.04 g++ version 5.4.0
 //!
 //! \reference
 //!         1）std::hash--->https://en.cppreference.com/w/cpp/utility/hash
+//!         2）Chen et al., Improving hash join performance through prefetching, ICDE 2004（group prefetching）
+//!         3）Kocberber et al., Asynchronous memory access chaining, VLDB 2015（AMAC）
 //!
 //! example
 //!     1）通过 Insert() 函数进行修改内部元素
@@ -50,15 +86,59 @@
 //!         auto target = hash_table.Find("2");
 //!         if (target.first)
 //!             hash_table.Insert(std::make_pair("2", 修改想要的值));
+//!     2）不拷贝：原地构造、直接修改、异构查询
+//!         HashTable<string, vector<int>, StringHash> sessions;
+//!         sessions.TryEmplace("user-1", 1000, 0);     // 键值不存在时才构造 vector<int>(1000, 0)
+//!         if (auto *value = sessions.FindPtr("user-1"))
+//!             value->push_back(1);
 
 namespace glib {
 
-template <typename _Key, typename _Value, typename _Hash = std::hash<_Key> >
+//! \brief 可以异构查询的字符串哈希函数：string、const char*、string_view 的哈希值相同
+//! \note 使用 hash::HashBytes()（wyhash 风格），只依赖字符内容，与 hash::Hash<std::string> 相同
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(const char *data, size_t length) const {
+        return static_cast<size_t>(hash::HashBytes(data, length));
+    }
+    size_t operator()(const std::string &key) const { return (*this)(key.data(), key.size()); }
+    size_t operator()(const char *key)        const { return (*this)(key, strlen(key));        }
+#if __cplusplus >= 201703L
+    size_t operator()(std::string_view key)   const { return (*this)(key.data(), key.size()); }
+#endif
+};
+
+//! \brief 可以异构比较的相等比较函数，与 StringHash 一起用于 FlatHashMap 的异构查询（C++11 没有 std::equal_to<>）
+struct StringEqual {
+    using is_transparent = void;
+
+    template <typename _Left, typename _Right>
+    bool operator()(const _Left &left, const _Right &right) const { return left == right; }
+};
+
+namespace hash_table_internal {
+
+template <typename... _Types>
+struct VoidType { using type = void; };
+
+// 哈希函数是否支持异构查询
+template <typename _Hash, typename = void>
+struct IsTransparent : std::false_type {};
+
+template <typename _Hash>
+struct IsTransparent<_Hash, typename VoidType<typename _Hash::is_transparent>::type> : std::true_type {};
+
+} // namespace hash_table_internal
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _Allocator = NodePool<std::pair<const _Key, _Value> > >
 class HashTable {
 public: // 类型、结构声明
-    using KeyType    = _Key;
-    using MappedType = _Value;
-    using Hasher     = _Hash;
+    using KeyType       = _Key;
+    using MappedType    = _Value;
+    using Hasher        = _Hash;
+    using AllocatorType = _Allocator;
 
     // 哈希表内部存储的数据
     struct HashData {
@@ -71,36 +151,31 @@ public: // 类型、结构声明
         HashNode *h_next;
     };
 
+private:
+    using NodeAllocator = typename std::allocator_traits<_Allocator>::template rebind_alloc<HashNode>;
+    using NodeTraits    = std::allocator_traits<NodeAllocator>;
+
+    // 只有哈希函数支持异构查询时，才能用其他类型的键值查询
+    template <typename _LookupKey>
+    using EnableIfTransparent = typename std::enable_if<
+        hash_table_internal::IsTransparent<Hasher>::value &&
+        !std::is_same<typename std::decay<_LookupKey>::type, KeyType>::value>::type;
+
 public: // 构造函数相关
     // 默认容量是 2 的指数次幂
     explicit
-    HashTable(size_t capacity = 8, double max_load_factor = 0.75f, double min_load_factor = 0.125f)
+    HashTable(size_t capacity = 8, double max_load_factor = 0.75f, double min_load_factor = 0.125f,
+              const AllocatorType &allocator = AllocatorType())
         : capacity_(capacity), max_load_factor_(max_load_factor),
-          min_load_factor_(min_load_factor), current_size_(0) {
+          min_load_factor_(min_load_factor), current_size_(0), node_allocator_(allocator) {
         if (capacity_ < min_capacity_)
             capacity_ = min_capacity_;
-        array_ = new HashNode*[capacity_];
-        for (size_t i = 0; i < capacity_; i++) {
-            array_[i] = nullptr;
-        }
+        array_ = AllocateBuckets(capacity_);
     }
 
     ~HashTable() {
-        if (nullptr != array_) {
-            for (size_t i = 0; i < capacity_; i++) {
-                if (nullptr != array_[i]) {
-                    // 对每个桶的节点释放空间
-                    HashNode *head = array_[i];
-                    while (nullptr != head->h_next) {
-                        HashNode *temp = head->h_next;
-                        delete head;
-                        head = temp;
-                    }
-                    delete head;
-                }
-            }
-            delete[] array_; // 释放数组
-        }
+        FreeBuckets(array_, capacity_);
+        FreeBuckets(old_array_, old_capacity_); // 正在搬移时，旧桶数组中还有数据
     }
 
     HashTable(const HashTable &other) = delete;
@@ -112,101 +187,253 @@ public: // 外部调用核心函数
     //! \brief 按照键值查询给定数据，不可修改内部数据
     //! \complexity O(1)
     //! \return 查询信息，first:是否成功找到，second:成功找到后，根据 second.data.value 查询对应值
-    std::pair<bool, MappedType> Find(const KeyType key) const {
+    std::pair<bool, MappedType> Find(const KeyType &key) const {
         auto result = FindInertial(key);
         return std::make_pair(result.first,
                                 (result.first? result.second->data.value : MappedType())
                              );
     }
 
-    //! \brief 在哈希表中插入指定数据，按照键值对进行插入
+    //! \brief 按照键值查询，返回映射值的指针，不拷贝映射值
     //! \complexity O(1)
-    void Insert(const std::pair<KeyType, MappedType> &data) {
-        size_t hash_index = hasher_(data.first) & (capacity_ - 1);
-        bool find_flag = false;
-        HashNode *head = array_[hash_index];
-        HashNode *pre_head = array_[hash_index];
-        while (nullptr != head) {
-            if (data.first == head->data.key) {  // 找到对应的 key，那么此时直接替换相应的键值
-                find_flag = true;
-                head->data.value = data.second;
-                break;
-            }
-            pre_head = head;
-            head = head->h_next;
-        }
+    //! \return 映射值的地址，没有找到返回 nullptr
+    MappedType* FindPtr(const KeyType &key) {
+        HashNode *node = FindNode(key);
+        return nullptr != node ? &node->data.value : nullptr;
+    }
+    const MappedType* FindPtr(const KeyType &key) const {
+        const HashNode *node = FindNode(key);
+        return nullptr != node ? &node->data.value : nullptr;
+    }
+    // 异构查询：比如用 const char*、string_view 查询 string 键值，需要哈希函数定义 is_transparent
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    MappedType* FindPtr(const _LookupKey &key) {
+        HashNode *node = FindNode(key);
+        return nullptr != node ? &node->data.value : nullptr;
+    }
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    const MappedType* FindPtr(const _LookupKey &key) const {
+        const HashNode *node = FindNode(key);
+        return nullptr != node ? &node->data.value : nullptr;
+    }
+
+    //! \brief 批量查询：results[i] 为 keys[i] 对应映射值的地址，没有找到为 nullptr
+    //! \note 见 \Note 9）。表远大于缓存时比逐个 FindPtr() 快；桶数组和节点小于 kBatchMinBytes 时直接逐个查询
+    //! \complexity O(n)
+    //! \return 找到的个数
+    size_t FindBatch(const KeyType *keys, size_t n, MappedType **results) {
+        return FindBatchImpl(keys, n, results);
+    }
+    size_t FindBatch(const KeyType *keys, size_t n, const MappedType **results) const {
+        return FindBatchImpl(keys, n, results);
+    }
 
-        // 在拉链中没有找到该关键值 key，那么在拉链尾部插入新节点
-        if (!find_flag) {
-            current_size_++;
-            HashNode *new_node = new HashNode;
-            new_node->data.key = data.first;
-            new_node->data.value = data.second;
-            new_node->h_next = nullptr;          // 尾部节点要指向空
-            if (nullptr == array_[hash_index]) { // 刚开始，该索引对应的桶没有链，直接把新节点插入即可
-                array_[hash_index] = new_node;
-            } else {
-                pre_head->h_next = new_node;
+    //! \brief 批量插入：依次 InsertOrAssign(keys[i], values[i])，结果与逐个插入相同（键值重复时后面的覆盖前面的）
+    //! \note 每组先计算哈希值、预取桶和链表头，再逐个插入，每个键值只计算一次哈希值
+    //! \complexity O(n)
+    //! \return 新插入的个数
+    size_t InsertBatch(const KeyType *keys, const MappedType *values, size_t n) {
+        size_t inserted = 0;
+        uint64_t hashes[kBatchGroup];
+        for (size_t base = 0; base < n; base += kBatchGroup) {
+            const size_t count = n - base < kBatchGroup ? n - base : kBatchGroup;
+            for (size_t i = 0; i < count; i++) {
+                hashes[i] = HashOf(keys[base + i]);
+                __builtin_prefetch(array_ + IndexOf(hashes[i], capacity_));
             }
+            for (size_t i = 0; i < count; i++)
+                __builtin_prefetch(array_[IndexOf(hashes[i], capacity_)]);
+            // 插入过程中可能开始扩容，之后的预取失效，但下标按新的容量重新计算，结果不受影响
+            for (size_t i = 0; i < count; i++)
+                inserted += InsertOrAssignImpl(keys[base + i], values[base + i], hashes[i]).second ? 1 : 0;
         }
+        return inserted;
+    }
 
-        // 动态扩充底层容量-一次性扩容
-        if (load_factor() > max_load_factor_) {
-            expand_or_shrink_ = true;
-            AdjustCapacity();
-        }
+    //! \brief 键值不存在时，用 args 原地构造映射值并插入；键值已存在时什么都不做，args 不会被移动
+    //! \complexity O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename... _Args>
+    std::pair<MappedType*, bool> TryEmplace(const KeyType &key, _Args&&... args) {
+        return TryEmplaceImpl(key, std::forward<_Args>(args)...);
+    }
+    template <typename... _Args>
+    std::pair<MappedType*, bool> TryEmplace(KeyType &&key, _Args&&... args) {
+        return TryEmplaceImpl(std::move(key), std::forward<_Args>(args)...);
+    }
+
+    //! \brief 键值不存在时插入，已存在时替换映射值，value 按照完美转发移动或拷贝
+    //! \complexity O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssign(const KeyType &key, _MappedArg &&value) {
+        return InsertOrAssignImpl(key, std::forward<_MappedArg>(value));
+    }
+    template <typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssign(KeyType &&key, _MappedArg &&value) {
+        return InsertOrAssignImpl(std::move(key), std::forward<_MappedArg>(value));
+    }
+
+    //! \brief 在哈希表中插入指定数据，按照键值对进行插入，键值已存在时替换映射值
+    //! \complexity O(1)，扩容时也是 O(1)：只搬移 kRehashBucketsPerOp 个旧桶
+    void Insert(const std::pair<KeyType, MappedType> &data) {
+        InsertOrAssign(data.first, data.second);
+    }
+    // 右值版本：键值、映射值都移动到节点中
+    void Insert(std::pair<KeyType, MappedType> &&data) {
+        InsertOrAssign(std::move(data.first), std::move(data.second));
     }
     // 同上另一种插入方法
     void Insert(const KeyType &key, const MappedType &value) {
-        Insert(std::make_pair(key, value));
+        InsertOrAssign(key, value);
     }
 
     //! \brief 在哈希表中删除指定值
     //! \complexity average case O(1)
-    void Delete(const KeyType &key) {
-        auto find_result = FindInertial(key);
-        if (find_result.first) {
-            // 表示哈希表中存在该数据，直接遍历删除即可
+    //! \return 是否删除了数据
+    bool Delete(const KeyType &key) {
+        RehashStepOnWrite();
+
+        // 在新桶数组中删除，没有找到时再到旧桶数组中删除
+        bool deleted = DeleteFromBuckets(array_, capacity_, key) ||
+                       (rehashing() && DeleteFromBuckets(old_array_, old_capacity_, key));
+        if (deleted)
             current_size_--;
-            auto hash_index = hasher_(key) & (capacity_ - 1);
-            HashNode *head = array_[hash_index];
-            HashNode *pre_head = head;
-            while (nullptr != head) {
-                if (head->data.key == key) {
-                    // 正式删除该节点
-                    if (head == array_[hash_index]) {
-                        array_[hash_index] = head->h_next;
-                    } else {
-                        pre_head->h_next = head->h_next;
-                    }
-                    delete head;
-                    break;
-                }
-                pre_head = head;
-                head = head->h_next;
-            }
-        }
 
         // 判断是否需要缩容
         if (load_factor() <= min_load_factor_) {
             expand_or_shrink_ = false;
             AdjustCapacity();
         }
+        return deleted;
+    }
+
+    //! \brief 遍历所有数据（无序），function(const KeyType&, MappedType&)，正在搬移时也包括旧桶中的数据
+    //! \note 遍历过程中不能插入、删除
+    //! \complexity O(capacity + size)
+    template <typename _Function>
+    void ForEach(_Function function) {
+        ForEachInBuckets(old_array_, old_capacity_, function);
+        ForEachInBuckets(array_, capacity_, function);
+    }
+    // 只读遍历，function(const KeyType&, const MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        ForEachInBuckets<const HashNode*>(old_array_, old_capacity_, function);
+        ForEachInBuckets<const HashNode*>(array_, capacity_, function);
+    }
+
+    //! \brief 预留容量：插入 n 个数据的过程中不会扩容，也不会为节点向系统申请内存（节点池）
+    //! \note 预留之后删除数据也不会缩容到预留的容量以下
+    //! \complexity O(n)：扩容时直接搬移完所有旧桶
+    void Reserve(size_t n) {
+        size_t new_capacity = min_capacity_;
+        while (static_cast<double>(n) / new_capacity > max_load_factor_)
+            new_capacity *= 2;
+        reserved_capacity_ = new_capacity;
+        if (new_capacity > capacity_) {
+            StartRehash(new_capacity);
+            while (RehashStep(old_capacity_)) {}
+        }
+        if (n > static_cast<size_t>(current_size_)) {
+            node_pool_internal::PoolReserve(node_allocator_, n - current_size_,
+                                            node_pool_internal::HasReserve<NodeAllocator>());
+        }
+    }
+
+    //! \brief 内存分配统计：allocations/deallocations 为节点的分配、释放次数，
+    //!        reused 为节点池复用的次数，chunks/bytes 为向系统申请内存的次数和当前字节数（包括桶数组）
+    AllocationStats allocation_stats() const {
+        AllocationStats stats = node_pool_internal::PoolStats(node_allocator_,
+                                                              node_pool_internal::HasStats<NodeAllocator>());
+        if (!node_pool_internal::HasStats<NodeAllocator>::value) {  // 每个节点单独分配
+            stats.chunks = node_allocations_;
+            stats.bytes  = current_size_ * sizeof(HashNode);
+        }
+        stats.allocations   = node_allocations_;
+        stats.deallocations = node_deallocations_;
+        stats.chunks       += bucket_allocations_;
+        stats.bytes        += (capacity_ + old_capacity_) * sizeof(HashNode*);
+        return stats;
+    }
+
+    //! \brief 哈希质量诊断：链长分布、最长的链、成功查找的平均比较次数与理论值（1 + 装载因子 / 2）
+    //! \note 正在搬移时把还没有搬移的旧桶也统计在内
+    //! \complexity O(capacity + size)
+    hash::Diagnostics hash_diagnostics() const {
+        hash::Diagnostics diagnostics;
+        diagnostics.size    = current_size_;
+        diagnostics.buckets = capacity_;
+        size_t total_probes = 0;
+        auto count_bucket = [&](const HashNode *head, size_t bucket) {
+            size_t length = 0;
+            for (; nullptr != head; head = head->h_next)
+                length++;
+            if (length >= diagnostics.histogram.size())
+                diagnostics.histogram.resize(length + 1, 0);
+            diagnostics.histogram[length]++;
+            if (length > 0)
+                diagnostics.used_buckets++;
+            if (length > diagnostics.max_probe) {
+                diagnostics.max_probe    = length;
+                diagnostics.worst_bucket = bucket;
+            }
+            total_probes += length * (length + 1) / 2;    // 链中第 i 个节点需要比较 i 次
+        };
+        for (size_t i = rehash_index_; i < old_capacity_; i++)
+            count_bucket(old_array_[i], i);
+        for (size_t i = 0; i < capacity_; i++)
+            count_bucket(array_[i], i);
+        if (current_size_ > 0) {
+            diagnostics.average_probes  = static_cast<double>(total_probes) / current_size_;
+            diagnostics.expected_probes = 1.0 + (static_cast<double>(current_size_) - 1) / (2.0 * capacity_);
+        }
+        return diagnostics;
+    }
+
+    //! \brief 渐进式搬移：把最多 budget 个非空旧桶中的节点搬到新桶数组
+    //! \note 连续的空桶最多跳过 budget * 10 个，保证单次调用的耗时有上限
+    //! \complexity O(budget)
+    //! \param budget 本次最多搬移的非空桶个数
+    //! \return 是否还有没有搬移的旧桶
+    bool RehashStep(size_t budget) {
+        if (!rehashing())
+            return false;
+        size_t empty_visits = budget * 10;
+        while (budget > 0 && rehash_index_ < old_capacity_) {
+            HashNode *head = old_array_[rehash_index_];
+            if (nullptr == head) {
+                rehash_index_++;
+                if (0 == --empty_visits)
+                    break;
+                continue;
+            }
+            // 插入到新桶的链表头部，不需要遍历到链表尾部
+            while (nullptr != head) {
+                HashNode *next_hash_node = head->h_next;
+                auto hash_index = BucketIndex(head->data.key, capacity_);
+                head->h_next = array_[hash_index];
+                array_[hash_index] = head;
+                head = next_hash_node;
+            }
+            old_array_[rehash_index_++] = nullptr;
+            budget--;
+        }
+        if (rehash_index_ == old_capacity_) {  // 搬移完成，释放旧桶数组
+            std::free(old_array_);
+            old_array_    = nullptr;
+            old_capacity_ = 0;
+            rehash_index_ = 0;
+        }
+        return rehashing();
     }
 
     // 打印哈希表内容（无序打印）
     void print_value() const {
         std::cout << "print start:" << std::endl;
         if (current_size_ > 0) {
-            for (size_t i = 0; i < capacity_; i++) {
-                HashNode *head = array_[i];
-                while (nullptr != head) {
-                    std::cout << "key: " << head->data.key << " "
-                              << "index: " << (hasher_(head->data.key) & (capacity_ - 1)) << " "
-                              << "value: " << head->data.value << std::endl;
-                    head = head->h_next;
-                }
-            }
+            print_buckets(old_array_, old_capacity_);
+            print_buckets(array_, capacity_);
         } else {
             std::cout << "哈希表为空!" << std::endl;
         }
@@ -219,55 +446,302 @@ public: // 外部调用核心函数
     double load_factor()     const { return static_cast<double>(size()) / capacity(); } // 返回当前装载因子大小
     double max_load_factor() const { return max_load_factor_;                         } // 最大装载因子
     double min_load_factor() const { return min_load_factor_;                         } // 最小装载因子
+    bool   rehashing()       const { return nullptr != old_array_;                    } // 是否正在渐进式搬移
 
 private: // helper functions
-    //! \brief 动态扩充底层哈希表容量
+    //! \brief 插入、删除前搬移一部分旧桶
+    void RehashStepOnWrite() {
+        if (rehashing())
+            RehashStep(kRehashBucketsPerOp);
+    }
+
+    template <typename _KeyArg, typename... _Args>
+    std::pair<MappedType*, bool> TryEmplaceImpl(_KeyArg &&key, _Args&&... args) {
+        RehashStepOnWrite();
+        uint64_t hash = HashOf(key);
+        HashNode *node = FindNode(key, hash);
+        if (nullptr != node)
+            return std::make_pair(&node->data.value, false);
+        node = NewNode(std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+        LinkNewNode(node, hash);
+        return std::make_pair(&node->data.value, true);
+    }
+
+    template <typename _KeyArg, typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssignImpl(_KeyArg &&key, _MappedArg &&value) {
+        return InsertOrAssignImpl(std::forward<_KeyArg>(key), std::forward<_MappedArg>(value), HashOf(key));
+    }
+    template <typename _KeyArg, typename _MappedArg>
+    std::pair<MappedType*, bool> InsertOrAssignImpl(_KeyArg &&key, _MappedArg &&value, uint64_t hash) {
+        RehashStepOnWrite();
+        HashNode *node = FindNode(key, hash);
+        if (nullptr != node) {                   // 找到对应的 key，那么此时直接替换相应的映射值
+            node->data.value = std::forward<_MappedArg>(value);
+            return std::make_pair(&node->data.value, false);
+        }
+        node = NewNode(std::forward<_KeyArg>(key), std::forward<_MappedArg>(value));
+        LinkNewNode(node, hash);
+        return std::make_pair(&node->data.value, true);
+    }
+
+    //! \brief 用分配器分配节点并构造键值、映射值，构造失败时释放内存
+    template <typename _KeyArg, typename... _Args>
+    HashNode* NewNode(_KeyArg &&key, _Args&&... args) {
+        HashNode *node = NodeTraits::allocate(node_allocator_, 1);
+        try {
+            new (node) HashNode{HashData{KeyType(std::forward<_KeyArg>(key)),
+                                         MappedType(std::forward<_Args>(args)...)}, nullptr};
+        } catch (...) {
+            NodeTraits::deallocate(node_allocator_, node, 1);
+            throw;
+        }
+        node_allocations_++;
+        return node;
+    }
+
+    void DeleteNode(HashNode *node) {
+        node->~HashNode();
+        NodeTraits::deallocate(node_allocator_, node, 1);
+        node_deallocations_++;
+    }
+
+    //! \brief 把新节点插入到新桶数组的链表头部，必要时扩容
+    void LinkNewNode(HashNode *node, uint64_t hash) {
+        size_t hash_index = IndexOf(hash, capacity_);
+        node->h_next = array_[hash_index];
+        array_[hash_index] = node;
+        current_size_++;
+
+        // 动态扩充底层容量-渐进式扩容，节点地址不变
+        if (load_factor() > max_load_factor_) {
+            expand_or_shrink_ = true;
+            AdjustCapacity();
+        }
+    }
+
+    //! \brief 动态扩充底层哈希表容量：分配新的桶数组，旧桶数组中的数据之后渐进式搬移
     //! \note 这里装载因子定义为（当前哈希表已存量/哈希表容量）
-    //! \complexity average case:O(1) 空间复杂度 O(2*capacity_ or capacity_/2) = O(capacity_)
-    //! \TODO
-    //!     1）修改当前低效的扩容方法——一次性扩容，变为专栏中高效扩容
+    //! \complexity O(1)：只分配新桶数组，不搬移数据。上一次搬移还没完成时先搬移完
     void AdjustCapacity() {
-        // 容量太大需要动态扩容，容量小需要缩减容量。都是按照 2 的倍数扩容和缩容。缩容不能小于 min_capacity_
-        HashNode ** temp;
-        decltype(capacity_) origin_capacity = capacity_;
+        // 容量太大需要动态扩容，容量小需要缩减容量。都是按照 2 的倍数扩容和缩容。缩容不能小于 Reserve() 预留的容量
+        decltype(capacity_) new_capacity = capacity_;
         if (expand_or_shrink_) {
-            capacity_ *= 2;
-            temp = new HashNode*[capacity_];
+            new_capacity *= 2;
         } else {
-            capacity_ /= 2;
-            if (capacity_ < min_capacity_)
-                capacity_ = min_capacity_;
-            if (capacity_ == origin_capacity)
+            new_capacity /= 2;
+            if (new_capacity < reserved_capacity_)
+                new_capacity = reserved_capacity_;
+            if (new_capacity >= capacity_)
                 return;
-            temp = new HashNode*[capacity_];
         }
+        StartRehash(new_capacity);
+    }
 
-        for (size_t i = 0; i < capacity_; i++) {
-            temp[i] = nullptr;
-        }
+    //! \brief 开始渐进式搬移：当前桶数组变为旧桶数组，分配 new_capacity 个桶的新桶数组
+    void StartRehash(size_t new_capacity) {
+        // 插入、删除时都会搬移，装载因子从越界到再次越界之间，上一次的搬移一般早已完成
+        while (RehashStep(old_capacity_)) {}
 
-        // 将原来所有数据从新计算进行搬移到新的底层哈希表
-        for (size_t i = 0; i < origin_capacity; i++) {
-            HashNode *head = array_[i];
-            while (nullptr != head) {
-                auto hash_index = hasher_(head->data.key) & (capacity_ - 1);
-                HashNode *next_hash_node = head->h_next;
-                if (nullptr == temp[hash_index]) {
-                    temp[hash_index] = head;
-                    head->h_next = nullptr;
+        old_array_    = array_;
+        old_capacity_ = capacity_;
+        rehash_index_ = 0;
+        capacity_     = new_capacity;
+        array_        = AllocateBuckets(capacity_);
+    }
+
+    //! \brief 分配桶数组，所有桶都为空
+    //! \note 使用 calloc：大块内存直接从操作系统映射，已经是 0，不需要逐个清空，
+    //!       页面在第一次访问时才分配，清零的开销分摊到之后的插入中
+    HashNode** AllocateBuckets(size_t capacity) {
+        HashNode **buckets = static_cast<HashNode**>(std::calloc(capacity, sizeof(HashNode*)));
+        if (nullptr == buckets)
+            throw std::bad_alloc();
+        bucket_allocations_++;
+        return buckets;
+    }
+
+    //! \brief 在 buckets 中删除键值为 key 的节点
+    //! \return 是否删除了节点
+    bool DeleteFromBuckets(HashNode **buckets, size_t capacity, const KeyType &key) {
+        auto hash_index = BucketIndex(key, capacity);
+        HashNode *head = buckets[hash_index];
+        HashNode *pre_head = head;
+        while (nullptr != head) {
+            if (head->data.key == key) {
+                // 正式删除该节点
+                if (head == buckets[hash_index]) {
+                    buckets[hash_index] = head->h_next;
                 } else {
-                    HashNode *temp_head = temp[hash_index];
-                    while (nullptr != temp_head->h_next) {
-                        temp_head = temp_head->h_next;
-                    }
-                    temp_head->h_next = head;
-                    head->h_next = nullptr;
+                    pre_head->h_next = head->h_next;
                 }
-                head = next_hash_node;
+                DeleteNode(head);
+                return true;
+            }
+            pre_head = head;
+            head = head->h_next;
+        }
+        return false;
+    }
+
+    //! \brief 在还没有搬移的旧桶中查询
+    //! \return 节点地址，没有找到或者没有正在搬移时返回 nullptr
+    template <typename _LookupKey>
+    HashNode* FindInOldBuckets(const _LookupKey &key, uint64_t hash) const {
+        if (!rehashing())
+            return nullptr;
+        auto hash_index = IndexOf(hash, old_capacity_);
+        if (hash_index < rehash_index_)      // 这个旧桶已经搬移过了
+            return nullptr;
+        for (HashNode *head = old_array_[hash_index]; nullptr != head; head = head->h_next) {
+            if (head->data.key == key)
+                return head;
+        }
+        return nullptr;
+    }
+
+    //! \brief 按照键值在新、旧桶数组中查询
+    //! \return 节点地址，没有找到返回 nullptr
+    template <typename _LookupKey>
+    HashNode* FindNode(const _LookupKey &key) const {
+        return FindNode(key, HashOf(key));
+    }
+    // 哈希值已经计算过（插入、批量插入），不再重复计算
+    template <typename _LookupKey>
+    HashNode* FindNode(const _LookupKey &key, uint64_t hash) const {
+        HashNode *old_node = FindInOldBuckets(key, hash);
+        if (nullptr != old_node)
+            return old_node;
+        for (HashNode *head = array_[IndexOf(hash, capacity_)]; nullptr != head; head = head->h_next) {
+            if (head->data.key == key)
+                return head;
+        }
+        return nullptr;
+    }
+
+    // 批量查询中一个正在进行的查询
+    struct BatchSlot {
+        size_t     index;     // 键值在这一批中的下标
+        uint64_t   hash;      // 打散之后的哈希值
+        HashNode **bucket;    // 下一步要读取的桶，读取之后为 nullptr
+        HashNode  *node;      // 下一步要比较的节点
+        bool       in_old;    // 正在旧桶数组中查找
+    };
+
+    //! \brief 开始查询 keys[index]：计算哈希值，预取桶。正在搬移并且旧桶还没有搬移时先查旧桶
+    void StartBatchSlot(BatchSlot &slot, const KeyType *keys, size_t index) const {
+        slot.index  = index;
+        slot.hash   = HashOf(keys[index]);
+        slot.node   = nullptr;
+        slot.in_old = rehashing() && IndexOf(slot.hash, old_capacity_) >= rehash_index_;
+        slot.bucket = slot.in_old ? old_array_ + IndexOf(slot.hash, old_capacity_)
+                                  : array_ + IndexOf(slot.hash, capacity_);
+        __builtin_prefetch(slot.bucket);
+    }
+
+    //! \brief 查询向前推进一步：读取之前预取的桶或者比较之前预取的节点，再预取下一步要访问的内存
+    //! \return 查询是否结束，结束时结果已经写入 results
+    template <typename _Result>
+    bool StepBatchSlot(BatchSlot &slot, const KeyType *keys, _Result **results) const {
+        if (nullptr != slot.bucket) {
+            slot.node   = *slot.bucket;
+            slot.bucket = nullptr;
+        } else if (slot.node->data.key == keys[slot.index]) {
+            results[slot.index] = &slot.node->data.value;
+            return true;
+        } else {
+            slot.node = slot.node->h_next;
+        }
+        if (nullptr != slot.node) {
+            __builtin_prefetch(slot.node);
+            return false;
+        }
+        if (slot.in_old) {              // 旧桶中没有，再查新桶
+            slot.in_old = false;
+            slot.bucket = array_ + IndexOf(slot.hash, capacity_);
+            __builtin_prefetch(slot.bucket);
+            return false;
+        }
+        results[slot.index] = nullptr;
+        return true;
+    }
+
+    //! \brief 批量查询（AMAC）：kBatchGroup 个查询轮流推进，每个查询每次只走一步（读桶或者比较一个节点），
+    //!        并预取下一步要访问的内存，轮到它时数据已经在缓存中。一个查询结束后，它的位置马上开始下一个键值，
+    //!        始终有 kBatchGroup 个互不依赖的缓存缺失同时进行，不会像逐个查询那样每次都等一整个内存延迟
+    template <typename _Result>
+    size_t FindBatchImpl(const KeyType *keys, size_t n, _Result **results) const {
+        // 表能放进缓存时没有缓存缺失可以重叠，轮流推进的额外开销反而更大，直接逐个查询
+        if ((capacity_ + old_capacity_) * sizeof(HashNode*) + size() * sizeof(HashNode) < kBatchMinBytes) {
+            size_t found = 0;
+            for (size_t i = 0; i < n; i++) {
+                HashNode *node = FindNode(keys[i]);
+                results[i] = nullptr != node ? &node->data.value : nullptr;
+                found += nullptr != node ? 1 : 0;
+            }
+            return found;
+        }
+        BatchSlot slots[kBatchGroup];
+        size_t active = 0;
+        for (; active < kBatchGroup && active < n; active++)
+            StartBatchSlot(slots[active], keys, active);
+        size_t next = active, found = 0;
+        while (active > 0) {
+            for (size_t i = 0; i < active; ) {
+                if (!StepBatchSlot(slots[i], keys, results)) {
+                    i++;
+                    continue;
+                }
+                found += nullptr != results[slots[i].index] ? 1 : 0;
+                if (next < n) {
+                    StartBatchSlot(slots[i], keys, next++);
+                    i++;
+                } else {                // 没有新的键值了，用最后一个查询填补这个位置
+                    slots[i] = slots[--active];
+                }
+            }
+        }
+        return found;
+    }
+
+    // 释放桶数组以及其中所有节点
+    void FreeBuckets(HashNode **buckets, size_t capacity) {
+        if (nullptr == buckets)
+            return;
+        for (size_t i = 0; i < capacity; i++) {
+            HashNode *head = buckets[i];
+            while (nullptr != head) {
+                HashNode *temp = head->h_next;
+                DeleteNode(head);
+                head = temp;
+            }
+        }
+        std::free(buckets); // 释放数组
+    }
+
+    // 遍历一个桶数组中的数据，const 版本的 ForEach() 传入 const 节点
+    template <typename _NodePointer, typename _Function>
+    static void ForEachInBuckets(_NodePointer const *buckets, size_t capacity, _Function &function) {
+        if (nullptr == buckets)
+            return;
+        for (size_t i = 0; i < capacity; i++) {
+            for (_NodePointer head = buckets[i]; nullptr != head; head = head->h_next)
+                function(static_cast<const KeyType&>(head->data.key), head->data.value);
+        }
+    }
+
+    // 打印一个桶数组中的数据
+    void print_buckets(HashNode **buckets, size_t capacity) const {
+        if (nullptr == buckets)
+            return;
+        for (size_t i = 0; i < capacity; i++) {
+            HashNode *head = buckets[i];
+            while (nullptr != head) {
+                std::cout << "key: " << head->data.key << " "
+                          << "index: " << BucketIndex(head->data.key, capacity) << " "
+                          << "value: " << head->data.value << std::endl;
+                head = head->h_next;
             }
         }
-        delete[] array_;
-        array_ = temp;
     }
 
     //! \brief 按照键值在哈希表中进行查询
@@ -276,37 +750,31 @@ private: // helper functions
     //! \param key 目标数据
     //! \return 查询信息，first:是否成功找到，second:成功的节点地址。进而可以修改指向的内容
     std::pair<bool, const HashNode*> FindInertial(const KeyType &key) const {
-        size_t hash_index = hasher_(key) & (capacity_ - 1);
-        bool find_flag = false;
-        HashNode *head = array_[hash_index];
-        while (nullptr != head) {
-            if (key == head->data.key) {
-                find_flag = true;
-                break;
-            }
-            head = head->h_next;
-        }
-        return std::make_pair(find_flag, (find_flag? head: nullptr));
-    }
-
-    // // 处理 string 对象哈希码的原理，目前内部设计原理不清楚
-    // size_t HashCode(const std::string &key) const {
-    //     size_t string_code = 0;
-    //     if (key.size() > 0) {
-    //         for (size_t i = 0; i < key.size(); i++) {
-    //             string_code = string_code * 31 + key[i];
-    //         }
-    //     }
-    //     return string_code;
-    // }
-    //
-    // //! \brief 一个散列函数，返回底层数组索引
-    // size_t HashFunction(const KeyType &key) const {
-    //     size_t hash = HashCode(key);
-    //     return (hash ^ (hash >> 16)) & (capacity_ - 1);
-    // }
+        const HashNode *node = FindNode(key);
+        return std::make_pair(nullptr != node, node);
+    }
+
+    //! \brief 散列函数，返回底层数组索引
+    //! \note 哈希值先经过 FibonacciMix() 打散再取低位：std::hash 对整数是恒等映射，
+    //!       不打散时步长为 2^k 的键值（1024、2048、3072...）全部落在同一个桶中
+    template <typename _LookupKey>
+    size_t BucketIndex(const _LookupKey &key, size_t capacity) const {
+        return IndexOf(HashOf(key), capacity);
+    }
+
+    // 打散之后的哈希值，扩容前后不变，插入时只计算一次
+    template <typename _LookupKey>
+    uint64_t HashOf(const _LookupKey &key) const {
+        return hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)));
+    }
+    static size_t IndexOf(uint64_t hash, size_t capacity) {
+        return static_cast<size_t>(hash) & (capacity - 1);
+    }
 
 private:
+    static const size_t kRehashBucketsPerOp = 2;  // 每次插入、删除时搬移的非空旧桶个数
+    static const size_t kBatchGroup         = 16; // 批量查询同时进行的查询个数、批量插入每组的键值个数
+    static const size_t kBatchMinBytes      = 16 << 20; // 桶数组和节点小于这个字节数时批量查询退化为逐个查询
     const size_t min_capacity_ = 8;        // 默认最小容量
     const Hasher hasher_       = Hasher(); // 默认构造一个哈希对象，使用 stl 提供的计算哈希值
     bool  expand_or_shrink_    = false;    // true: 表示扩容， false 表示缩容
@@ -316,6 +784,18 @@ private:
     size_t     capacity_;         // 哈希表的容量 默认 16
     int        current_size_;     // 当前哈希表中元素的数量
 
+    // 渐进式搬移
+    HashNode** old_array_    = nullptr; // 旧桶数组，没有正在搬移时为空
+    size_t     old_capacity_ = 0;       // 旧桶数组的容量
+    size_t     rehash_index_ = 0;       // 下一个要搬移的旧桶，之前的旧桶都已经搬移完
+    size_t     reserved_capacity_ = 8;  // Reserve() 预留的容量，缩容时不会小于该值
+
+    // 节点分配
+    NodeAllocator node_allocator_;          // 节点分配器，默认为节点池
+    size_t node_allocations_   = 0;         // 节点分配次数
+    size_t node_deallocations_ = 0;         // 节点释放次数
+    size_t bucket_allocations_ = 0;         // 桶数组分配次数
+
 }; // class HashTable
 
 } // namespace glib
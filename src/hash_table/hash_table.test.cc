@@ -10,10 +10,65 @@
  */
 
 #include "./hash_table.hpp"
+#include "../utils/tic_toc.hpp"
 #include <string>
 #include <iostream>
+#include <vector>
+#include <algorithm> // std::max
+#include <cstdlib>   // malloc free
+#include <new>
 using namespace std;
 
+// 统计内存分配次数，验证查询时没有构造临时 string
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void *pointer = malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    g_allocations++;
+    if (void *pointer = malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+// C++14 起按大小释放的版本，也要替换，否则会由库的版本释放，与上面的 malloc 不配对
+void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+// 统计拷贝、移动次数的映射值
+struct Payload {
+    static int copies;
+    static int moves;
+    vector<int> data;
+
+    Payload() {}
+    Payload(size_t n, int value) : data(n, value) {}
+    Payload(const Payload &other) : data(other.data) { copies++; }
+    Payload(Payload &&other) : data(std::move(other.data)) { moves++; }
+    Payload& operator=(const Payload &other) { data = other.data; copies++; return *this; }
+    Payload& operator=(Payload &&other) { data = std::move(other.data); moves++; return *this; }
+};
+int Payload::copies = 0;
+int Payload::moves  = 0;
+
 //! \brief LRU 哈希表 + 双链表实现，简单测试
 //! \run
 //!     g++ hash_table.test.cc -std=c++11 && ./a.out
@@ -80,6 +135,115 @@ int main(int argc, char const *argv[]) {
         hash_table.Insert("1", "N");
     }
     hash_table.print_value();
+    cout << endl;
+
+    // 验证渐进式扩容：搬移期间插入、查找、删除都正确，单次插入的最大耗时不随数据量增长
+    cout << "验证渐进式扩容" << endl;
+    glib::HashTable<int, int> numbers;
+    const int kNum = 2000000;
+    double max_insert_ms = 0;
+    bool rehash_ok = true;
+    size_t rehash_count = 0;
+    for (int i = 0; i < kNum; i++) {
+        TicToc timer;
+        numbers.Insert(i, i * 2);
+        max_insert_ms = std::max(max_insert_ms, timer.toc());
+        if (numbers.rehashing()) {
+            rehash_count++;
+            // 搬移期间，已经插入的数据都能找到（抽查刚插入的和最早插入的）
+            rehash_ok = rehash_ok && numbers.Find(i).second == i * 2 && numbers.Find(i / 2).second == i / 2 * 2;
+        }
+    }
+    cout << "插入 " << kNum << " 个数据，容量：" << numbers.capacity()
+         << "，处于搬移中的插入次数：" << rehash_count << "，单次插入最大耗时：" << max_insert_ms << " ms" << endl;
+    for (int i = 0; i < kNum; i += 2)
+        numbers.Delete(i);
+    while (numbers.RehashStep(64)) {}
+    for (int i = 0; i < kNum; i++)
+        rehash_ok = rehash_ok && (numbers.Find(i).first == (1 == i % 2));
+    rehash_ok = rehash_ok && kNum / 2 == numbers.size() && !numbers.rehashing();
+    cout << (rehash_ok ? "ok" : "error") << endl;
+
+    cout << endl;
+
+    // 验证不拷贝的接口：TryEmplace 原地构造，InsertOrAssign 移动，FindPtr 返回指针，异构查询不分配内存
+    cout << "验证 TryEmplace/InsertOrAssign/FindPtr" << endl;
+    glib::HashTable<string, Payload, glib::StringHash> sessions;
+    auto emplaced = sessions.TryEmplace("session-0000000000001", 1000, 7);
+    bool emplace_ok = emplaced.second && 1000 == emplaced.first->data.size();
+    emplace_ok = emplace_ok && !sessions.TryEmplace("session-0000000000001", 5, 5).second
+                            && 1000 == sessions.FindPtr("session-0000000000001")->data.size();
+    Payload payload(10, 1);
+    auto assigned = sessions.InsertOrAssign("session-0000000000002", std::move(payload));
+    emplace_ok = emplace_ok && assigned.second && 10 == assigned.first->data.size();
+    assigned = sessions.InsertOrAssign("session-0000000000002", Payload(20, 2));
+    emplace_ok = emplace_ok && !assigned.second && 20 == sessions.FindPtr("session-0000000000002")->data.size();
+    emplace_ok = emplace_ok && 0 == Payload::copies;
+    cout << "拷贝次数：" << Payload::copies << "，移动次数：" << Payload::moves << endl;
+
+    // 键值超过短字符串优化的长度，构造临时 string 一定会分配内存
+    const char *lookup_key = "session-0000000000002";
+    size_t allocations = g_allocations;
+    const auto &const_sessions = sessions;
+    size_t found = 0;
+    for (int i = 0; i < 1000; i++) {
+        found += nullptr != const_sessions.FindPtr(lookup_key);
+        found += nullptr != sessions.FindPtr("session-not-exist-000000");
+    }
+    allocations = g_allocations - allocations;
+    emplace_ok = emplace_ok && 1000 == found && 0 == allocations;
+    cout << "异构查询 2000 次，内存分配次数：" << allocations << endl;
+
+    // 右值插入以及 std::hash 的普通查询
+    glib::HashTable<string, string> strings;
+    strings.Insert(std::make_pair(string("k"), string(100, 'v')));
+    emplace_ok = emplace_ok && nullptr != strings.FindPtr("k") && nullptr == strings.FindPtr("x");
+    cout << (emplace_ok ? "ok" : "error") << endl;
+
+    cout << endl;
+
+    // 验证批量接口：与逐个查询结果相同，包括正在搬移、键值不存在、个数不是分组大小的倍数
+    cout << "验证 FindBatch/InsertBatch" << endl;
+    glib::HashTable<int, int> batch;
+    vector<int> batch_keys, batch_values;
+    const int kBatchNum = 800003;     // 表超过 16MB，批量查询不会退化为逐个查询；插入结束时正在扩容搬移
+    for (int i = 0; i < kBatchNum; i++) {
+        batch_keys.push_back(i * 7);
+        batch_values.push_back(i);
+    }
+    size_t batch_inserted = batch.InsertBatch(batch_keys.data(), batch_values.data(), batch_keys.size());
+    batch_values[5] = -5;   // 重复插入：已存在的键值替换映射值
+    batch_inserted += batch.InsertBatch(batch_keys.data() + 5, batch_values.data() + 5, 1);
+    bool batch_ok = batch_keys.size() == batch_inserted && batch_keys.size() == batch.size() &&
+                    -5 == batch.Find(5 * 7).second && batch.rehashing();
+    vector<int> lookup_keys;
+    for (int i = 0; i < kBatchNum * 2; i++)
+        lookup_keys.push_back(i * 7 / 2);      // 一部分存在，一部分不存在
+    vector<const int*> batch_results(lookup_keys.size());
+    for (int round = 0; round < 3; round++) {
+        // 第一轮正在搬移，第二轮搬移完成，第三轮删除大部分数据之后表很小
+        if (1 == round) {
+            while (batch.RehashStep(64)) {}
+        } else if (2 == round) {
+            for (int i = 0; i < kBatchNum - 1000; i++)
+                batch.Delete(i * 7);
+        }
+        const auto &const_batch = batch;
+        size_t batch_found = const_batch.FindBatch(lookup_keys.data(), lookup_keys.size(), batch_results.data());
+        size_t single_found = 0;
+        for (size_t i = 0; i < lookup_keys.size(); i++) {
+            const int *expected = const_batch.FindPtr(lookup_keys[i]);
+            single_found += nullptr != expected ? 1 : 0;
+            batch_ok = batch_ok && batch_results[i] == expected;
+        }
+        batch_ok = batch_ok && batch_found == single_found && batch_found > 0;
+    }
+    vector<int*> mutable_results(1);
+    batch.FindBatch(batch_keys.data() + kBatchNum - 1, 1, mutable_results.data());
+    *mutable_results[0] = 42;
+    batch_ok = batch_ok && 1000 == batch.size() && 42 == batch.Find((kBatchNum - 1) * 7).second &&
+               0 == batch.FindBatch(batch_keys.data(), 0, mutable_results.data());
+    cout << (batch_ok ? "ok" : "error") << endl;
 
-    return 0;
+    return (rehash_ok && emplace_ok && batch_ok) ? 0 : 1;
 }
@@ -0,0 +1,109 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: hash_table_batch_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/20
+ * Description: throughput benchmark of HashTable batched lookup/insert vs per-key loop
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "hash_table.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+
+//! \brief 批量查询、插入吞吐量测试：表的大小从能放进缓存到远大于 L3，
+//!        对比逐个 FindPtr()/InsertOrAssign() 与 FindBatch()/InsertBatch()，查询键值随机，一半命中
+//! \run
+//!     g++ hash_table_batch_benchmark.cc -std=c++11 -O2 && ./a.out [最大数据量，默认 16M]
+
+namespace {
+
+const size_t kLookups   = 1 << 22;   // 每种大小的查询次数
+const size_t kBatchSize = 1024;      // 每次批量调用的键值个数
+
+// xorshift 随机数，比 mt19937 快，不影响测量
+struct FastRandom {
+    uint64_t state;
+    explicit FastRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint64_t operator()() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// 每秒百万次操作
+double Mops(size_t ops, double ms) { return ms > 0 ? ops / ms / 1000.0 : 0; }
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    size_t max_size = argc > 1 ? strtoull(argv[1], nullptr, 10) : (size_t(1) << 24);
+    cout << setw(10) << "size" << setw(14) << "find Mops" << setw(14) << "batch Mops" << setw(10) << "speedup"
+         << setw(14) << "insert Mops" << setw(14) << "batch Mops" << setw(10) << "speedup" << endl;
+
+    for (size_t size = 1 << 14; size <= max_size; size *= 4) {
+        // 键值为随机数，插入顺序与节点的内存顺序无关
+        FastRandom random(size);
+        vector<uint64_t> keys(size), values(size);
+        for (size_t i = 0; i < size; i++) {
+            keys[i]   = random();
+            values[i] = i;
+        }
+
+        // 插入：同样的数据分别逐个插入、批量插入到两个空表中
+        glib::HashTable<uint64_t, uint64_t> single, batch;
+        TicToc timer;
+        for (size_t i = 0; i < size; i++)
+            single.InsertOrAssign(keys[i], values[i]);
+        double insert_ms = timer.toc();
+        timer.tic();
+        for (size_t i = 0; i < size; i += kBatchSize)
+            batch.InsertBatch(keys.data() + i, values.data() + i, size - i < kBatchSize ? size - i : kBatchSize);
+        double batch_insert_ms = timer.toc();
+        // 搬移完旧桶之后再测查询，两种查询都不需要检查旧桶
+        while (single.RehashStep(1024)) {}
+        while (batch.RehashStep(1024)) {}
+
+        // 查询：一半是已经插入的键值，一半是随机数（几乎都不存在）
+        vector<uint64_t> lookups(kLookups);
+        for (size_t i = 0; i < kLookups; i++)
+            lookups[i] = (random() & 1) ? keys[random() % size] : random();
+        vector<const uint64_t*> results(kBatchSize);
+        const auto &table = batch;
+        uint64_t checksum = 0, batch_checksum = 0;
+        timer.tic();
+        for (size_t i = 0; i < kLookups; i++) {
+            const uint64_t *value = table.FindPtr(lookups[i]);
+            checksum += nullptr != value ? *value : 1;
+        }
+        double find_ms = timer.toc();
+        timer.tic();
+        for (size_t i = 0; i < kLookups; i += kBatchSize) {
+            table.FindBatch(lookups.data() + i, kBatchSize, results.data());
+            for (size_t j = 0; j < kBatchSize; j++)
+                batch_checksum += nullptr != results[j] ? *results[j] : 1;
+        }
+        double batch_find_ms = timer.toc();
+        if (checksum != batch_checksum || single.size() != batch.size()) {
+            cout << "error: batch results differ" << endl;
+            return 1;
+        }
+
+        cout << setw(10) << size << fixed << setprecision(1)
+             << setw(14) << Mops(kLookups, find_ms) << setw(14) << Mops(kLookups, batch_find_ms)
+             << setw(9) << find_ms / batch_find_ms << "x"
+             << setw(14) << Mops(size, insert_ms) << setw(14) << Mops(size, batch_insert_ms)
+             << setw(9) << insert_ms / batch_insert_ms << "x" << endl;
+    }
+    return 0;
+}
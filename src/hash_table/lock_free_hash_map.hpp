@@ -0,0 +1,420 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: lock_free_hash_map.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/18
+ * Description: lock-free split-ordered list hash map with epoch based reclamation
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_LOCK_FREE_HASH_MAP_HPP_
+#define GLIB_LOCK_FREE_HASH_MAP_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t uintptr_t
+#include <atomic>
+#include <functional>  // std::hash std::equal_to
+#include <utility>     // std::pair std::forward
+#include "hash.hpp"
+#include "../utils/epoch.hpp"
+#include "../internal/macros.h"
+
+//! \brief 无锁哈希表（split-ordered list）：所有数据在一条按「反转哈希值」排序的无锁有序链表中，
+//!        桶只是指向链表中哨兵节点的捷径，扩容时不搬移任何数据
+//!     外部调用核心函数：
+//!         1）查询：Find() 返回映射值的拷贝，Contains()，Visit() 在临界区内访问映射值（不拷贝）
+//!         2）插入：Insert()/InsertOrAssign() 插入或者替换，TryEmplace() 键值不存在时才插入
+//!         3）删除：Delete()
+//!         4）遍历：ForEach()
+//!     外部调用状态函数：
+//!         1）哈希表状态：size()、empty()、bucket_count()
+//!
+//! \Note
+//!     1）链表按 split-order 键值排序：普通节点为 reverse(hash | 最高位)（最低位为 1），
+//!        桶 b 的哨兵节点为 reverse(b)（最低位为 0）。桶数翻倍时，桶 b 中的数据按哈希值的下一位
+//!        正好分成两段，新桶 b + 2^k 的哨兵插在两段之间即可，不需要搬移节点
+//!     2）桶数组按段分配：第 0 段为桶 0，第 k 段为桶 [2^(k-1), 2^k)，已有的段不会移动、不会释放。
+//!        新桶在第一次写入时才初始化（插入哨兵节点），父桶为去掉最高位之后的桶
+//!     3）读操作（Find/Contains/Visit/ForEach）不加锁、不等待，也不写任何共享的缓存行：
+//!        只写自己线程的纪元槽；遇到已标记删除的节点直接跳过，不帮忙摘除；
+//!        桶还没有初始化时从父桶开始查找，不插入哨兵节点
+//!     4）写操作是无锁（lock-free）的：删除先在节点的 next 指针最低位打删除标记，再用 CAS 摘除（Harris-Michael），
+//!        谁摘除了节点谁负责 Retire()，由 EpochDomain 在所有读者离开之后释放
+//!     5）映射值放在单独分配的对象中，节点保存指向它的原子指针。InsertOrAssign() 替换指针，
+//!        旧的映射值同样延迟释放，读者读到的映射值不会被修改，所以 MappedType 不需要是原子类型
+//!     6）适合读远多于写的场景（配置、特征查找表）：每次写都要分配节点或映射值，比 ConcurrentHashTable 慢
+//!     7）size() 是近似值；ForEach() 是弱一致的遍历，可以与写操作并发，不会重复也不会崩溃，
+//!        但遍历期间插入、删除的数据可能看得到也可能看不到
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!     1）Shalev, Shavit, Split-ordered lists: lock-free extensible hash tables, JACM 2006
+//!     2）Maged Michael, High performance dynamic lock-free hash tables and list-based sets, SPAA 2002
+//!
+//! example
+//!     glib::LockFreeHashMap<string, int> features;
+//!     features.Insert("new-ui", 1);          // 写线程
+//!     auto value = features.Find("new-ui");  // 任意多个读线程
+//!     features.Delete("new-ui");
+
+namespace glib {
+
+namespace lock_free_hash_internal {
+
+// 64 位反转
+inline uint64_t ReverseBits(uint64_t x) {
+    x = ((x >> 1)  & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+    x = ((x >> 2)  & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+    x = ((x >> 4)  & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+    x = ((x >> 8)  & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+    return (x >> 32) | (x << 32);
+}
+
+// 最高的为 1 的位的下标，x > 0
+inline size_t HighestBit(uint64_t x) {
+    return 63 - static_cast<size_t>(__builtin_clzll(x));
+}
+
+} // namespace lock_free_hash_internal
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key> >
+class LockFreeHashMap {
+public: // 类型声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+    using KeyEqual   = _KeyEqual;
+
+public: // 构造函数相关
+    //! \param bucket_count 初始桶数，向上取整到 2 的指数次幂
+    explicit
+    LockFreeHashMap(size_t bucket_count = 16) : size_(0) {
+        size_t count = 2;
+        while (count < bucket_count)
+            count *= 2;
+        bucket_count_.store(count, std::memory_order_relaxed);
+        for (size_t i = 0; i < kMaxSegments; i++)
+            segments_[i].store(nullptr, std::memory_order_relaxed);
+        // 桶 0 的哨兵是整个链表的头部，一直存在
+        Node *head = new Node(0);
+        Segment(0)[0].store(head, std::memory_order_release);
+    }
+
+    //! \brief 析构时不能有其他线程在访问；已经 Retire() 的节点由 EpochDomain 释放
+    ~LockFreeHashMap() {
+        Node *node = Bucket(0)->load(std::memory_order_relaxed);
+        while (nullptr != node) {
+            Node *next = Pointer(node->next.load(std::memory_order_relaxed));
+            delete node;
+            node = next;
+        }
+        for (size_t i = 0; i < kMaxSegments; i++)
+            delete [] segments_[i].load(std::memory_order_relaxed);
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(LockFreeHashMap);
+
+public: // 外部调用核心函数
+    //! \brief 按照键值查询，返回映射值的拷贝
+    //! \complexity 平均 O(1)，不加锁、不写共享内存
+    //! \return first:是否找到，second:映射值的拷贝
+    std::pair<bool, MappedType> Find(const KeyType &key) const {
+        utils::EpochGuard guard;
+        const Node *node = ReadFind(key);
+        if (nullptr == node)
+            return std::make_pair(false, MappedType());
+        return std::make_pair(true, *node->value.load(std::memory_order_acquire));
+    }
+
+    //! \brief 是否存在键值 key
+    bool Contains(const KeyType &key) const {
+        utils::EpochGuard guard;
+        return nullptr != ReadFind(key);
+    }
+
+    //! \brief 在临界区内访问映射值，function(const MappedType&)，不拷贝映射值
+    //! \return 是否找到
+    template <typename _Function>
+    bool Visit(const KeyType &key, _Function function) const {
+        utils::EpochGuard guard;
+        const Node *node = ReadFind(key);
+        if (nullptr == node)
+            return false;
+        function(*node->value.load(std::memory_order_acquire));
+        return true;
+    }
+
+    //! \brief 键值不存在时插入，已存在时替换映射值（旧的映射值延迟释放）
+    //! \complexity 平均 O(1)，lock-free
+    //! \return 是否插入了新数据
+    bool InsertOrAssign(const KeyType &key, const MappedType &value) {
+        utils::EpochGuard guard;
+        MappedType *new_value = new MappedType(value);
+        uint64_t hash = HashOf(key);
+        Node *node = new Node(RegularKey(hash), key, new_value);
+        Node *existing = ListInsert(GetBucket(hash & (bucket_count() - 1)), node);
+        if (nullptr == existing) {
+            GrowIfNeeded(size_.fetch_add(1, std::memory_order_relaxed) + 1);
+            return true;
+        }
+        node->value.store(nullptr, std::memory_order_relaxed);
+        delete node;
+        MappedType *old_value = existing->value.exchange(new_value, std::memory_order_acq_rel);
+        utils::EpochDomain::Instance().Retire(old_value);
+        return false;
+    }
+    bool Insert(const KeyType &key, const MappedType &value) { return InsertOrAssign(key, value); }
+    bool Insert(const std::pair<KeyType, MappedType> &data)  { return InsertOrAssign(data.first, data.second); }
+
+    //! \brief 键值不存在时用 args 构造映射值并插入，已存在时什么都不做
+    //! \return 是否插入了新数据
+    template <typename... _Args>
+    bool TryEmplace(const KeyType &key, _Args&&... args) {
+        utils::EpochGuard guard;
+        uint64_t hash = HashOf(key);
+        Node *start = GetBucket(hash & (bucket_count() - 1));
+        if (nullptr != ReadFindFrom(start, RegularKey(hash), key))
+            return false;
+        Node *node = new Node(RegularKey(hash), key, new MappedType(std::forward<_Args>(args)...));
+        if (nullptr != ListInsert(start, node)) {
+            delete node;
+            return false;
+        }
+        GrowIfNeeded(size_.fetch_add(1, std::memory_order_relaxed) + 1);
+        return true;
+    }
+
+    //! \brief 删除键值为 key 的数据
+    //! \complexity 平均 O(1)，lock-free
+    //! \return 是否删除了数据（多个线程同时删除同一个键值时只有一个返回 true）
+    bool Delete(const KeyType &key) {
+        utils::EpochGuard guard;
+        uint64_t hash = HashOf(key);
+        uint64_t split_key = RegularKey(hash);
+        Node *start = GetBucket(hash & (bucket_count() - 1));
+        std::atomic<uintptr_t> *prev;
+        Node *current;
+        while (true) {
+            if (!ListFind(start, split_key, &key, prev, current))
+                return false;
+            uintptr_t next = current->next.load(std::memory_order_acquire);
+            if (IsMarked(next))
+                continue;       // 其他线程正在删除，重新查找
+            // 1）逻辑删除：标记 next 指针，之后没有线程能在它后面插入
+            if (!current->next.compare_exchange_strong(next, next | kMark, std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed))
+                continue;
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            // 2）物理删除：从链表中摘除，失败时由 ListFind() 顺便摘除
+            uintptr_t expected = Raw(current);
+            if (prev->compare_exchange_strong(expected, next, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed))
+                utils::EpochDomain::Instance().Retire(current);
+            else
+                ListFind(start, split_key, &key, prev, current);
+            return true;
+        }
+    }
+
+    //! \brief 遍历所有数据，function(const KeyType&, const MappedType&)，弱一致，可以与写操作并发
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        utils::EpochGuard guard;
+        const Node *node = Bucket(0)->load(std::memory_order_acquire);
+        while (nullptr != node) {
+            uintptr_t next = node->next.load(std::memory_order_acquire);
+            if (!node->IsSentinel() && !IsMarked(next))
+                function(node->key, *node->value.load(std::memory_order_acquire));
+            node = Pointer(next);
+        }
+    }
+
+    size_t size()         const { return size_.load(std::memory_order_relaxed);         } // 数据量（近似值）
+    bool   empty()        const { return 0 == size();                                    } // 是否为空
+    size_t bucket_count() const { return bucket_count_.load(std::memory_order_acquire);  } // 当前桶数
+
+private: // 类型声明
+    struct Node {
+        // 哨兵节点
+        explicit Node(uint64_t split) : next(0), split_key(split), key(), value(nullptr) {}
+        // 普通节点
+        Node(uint64_t split, const KeyType &k, MappedType *v) : next(0), split_key(split), key(k), value(v) {}
+        ~Node() { delete value.load(std::memory_order_relaxed); }
+
+        bool IsSentinel() const { return 0 == (split_key & 1); }
+
+        std::atomic<uintptr_t>    next;       // 下一个节点，最低位为删除标记
+        const uint64_t            split_key;  // split-order 键值，链表按它排序
+        const KeyType             key;        // 哨兵节点中没有使用
+        std::atomic<MappedType*>  value;      // 哨兵节点为空
+    };
+
+    using BucketSlot = std::atomic<Node*>;
+
+private: // helper functions
+    static bool      IsMarked(uintptr_t link) { return 0 != (link & kMark);                         }
+    static Node*     Pointer(uintptr_t link)  { return reinterpret_cast<Node*>(link & ~kMark);      }
+    static uintptr_t Raw(const Node *node)    { return reinterpret_cast<uintptr_t>(node);           }
+
+    uint64_t HashOf(const KeyType &key) const {
+        return hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)));
+    }
+    static uint64_t RegularKey(uint64_t hash) {
+        return lock_free_hash_internal::ReverseBits(hash | (uint64_t(1) << 63));
+    }
+    static uint64_t SentinelKey(size_t bucket) {
+        return lock_free_hash_internal::ReverseBits(bucket);
+    }
+
+    // 第 k 段的桶数：第 0 段 1 个，第 k 段 2^(k-1) 个
+    static size_t SegmentSize(size_t segment) { return 0 == segment ? 1 : size_t(1) << (segment - 1); }
+
+    //! \brief 取得第 segment 段，不存在时分配（多个线程同时分配时只有一个成功）
+    BucketSlot* Segment(size_t segment) {
+        BucketSlot *slots = segments_[segment].load(std::memory_order_acquire);
+        if (nullptr != slots)
+            return slots;
+        BucketSlot *fresh = new BucketSlot[SegmentSize(segment)]();
+        if (segments_[segment].compare_exchange_strong(slots, fresh, std::memory_order_acq_rel,
+                                                       std::memory_order_acquire))
+            return fresh;
+        delete [] fresh;
+        return slots;
+    }
+
+    //! \brief 桶 bucket 的槽，所在的段还没有分配时返回 nullptr
+    const BucketSlot* Bucket(size_t bucket) const {
+        if (0 == bucket)
+            return segments_[0].load(std::memory_order_acquire);
+        size_t segment = lock_free_hash_internal::HighestBit(bucket) + 1;
+        const BucketSlot *slots = segments_[segment].load(std::memory_order_acquire);
+        return nullptr == slots ? nullptr : slots + (bucket - SegmentSize(segment));
+    }
+
+    //! \brief 取得桶 bucket 的哨兵节点，还没有初始化时先初始化父桶，再把自己的哨兵插入链表（只有写操作调用）
+    Node* GetBucket(size_t bucket) {
+        const BucketSlot *slot = Bucket(bucket);
+        Node *sentinel = nullptr == slot ? nullptr : slot->load(std::memory_order_acquire);
+        if (nullptr != sentinel)
+            return sentinel;
+        size_t parent = bucket & ~(size_t(1) << lock_free_hash_internal::HighestBit(bucket));
+        Node *parent_sentinel = GetBucket(parent);
+        Node *node = new Node(SentinelKey(bucket));
+        Node *existing = ListInsert(parent_sentinel, node);
+        if (nullptr != existing) {      // 其他线程已经插入了这个哨兵
+            delete node;
+            node = existing;
+        }
+        size_t segment = lock_free_hash_internal::HighestBit(bucket) + 1;
+        BucketSlot &target = Segment(segment)[bucket - SegmentSize(segment)];
+        Node *expected = nullptr;
+        target.compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed);
+        return node;
+    }
+
+    //! \brief 只读查找：从已经初始化的最近的祖先桶开始，跳过已标记删除的节点，不写任何共享内存
+    const Node* ReadFind(const KeyType &key) const {
+        uint64_t hash = HashOf(key);
+        size_t bucket = hash & (bucket_count() - 1);
+        const Node *start = nullptr;
+        while (true) {
+            const BucketSlot *slot = Bucket(bucket);
+            start = nullptr == slot ? nullptr : slot->load(std::memory_order_acquire);
+            if (nullptr != start || 0 == bucket)
+                break;
+            bucket &= ~(size_t(1) << lock_free_hash_internal::HighestBit(bucket));
+        }
+        return ReadFindFrom(start, RegularKey(hash), key);
+    }
+
+    const Node* ReadFindFrom(const Node *start, uint64_t split_key, const KeyType &key) const {
+        const Node *node = Pointer(start->next.load(std::memory_order_acquire));
+        while (nullptr != node && node->split_key <= split_key) {
+            uintptr_t next = node->next.load(std::memory_order_acquire);
+            if (node->split_key == split_key && !IsMarked(next) && key_equal_(node->key, key))
+                return node;
+            node = Pointer(next);
+        }
+        return nullptr;
+    }
+
+    //! \brief 从 start 开始查找 split_key（key 为空时查找哨兵节点），顺便摘除遇到的已标记节点
+    //! \param prev 输出：指向 current 的链接
+    //! \param current 输出：找到的节点，没有找到时为第一个排在它后面的节点（插入位置）
+    //! \return 是否找到
+    bool ListFind(Node *start, uint64_t split_key, const KeyType *key,
+                  std::atomic<uintptr_t> *&prev, Node *&current) {
+    retry:
+        prev = &start->next;
+        current = Pointer(prev->load(std::memory_order_acquire));
+        while (nullptr != current) {
+            uintptr_t next = current->next.load(std::memory_order_acquire);
+            if (prev->load(std::memory_order_acquire) != Raw(current))
+                goto retry;     // 前驱已经改变（被删除或者在中间插入了节点）
+            if (IsMarked(next)) {
+                uintptr_t expected = Raw(current);
+                if (!prev->compare_exchange_strong(expected, next & ~kMark, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed))
+                    goto retry;
+                utils::EpochDomain::Instance().Retire(current);
+                current = Pointer(next);
+                continue;
+            }
+            if (current->split_key > split_key)
+                return false;
+            if (current->split_key == split_key &&
+                (nullptr == key || key_equal_(current->key, *key)))
+                return true;
+            prev = &current->next;
+            current = Pointer(next);
+        }
+        return false;
+    }
+
+    //! \brief 把 node 插入到 start 之后的有序位置
+    //! \return 已经存在相同键值的节点时返回该节点（node 没有插入），否则返回 nullptr
+    Node* ListInsert(Node *start, Node *node) {
+        const KeyType *key = node->IsSentinel() ? nullptr : &node->key;
+        std::atomic<uintptr_t> *prev;
+        Node *current;
+        while (true) {
+            if (ListFind(start, node->split_key, key, prev, current))
+                return current;
+            node->next.store(Raw(current), std::memory_order_relaxed);
+            uintptr_t expected = Raw(current);
+            if (prev->compare_exchange_strong(expected, Raw(node), std::memory_order_release,
+                                              std::memory_order_relaxed))
+                return nullptr;
+        }
+    }
+
+    //! \brief 平均每个桶的数据超过 kMaxLoadFactor 个时桶数翻倍，只修改桶数，新桶在用到时才初始化
+    void GrowIfNeeded(size_t size) {
+        size_t count = bucket_count_.load(std::memory_order_relaxed);
+        if (size > count * kMaxLoadFactor && count < kMaxBuckets)
+            bucket_count_.compare_exchange_strong(count, count * 2, std::memory_order_release,
+                                                  std::memory_order_relaxed);
+    }
+
+private:
+    static const uintptr_t kMark          = 1;                // next 指针中的删除标记
+    static const size_t    kMaxLoadFactor = 2;                // 每个桶平均的最大数据量
+    static const size_t    kMaxSegments   = 48;               // 最多 2^47 个桶
+    static const size_t    kMaxBuckets    = size_t(1) << (kMaxSegments - 1);
+
+    Hasher                   hasher_;
+    KeyEqual                 key_equal_;
+    std::atomic<size_t>      size_;                      // 数据量
+    std::atomic<size_t>      bucket_count_;              // 当前桶数，2 的指数次幂
+    std::atomic<BucketSlot*> segments_[kMaxSegments];    // 按段分配的桶数组
+
+}; // class LockFreeHashMap
+
+} // namespace glib
+
+#endif // GLIB_LOCK_FREE_HASH_MAP_HPP_
@@ -0,0 +1,153 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: lock_free_hash_map.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/18
+ * Description: test lock-free hash map (run it under ThreadSanitizer too)
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./lock_free_hash_map.hpp"
+#include "../internal/test_util.h"
+#include <cstdint>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+using glib::test_internal::RunThreads;
+
+namespace {
+
+// 映射值：写线程保证 check == key * 3 + version，读线程读到的值必须满足这个关系（不会读到一半被改写的值）
+struct Versioned {
+    uint64_t version;
+    uint64_t check;
+    string   payload;   // 有堆内存，释放之后再读 ASan/TSan 能发现
+};
+
+} // namespace
+
+//! \brief 无锁哈希表测试：单线程与 unordered_map 对比、扩容、读写并发压力测试、并发删除
+//! \run
+//!     g++ lock_free_hash_map.test.cc -std=c++11 -O2 -pthread && ./a.out
+//!     g++ lock_free_hash_map.test.cc -std=c++11 -O1 -g -pthread -fsanitize=thread && ./a.out
+int main(int argc, char const *argv[]) {
+    bool all_ok = true;
+
+    // 1）单线程随机操作，与 std::unordered_map 对比
+    cout << "随机对比测试" << endl;
+    mt19937_64 engine(2019);
+    glib::LockFreeHashMap<uint64_t, uint64_t> map(2);
+    unordered_map<uint64_t, uint64_t> expected;
+    bool random_ok = true;
+    for (size_t i = 0; i < 200000 && random_ok; i++) {
+        uint64_t key = engine() % 5000;
+        uint64_t value = engine();
+        switch (engine() % 4) {
+            case 0:
+                random_ok = map.Insert(key, value) == (0 == expected.count(key));
+                expected[key] = value;
+                break;
+            case 1:
+                random_ok = map.TryEmplace(key, value) == expected.emplace(key, value).second;
+                break;
+            case 2:
+                random_ok = map.Delete(key) == (1 == expected.erase(key));
+                break;
+            default: {
+                auto result = map.Find(key);
+                auto iter = expected.find(key);
+                random_ok = result.first == (iter != expected.end()) &&
+                            (!result.first || result.second == iter->second);
+            }
+        }
+        random_ok = random_ok && map.size() == expected.size();
+    }
+    size_t count = 0;
+    map.ForEach([&](uint64_t key, uint64_t value) {
+        random_ok = random_ok && expected.count(key) && expected[key] == value;
+        count++;
+    });
+    random_ok = random_ok && count == expected.size();
+    cout << " size " << map.size() << " buckets " << map.bucket_count() << (random_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && random_ok;
+
+    // 2）扩容：桶数随数据量翻倍，所有数据都能查到
+    cout << "扩容测试" << endl;
+    glib::LockFreeHashMap<string, int> strings;
+    for (int i = 0; i < 100000; i++)
+        strings.Insert("key-" + to_string(i), i);
+    bool grow_ok = strings.bucket_count() >= 100000 / 2 && 100000 == strings.size();
+    for (int i = 0; i < 100000; i++)
+        grow_ok = grow_ok && i == strings.Find("key-" + to_string(i)).second;
+    grow_ok = grow_ok && !strings.Contains("key-100000");
+    cout << " buckets " << strings.bucket_count() << (grow_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && grow_ok;
+
+    // 3）读写并发：写线程不断插入、替换、删除，读线程验证读到的值是完整的
+    cout << "读写并发压力测试" << endl;
+    const size_t kWriters = 2, kReaders = 6;
+    glib::LockFreeHashMap<uint64_t, Versioned> versioned(2);
+    atomic<size_t> bad_reads(0), hits(0);
+    atomic<size_t> writers_done(0);
+    RunThreads(kWriters + kReaders, [&](size_t index) {
+        mt19937_64 random(index);
+        if (index < kWriters) {
+            for (uint64_t i = 0; i < 60000; i++) {
+                uint64_t key = random() % 2048;
+                uint64_t version = random();
+                switch (random() % 3) {
+                    case 0:  versioned.InsertOrAssign(key, Versioned{version, key * 3 + version, "v" + to_string(i)}); break;
+                    case 1:  versioned.TryEmplace(key, Versioned{version, key * 3 + version, "e"}); break;
+                    default: versioned.Delete(key);
+                }
+            }
+            writers_done++;
+        } else {
+            while (writers_done.load() < kWriters) {
+                for (int i = 0; i < 1000; i++) {
+                    uint64_t key = random() % 2048;
+                    bool found = versioned.Visit(key, [&](const Versioned &value) {
+                        if (value.check != key * 3 + value.version || value.payload.empty())
+                            bad_reads++;
+                    });
+                    hits += found ? 1 : 0;
+                }
+            }
+        }
+    });
+    size_t listed = 0;
+    versioned.ForEach([&](uint64_t, const Versioned &) { listed++; });
+    bool stress_ok = 0 == bad_reads && hits > 0 && listed == versioned.size();
+    cout << " hits " << hits << " size " << versioned.size() << (stress_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && stress_ok;
+
+    // 4）并发插入、删除同一批键值：每个键值只有一个线程删除成功
+    cout << "并发删除测试" << endl;
+    glib::LockFreeHashMap<uint64_t, uint64_t> shared;
+    const uint64_t kKeys = 20000;
+    RunThreads(4, [&](size_t index) {
+        for (uint64_t key = index; key < kKeys; key += 4)
+            shared.Insert(key, key);
+    });
+    atomic<size_t> deleted(0);
+    RunThreads(4, [&](size_t) {
+        for (uint64_t key = 0; key < kKeys; key++)
+            deleted += shared.Delete(key) ? 1 : 0;
+    });
+    bool delete_ok = kKeys == deleted && shared.empty() && !shared.Contains(7);
+    size_t remaining = 0;
+    shared.ForEach([&](uint64_t, uint64_t) { remaining++; });
+    delete_ok = delete_ok && 0 == remaining;
+    cout << " deleted " << deleted << " epoch " << glib::utils::EpochDomain::Instance().epoch()
+         << (delete_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && delete_ok;
+
+    return all_ok ? 0 : 1;
+}
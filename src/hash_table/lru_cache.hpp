@@ -0,0 +1,541 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: lru_cache.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/22
+ * Description: generic key/value cache with compact index-linked nodes and pluggable eviction policy
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_LRU_CACHE_HPP_
+#define GLIB_LRU_CACHE_HPP_
+#include <cstdint>     // uint32_t uint64_t
+#include <iostream>
+#include <functional>  // std::hash std::equal_to
+#include <memory>      // std::allocator
+#include <new>         // placement new
+#include <stdexcept>   // std::length_error std::invalid_argument
+#include <type_traits> // std::aligned_storage
+#include <utility>     // std::pair std::move std::forward
+#include <vector>
+#include "hash_table.hpp" // hash_table_internal::IsTransparent、StringHash、StringEqual、hash::FibonacciMix
+#include "cache_policy.hpp"
+
+//! \brief 通用的缓存：键值、映射值类型任意，淘汰策略由模板参数 _Policy 决定（见 cache_policy.hpp），
+//!        默认为 LRU（LruPolicy），查询即提升为最近使用
+//!     外部调用核心函数：
+//!         1）查询并提升为最近使用：Get()，只查询不提升：Peek()、Contains()
+//!         2）插入或者替换映射值：Put()，键值不存在时才原地构造映射值：Emplace()，缓存满时按照策略淘汰数据
+//!         3）删除一个数据：Erase()，清空：Clear()
+//!         4）调整缓存容量：set_capacity()
+//!         5）按照策略的顺序遍历（LRU 为从最近使用到最久未使用）：ForEach()
+//!         6）句柄接口：查找 Lookup()、读取 value()、提升 Touch() 分开调用，用于批量提升（ShardedLruCache）；
+//!            策略的 Access() 线程安全时（CLOCK），共享锁内可以直接调用 TouchShared()
+//!     外部调用状态函数：
+//!         1）打印缓存数据（ForEach() 的顺序）：print_value()
+//!         2）缓存状态：size()、empty()、capacity()、bucket_count()、memory_usage()
+//!         3）命中、未命中、淘汰次数：stats()、ResetStats()
+//!     内部辅助核心函数：
+//!         1）查询：FindIndex()，插入：InsertNew()，删除：Remove()
+//!         2）重新分配节点数组：Reallocate()
+//!
+//! \Note
+//!     1）与 LruHash 的区别：键值只存储一份；Get() 会把数据移动到链表头（LruHash::Find() 是 const，不提升）；
+//!        映射值可以是任意类型，包括只能移动的类型
+//!     2）所有节点放在一个连续的数组中，双链表、哈希拉链都用 32 位下标（而不是 64 位指针）串联，
+//!        拉链链接在节点内，双链表链接在策略的数组中（下标与节点相同），LRU 每个数据的额外开销为
+//!        12 字节链接 + 4 字节左右的桶，没有单独分配节点的开销。
+//!        比如 <uint64_t, uint64_t> 每个数据约 36 字节，LruHash<uint64_t> 约 56 字节（还存了两份键值）
+//!     3）节点数组按需加倍增长，最大为缓存容量 + 1，空的大缓存不会一开始就占满内存。
+//!        桶的个数为不小于节点数组大小的 2 的幂，装载因子不超过 1，与节点数组一起重新分配
+//!     4）新数据先插入，数据个数超过容量时再由策略选择淘汰的数据（不会是刚插入的数据），
+//!        这样策略可以比较新数据与淘汰对象（TinyLFU），或者根据新数据是否在幽灵队列中选择淘汰哪一段（ARC）。
+//!        淘汰、删除的节点放入空闲链表（复用拉链的 chain 下标），稳定运行时不再分配内存
+//!     5）节点数组增长（插入时）时数据的下标不变、地址改变，缩小（set_capacity()）时下标大于新大小的数据
+//!        移动到空闲的位置，之前 Get()/Peek() 得到的指针失效；
+//!        淘汰、删除也会使被淘汰、删除的数据的指针失效。单线程使用
+//!     6）容量上限为 2^32 - 3 个数据
+//!     7）纯 LRU 会被一次性的大范围扫描冲掉所有热点数据，这种访问模式下使用 SlruPolicy、TwoQueuePolicy、
+//!        ArcPolicy 或者 TinyLfuPolicy，cache_trace_replay.cc 可以用实际的访问记录比较各个策略的命中率
+//!
+//! \complexity
+//!     Get()/Peek()/Put()/Emplace()/Erase() 平均 O(1)，节点数组增长时均摊 O(1)（所有策略都是 O(1)）
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! example
+//!     LruCache<uint64_t, std::string> responses(10000000);
+//!     responses.Put(request_id, body);
+//!     if (const std::string *body = responses.Get(request_id))
+//!         ...
+//!     LruCache<uint64_t, Block, std::hash<uint64_t>, std::equal_to<uint64_t>, TinyLfuPolicy> blocks(100000);
+
+namespace glib {
+
+//! \brief 缓存的命中、未命中、淘汰次数
+struct CacheStats {
+    size_t hits      = 0;   // Get() 命中
+    size_t misses    = 0;   // Get() 未命中
+    size_t evictions = 0;   // 因为容量淘汰的数据个数（不包括 Erase()、Clear()）
+
+    double hit_rate() const {
+        return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+    }
+};
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key>, typename _Policy = LruPolicy>
+class LruCache {
+public: // 类型声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+    using KeyEqual   = _KeyEqual;
+    using Policy     = _Policy;
+
+    // 节点中存储的数据
+    struct HashData {
+        KeyType key;        // 键值
+        MappedType value;   // 映射值
+    };
+
+private:
+    using Index = uint32_t;
+
+    // 节点：数据只在使用中的节点里构造，使用顺序由策略保存
+    struct Node {
+        typename std::aligned_storage<sizeof(HashData), alignof(HashData)>::type storage;
+        Index chain;    // 哈希拉链中的下一个节点；空闲节点的下一个空闲节点
+
+        HashData& data() { return *reinterpret_cast<HashData*>(&storage); }
+        const HashData& data() const { return *reinterpret_cast<const HashData*>(&storage); }
+    };
+
+    using Allocator = std::allocator<Node>;
+
+    // 哈希函数、比较函数都支持异构查询时，才能用其他类型的键值查询
+    template <typename _LookupKey>
+    using EnableIfTransparent = typename std::enable_if<
+        hash_table_internal::IsTransparent<Hasher>::value &&
+        hash_table_internal::IsTransparent<KeyEqual>::value &&
+        !std::is_same<typename std::decay<_LookupKey>::type, KeyType>::value>::type;
+
+public: // 构造函数相关
+    //! \param capacity 缓存最多保存的数据个数，至少为 1
+    explicit
+    LruCache(size_t capacity, const Hasher &hasher = Hasher(), const KeyEqual &key_equal = KeyEqual())
+        : hasher_(hasher), key_equal_(key_equal), nodes_(nullptr), node_count_(0), used_nodes_(0),
+          buckets_(nullptr), bucket_mask_(0), free_(kNil), current_size_(0),
+          capacity_(CheckCapacity(capacity)) {
+        policy_.set_capacity(capacity_);
+        Reallocate(capacity_ + 1 < kInitialNodes ? capacity_ + 1 : kInitialNodes);
+    }
+
+    ~LruCache() {
+        Clear();
+        Allocator().deallocate(nodes_, node_count_);
+        delete[] buckets_;
+    }
+
+    LruCache(const LruCache &other) = delete;
+    LruCache(LruCache &&other) = delete;
+    LruCache& operator=(const LruCache &other) = delete;
+    LruCache& operator=(LruCache &&other) = delete;
+
+public: // 外部调用核心函数
+    //! \brief 查询映射值，并通知策略数据被访问（LRU 提升为最近使用），计入命中、未命中次数
+    //! \complexity 平均 O(1)
+    //! \return 映射值的地址，没有找到返回 nullptr。插入、删除之后可能失效
+    MappedType* Get(const KeyType &key) { return GetImpl(key); }
+    // 异构查询
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    MappedType* Get(const _LookupKey &key) { return GetImpl(key); }
+
+    //! \brief 只查询映射值，不改变使用顺序
+    //! \complexity 平均 O(1)
+    const MappedType* Peek(const KeyType &key) const { return PeekImpl(key); }
+    template <typename _LookupKey, typename = EnableIfTransparent<_LookupKey> >
+    const MappedType* Peek(const _LookupKey &key) const { return PeekImpl(key); }
+
+    bool Contains(const KeyType &key) const { return kNil != FindIndex(key); }
+
+    //! \brief 插入或者替换映射值，替换时算作一次访问；数据个数超过容量时按照策略淘汰一个数据
+    //! \complexity 平均 O(1)
+    //! \return true:插入了新的键值，false:替换了已有键值的映射值
+    template <typename _MappedArg>
+    bool Put(const KeyType &key, _MappedArg &&value) {
+        return PutImpl(key, std::forward<_MappedArg>(value));
+    }
+    template <typename _MappedArg>
+    bool Put(KeyType &&key, _MappedArg &&value) {
+        return PutImpl(std::move(key), std::forward<_MappedArg>(value));
+    }
+
+    //! \brief 键值不存在时，用 args 原地构造映射值并插入；已存在时不修改映射值，算作一次访问
+    //! \complexity 平均 O(1)
+    //! \return first:映射值的地址，second:是否插入了新数据
+    template <typename... _Args>
+    std::pair<MappedType*, bool> Emplace(const KeyType &key, _Args&&... args) {
+        return EmplaceImpl(key, std::forward<_Args>(args)...);
+    }
+    template <typename... _Args>
+    std::pair<MappedType*, bool> Emplace(KeyType &&key, _Args&&... args) {
+        return EmplaceImpl(std::move(key), std::forward<_Args>(args)...);
+    }
+
+    //! \brief 删除指定数据
+    //! \complexity 平均 O(1)
+    //! \return 是否删除了数据
+    bool Erase(const KeyType &key) {
+        Index index = FindIndex(key);
+        if (kNil == index)
+            return false;
+        Remove(index);
+        return true;
+    }
+
+    //! \brief 删除所有数据，保留节点数组
+    void Clear() {
+        policy_.ForEach([this](Index index) { nodes_[index].data().~HashData(); });
+        policy_.Clear();
+        for (size_t i = 0; i <= bucket_mask_; i++)
+            buckets_[i] = kNil;
+        free_         = kNil;
+        used_nodes_   = 0;
+        current_size_ = 0;
+    }
+
+    //! \brief 调整缓存容量：数据多于新容量时按照策略淘汰，节点数组大于新容量 + 1 时缩小
+    //! \complexity O(淘汰的数据个数)，缩小节点数组时 O(size)
+    void set_capacity(size_t capacity) {
+        capacity_ = CheckCapacity(capacity);
+        policy_.set_capacity(capacity_);
+        while (current_size_ > capacity_)
+            Evict(kNil);
+        if (node_count_ > capacity_ + 1)
+            Reallocate(capacity_ + 1);
+    }
+
+    //! \brief 按照策略的顺序遍历（LRU 为从最近使用到最久未使用），function(const KeyType&, MappedType&)，
+    //!        不改变使用顺序
+    template <typename _Function>
+    void ForEach(_Function function) {
+        policy_.ForEach([this, &function](Index index) {
+            function(static_cast<const KeyType&>(nodes_[index].data().key), nodes_[index].data().value);
+        });
+    }
+    // 只读遍历，function(const KeyType&, const MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) const {
+        policy_.ForEach([this, &function](Index index) {
+            function(nodes_[index].data().key, static_cast<const MappedType&>(nodes_[index].data().value));
+        });
+    }
+
+    // 打印缓存数据，ForEach() 的顺序
+    void print_value() const {
+        std::cout << "print start:" << std::endl;
+        if (current_size_ > 0) {
+            ForEach([](const KeyType &key, const MappedType &value) {
+                std::cout << "key: " << key << " " << "value: " << value << std::endl;
+            });
+        } else {
+            std::cout << "缓存为空!" << std::endl;
+        }
+        std::cout << "print end." << std::endl;
+    }
+
+    size_t size()         const { return current_size_;          } // 当前数据量
+    bool   empty()        const { return 0 == current_size_;     } // 是否为空
+    size_t capacity()     const { return capacity_;              } // 缓存容量
+    size_t bucket_count() const { return bucket_mask_ + 1;       } // 桶的个数
+    // 节点数组、桶数组和策略占用的字节数（不包括键值、映射值自己在堆上分配的内存）
+    size_t memory_usage() const {
+        return node_count_ * sizeof(Node) + bucket_count() * sizeof(Index) + policy_.memory_usage();
+    }
+
+    const CacheStats& stats()  const { return stats_;     } // 命中、未命中、淘汰次数
+    void         ResetStats()        { stats_ = CacheStats(); }
+    const Policy& policy()     const { return policy_;    } // 淘汰策略的状态
+
+public: // 句柄接口：查找与提升分开，ShardedLruCache 在读锁内查找、记录命中，之后在写锁内批量提升
+    using Handle = Index;
+    static constexpr Handle kNullHandle = static_cast<Handle>(-1);
+
+    //! \brief 只查找不提升，返回数据的句柄，没有找到返回 kNullHandle，不计入命中、未命中次数
+    //! \note 句柄在插入新数据、删除、淘汰、Clear()、set_capacity() 之前有效，
+    //!       Get()、Touch()、替换已有数据的映射值不会使句柄失效
+    template <typename _LookupKey>
+    Handle Lookup(const _LookupKey &key) const { return FindIndex(key); }
+
+    const MappedType& value(Handle handle) const { return nodes_[handle].data().value; }
+    MappedType&       value(Handle handle)       { return nodes_[handle].data().value; }
+
+    //! \brief 通知策略句柄对应的数据被访问（LRU 提升为最近使用）
+    void Touch(Handle handle) { policy_.Access(handle, HashOf(nodes_[handle].data().key)); }
+
+    //! \brief 只读地通知策略句柄对应的数据被访问，多个线程可以在共享锁内同时调用
+    //! \note 只有声明了 kConcurrentAccess 的策略（ClockPolicy、ClockProPolicy）可以使用
+    void TouchShared(Handle handle) const {
+        static_assert(cache_policy_internal::HasConcurrentAccess<Policy>::value,
+                      "LruCache::TouchShared() requires a policy with concurrent Access()");
+        policy_.Access(handle);
+    }
+
+private: // helper functions
+    static size_t CheckCapacity(size_t capacity) {
+        if (0 == capacity)
+            throw std::invalid_argument("LruCache: capacity must be at least 1");
+        if (capacity >= kNil - 1)
+            throw std::length_error("LruCache: capacity exceeds 32-bit node index");
+        return capacity;
+    }
+
+    // 打散之后的哈希值，取低位得到桶，与 HashTable 相同
+    template <typename _LookupKey>
+    uint64_t HashOf(const _LookupKey &key) const {
+        return hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)));
+    }
+
+    template <typename _LookupKey>
+    size_t BucketIndex(const _LookupKey &key) const {
+        return static_cast<size_t>(HashOf(key)) & bucket_mask_;
+    }
+
+    //! \brief 在拉链中查找键值
+    //! \return 节点下标，没有找到返回 kNil
+    template <typename _LookupKey>
+    Index FindIndex(const _LookupKey &key) const {
+        return FindIndex(key, HashOf(key));
+    }
+    template <typename _LookupKey>
+    Index FindIndex(const _LookupKey &key, uint64_t hash) const {
+        for (Index index = buckets_[static_cast<size_t>(hash) & bucket_mask_]; kNil != index;
+             index = nodes_[index].chain) {
+            if (key_equal_(nodes_[index].data().key, key))
+                return index;
+        }
+        return kNil;
+    }
+
+    template <typename _LookupKey>
+    MappedType* GetImpl(const _LookupKey &key) {
+        const uint64_t hash = HashOf(key);
+        Index index = FindIndex(key, hash);
+        if (kNil == index) {
+            stats_.misses++;
+            return nullptr;
+        }
+        stats_.hits++;
+        policy_.Access(index, hash);
+        return &nodes_[index].data().value;
+    }
+
+    template <typename _LookupKey>
+    const MappedType* PeekImpl(const _LookupKey &key) const {
+        Index index = FindIndex(key);
+        return kNil != index ? &nodes_[index].data().value : nullptr;
+    }
+
+    template <typename _KeyArg, typename _MappedArg>
+    bool PutImpl(_KeyArg &&key, _MappedArg &&value) {
+        const uint64_t hash = HashOf(key);
+        Index index = FindIndex(key, hash);
+        if (kNil != index) {
+            nodes_[index].data().value = std::forward<_MappedArg>(value);
+            policy_.Access(index, hash);
+            return false;
+        }
+        InsertNew(hash, std::forward<_KeyArg>(key), std::forward<_MappedArg>(value));
+        return true;
+    }
+
+    template <typename _KeyArg, typename... _Args>
+    std::pair<MappedType*, bool> EmplaceImpl(_KeyArg &&key, _Args&&... args) {
+        const uint64_t hash = HashOf(key);
+        Index index = FindIndex(key, hash);
+        if (kNil != index) {
+            policy_.Access(index, hash);
+            return std::make_pair(&nodes_[index].data().value, false);
+        }
+        index = InsertNew(hash, std::forward<_KeyArg>(key), std::forward<_Args>(args)...);
+        return std::make_pair(&nodes_[index].data().value, true);
+    }
+
+    //! \brief 插入一个不存在的键值，交给策略；数据个数超过容量时由策略选择一个其他数据淘汰
+    //! \note 1）构造失败时节点放回空闲链表
+    //!       2）节点数组需要加倍时，参数可能引用数组中的数据（比如 Put(key, *Peek(other))），
+    //!          重新分配会移动、析构它们，所以先在栈上构造好新数据，再取得节点
+    //! \param hash 键值打散之后的哈希值 HashOf(key)
+    template <typename _KeyArg, typename... _Args>
+    Index InsertNew(uint64_t hash, _KeyArg &&key, _Args&&... args) {
+        if (kNil == free_ && used_nodes_ == node_count_) {
+            HashData data{KeyType(std::forward<_KeyArg>(key)), MappedType(std::forward<_Args>(args)...)};
+            return InsertData(hash, std::move(data));
+        }
+        Index index = AcquireNode();
+        try {
+            new (&nodes_[index].storage) HashData{KeyType(std::forward<_KeyArg>(key)),
+                                                  MappedType(std::forward<_Args>(args)...)};
+        } catch (...) {
+            nodes_[index].chain = free_;
+            free_ = index;
+            throw;
+        }
+        return LinkNew(index, hash);
+    }
+
+    // 插入已经构造好的数据（节点数组可能重新分配）
+    Index InsertData(uint64_t hash, HashData &&data) {
+        Index index = AcquireNode();
+        try {
+            new (&nodes_[index].storage) HashData(std::move(data));
+        } catch (...) {
+            nodes_[index].chain = free_;
+            free_ = index;
+            throw;
+        }
+        return LinkNew(index, hash);
+    }
+
+    // 新数据放入拉链、交给策略，超过容量时淘汰
+    Index LinkNew(Index index, uint64_t hash) {
+        // 节点数组可能重新分配过，桶要在取得节点之后计算
+        size_t bucket = static_cast<size_t>(hash) & bucket_mask_;
+        nodes_[index].chain = buckets_[bucket];
+        buckets_[bucket] = index;
+        policy_.Insert(index, hash);
+        current_size_++;
+        if (current_size_ > capacity_)
+            Evict(index);
+        return index;
+    }
+
+    // 按照策略淘汰一个数据，protect 为不能淘汰的数据（刚插入的数据）
+    void Evict(Index protect) {
+        Index victim = policy_.Victim(protect, [this](Index index) { return HashOf(nodes_[index].data().key); });
+        Remove(victim, true);
+        stats_.evictions++;
+    }
+
+    // 取得一个未使用的节点：先用空闲链表，再用数组中从未用过的节点，都没有时节点数组加倍
+    Index AcquireNode() {
+        if (kNil != free_) {
+            Index index = free_;
+            free_ = nodes_[index].chain;
+            return index;
+        }
+        if (used_nodes_ == node_count_)
+            Reallocate(node_count_ * 2 < capacity_ + 1 ? node_count_ * 2 : capacity_ + 1);
+        return static_cast<Index>(used_nodes_++);
+    }
+
+    //! \brief 删除节点上的数据：从拉链、策略中摘下，析构数据，节点放入空闲链表
+    //! \param evicted 是否因为容量淘汰（幽灵队列只记录淘汰的数据）
+    void Remove(Index index, bool evicted = false) {
+        const uint64_t hash = HashOf(nodes_[index].data().key);
+        Index *link = &buckets_[static_cast<size_t>(hash) & bucket_mask_];
+        while (*link != index)
+            link = &nodes_[*link].chain;
+        *link = nodes_[index].chain;
+        policy_.Remove(index, hash, evicted);
+        nodes_[index].data().~HashData();
+        nodes_[index].chain = free_;
+        free_ = index;
+        current_size_--;
+    }
+
+    //! \brief 重新分配 node_count 个节点，重建空闲链表和桶数组
+    //! \note 数据的下标不变；缩小时下标不小于 node_count 的数据移动到前面的空闲位置（通知策略），
+    //!       调用前数据个数不能超过 node_count
+    //! \complexity O(used_nodes + bucket_count)
+    void Reallocate(size_t node_count) {
+        std::vector<bool> live(used_nodes_, false);
+        policy_.ForEach([&live](Index index) { live[index] = true; });
+        if (node_count > node_count_)
+            policy_.Resize(node_count);
+
+        Node *nodes = Allocator().allocate(node_count);
+        Index hole = 0;
+        for (Index index = 0; index < used_nodes_; index++) {
+            if (!live[index])
+                continue;
+            Index target = index;
+            if (index >= node_count) {
+                while (live[hole])
+                    hole++;
+                target = hole;
+                live[hole] = true;
+                policy_.Relocate(index, target);
+            }
+            new (&nodes[target].storage) HashData(std::move(nodes_[index].data()));
+            nodes_[index].data().~HashData();
+        }
+        if (nullptr != nodes_)
+            Allocator().deallocate(nodes_, node_count_);
+        if (node_count < node_count_)
+            policy_.Resize(node_count);
+        nodes_      = nodes;
+        node_count_ = node_count;
+        if (used_nodes_ > node_count)
+            used_nodes_ = node_count;
+        free_ = kNil;
+        for (Index index = static_cast<Index>(used_nodes_); index-- > 0; ) {
+            if (!live[index]) {
+                nodes_[index].chain = free_;
+                free_ = index;
+            }
+        }
+
+        size_t bucket_count = kInitialNodes;
+        while (bucket_count < node_count)
+            bucket_count *= 2;
+        if (bucket_count != bucket_mask_ + 1 || nullptr == buckets_) {
+            delete[] buckets_;
+            buckets_     = new Index[bucket_count];
+            bucket_mask_ = bucket_count - 1;
+        }
+        for (size_t i = 0; i < bucket_count; i++)
+            buckets_[i] = kNil;
+        policy_.ForEach([this](Index index) {
+            size_t bucket = BucketIndex(nodes_[index].data().key);
+            nodes_[index].chain = buckets_[bucket];
+            buckets_[bucket] = index;
+        });
+    }
+
+private:
+    static constexpr Index  kNil          = static_cast<Index>(-1); // 空下标
+    static constexpr size_t kInitialNodes = 16;                     // 节点数组的初始大小、桶的最少个数
+    Hasher    hasher_;          // 哈希函数
+    KeyEqual  key_equal_;       // 键值比较函数
+    Node     *nodes_;           // 节点数组
+    size_t    node_count_;      // 节点数组大小，不超过 capacity_ + 1
+    size_t    used_nodes_;      // 数组中用过的节点个数，之后的节点从未使用
+    Index    *buckets_;         // 桶数组，保存拉链头节点的下标
+    size_t    bucket_mask_;     // 桶的个数 - 1
+    Index     free_;            // 空闲链表头
+    size_t    current_size_;    // 当前数据个数
+    size_t    capacity_;        // 缓存容量
+    Policy    policy_;          // 淘汰策略，保存数据的使用顺序
+    CacheStats stats_;          // 命中、未命中、淘汰次数
+
+}; // class LruCache
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual, typename _Policy>
+constexpr typename LruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::Index
+LruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::kNil;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual, typename _Policy>
+constexpr size_t LruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::kInitialNodes;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual, typename _Policy>
+constexpr typename LruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::Handle
+LruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::kNullHandle;
+
+} // namespace glib
+
+#endif // GLIB_LRU_CACHE_HPP_
@@ -0,0 +1,204 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: lru_cache.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/22
+ * Description: test generic lru cache
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./lru_cache.hpp"
+#include "./lru_hash.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// 参照实现：std::list 保存使用顺序，std::unordered_map 保存链表位置
+class ReferenceLru {
+public:
+    explicit ReferenceLru(size_t capacity) : capacity_(capacity) {}
+
+    const uint64_t* Get(uint64_t key) {
+        auto iter = index_.find(key);
+        if (iter == index_.end())
+            return nullptr;
+        order_.splice(order_.begin(), order_, iter->second);
+        return &iter->second->second;
+    }
+
+    bool Put(uint64_t key, uint64_t value) {
+        auto iter = index_.find(key);
+        if (iter != index_.end()) {
+            iter->second->second = value;
+            order_.splice(order_.begin(), order_, iter->second);
+            return false;
+        }
+        if (order_.size() == capacity_) {
+            index_.erase(order_.back().first);
+            order_.pop_back();
+        }
+        order_.emplace_front(key, value);
+        index_[key] = order_.begin();
+        return true;
+    }
+
+    bool Erase(uint64_t key) {
+        auto iter = index_.find(key);
+        if (iter == index_.end())
+            return false;
+        order_.erase(iter->second);
+        index_.erase(iter);
+        return true;
+    }
+
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        while (order_.size() > capacity_) {
+            index_.erase(order_.back().first);
+            order_.pop_back();
+        }
+    }
+
+    const list<pair<uint64_t, uint64_t> >& order() const { return order_; }
+
+private:
+    size_t capacity_;
+    list<pair<uint64_t, uint64_t> > order_;
+    unordered_map<uint64_t, list<pair<uint64_t, uint64_t> >::iterator> index_;
+};
+
+// 两个缓存的内容、使用顺序是否相同
+bool SameOrder(const glib::LruCache<uint64_t, uint64_t> &cache, const ReferenceLru &reference) {
+    auto iter = reference.order().begin();
+    bool same = cache.size() == reference.order().size();
+    cache.ForEach([&](uint64_t key, uint64_t value) {
+        same = same && iter != reference.order().end() && iter->first == key && iter->second == value;
+        ++iter;
+    });
+    return same;
+}
+
+} // namespace
+
+//! \brief LRU 缓存测试：与参照实现对比随机操作和使用顺序、Emplace/只能移动的映射值、异构查询、
+//!        调整容量，以及每个数据占用的内存与 LruHash 对比
+//! \run
+//!     g++ lru_cache.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    mt19937_64 engine(2019);
+    bool all_ok = true;
+
+    // 1）随机 Get/Put/Erase/set_capacity，结果和使用顺序与参照实现相同
+    cout << "随机操作" << endl;
+    glib::LruCache<uint64_t, uint64_t> cache(100);
+    ReferenceLru reference(100);
+    bool random_ok = true;
+    for (int i = 0; i < 300000 && random_ok; i++) {
+        uint64_t key = engine() % 300, value = engine();
+        switch (engine() % 10) {
+            case 0: case 1: case 2: case 3: {
+                const uint64_t *expected = reference.Get(key);
+                const uint64_t *found = cache.Get(key);
+                random_ok = (nullptr == expected) == (nullptr == found) && (nullptr == found || *found == *expected);
+                break;
+            }
+            case 4: case 5: case 6: case 7:
+                random_ok = reference.Put(key, value) == cache.Put(key, value);
+                break;
+            case 8:
+                random_ok = reference.Erase(key) == cache.Erase(key);
+                break;
+            default:
+                if (0 == engine() % 100) {
+                    size_t capacity = 1 + engine() % 200;
+                    reference.set_capacity(capacity);
+                    cache.set_capacity(capacity);
+                }
+        }
+        if (0 == i % 1000)
+            random_ok = random_ok && SameOrder(cache, reference);
+    }
+    random_ok = random_ok && SameOrder(cache, reference);
+    cout << (random_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && random_ok;
+
+    // 2）Get 提升、Peek 不提升、Emplace 不覆盖已有映射值、只能移动的映射值、异构查询、容量为 1
+    cout << "接口" << endl;
+    glib::LruCache<string, unique_ptr<string>, glib::StringHash, glib::StringEqual> owners(3);
+    owners.Emplace("a", new string("A"));
+    owners.Emplace("b", new string("B"));
+    owners.Emplace("c", new string("C"));
+    bool api_ok = "A" == **owners.Get("a");                   // 使用顺序 a c b
+    api_ok = api_ok && "B" == **owners.Peek("b");             // 不提升，b 仍然最久未使用
+    api_ok = api_ok && !owners.Emplace("c", unique_ptr<string>(new string("X"))).second &&
+             "C" == **owners.Peek(string("c"));
+    owners.Put(string("d"), unique_ptr<string>(new string("D")));   // 淘汰 b
+    api_ok = api_ok && !owners.Contains("b") && owners.Contains("a") && 3 == owners.size() &&
+             owners.Erase("a") && !owners.Erase("a") && 2 == owners.size();
+    owners.Clear();
+    api_ok = api_ok && owners.empty() && nullptr == owners.Get("c") && owners.Emplace("e", new string("E")).second;
+    glib::LruCache<int, int> single(1);
+    single.Put(1, 1);
+    single.Put(2, 2);
+    api_ok = api_ok && nullptr == single.Get(1) && 2 == *single.Get(2) && 1 == single.size();
+    bool thrown = false;
+    try {
+        glib::LruCache<int, int> zero(0);
+    } catch (const std::invalid_argument &error) {
+        thrown = true;
+    }
+    api_ok = api_ok && thrown;
+    cout << (api_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && api_ok;
+
+    // 3）插入时节点数组加倍，映射值引用缓存中的数据：先构造新数据再重新分配
+    cout << "插入自身的数据" << endl;
+    glib::LruCache<int, string> blobs(100);
+    for (int key = 0; key < 16; key++)                        // 用满初始的 16 个节点
+        blobs.Put(key, string(100, static_cast<char>('a' + key)));
+    blobs.Put(100, *blobs.Peek(3));
+    for (int key = 16; key < 31; key++)
+        blobs.Put(key, string(100, static_cast<char>('a' + key)));
+    bool alias_ok = 32 == blobs.size() && blobs.Emplace(200, *blobs.Peek(5)).second;
+    alias_ok = alias_ok && string(100, 'd') == *blobs.Peek(100) && string(100, 'f') == *blobs.Peek(200) &&
+               string(100, 'd') == *blobs.Peek(3);
+    cout << (alias_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && alias_ok;
+
+    // 4）内存与速度：100 万个 <uint64_t, uint64_t>，与 LruHash<uint64_t>（节点 + 两倍容量的桶指针）对比内存
+    cout << "内存与速度" << endl;
+    const size_t kNum = 1000000;
+    vector<uint64_t> keys(kNum);
+    for (auto &key: keys) key = engine();
+    glib::LruCache<uint64_t, uint64_t> large(kNum);
+    for (size_t i = 0; i < kNum; i++)
+        large.Put(keys[i], keys[i]);
+    double cache_bytes  = static_cast<double>(large.memory_usage()) / kNum;
+    double legacy_bytes = sizeof(glib::LruHash<uint64_t>::HashNode) + 2.0 * sizeof(void*);
+    vector<uint64_t> lookups(kNum);
+    for (auto &key: lookups) key = keys[engine() % kNum];
+    uint64_t checksum = 0;
+    TicToc timer;
+    for (auto key: lookups) checksum += *large.Get(key);
+    double get_ms = timer.toc();
+    cout << "  LruCache " << cache_bytes << " bytes/entry, LruHash " << legacy_bytes << " bytes/entry" << endl;
+    cout << "  100 万次 Get " << get_ms << " ms (checksum " << (checksum & 0xFF) << ")" << endl;
+    bool memory_ok = kNum == large.size() && cache_bytes < legacy_bytes;
+    large.set_capacity(10);
+    memory_ok = memory_ok && 10 == large.size() && large.memory_usage() < 1024 && large.Contains(lookups.back());
+    cout << (memory_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && memory_ok;
+
+    return all_ok ? 0 : 1;
+}
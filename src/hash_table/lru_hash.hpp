@@ -13,7 +13,10 @@
 #define GLIB_LRU_HASH_HPP_
 #include <iostream>
 #include <functional> // std::hash<>
+#include <memory>     // std::allocator_traits
 #include "assert.h"   // assert()
+#include "node_pool.hpp"
+#include "hash.hpp"
 
 //! \brief 利用哈希表和双链表实现 LRU 缓存淘汰算法
 //!     外部调用核心函数：
@@ -26,6 +29,8 @@
 //!         2）打印 LRU 内部数据：print_value()
 //!         3）LRU 状态：size()、empty()、capacity()
 //!         4）底层哈希表状态：max_load_factor()、min_load_factor()、hash_capacity()、load_factor()
+//!         5）内存分配统计：allocation_stats()
+//!         6）预留容量：Reserve()，同时预留桶数组和节点池
 //!     内部辅助核心函数：
 //!         1）调节底层哈希容量：AdjustCapacity()
 //!         2）将指定节点移到双链表头：MoveListHead()
@@ -37,6 +42,8 @@
 //! \Note
 //!     1）底层哈希存储的数据依然是 key 和 value。并且 key == value，这样会浪费点空间。
 //!     2）仅适用于内置数据类型，比如 string int ...
+//!     3）节点由分配器模板参数 _Allocator 分配，默认使用节点池 NodePool：缓存满了以后淘汰的节点直接被新数据复用，
+//!        稳定运行时不再调用 malloc/free
 //!
 //! \TODO
 //!     1）扩容底层哈希表规的则需要修改，下面使用的是一次性扩容-底层。
@@ -48,13 +55,13 @@
 
 namespace glib {
 
-template <typename _Key, typename _Hash = std::hash<_Key> >
+template <typename _Key, typename _Hash = std::hash<_Key>, typename _Allocator = NodePool<_Key> >
 class LruHash {
 public: // 类型声明
     using _Value     = _Key;
     using KeyType    = _Key;
     using MappedType = _Value;
-    using Hasher     = std::hash<_Key>;
+    using Hasher     = _Hash;
 
     // 哈希表内部存储的数据，包含了键值及其对应的数据
     //! \note 此时 key 和 value 是一样的值！
@@ -70,12 +77,16 @@ public: // 类型声明
         HashNode *h_next; // 拉链中的下一个节点
     };
 
+private:
+    using NodeAllocator = typename std::allocator_traits<_Allocator>::template rebind_alloc<HashNode>;
+    using NodeTraits    = std::allocator_traits<NodeAllocator>;
+
 public: // 构造函数相关
     // 默认容量是 2 的指数次幂
     explicit
-    LruHash(size_t max_lru_size = 8)
+    LruHash(size_t max_lru_size = 8, const _Allocator &allocator = _Allocator())
         : max_lru_size_(max_lru_size), current_size_(0),
-          list_head_(nullptr), list_tail_(nullptr), expand_or_shrink_(false) {
+          list_head_(nullptr), list_tail_(nullptr), expand_or_shrink_(false), node_allocator_(allocator) {
         assert(max_lru_size >= 1);
         if (max_lru_size_ <= max_load_factor_*min_capacity_)
             hash_capacity_ = min_capacity_; // 8
@@ -96,10 +107,10 @@ public: // 构造函数相关
                     HashNode *head = array_[i];
                     while (nullptr != head->h_next) {
                         HashNode *temp = head->h_next;
-                        delete head;
+                        DeleteNode(head);
                         head = temp;
                     }
-                    delete head;
+                    DeleteNode(head);
                 }
             }
             delete[] array_; // 释放数组
@@ -141,7 +152,7 @@ public: // 外部调用函数
         // 这里有两种情况：
         //      1）达到了缓存的上限，此时需要在头部插入新节点。
         //      2）没有找到给定数据，同时没有达到上限，直接插入新节点。
-        size_t hash_index = hasher_(key) & (hash_capacity_ - 1);
+        size_t hash_index = BucketIndex(key);
         bool find_flag = false;
         HashNode *head = array_[hash_index];
         HashNode *pre_head = array_[hash_index];
@@ -156,7 +167,7 @@ public: // 外部调用函数
 
         // 在拉链中没有找到该关键值 key，那么在拉链尾部和双链表尾部插入新节点
         if (!find_flag) {
-            HashNode *new_node = new HashNode;
+            HashNode *new_node = NewNode();
             new_node->data.key = key;                // 这里对于缓存结构来说，存储的关键字和关键值是一样的
             new_node->data.value = key;
             new_node->h_next = nullptr;              // 尾部节点要指向空
@@ -191,7 +202,7 @@ public: // 外部调用函数
         auto find_result = FindInertial(key);
         if (find_result.first) {
             // 哈希表中存在该数据，直接遍历删除即可
-            auto hash_index = hasher_(key) & (hash_capacity_ - 1);
+            auto hash_index = BucketIndex(key);
             HashNode *head = array_[hash_index];
             HashNode *pre_head = head;
             while (nullptr != head) {
@@ -221,7 +232,7 @@ public: // 外部调用函数
                     }
 
                     // 在内存中删除该节点
-                    delete head;
+                    DeleteNode(head);
                     break;
                 }
                 pre_head = head;
@@ -256,6 +267,23 @@ public: // 外部调用函数
         }
     }
 
+    //! \brief 预留容量：之后插入 n 个数据的过程中不会重新分配桶数组，也不会为节点向系统申请内存（节点池）
+    //! \note 数据个数不会超过 LRU 容量，n 超过 LRU 容量时按照 LRU 容量预留；桶数组只扩大不缩小
+    //! \complexity O(n)
+    void Reserve(size_t n) {
+        if (n > max_lru_size_)
+            n = max_lru_size_;
+        size_t new_capacity = min_capacity_;
+        while (static_cast<double>(n) / new_capacity > max_load_factor_)
+            new_capacity *= 2;
+        if (new_capacity > hash_capacity_)
+            MoveBuckets(new_capacity);
+        if (n > current_size_) {
+            node_pool_internal::PoolReserve(node_allocator_, n - current_size_,
+                                            node_pool_internal::HasReserve<NodeAllocator>());
+        }
+    }
+
     // 调试打印输出，分别按照哈希表和双链表顺序
     void debug_print_value() const {
         std::cout << "debug_print_value start:" << std::endl;
@@ -285,7 +313,35 @@ public: // 外部调用函数
     size_t hash_capacity()   const { return hash_capacity_;                           } // 哈希容量
     double load_factor()     const { return static_cast<double>(hash_capacity_)/capacity();} // 返回当前装载因子大小：lru大小/哈希大小
 
+    // 节点的内存分配统计，分配器不是节点池时只有分配、释放次数
+    AllocationStats allocation_stats() const {
+        AllocationStats stats = node_pool_internal::PoolStats(node_allocator_,
+                                                              node_pool_internal::HasStats<NodeAllocator>());
+        stats.allocations   = node_allocations_;
+        stats.deallocations = node_deallocations_;
+        return stats;
+    }
+
 private: // helper functions
+    // 用分配器分配并构造节点
+    HashNode* NewNode() {
+        HashNode *node = NodeTraits::allocate(node_allocator_, 1);
+        try {
+            new (node) HashNode;
+        } catch (...) {
+            NodeTraits::deallocate(node_allocator_, node, 1);
+            throw;
+        }
+        node_allocations_++;
+        return node;
+    }
+
+    void DeleteNode(HashNode *node) {
+        node->~HashNode();
+        NodeTraits::deallocate(node_allocator_, node, 1);
+        node_deallocations_++;
+    }
+
     //! \brief 动态扩充底层哈希表容量
     //! \note 这里装载因子定义为（LRU 容量/哈希表容量）且这里扩容仅仅对底层的哈希表起作用，双链表不需要修改
     //! \complexity average case:O(1) 空间复杂度 O(2*hash_capacity or hash_capacity/2) = O(hash_capacity)
@@ -295,23 +351,28 @@ private: // helper functions
     void AdjustCapacity() {
         std::cout << "AdjustCapacity()->";
         // 容量太大需要动态扩容，容量小需要缩减容量。都是按照 2 的倍数扩容和缩容。缩容不能小于 min_capacity_
-        HashNode ** temp;
-        decltype(hash_capacity_) origin_capacity = hash_capacity_;
+        size_t new_capacity;
         if (expand_or_shrink_) {
-            hash_capacity_ = max_lru_size_*2;
-            temp = new HashNode*[hash_capacity_];
+            new_capacity = max_lru_size_*2;
             std::cout<< "扩容" << std::endl;
         } else {
             if (max_lru_size_ <= max_load_factor_*min_capacity_)
-                hash_capacity_ = min_capacity_; // 8
+                new_capacity = min_capacity_; // 8
             else
-                hash_capacity_ = max_lru_size_ * 1.5; // > 4/3 TODO 需要改为最接近 2 的整数次幂
-            if (hash_capacity_ == origin_capacity)
+                new_capacity = max_lru_size_ * 1.5; // > 4/3 TODO 需要改为最接近 2 的整数次幂
+            if (new_capacity == hash_capacity_)
                 return;
-            temp = new HashNode*[hash_capacity_];
             std::cout << "缩绒" << std::endl;
         }
+        MoveBuckets(new_capacity);
+    }
 
+    //! \brief 分配 new_capacity 个桶，把所有节点按照新的容量重新放入
+    //! \complexity O(hash_capacity + size)
+    void MoveBuckets(size_t new_capacity) {
+        const size_t origin_capacity = hash_capacity_;
+        hash_capacity_ = new_capacity;
+        HashNode **temp = new HashNode*[hash_capacity_];
         for (size_t i = 0; i < hash_capacity_; i++) {
             temp[i] = nullptr;
         }
@@ -320,7 +381,7 @@ private: // helper functions
         for (size_t i = 0; i < origin_capacity; i++) {
             HashNode *head = array_[i];
             while (nullptr != head) {
-                auto hash_index = hasher_(head->data.key) & (hash_capacity_ - 1);
+                auto hash_index = BucketIndex(head->data.key);
                 HashNode *next_hash_node = head->h_next;
                 if (nullptr == temp[hash_index]) {
                     temp[hash_index] = head;
@@ -374,13 +435,18 @@ private: // helper functions
         list_head_->pre = nullptr;
     }
 
+    //! \brief 散列函数，返回底层数组索引：哈希值先打散再取低位，与 HashTable 相同
+    size_t BucketIndex(const KeyType &key) const {
+        return static_cast<size_t>(hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)))) & (hash_capacity_ - 1);
+    }
+
     //! \brief 按照键值在哈希表中进行查询
     //! \complexity O(1)
     //! \note 通过返回的指针可以查看和修改对应节点值
     //! \param key 目标数据
     //! \return 查询信息，first:是否成功找到，second:成功的节点地址，进而可以修改指向的内容
     std::pair<bool, HashNode*> FindInertial(const KeyType &key) const {
-        size_t hash_index = hasher_(key) & (hash_capacity_ - 1);
+        size_t hash_index = BucketIndex(key);
         bool find_flag = false;
         HashNode *head = array_[hash_index];
         while (nullptr != head) {
@@ -400,7 +466,7 @@ private: // helper functions
                 HashNode *head = array_[i];
                 while (nullptr != head) {
                     std::cout << "key: " << head->data.key << " "
-                              << "index: " << (hasher_(head->data.key) & (hash_capacity_ - 1)) << " "
+                              << "index: " << BucketIndex(head->data.key) << " "
                               << "value: " << head->data.value << std::endl;
                     head = head->h_next;
                 }
@@ -437,6 +503,11 @@ private:
 
     // Lru 参数
     size_t max_lru_size_;  // 设置 LRU 大小，进而调节哈希表相关变量
+
+    // 节点分配
+    NodeAllocator node_allocator_;      // 节点分配器，默认为节点池
+    size_t node_allocations_   = 0;     // 节点分配次数
+    size_t node_deallocations_ = 0;     // 节点释放次数
 }; // LruHash
 
 } // namespace glib
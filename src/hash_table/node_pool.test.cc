@@ -0,0 +1,154 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: node_pool.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/16
+ * Description: test node pool and its use in HashTable / LruHash
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./node_pool.hpp"
+#include "./hash_table.hpp"
+#include "./lru_hash.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm> // std::sort std::unique
+using namespace std;
+
+namespace {
+
+struct Node {
+    uint64_t key;
+    double   value;
+    Node    *next;
+};
+
+//! \brief 随机插入、删除 operations 次，键值范围 [0, range)，返回耗时（毫秒）
+template <typename _Table>
+double Churn(_Table &table, size_t operations, uint64_t range, uint64_t &checksum) {
+    mt19937_64 engine(2019);
+    TicToc timer;
+    for (size_t i = 0; i < operations; i++) {
+        uint64_t key = engine() % range;
+        if (engine() & 1)
+            table.Insert(key, key);
+        else
+            table.Delete(key);
+    }
+    for (uint64_t key = 0; key < range; key++)
+        checksum += table.Find(key).first;
+    return timer.toc();
+}
+
+} // namespace
+
+//! \brief 节点池测试：节点复用、预留，哈希表在频繁插入、删除时与 std::allocator 的对比
+//! \run
+//!     g++ node_pool.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    bool all_ok = true;
+
+    // 1）节点池本身：释放的节点被复用，地址不重复，预留之后不再申请内存
+    cout << "节点池测试" << endl;
+    glib::NodePool<Node> pool;
+    vector<Node*> nodes;
+    for (int i = 0; i < 1000; i++) {
+        nodes.push_back(pool.allocate(1));
+        nodes.back()->key = i;
+    }
+    bool pool_ok = true;
+    for (int i = 0; i < 1000; i++)
+        pool_ok = pool_ok && static_cast<uint64_t>(i) == nodes[i]->key;
+    size_t chunks = pool.stats().chunks;
+    for (int i = 0; i < 1000; i += 2)
+        pool.deallocate(nodes[i], 1);
+    for (int i = 0; i < 1000; i += 2)
+        nodes[i] = pool.allocate(1);
+    pool_ok = pool_ok && chunks == pool.stats().chunks && 500 == pool.stats().reused;
+    pool.Reserve(10000);
+    chunks = pool.stats().chunks;
+    for (int i = 0; i < 10000; i++)
+        nodes.push_back(pool.allocate(1));
+    pool_ok = pool_ok && chunks == pool.stats().chunks;
+    std::sort(nodes.begin(), nodes.end());
+    pool_ok = pool_ok && std::unique(nodes.begin(), nodes.end()) == nodes.end();
+    for (auto node: nodes)
+        pool.deallocate(node, 1);
+    pool.stats().print();
+    cout << (pool_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && pool_ok;
+
+    // 2）哈希表：频繁插入、删除，节点池与 std::allocator 对比
+    cout << "哈希表插入、删除 400 万次（键值范围 10 万）" << endl;
+    using PoolTable = glib::HashTable<uint64_t, uint64_t>;
+    using HeapTable = glib::HashTable<uint64_t, uint64_t, std::hash<uint64_t>,
+                                      std::allocator<std::pair<const uint64_t, uint64_t> > >;
+    uint64_t pool_checksum = 0, heap_checksum = 0;
+    PoolTable pool_table;
+    HeapTable heap_table;
+    double pool_ms = Churn(pool_table, 4000000, 100000, pool_checksum);
+    double heap_ms = Churn(heap_table, 4000000, 100000, heap_checksum);
+    cout << " NodePool:       " << pool_ms << " ms" << endl;
+    pool_table.allocation_stats().print();
+    cout << " std::allocator: " << heap_ms << " ms" << endl;
+    heap_table.allocation_stats().print();
+    glib::AllocationStats pool_stats = pool_table.allocation_stats();
+    bool churn_ok = pool_checksum == heap_checksum && pool_table.size() == heap_table.size() &&
+                    pool_stats.allocations - pool_stats.deallocations == pool_table.size() &&
+                    pool_stats.chunks * 100 < pool_stats.allocations;
+    cout << (churn_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && churn_ok;
+
+    // 3）Reserve：之后插入 n 个数据不会扩容，也不会为节点申请内存
+    cout << "Reserve 测试" << endl;
+    glib::HashTable<string, int> reserved;
+    reserved.Reserve(50000);
+    glib::AllocationStats before = reserved.allocation_stats();
+    size_t capacity = reserved.capacity();
+    for (int i = 0; i < 50000; i++)
+        reserved.Insert(to_string(i), i);
+    glib::AllocationStats after = reserved.allocation_stats();
+    for (int i = 0; i < 50000; i++)
+        reserved.Delete(to_string(i));
+    bool reserve_ok = capacity == reserved.capacity() && before.chunks == after.chunks &&
+                      50000 == after.allocations && reserved.empty();
+    after.print();
+    cout << (reserve_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && reserve_ok;
+
+    // 4）LruHash：缓存满了之后淘汰的节点被复用
+    cout << "LruHash 测试" << endl;
+    glib::LruHash<int> lru(1000);
+    for (int i = 0; i < 100000; i++)
+        lru.Insert(i);
+    glib::AllocationStats lru_stats = lru.allocation_stats();
+    lru_stats.print();
+    bool lru_ok = 1000 == lru.size() && 100000 == lru_stats.allocations && lru_stats.reused >= 99000 &&
+                  lru.Find(99999).first && !lru.Find(0).first;
+    cout << (lru_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && lru_ok;
+
+    // 5）LruHash::Reserve：之后插满缓存不会重新分配桶数组，也不会为节点申请内存
+    cout << "LruHash Reserve 测试" << endl;
+    glib::LruHash<int> reserved_lru(20000);
+    reserved_lru.Reserve(20000);
+    glib::AllocationStats lru_before = reserved_lru.allocation_stats();
+    size_t hash_capacity = reserved_lru.hash_capacity();
+    for (int i = 0; i < 30000; i++)
+        reserved_lru.Insert(i);
+    glib::AllocationStats lru_after = reserved_lru.allocation_stats();
+    lru_after.print();
+    bool lru_reserve_ok = hash_capacity == reserved_lru.hash_capacity() && lru_before.chunks == lru_after.chunks &&
+                          20000 == reserved_lru.size() && reserved_lru.Find(29999).first;
+    cout << (lru_reserve_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && lru_reserve_ok;
+
+    return all_ok ? 0 : 1;
+}
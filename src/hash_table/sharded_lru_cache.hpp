@@ -0,0 +1,367 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: sharded_lru_cache.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/23
+ * Description: thread-safe sharded lru cache with buffered (lazy) promotion
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_SHARDED_LRU_CACHE_HPP_
+#define GLIB_SHARDED_LRU_CACHE_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t uint64_t
+#include <atomic>
+#include <functional>  // std::hash std::equal_to
+#include <mutex>       // std::lock_guard
+#include <new>         // operator new、placement new
+#include <utility>     // std::pair
+#include "lru_cache.hpp"
+#include "concurrent_hash_table.hpp" // SharedSpinLock、concurrent_hash_internal::kCacheLineSize
+#include "../utils/thread_pool.hpp"
+#include "../internal/macros.h"
+
+//! \brief 线程安全的 LRU 缓存：数据按照哈希值分到 N 个分片，每个分片是一个 LruCache 加一把读写锁，
+//!        命中时不立即移动链表，而是记录到读缓冲区中，之后在写锁内批量提升（Caffeine 的做法）
+//!     外部调用核心函数：
+//!         1）查询：Get() 返回映射值的拷贝，Visit() 在读锁内访问映射值（不拷贝），两者都记录一次命中；
+//!            Contains() 不记录命中
+//!         2）插入或者替换映射值：Put()，删除：Erase()，清空：Clear()
+//!         3）立即应用所有分片中记录的命中：FlushPromotions()
+//!     外部调用状态函数：
+//!         1）缓存状态：size()、empty()、capacity()、num_shards()、num_stripes()
+//!         2）因为读缓冲区满而丢弃的命中个数：dropped_promotions()
+//!
+//! \Note
+//!     1）LruHash/LruCache 每次命中都要修改共享的双链表，读操作也必须加互斥锁，所有读者串行执行。
+//!        这里命中只在读锁内查找，并把节点的句柄写入读缓冲区（一次原子加法 + 一次写），多个读者可以同时进行
+//!     2）每个分片有 num_stripes() 个读缓冲区（按缓存行对齐），个数为硬件线程数向上取整到 2 的指数次幂（最多 kMaxStripes）。
+//!        线程第一次命中时按创建顺序分配编号，之后固定使用编号对应的缓冲区：同时运行的线程不超过缓冲区个数、
+//!        编号连续时每个线程独占一个缓存行；线程数更多或者线程反复创建销毁（编号取模后重复）时，多个线程会写同一个
+//!        缓冲区，count 上的原子加法争用同一个缓存行，结果仍然正确，只是变慢。缓冲区满时，当前线程尝试加写锁（不等待），按照记录的顺序把这些数据移动到链表头，然后清空缓冲区；
+//!        加锁失败或者缓冲区已满时新的命中直接丢弃。丢弃少量命中只会让淘汰顺序稍微偏离严格的 LRU：
+//!        热点数据命中很多次，总有一部分会被记录下来
+//!     3）写操作（Put/Erase/Clear）加写锁之后先应用缓冲区中的命中，再修改缓存。所以缓冲区中的句柄
+//!        都是上一次修改之后记录的，始终有效（LruCache 的句柄只会因为插入、删除、淘汰而失效）
+//!     4）每个分片的容量为总容量 / 分片数（向上取整），淘汰只在分片内部进行，是近似的全局 LRU。
+//!        分片个数是 2 的指数次幂，默认为硬件线程数的 4 倍（至少 16），选择分片用哈希值打散后的高位
+//!     5）Visit() 的 function 在分片读锁内执行，不能再访问同一个缓存（会死锁）
+//!     6）_Policy 为每个分片 LruCache 的淘汰策略（见 cache_policy.hpp），缓冲区中的命中按顺序交给策略的 Access()。
+//!        策略声明了 kConcurrentAccess 时（ClockPolicy、ClockProPolicy，见 clock_cache.hpp），命中在读锁内直接
+//!        设置引用位，不使用读缓冲区，dropped_promotions() 始终为 0
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \benchmark
+//!     sharded_lru_cache_benchmark.cc：1 ~ 64 个线程、Zipf 分布的访问下与「互斥锁 + LruCache」的吞吐量、命中率对比
+//!     Intel Xeon（虚拟机，1 个硬件线程）、g++ 12.2.0 -O2，./a.out 4000000 中 32 个线程的一行：
+//!         mutex 10.42 Mops/s（命中率 76.12%），sharded 9.67 Mops/s（命中率 76.13%），speedup 0.93
+//!     只有一个硬件线程时各线程轮流执行，没有锁竞争，这一行只说明命中率不受延迟提升影响；
+//!     多核机器上的吞吐量需要重新运行基准测试得到
+//!
+//! \reference
+//!     1）Ben Manes, Caffeine: Design of a modern cache（BP-Wrapper 读缓冲区）
+//!     2）Ding et al., BP-Wrapper: A system framework making any replacement algorithms (almost) lock contention free, ICDE 2009
+//!
+//! example
+//!     glib::ShardedLruCache<uint64_t, string> responses(10000000);
+//!     // 多个线程中
+//!     auto hit = responses.Get(request_id);
+//!     if (!hit.first)
+//!         responses.Put(request_id, Compute(request_id));
+
+namespace glib {
+
+namespace sharded_lru_internal {
+
+//! \brief 当前线程使用的读缓冲区编号：每个线程第一次调用时按顺序分配，之后不变
+inline size_t ThreadStripe() {
+    static std::atomic<size_t> next_stripe(0);
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed);
+    return stripe;
+}
+
+} // namespace sharded_lru_internal
+
+template <typename _Key, typename _Value, typename _Hash = std::hash<_Key>,
+          typename _KeyEqual = std::equal_to<_Key>, typename _Policy = LruPolicy>
+class ShardedLruCache {
+public: // 类型声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Hasher     = _Hash;
+    using KeyEqual   = _KeyEqual;
+    using CacheType  = LruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>;
+
+private:
+    // 策略的 Access() 是否可以在读锁内并发调用
+    using ConcurrentAccess = cache_policy_internal::HasConcurrentAccess<_Policy>;
+
+public: // 构造函数相关
+    //! \param capacity 缓存的总容量，平均分到各个分片
+    //! \param num_shards 分片个数，向上取整到 2 的指数次幂，0 表示硬件线程数的 4 倍（至少 16）
+    explicit
+    ShardedLruCache(size_t capacity, size_t num_shards = 0) : hasher_(), num_stripes_(1) {
+        if (0 == num_shards) {
+            num_shards = 4 * utils::ThreadPool::HardwareConcurrency();
+            if (num_shards < kMinShards)
+                num_shards = kMinShards;
+        }
+        num_shards_ = 1;
+        while (num_shards_ < num_shards)
+            num_shards_ *= 2;
+        shard_capacity_ = (capacity + num_shards_ - 1) / num_shards_;
+        if (0 == shard_capacity_)
+            shard_capacity_ = 1;
+        while (num_stripes_ < utils::ThreadPool::HardwareConcurrency() && num_stripes_ < kMaxStripes)
+            num_stripes_ *= 2;
+
+        // 多申请一个缓存行的内存，保证第一个分片按缓存行对齐（C++17 之前 new 不保证超过 16 字节的对齐）
+        // 读缓冲区紧跟在分片数组之后（sizeof(Shard) 是缓存行的整数倍，读缓冲区同样按缓存行对齐）
+        buffer_ = ::operator new(num_shards_ * (sizeof(Shard) + num_stripes_ * sizeof(ReadBuffer)) +
+                                 concurrent_hash_internal::kCacheLineSize);
+        uintptr_t address = reinterpret_cast<uintptr_t>(buffer_);
+        address = (address + concurrent_hash_internal::kCacheLineSize - 1) &
+                  ~static_cast<uintptr_t>(concurrent_hash_internal::kCacheLineSize - 1);
+        shards_ = reinterpret_cast<Shard*>(address);
+        ReadBuffer *buffers = reinterpret_cast<ReadBuffer*>(shards_ + num_shards_);
+        for (size_t i = 0; i < num_shards_ * num_stripes_; i++)
+            new (buffers + i) ReadBuffer();
+        size_t constructed = 0;
+        try {
+            for (; constructed < num_shards_; constructed++)
+                new (shards_ + constructed) Shard(shard_capacity_, buffers + constructed * num_stripes_);
+        } catch (...) {
+            DestroyShards(constructed);
+            throw;
+        }
+    }
+
+    ~ShardedLruCache() { DestroyShards(num_shards_); }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(ShardedLruCache);
+
+public: // 外部调用核心函数
+    //! \brief 查询映射值的拷贝，命中时记录到读缓冲区，之后批量提升为最近使用
+    //! \complexity O(1)，只加读锁
+    //! \return first:是否命中，second:映射值的拷贝
+    std::pair<bool, MappedType> Get(const KeyType &key) {
+        Shard &shard = ShardFor(key);
+        bool drain = false;
+        std::pair<bool, MappedType> result;
+        {
+            ReadGuard guard(shard.lock);
+            typename CacheType::Handle handle = shard.cache.Lookup(key);
+            if (CacheType::kNullHandle == handle)
+                return std::make_pair(false, MappedType());
+            result = std::make_pair(true, shard.cache.value(handle));
+            drain = RecordHit(shard, handle, ConcurrentAccess());
+        }
+        if (drain)
+            TryDrain(shard);
+        return result;
+    }
+
+    //! \brief 在读锁内访问映射值，function(const MappedType&)，不拷贝映射值，命中时记录一次命中
+    //! \return 是否命中
+    template <typename _Function>
+    bool Visit(const KeyType &key, _Function function) {
+        Shard &shard = ShardFor(key);
+        bool drain = false;
+        {
+            ReadGuard guard(shard.lock);
+            typename CacheType::Handle handle = shard.cache.Lookup(key);
+            if (CacheType::kNullHandle == handle)
+                return false;
+            function(static_cast<const MappedType&>(shard.cache.value(handle)));
+            drain = RecordHit(shard, handle, ConcurrentAccess());
+        }
+        if (drain)
+            TryDrain(shard);
+        return true;
+    }
+
+    //! \brief 是否存在键值 key，不记录命中
+    bool Contains(const KeyType &key) const {
+        const Shard &shard = ShardFor(key);
+        ReadGuard guard(shard.lock);
+        return CacheType::kNullHandle != shard.cache.Lookup(key);
+    }
+
+    //! \brief 插入或者替换映射值，数据成为分片内最近使用；分片满时淘汰分片内最久未使用的数据
+    //! \return 是否插入了新数据
+    bool Put(const KeyType &key, const MappedType &value) {
+        Shard &shard = ShardFor(key);
+        std::lock_guard<SharedSpinLock> guard(shard.lock);
+        Drain(shard);
+        return shard.cache.Put(key, value);
+    }
+
+    //! \brief 删除指定数据
+    //! \return 是否删除了数据
+    bool Erase(const KeyType &key) {
+        Shard &shard = ShardFor(key);
+        std::lock_guard<SharedSpinLock> guard(shard.lock);
+        Drain(shard);
+        return shard.cache.Erase(key);
+    }
+
+    //! \brief 删除所有数据，逐个分片加写锁
+    void Clear() {
+        for (size_t i = 0; i < num_shards_; i++) {
+            std::lock_guard<SharedSpinLock> guard(shards_[i].lock);
+            Drain(shards_[i]);
+            shards_[i].cache.Clear();
+        }
+    }
+
+    //! \brief 立即应用所有分片中记录的命中（测试或者需要确定的淘汰顺序时使用）
+    void FlushPromotions() {
+        for (size_t i = 0; i < num_shards_; i++) {
+            std::lock_guard<SharedSpinLock> guard(shards_[i].lock);
+            Drain(shards_[i]);
+        }
+    }
+
+    //! \brief 数据量：逐个分片加读锁求和，有并发修改时只是近似值
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < num_shards_; i++) {
+            ReadGuard guard(shards_[i].lock);
+            total += shards_[i].cache.size();
+        }
+        return total;
+    }
+
+    //! \brief 因为读缓冲区满而丢弃的命中个数（近似值）
+    size_t dropped_promotions() const {
+        size_t total = 0;
+        for (size_t i = 0; i < num_shards_; i++) {
+            for (size_t j = 0; j < num_stripes_; j++)
+                total += shards_[i].buffers[j].dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    bool   empty()       const { return 0 == size();                    }  // 是否为空
+    size_t capacity()    const { return shard_capacity_ * num_shards_;  }  // 总容量（分片容量之和）
+    size_t num_shards()  const { return num_shards_;                    }  // 分片个数
+    size_t num_stripes() const { return num_stripes_;                   }  // 每个分片的读缓冲区个数
+
+private: // 类型声明
+    static const size_t kMaxStripes  = 64;   // 每个分片最多的读缓冲区个数
+    static const size_t kBufferSlots = 14;   // 每个读缓冲区记录的命中个数，加上两个计数刚好一个缓存行
+
+    // 读缓冲区：count 为已经占用的位置，超过 kBufferSlots 时丢弃新的命中
+    struct alignas(concurrent_hash_internal::kCacheLineSize) ReadBuffer {
+        ReadBuffer() : count(0), dropped(0) {}
+
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> dropped;      // 丢弃的命中个数，与缓冲区在同一个缓存行，不与其他线程共享
+        std::atomic<uint32_t> handles[kBufferSlots];
+    };
+
+    // 一个分片：读写锁 + LruCache + 读缓冲区，按缓存行对齐
+    struct alignas(concurrent_hash_internal::kCacheLineSize) Shard {
+        Shard(size_t capacity, ReadBuffer *read_buffers) : cache(capacity), buffers(read_buffers) {}
+
+        mutable SharedSpinLock lock;
+        CacheType              cache;
+        ReadBuffer            *buffers;     // num_stripes_ 个读缓冲区，位于分片数组之后
+    };
+
+    // 读锁的 RAII 封装（std::shared_lock 需要 C++14）
+    class ReadGuard {
+    public:
+        explicit ReadGuard(SharedSpinLock &lock) : lock_(lock) { lock_.lock_shared(); }
+        ~ReadGuard() { lock_.unlock_shared(); }
+
+        GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(ReadGuard);
+
+    private:
+        SharedSpinLock &lock_;
+    };
+
+private: // helper functions
+    //! \brief 策略的 Access() 线程安全时（CLOCK），在读锁内直接通知策略，不需要批量提升
+    bool RecordHit(Shard &shard, typename CacheType::Handle handle, std::true_type) {
+        shard.cache.TouchShared(handle);
+        return false;
+    }
+
+    //! \brief 在读锁内把命中的句柄写入当前线程的读缓冲区
+    //! \return 缓冲区是否已满（需要尝试批量提升）
+    bool RecordHit(Shard &shard, typename CacheType::Handle handle, std::false_type) {
+        ReadBuffer &buffer = shard.buffers[sharded_lru_internal::ThreadStripe() & (num_stripes_ - 1)];
+        uint32_t position = buffer.count.load(std::memory_order_relaxed);
+        if (position < kBufferSlots) {
+            position = buffer.count.fetch_add(1, std::memory_order_relaxed);
+            if (position < kBufferSlots) {
+                buffer.handles[position].store(handle, std::memory_order_relaxed);
+                return position + 1 == kBufferSlots;
+            }
+        }
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //! \brief 尝试加写锁（不等待）批量提升，其他线程持有锁时直接返回，由之后的命中或者写操作处理
+    void TryDrain(Shard &shard) {
+        if (!shard.lock.try_lock())
+            return;
+        Drain(shard);
+        shard.lock.unlock();
+    }
+
+    //! \brief 在写锁内按照记录的顺序提升读缓冲区中的数据，然后清空缓冲区
+    //! \note 写锁与所有读锁互斥：读者在释放读锁之前已经写完句柄，这里读到的都是完整的记录
+    void Drain(Shard &shard) {
+        for (size_t i = 0; i < num_stripes_; i++) {
+            ReadBuffer &buffer = shard.buffers[i];
+            uint32_t count = buffer.count.load(std::memory_order_relaxed);
+            if (count > kBufferSlots)
+                count = kBufferSlots;
+            for (uint32_t j = 0; j < count; j++)
+                shard.cache.Touch(buffer.handles[j].load(std::memory_order_relaxed));
+            buffer.count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_t ShardIndex(const KeyType &key) const {
+        uint64_t hash = hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)));
+        return static_cast<size_t>(hash >> 32) & (num_shards_ - 1);
+    }
+
+    Shard&       ShardFor(const KeyType &key)       { return shards_[ShardIndex(key)]; }
+    const Shard& ShardFor(const KeyType &key) const { return shards_[ShardIndex(key)]; }
+
+    void DestroyShards(size_t count) {
+        for (size_t i = 0; i < count; i++)
+            shards_[i].~Shard();
+        ::operator delete(buffer_);
+    }
+
+private:
+    static const size_t kMinShards = 16; // 默认最少的分片个数
+
+    Hasher  hasher_;          // 选择分片用的哈希函数，分片内部的 LruCache 再单独计算一次
+    size_t  num_shards_;      // 分片个数，2 的指数次幂
+    size_t  shard_capacity_;  // 每个分片的容量
+    size_t  num_stripes_;     // 每个分片的读缓冲区个数，2 的指数次幂
+    Shard  *shards_;          // 按缓存行对齐的分片数组，位于 buffer_ 中
+    void   *buffer_;          // 分片数组所在的原始内存
+
+}; // class ShardedLruCache
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual, typename _Policy>
+const size_t ShardedLruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::kMaxStripes;
+
+template <typename _Key, typename _Value, typename _Hash, typename _KeyEqual, typename _Policy>
+const size_t ShardedLruCache<_Key, _Value, _Hash, _KeyEqual, _Policy>::kBufferSlots;
+
+} // namespace glib
+
+#endif // GLIB_SHARDED_LRU_CACHE_HPP_
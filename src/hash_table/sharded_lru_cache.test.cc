@@ -0,0 +1,105 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: sharded_lru_cache.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/23
+ * Description: test sharded lru cache with buffered promotion
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./sharded_lru_cache.hpp"
+#include "../internal/test_util.h"
+#include <cstdint>
+#include <algorithm> // std::min
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+using glib::test_internal::RunThreads;
+
+//! \brief 分片 LRU 缓存测试：单分片的淘汰顺序（命中延迟提升）、多线程读写一致、容量上限、热点数据不被淘汰
+//! \run
+//!     g++ sharded_lru_cache.test.cc -std=c++11 -O2 -pthread && ./a.out
+int main(int argc, char const *argv[]) {
+    const size_t kThreads = 8;
+    bool all_ok = true;
+
+    // 1）单分片：命中先记录在读缓冲区，写操作之前会先提升，淘汰顺序与严格 LRU 相同
+    cout << "单分片淘汰顺序" << endl;
+    glib::ShardedLruCache<string, int> single(3, 1);
+    single.Put("a", 1);
+    single.Put("b", 2);
+    single.Put("c", 3);
+    const size_t stripes = single.num_stripes();   // 硬件线程数向上取整到 2 的指数次幂，最多 64
+    bool order_ok = 1 == single.num_shards() && 3 == single.capacity() && 0 == (stripes & (stripes - 1)) &&
+                    stripes >= min<size_t>(thread::hardware_concurrency(), 64) && 1 == single.Get("a").second;
+    single.Put("d", 4);                     // 先提升 a，再淘汰最久未使用的 b
+    order_ok = order_ok && !single.Contains("b") && single.Contains("a") && 3 == single.size();
+    order_ok = order_ok && single.Visit("c", [](const int &value) { cout << " c -> " << value << endl; });
+    single.FlushPromotions();
+    single.Put("e", 5);                     // 使用顺序 c d a，淘汰 a
+    order_ok = order_ok && !single.Contains("a") && single.Contains("c") && !single.Get("x").first &&
+               single.Erase("c") && !single.Erase("c") && 2 == single.size();
+    single.Clear();
+    order_ok = order_ok && single.empty();
+    cout << (order_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && order_ok;
+
+    // 2）读写混合：映射值总是键值的 3 倍，读线程读到的值必须一致；缓存容量小，一直在淘汰
+    cout << "多线程读写" << endl;
+    glib::ShardedLruCache<uint64_t, uint64_t> mixed(512, 8);
+    atomic<size_t> bad_reads(0), hits(0);
+    RunThreads(kThreads, [&](size_t index) {
+        mt19937_64 engine(index);
+        for (size_t i = 0; i < 200000; i++) {
+            uint64_t key = engine() % 4096;
+            if (index < 2) {
+                if (engine() % 8)
+                    mixed.Put(key, key * 3);
+                else
+                    mixed.Erase(key);
+            } else {
+                auto result = mixed.Get(key);
+                if (result.first) {
+                    hits++;
+                    if (key * 3 != result.second)
+                        bad_reads++;
+                }
+            }
+        }
+    });
+    bool mixed_ok = 0 == bad_reads && hits > 0 && mixed.size() <= mixed.capacity();
+    cout << " hits " << hits << ", dropped promotions " << mixed.dropped_promotions()
+         << (mixed_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && mixed_ok;
+
+    // 3）热点数据：所有线程反复读 100 个热点键值，同时不断插入只用一次的冷数据，
+    //    延迟提升仍然让热点数据留在缓存中
+    cout << "热点数据" << endl;
+    glib::ShardedLruCache<uint64_t, uint64_t> hot(2000, 16);
+    const uint64_t kHotKeys = 100;
+    for (uint64_t key = 0; key < kHotKeys; key++)
+        hot.Put(key, key);
+    RunThreads(kThreads, [&](size_t index) {
+        for (uint64_t i = 0; i < 100000; i++) {
+            uint64_t key = i % kHotKeys;
+            if (!hot.Get(key).first)
+                hot.Put(key, key);
+            if (0 == i % 4)
+                hot.Put(kHotKeys + index * 1000000 + i, i);     // 冷数据
+        }
+    });
+    size_t hot_present = 0;
+    for (uint64_t key = 0; key < kHotKeys; key++)
+        hot_present += hot.Contains(key) ? 1 : 0;
+    bool hot_ok = hot_present >= kHotKeys * 9 / 10 && hot.size() <= hot.capacity();
+    cout << " hot keys present " << hot_present << "/" << kHotKeys << (hot_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && hot_ok;
+
+    return all_ok ? 0 : 1;
+}
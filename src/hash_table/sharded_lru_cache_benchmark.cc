@@ -0,0 +1,159 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: sharded_lru_cache_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/23
+ * Description: multi-threaded throughput and hit rate of sharded lru cache vs mutex + LruCache
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "sharded_lru_cache.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm> // std::lower_bound
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! \brief 分片 LRU 缓存吞吐量、命中率测试：线程数从 1 到 64，键值服从 Zipf 分布（s = 0.99），
+//!        缓存容量为键值范围的 10%，未命中时插入（cache-aside），与「一个 std::mutex + LruCache」对比。
+//!        两者命中率应该接近：延迟提升、丢弃少量命中不会明显影响命中率
+//! \run
+//!     g++ sharded_lru_cache_benchmark.cc -std=c++11 -O2 -pthread && ./a.out [每个配置的总操作数]
+
+namespace {
+
+const uint64_t kKeyRange = 1 << 20;             // 键值范围
+const size_t   kCapacity = kKeyRange / 10;      // 缓存容量
+
+// 所有请求都经过一把互斥锁，作为对比的基准，命中时立即提升
+class MutexLruCache {
+public:
+    explicit MutexLruCache(size_t capacity) : cache_(capacity) {}
+
+    pair<bool, uint64_t> Get(uint64_t key) {
+        lock_guard<mutex> guard(mutex_);
+        const uint64_t *value = cache_.Get(key);
+        return make_pair(nullptr != value, nullptr != value ? *value : 0);
+    }
+    void Put(uint64_t key, uint64_t value) {
+        lock_guard<mutex> guard(mutex_);
+        cache_.Put(key, value);
+    }
+
+private:
+    mutex                               mutex_;
+    glib::LruCache<uint64_t, uint64_t>  cache_;
+};
+
+// 每个线程独立的随机数发生器（xorshift64*）
+struct FastRandom {
+    explicit FastRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t operator()() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+    uint64_t state;
+};
+
+//! \brief Zipf 分布的累积分布函数，排名 i 的概率正比于 1 / (i + 1)^s
+vector<double> ZipfCdf(uint64_t n, double s) {
+    vector<double> cdf(n);
+    double sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sum += 1.0 / pow(static_cast<double>(i + 1), s);
+        cdf[i] = sum;
+    }
+    for (auto &value: cdf)
+        value /= sum;
+    return cdf;
+}
+
+//! \brief 按照 Zipf 分布生成 count 个键值，排名打散到整个键值范围，热点不集中在相邻的键值上
+vector<uint64_t> ZipfKeys(const vector<double> &cdf, size_t count, uint64_t seed) {
+    FastRandom random(seed);
+    vector<uint64_t> keys(count);
+    for (auto &key: keys) {
+        double u = static_cast<double>(random() >> 11) / static_cast<double>(uint64_t(1) << 53);
+        uint64_t rank = static_cast<uint64_t>(lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        key = (rank * 0x9E3779B97F4A7C15ull) >> 12;
+    }
+    return keys;
+}
+
+//! \brief num_threads 个线程同时回放各自的访问序列，未命中时插入
+//! \return first:吞吐量（百万次操作/秒），second:命中率
+template <typename _Cache>
+pair<double, double> Run(_Cache &cache, const vector<vector<uint64_t> > &streams, size_t num_threads) {
+    atomic<size_t> ready(0), hits(0);
+    atomic<bool>   start(false);
+    vector<thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            const vector<uint64_t> &keys = streams[t];
+            size_t local_hits = 0;
+            ready++;
+            while (!start.load(memory_order_acquire))
+                this_thread::yield();
+            for (uint64_t key: keys) {
+                if (cache.Get(key).first)
+                    local_hits++;
+                else
+                    cache.Put(key, key);
+            }
+            hits += local_hits;
+        });
+    }
+    while (ready.load() < num_threads)
+        this_thread::yield();
+    TicToc timer;
+    start.store(true, memory_order_release);
+    for (auto &t: threads)
+        t.join();
+    double elapsed = timer.toc();
+    size_t total = streams[0].size() * num_threads;
+    return make_pair(static_cast<double>(total) / elapsed / 1000.0, static_cast<double>(hits) / total);
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    size_t total_ops = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 8000000;
+    vector<double> cdf = ZipfCdf(kKeyRange, 0.99);
+
+    cout << "operations = " << total_ops << ", keys = " << kKeyRange << ", capacity = " << kCapacity
+         << ", hardware threads = " << glib::utils::ThreadPool::HardwareConcurrency() << endl;
+    cout << fixed << setprecision(2);
+    cout << setw(8) << "threads" << setw(16) << "mutex Mops/s" << setw(10) << "hit%"
+         << setw(18) << "sharded Mops/s" << setw(10) << "hit%" << setw(10) << "speedup" << endl;
+    for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+        vector<vector<uint64_t> > streams;
+        for (size_t t = 0; t < num_threads; t++)
+            streams.push_back(ZipfKeys(cdf, total_ops / num_threads, t + 1));
+        pair<double, double> mutex_result, sharded_result;
+        {
+            MutexLruCache cache(kCapacity);
+            mutex_result = Run(cache, streams, num_threads);
+        }
+        {
+            glib::ShardedLruCache<uint64_t, uint64_t> cache(kCapacity);
+            sharded_result = Run(cache, streams, num_threads);
+        }
+        cout << setw(8) << num_threads
+             << setw(16) << mutex_result.first << setw(10) << mutex_result.second * 100
+             << setw(18) << sharded_result.first << setw(10) << sharded_result.second * 100
+             << setw(10) << sharded_result.first / mutex_result.first << endl;
+    }
+    return 0;
+}
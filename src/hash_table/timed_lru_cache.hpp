@@ -0,0 +1,622 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: timed_lru_cache.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: lru cache with weighted capacity and per-entry ttl expired by a hierarchical timing wheel
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_TIMED_LRU_CACHE_HPP_
+#define GLIB_TIMED_LRU_CACHE_HPP_
+#include <cstdint>     // uint16_t uint32_t uint64_t
+#include <iostream>
+#include <functional>  // std::hash std::equal_to
+#include <memory>      // std::allocator
+#include <new>         // placement new
+#include <stdexcept>   // std::length_error std::invalid_argument
+#include <type_traits> // std::aligned_storage
+#include <utility>     // std::pair std::move std::forward
+#include <vector>
+#include "lru_cache.hpp" // CacheStats、hash::FibonacciMix
+
+//! \brief 按权重（比如字节数）限制容量、每个数据可以设置过期时间的 LRU 缓存，过期由分层时间轮驱动
+//!     外部调用核心函数：
+//!         1）查询并提升为最近使用：Get()，只查询不提升：Peek()、Contains()
+//!         2）插入或者替换：Put(key, value, ttl)，ttl 为从当前时间开始的存活时长（0 表示不过期）；
+//!            总权重超过上限时淘汰最久未使用的数据
+//!         3）删除一个数据：Erase()，清空：Clear()
+//!         4）推进时间并删除所有过期的数据：ExpireUpTo(now)
+//!         5）调整权重上限：set_max_weight()
+//!         6）从最近使用到最久未使用遍历：ForEach()
+//!     外部调用状态函数：
+//!         1）缓存状态：size()、empty()、weight()、max_weight()、now()、expire_time()
+//!         2）命中、未命中、淘汰、过期次数：stats()、ResetStats()
+//!
+//! \Note
+//!     1）LruHash、LruCache 只按数据个数限制容量，数据也不会过期。这里每个数据的权重由 _Weigher 计算
+//!        （weigher(key, value) 返回 uint64_t，默认每个数据权重为 1），总权重不超过 max_weight；
+//!        单个数据的权重超过 max_weight 时不缓存（同一个键值的旧数据也会被删除）
+//!     2）时间由调用者提供：一个单调不减的整数时钟（比如毫秒），缓存只在 ExpireUpTo(now) 中推进当前时间，
+//!        Put() 的过期时间为 now() + ttl。ExpireUpTo() 返回之后没有过期的数据留在缓存中，
+//!        所以 Get() 不需要检查过期时间，测试中可以精确控制时间
+//!     3）TimingWheel：6 层、每层 64 个槽（覆盖 2^36 个时间单位，更远的数据放在溢出链表中）。
+//!        数据放在过期时间与当前时间第一个不同的 6 位所在的层、过期时间在这一层的槽中；
+//!        时间推进时只取出「被经过」的槽（每层一个 64 位占用位图），到期的删除，没到期的重新放入更低的层。
+//!        每个数据最多下降 7 次，所以过期 n 个数据是 O(n) 的，推进时间本身是 O(层数)，从不扫描 LRU 链表
+//!     4）节点数组、LRU 双链表、哈希拉链与 LruCache 相同，都用 32 位下标；
+//!        时间轮的链接、过期时间放在 TimingWheel 自己的数组中（Entry 对齐到 8 字节后每个数据 24 字节，
+//!        不过期的数据也占用，memory_usage() 中计入）
+//!     5）单线程使用
+//!
+//! \complexity
+//!     Get()/Peek()/Put()/Erase() 平均 O(1)；ExpireUpTo() 均摊 O(过期的数据个数 + 层数)
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!     1）Varghese, Lauck, Hashed and hierarchical timing wheels, SOSP 1987
+//!     2）William Ahern, timeout.c（用占用位图找出被经过的槽）
+//!
+//! example
+//!     struct BlobWeigher {
+//!         uint64_t operator()(const std::string &key, const std::string &blob) const { return key.size() + blob.size(); }
+//!     };
+//!     glib::TimedLruCache<std::string, std::string, BlobWeigher> blobs(64 << 20);   // 64MB
+//!     blobs.ExpireUpTo(NowMs());
+//!     blobs.Put(url, body, 30 * 1000);                                              // 30 秒后过期
+
+namespace glib {
+
+//! \brief 默认的权重：每个数据为 1，此时 max_weight 就是数据个数
+struct UnitWeigher {
+    template <typename _Key, typename _Value>
+    uint64_t operator()(const _Key&, const _Value&) const { return 1; }
+};
+
+//! \brief 分层时间轮：为下标 [0, n) 的对象安排过期时间，Advance() 推进时间并回调到期的对象
+class TimingWheel {
+public:
+    using Index = uint32_t;
+    static constexpr Index kNil = static_cast<Index>(-1);
+
+    explicit TimingWheel(uint64_t now = 0) : now_(0) { Reset(now); }
+
+    //! \brief 删除所有安排，时间设置为 now
+    void Reset(uint64_t now) {
+        for (auto &head: heads_)
+            head = kNil;
+        for (auto &bits: occupied_)
+            bits = 0;
+        for (auto &entry: entries_)
+            entry.slot = kNoSlot;
+        now_ = now;
+    }
+
+    //! \brief 对象个数变化，调用前后下标不变的对象保持原来的安排
+    void Resize(size_t count) { entries_.resize(count, Entry{kNil, kNil, 0, kNoSlot}); }
+
+    //! \brief 安排 index 在 expire_time 过期（已经安排过时先取消），expire_time 不大于当前时间时按照下一个时间单位处理
+    //! \complexity O(1)
+    void Schedule(Index index, uint64_t expire_time) {
+        Cancel(index);
+        entries_[index].expire_time = expire_time > now_ ? expire_time : now_ + 1;
+        Link(index, SlotOf(entries_[index].expire_time));
+    }
+
+    //! \brief 取消安排，没有安排时什么也不做
+    //! \complexity O(1)
+    void Cancel(Index index) {
+        if (kNoSlot != entries_[index].slot)
+            Unlink(index);
+    }
+
+    //! \brief 时间推进到 now（不大于当前时间时什么也不做），过期时间不大于 now 的对象取消安排之后回调 on_expire(index)
+    //! \note on_expire 中可以取消、安排其他对象
+    //! \complexity O(层数 + 被经过的槽中的对象个数)，每个对象最多被经过 kLevels + 1 次
+    //! \return 过期的对象个数
+    template <typename _Function>
+    size_t Advance(uint64_t now, _Function on_expire) {
+        if (now <= now_)
+            return 0;
+        for (size_t level = 0; level < kLevels; level++) {
+            const size_t shift = level * kSlotBits;
+            uint64_t passed;
+            if ((now_ >> (shift + kSlotBits)) != (now >> (shift + kSlotBits))) {
+                passed = ~uint64_t(0);                           // 更高的层变化了，这一层所有槽都被经过
+            } else {
+                passed = UpTo((now >> shift) & kSlotMask) & ~UpTo((now_ >> shift) & kSlotMask);
+            }
+            passed &= occupied_[level];
+            while (0 != passed) {
+                size_t slot = static_cast<size_t>(__builtin_ctzll(passed));
+                passed &= passed - 1;
+                MoveAll(level * kSlots + slot, kPendingSlot);
+            }
+        }
+        if ((now_ >> (kLevels * kSlotBits)) != (now >> (kLevels * kSlotBits)))
+            MoveAll(kOverflowSlot, kPendingSlot);
+        now_ = now;
+
+        size_t expired = 0;
+        while (kNil != heads_[kPendingSlot]) {
+            Index index = heads_[kPendingSlot];
+            Unlink(index);
+            if (entries_[index].expire_time <= now_) {
+                expired++;
+                on_expire(index);
+            } else {
+                Link(index, SlotOf(entries_[index].expire_time));
+            }
+        }
+        return expired;
+    }
+
+    bool     scheduled(Index index)   const { return kNoSlot != entries_[index].slot; } // 是否安排了过期时间
+    uint64_t expire_time(Index index) const { return entries_[index].expire_time;      } // 安排的过期时间
+    uint64_t now()                    const { return now_;                             } // 当前时间
+    // 每个对象的链接、过期时间占用的字节数
+    size_t   memory_usage()           const { return entries_.capacity() * sizeof(Entry); }
+
+private:
+    static const size_t   kSlotBits     = 6;
+    static const size_t   kSlots        = size_t(1) << kSlotBits;     // 每层的槽数
+    static const uint64_t kSlotMask     = kSlots - 1;
+    static const size_t   kLevels       = 6;
+    static const uint16_t kOverflowSlot = kLevels * kSlots;           // 超过最高层范围的对象
+    static const uint16_t kPendingSlot  = kOverflowSlot + 1;          // Advance() 中待处理的对象
+    static const uint16_t kNoSlot       = 0xFFFF;
+
+    struct Entry {
+        Index    prev;
+        Index    next;
+        uint64_t expire_time;
+        uint16_t slot;         // 所在的链表，kNoSlot 表示没有安排
+    };
+
+    // 第 0 ~ digit 位为 1
+    static uint64_t UpTo(uint64_t digit) {
+        return digit >= 63 ? ~uint64_t(0) : (uint64_t(1) << (digit + 1)) - 1;
+    }
+
+    // 过期时间所在的槽：与当前时间第一个不同的 6 位所在的层
+    uint16_t SlotOf(uint64_t expire_time) const {
+        uint64_t diff = expire_time ^ now_;
+        size_t level = (63 - static_cast<size_t>(__builtin_clzll(diff))) / kSlotBits;
+        if (level >= kLevels)
+            return kOverflowSlot;
+        return static_cast<uint16_t>(level * kSlots + ((expire_time >> (level * kSlotBits)) & kSlotMask));
+    }
+
+    void Link(Index index, uint16_t slot) {
+        Entry &entry = entries_[index];
+        entry.slot = slot;
+        entry.prev = kNil;
+        entry.next = heads_[slot];
+        if (kNil != heads_[slot])
+            entries_[heads_[slot]].prev = index;
+        heads_[slot] = index;
+        if (slot < kOverflowSlot)
+            occupied_[slot / kSlots] |= uint64_t(1) << (slot % kSlots);
+    }
+
+    void Unlink(Index index) {
+        Entry &entry = entries_[index];
+        if (kNil != entry.prev)
+            entries_[entry.prev].next = entry.next;
+        else
+            heads_[entry.slot] = entry.next;
+        if (kNil != entry.next)
+            entries_[entry.next].prev = entry.prev;
+        if (kNil == heads_[entry.slot] && entry.slot < kOverflowSlot)
+            occupied_[entry.slot / kSlots] &= ~(uint64_t(1) << (entry.slot % kSlots));
+        entry.slot = kNoSlot;
+    }
+
+    // 把一个槽的链表整体接到另一个链表头
+    void MoveAll(uint16_t from, uint16_t to) {
+        Index index = heads_[from];
+        if (kNil == index)
+            return;
+        Index last = index;
+        for (; ; last = entries_[last].next) {
+            entries_[last].slot = to;
+            if (kNil == entries_[last].next)
+                break;
+        }
+        entries_[last].next = heads_[to];
+        if (kNil != heads_[to])
+            entries_[heads_[to]].prev = last;
+        heads_[to] = index;
+        heads_[from] = kNil;
+        if (from < kOverflowSlot)
+            occupied_[from / kSlots] &= ~(uint64_t(1) << (from % kSlots));
+    }
+
+    Index              heads_[kPendingSlot + 1];   // 每个槽、溢出链表、待处理链表的头
+    uint64_t           occupied_[kLevels];         // 每层非空的槽
+    std::vector<Entry> entries_;
+    uint64_t           now_;                       // 当前时间
+};
+
+//! \brief 带过期、淘汰、命中次数的统计
+struct TimedCacheStats : CacheStats {
+    size_t expirations = 0;     // 过期删除的数据个数
+};
+
+template <typename _Key, typename _Value, typename _Weigher = UnitWeigher,
+          typename _Hash = std::hash<_Key>, typename _KeyEqual = std::equal_to<_Key> >
+class TimedLruCache {
+public: // 类型声明
+    using KeyType    = _Key;
+    using MappedType = _Value;
+    using Weigher    = _Weigher;
+    using Hasher     = _Hash;
+    using KeyEqual   = _KeyEqual;
+
+    // 节点中存储的数据
+    struct HashData {
+        KeyType key;        // 键值
+        MappedType value;   // 映射值
+    };
+
+    static constexpr uint64_t kNoExpiry = 0;   // Put() 的 ttl 为 0 时不过期
+
+private:
+    using Index = uint32_t;
+
+    // 节点：数据只在使用中的节点里构造
+    struct Node {
+        typename std::aligned_storage<sizeof(HashData), alignof(HashData)>::type storage;
+        uint64_t weight;    // 数据的权重
+        Index prev;         // 双链表中更近使用的节点
+        Index next;         // 双链表中更久未使用的节点；空闲节点的下一个空闲节点
+        Index chain;        // 哈希拉链中的下一个节点
+
+        HashData& data() { return *reinterpret_cast<HashData*>(&storage); }
+        const HashData& data() const { return *reinterpret_cast<const HashData*>(&storage); }
+    };
+
+    using Allocator = std::allocator<Node>;
+
+public: // 构造函数相关
+    //! \param max_weight 总权重上限，至少为 1
+    //! \param now 初始时间
+    explicit
+    TimedLruCache(uint64_t max_weight, uint64_t now = 0, const Weigher &weigher = Weigher(),
+                  const Hasher &hasher = Hasher(), const KeyEqual &key_equal = KeyEqual())
+        : weigher_(weigher), hasher_(hasher), key_equal_(key_equal), nodes_(nullptr), node_count_(0),
+          used_nodes_(0), buckets_(nullptr), bucket_mask_(0), head_(kNil), tail_(kNil), free_(kNil),
+          current_size_(0), weight_(0), max_weight_(CheckWeight(max_weight)), wheel_(now) {
+        Reallocate(kInitialNodes);
+    }
+
+    ~TimedLruCache() {
+        Clear();
+        Allocator().deallocate(nodes_, node_count_);
+        delete[] buckets_;
+    }
+
+    TimedLruCache(const TimedLruCache &other) = delete;
+    TimedLruCache(TimedLruCache &&other) = delete;
+    TimedLruCache& operator=(const TimedLruCache &other) = delete;
+    TimedLruCache& operator=(TimedLruCache &&other) = delete;
+
+public: // 外部调用核心函数
+    //! \brief 查询映射值，并把数据提升为最近使用
+    //! \complexity 平均 O(1)
+    //! \return 映射值的地址，没有找到返回 nullptr。插入、删除、淘汰、ExpireUpTo() 之后可能失效
+    MappedType* Get(const KeyType &key) {
+        Index index = FindIndex(key);
+        if (kNil == index) {
+            stats_.misses++;
+            return nullptr;
+        }
+        stats_.hits++;
+        MoveToFront(index);
+        return &nodes_[index].data().value;
+    }
+
+    //! \brief 只查询映射值，不改变使用顺序
+    const MappedType* Peek(const KeyType &key) const {
+        Index index = FindIndex(key);
+        return kNil != index ? &nodes_[index].data().value : nullptr;
+    }
+
+    bool Contains(const KeyType &key) const { return kNil != FindIndex(key); }
+
+    //! \brief 插入或者替换数据，数据成为最近使用，过期时间为 now() + ttl（ttl 为 kNoExpiry 时不过期）；
+    //!        总权重超过上限时从最久未使用的数据开始淘汰
+    //! \complexity 平均 O(1)，加上淘汰的数据个数
+    //! \return 数据是否被缓存（权重超过 max_weight 时返回 false，并删除同一个键值的旧数据）
+    template <typename _KeyArg, typename _MappedArg>
+    bool Put(_KeyArg &&key, _MappedArg &&value, uint64_t ttl = kNoExpiry) {
+        uint64_t weight = weigher_(static_cast<const KeyType&>(key), static_cast<const MappedType&>(value));
+        Index index = FindIndex(key);
+        if (weight > max_weight_) {
+            if (kNil != index)
+                Remove(index);
+            return false;
+        }
+        if (kNil != index) {
+            nodes_[index].data().value = std::forward<_MappedArg>(value);
+            weight_ = weight_ - nodes_[index].weight + weight;
+            nodes_[index].weight = weight;
+            MoveToFront(index);
+        } else {
+            index = InsertNew(std::forward<_KeyArg>(key), std::forward<_MappedArg>(value), weight);
+        }
+        if (kNoExpiry != ttl)
+            wheel_.Schedule(index, ttl < ~uint64_t(0) - wheel_.now() ? wheel_.now() + ttl : ~uint64_t(0));
+        else
+            wheel_.Cancel(index);
+        EvictOverweight();
+        return true;
+    }
+
+    //! \brief 删除指定数据
+    //! \return 是否删除了数据
+    bool Erase(const KeyType &key) {
+        Index index = FindIndex(key);
+        if (kNil == index)
+            return false;
+        Remove(index);
+        return true;
+    }
+
+    //! \brief 删除所有数据，保留节点数组，当前时间不变
+    void Clear() {
+        for (Index index = head_; kNil != index; index = nodes_[index].next)
+            nodes_[index].data().~HashData();
+        for (size_t i = 0; i <= bucket_mask_; i++)
+            buckets_[i] = kNil;
+        wheel_.Reset(wheel_.now());
+        head_ = tail_ = free_ = kNil;
+        used_nodes_   = 0;
+        current_size_ = 0;
+        weight_       = 0;
+    }
+
+    //! \brief 当前时间推进到 now，删除所有过期时间不大于 now 的数据；now 不大于当前时间时什么也不做
+    //! \complexity 均摊 O(过期的数据个数 + 时间轮层数)
+    //! \return 删除的数据个数
+    size_t ExpireUpTo(uint64_t now) {
+        size_t expired = wheel_.Advance(now, [this](Index index) { Remove(index); });
+        stats_.expirations += expired;
+        return expired;
+    }
+
+    //! \brief 调整总权重上限，超过时淘汰最久未使用的数据
+    void set_max_weight(uint64_t max_weight) {
+        max_weight_ = CheckWeight(max_weight);
+        EvictOverweight();
+    }
+
+    //! \brief 从最近使用到最久未使用遍历，function(const KeyType&, MappedType&)
+    template <typename _Function>
+    void ForEach(_Function function) {
+        for (Index index = head_; kNil != index; index = nodes_[index].next)
+            function(static_cast<const KeyType&>(nodes_[index].data().key), nodes_[index].data().value);
+    }
+
+    //! \brief 数据的过期时间，不存在或者不过期时返回 kNoExpiry
+    uint64_t expire_time(const KeyType &key) const {
+        Index index = FindIndex(key);
+        return kNil != index && wheel_.scheduled(index) ? wheel_.expire_time(index) : kNoExpiry;
+    }
+
+    size_t   size()       const { return current_size_;      } // 当前数据量
+    bool     empty()      const { return 0 == current_size_; } // 是否为空
+    uint64_t weight()     const { return weight_;            } // 当前总权重
+    uint64_t max_weight() const { return max_weight_;        } // 总权重上限
+    uint64_t now()        const { return wheel_.now();       } // 当前时间
+    // 节点数组、桶数组、时间轮占用的字节数（不包括键值、映射值自己在堆上分配的内存）
+    size_t memory_usage() const {
+        return node_count_ * sizeof(Node) + (bucket_mask_ + 1) * sizeof(Index) + wheel_.memory_usage();
+    }
+
+    const TimedCacheStats& stats() const { return stats_;             } // 命中、未命中、淘汰、过期次数
+    void              ResetStats()       { stats_ = TimedCacheStats(); }
+
+private: // helper functions
+    static uint64_t CheckWeight(uint64_t max_weight) {
+        if (0 == max_weight)
+            throw std::invalid_argument("TimedLruCache: max_weight must be at least 1");
+        return max_weight;
+    }
+
+    size_t BucketIndex(const KeyType &key) const {
+        return static_cast<size_t>(hash::FibonacciMix(static_cast<uint64_t>(hasher_(key)))) & bucket_mask_;
+    }
+
+    Index FindIndex(const KeyType &key) const {
+        for (Index index = buckets_[BucketIndex(key)]; kNil != index; index = nodes_[index].chain) {
+            if (key_equal_(nodes_[index].data().key, key))
+                return index;
+        }
+        return kNil;
+    }
+
+    // 总权重超过上限时淘汰链表尾部；新数据的权重不超过上限，所以不会淘汰到它自己
+    void EvictOverweight() {
+        while (weight_ > max_weight_) {
+            Remove(tail_);
+            stats_.evictions++;
+        }
+    }
+
+    //! \note 节点数组需要加倍时，参数可能引用数组中的数据（比如 Put(key, *Peek(other))），
+    //!       重新分配会移动、析构它们，所以先在栈上构造好新数据，再取得节点
+    template <typename _KeyArg, typename _MappedArg>
+    Index InsertNew(_KeyArg &&key, _MappedArg &&value, uint64_t weight) {
+        if (kNil == free_ && used_nodes_ == node_count_) {
+            HashData data{KeyType(std::forward<_KeyArg>(key)), MappedType(std::forward<_MappedArg>(value))};
+            return InsertData(std::move(data), weight);
+        }
+        Index index = AcquireNode();
+        try {
+            new (&nodes_[index].storage) HashData{KeyType(std::forward<_KeyArg>(key)),
+                                                  MappedType(std::forward<_MappedArg>(value))};
+        } catch (...) {
+            nodes_[index].next = free_;
+            free_ = index;
+            throw;
+        }
+        return LinkNew(index, weight);
+    }
+
+    // 插入已经构造好的数据（节点数组可能重新分配）
+    Index InsertData(HashData &&data, uint64_t weight) {
+        Index index = AcquireNode();
+        try {
+            new (&nodes_[index].storage) HashData(std::move(data));
+        } catch (...) {
+            nodes_[index].next = free_;
+            free_ = index;
+            throw;
+        }
+        return LinkNew(index, weight);
+    }
+
+    // 新数据放入拉链、链表头
+    Index LinkNew(Index index, uint64_t weight) {
+        size_t bucket = BucketIndex(nodes_[index].data().key);
+        nodes_[index].chain  = buckets_[bucket];
+        nodes_[index].weight = weight;
+        buckets_[bucket] = index;
+        PushFront(index);
+        current_size_++;
+        weight_ += weight;
+        return index;
+    }
+
+    // 取得一个未使用的节点：先用空闲链表，再用数组中从未用过的节点，都没有时节点数组加倍
+    Index AcquireNode() {
+        if (kNil != free_) {
+            Index index = free_;
+            free_ = nodes_[index].next;
+            return index;
+        }
+        if (used_nodes_ == node_count_) {
+            if (node_count_ * 2 >= kNil)
+                throw std::length_error("TimedLruCache: too many entries for 32-bit node index");
+            Reallocate(node_count_ * 2);
+        }
+        return static_cast<Index>(used_nodes_++);
+    }
+
+    //! \brief 删除节点上的数据：从拉链、双链表、时间轮中摘下，析构数据，节点放入空闲链表
+    void Remove(Index index) {
+        Index *link = &buckets_[BucketIndex(nodes_[index].data().key)];
+        while (*link != index)
+            link = &nodes_[*link].chain;
+        *link = nodes_[index].chain;
+        Unlink(index);
+        wheel_.Cancel(index);
+        weight_ -= nodes_[index].weight;
+        nodes_[index].data().~HashData();
+        nodes_[index].next = free_;
+        free_ = index;
+        current_size_--;
+    }
+
+    void MoveToFront(Index index) {
+        if (head_ == index)
+            return;
+        Unlink(index);
+        PushFront(index);
+    }
+
+    void PushFront(Index index) {
+        nodes_[index].prev = kNil;
+        nodes_[index].next = head_;
+        if (kNil != head_)
+            nodes_[head_].prev = index;
+        else
+            tail_ = index;
+        head_ = index;
+    }
+
+    void Unlink(Index index) {
+        const Index prev = nodes_[index].prev, next = nodes_[index].next;
+        if (kNil != prev)
+            nodes_[prev].next = next;
+        else
+            head_ = next;
+        if (kNil != next)
+            nodes_[next].prev = prev;
+        else
+            tail_ = prev;
+    }
+
+    //! \brief 节点数组增长到 node_count，数据、链接的下标不变（时间轮按照下标记录），重建桶数组
+    //! \complexity O(used_nodes + bucket_count)
+    void Reallocate(size_t node_count) {
+        Node *nodes = Allocator().allocate(node_count);
+        for (size_t i = 0; i < used_nodes_; i++) {
+            nodes[i].weight = nodes_[i].weight;
+            nodes[i].prev   = nodes_[i].prev;
+            nodes[i].next   = nodes_[i].next;
+        }
+        for (Index index = head_; kNil != index; index = nodes_[index].next) {
+            new (&nodes[index].storage) HashData(std::move(nodes_[index].data()));
+            nodes_[index].data().~HashData();
+        }
+        if (nullptr != nodes_)
+            Allocator().deallocate(nodes_, node_count_);
+        nodes_      = nodes;
+        node_count_ = node_count;
+        wheel_.Resize(node_count);
+
+        size_t bucket_count = node_count;    // 节点数总是 2 的幂
+        if (nullptr != buckets_)
+            delete[] buckets_;
+        buckets_     = new Index[bucket_count];
+        bucket_mask_ = bucket_count - 1;
+        for (size_t i = 0; i < bucket_count; i++)
+            buckets_[i] = kNil;
+        for (Index index = head_; kNil != index; index = nodes_[index].next) {
+            size_t bucket = BucketIndex(nodes_[index].data().key);
+            nodes_[index].chain = buckets_[bucket];
+            buckets_[bucket] = index;
+        }
+    }
+
+private:
+    static constexpr Index  kNil          = static_cast<Index>(-1); // 空下标
+    static constexpr size_t kInitialNodes = 16;                     // 节点数组的初始大小
+    Weigher         weigher_;        // 权重函数
+    Hasher          hasher_;         // 哈希函数
+    KeyEqual        key_equal_;      // 键值比较函数
+    Node           *nodes_;          // 节点数组
+    size_t          node_count_;     // 节点数组大小
+    size_t          used_nodes_;     // 数组中用过的节点个数，之后的节点从未使用
+    Index          *buckets_;        // 桶数组，保存拉链头节点的下标
+    size_t          bucket_mask_;    // 桶的个数 - 1
+    Index           head_;           // 最近使用的节点
+    Index           tail_;           // 最久未使用的节点
+    Index           free_;           // 空闲链表头
+    size_t          current_size_;   // 当前数据个数
+    uint64_t        weight_;         // 当前总权重
+    uint64_t        max_weight_;     // 总权重上限
+    TimingWheel     wheel_;          // 过期时间
+    TimedCacheStats stats_;          // 命中、未命中、淘汰、过期次数
+
+}; // class TimedLruCache
+
+template <typename _Key, typename _Value, typename _Weigher, typename _Hash, typename _KeyEqual>
+constexpr uint64_t TimedLruCache<_Key, _Value, _Weigher, _Hash, _KeyEqual>::kNoExpiry;
+
+template <typename _Key, typename _Value, typename _Weigher, typename _Hash, typename _KeyEqual>
+constexpr typename TimedLruCache<_Key, _Value, _Weigher, _Hash, _KeyEqual>::Index
+TimedLruCache<_Key, _Value, _Weigher, _Hash, _KeyEqual>::kNil;
+
+template <typename _Key, typename _Value, typename _Weigher, typename _Hash, typename _KeyEqual>
+constexpr size_t TimedLruCache<_Key, _Value, _Weigher, _Hash, _KeyEqual>::kInitialNodes;
+
+} // namespace glib
+
+#endif // GLIB_TIMED_LRU_CACHE_HPP_
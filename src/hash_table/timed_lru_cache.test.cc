@@ -0,0 +1,211 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: timed_lru_cache.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/24
+ * Description: test weighted capacity, ttl expiry and the hierarchical timing wheel
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "./timed_lru_cache.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+namespace {
+
+struct StringWeigher {
+    uint64_t operator()(const string &key, const string &value) const { return key.size() + value.size(); }
+};
+
+//! \brief 时间轮与朴素模型对比：随机安排、取消、推进（包括跨越多层与溢出链表的大步推进），
+//!        每次推进过期的对象集合相同
+bool WheelTest() {
+    mt19937_64 engine(2019);
+    const size_t kCount = 2000;
+    glib::TimingWheel wheel(12345);
+    wheel.Resize(kCount);
+    map<uint32_t, uint64_t> model;       // 下标 -> 过期时间
+    bool ok = true;
+    for (int round = 0; round < 20000 && ok; round++) {
+        uint32_t index = static_cast<uint32_t>(engine() % kCount);
+        switch (engine() % 8) {
+            case 0: case 1: case 2: case 3: {
+                // 过期时间的数量级随机：覆盖每一层与溢出链表
+                uint64_t delay = engine() & ((uint64_t(1) << (engine() % 40)) - 1);
+                wheel.Schedule(index, wheel.now() + delay);
+                model[index] = wheel.now() + (0 == delay ? 1 : delay);
+                break;
+            }
+            case 4:
+                wheel.Cancel(index);
+                model.erase(index);
+                break;
+            default: {
+                uint64_t step = engine() & ((uint64_t(1) << (engine() % 40)) - 1);
+                uint64_t now = wheel.now() + step;
+                vector<uint32_t> expired;
+                size_t count = wheel.Advance(now, [&expired](uint32_t i) { expired.push_back(i); });
+                size_t expected = 0;
+                for (auto it = model.begin(); it != model.end(); ) {
+                    if (it->second <= now) {
+                        expected++;
+                        it = model.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                ok = count == expected && expired.size() == expected && now == wheel.now();
+                for (uint32_t i: expired)
+                    ok = ok && !wheel.scheduled(i);
+            }
+        }
+        ok = ok && wheel.scheduled(index) == (model.count(index) > 0);
+    }
+    for (const auto &entry: model)
+        ok = ok && wheel.scheduled(entry.first) && entry.second == wheel.expire_time(entry.first);
+    return ok;
+}
+
+//! \brief 缓存随机操作：映射值是最后一次 Put 的值，总权重不超过上限，过期的数据全部删除
+bool RandomTest() {
+    mt19937_64 engine(7);
+    glib::TimedLruCache<uint64_t, uint64_t> cache(100);
+    unordered_map<uint64_t, uint64_t> latest;
+    bool ok = true;
+    for (int i = 0; i < 300000 && ok; i++) {
+        uint64_t key = engine() % 400;
+        switch (engine() % 10) {
+            case 0: case 1: case 2: case 3: {
+                const uint64_t *found = cache.Get(key);
+                ok = nullptr == found || latest[key] == *found;
+                break;
+            }
+            case 4: case 5: case 6: {
+                uint64_t value = engine();
+                cache.Put(key, value, engine() % 3 ? engine() % 500 : glib::TimedLruCache<uint64_t, uint64_t>::kNoExpiry);
+                latest[key] = value;
+                ok = cache.Contains(key) && cache.weight() <= cache.max_weight() && cache.size() == cache.weight();
+                break;
+            }
+            case 7:
+                cache.Erase(key);
+                ok = !cache.Contains(key);
+                break;
+            case 8: {
+                uint64_t now = cache.now() + engine() % 50;
+                cache.ExpireUpTo(now);
+                cache.ForEach([&](const uint64_t &k, const uint64_t &) {
+                    uint64_t expire = cache.expire_time(k);
+                    ok = ok && (0 == expire || expire > now);
+                });
+                break;
+            }
+            default:
+                if (0 == engine() % 100)
+                    cache.set_max_weight(1 + engine() % 300);
+                ok = cache.weight() <= cache.max_weight();
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+//! \brief TimedLruCache 测试：时间轮与朴素模型一致、ttl 过期、按权重淘汰、随机操作、
+//!        过期数百万数据的时间与数据个数成线性关系
+//! \run
+//!     g++ timed_lru_cache.test.cc -std=c++11 -O2 && ./a.out
+int main(int argc, char const *argv[]) {
+    bool all_ok = true;
+
+    // 1）时间轮
+    cout << "时间轮" << endl;
+    bool wheel_ok = WheelTest();
+    cout << (wheel_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && wheel_ok;
+
+    // 2）过期：ttl 到达的时间点过期，ttl 为 0 不过期，重新 Put 刷新过期时间
+    cout << "过期" << endl;
+    glib::TimedLruCache<string, int> timed(100, 1000);
+    timed.Put("a", 1, 10);
+    timed.Put("b", 2, 20);
+    timed.Put("c", 3);
+    bool expire_ok = 1010 == timed.expire_time("a") && 0 == timed.expire_time("c");
+    expire_ok = expire_ok && 0 == timed.ExpireUpTo(1009) && 3 == timed.size();
+    expire_ok = expire_ok && 1 == timed.ExpireUpTo(1010) && !timed.Contains("a") && timed.Contains("b");
+    timed.Put("b", 22, 100);                                    // 刷新为 1110
+    expire_ok = expire_ok && 0 == timed.ExpireUpTo(1100) && 22 == *timed.Get("b");
+    expire_ok = expire_ok && 1 == timed.ExpireUpTo(1u << 30) && 1 == timed.size() && 3 == *timed.Get("c");
+    expire_ok = expire_ok && 0 == timed.ExpireUpTo(5) && (1u << 30) == timed.now();     // 时间不会倒退
+    expire_ok = expire_ok && 2 == timed.stats().expirations && 0 == timed.stats().evictions;
+    cout << (expire_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && expire_ok;
+
+    // 3）按权重（字节数）淘汰：超过上限时淘汰最久未使用的数据，超过上限的单个数据不缓存
+    cout << "权重" << endl;
+    glib::TimedLruCache<string, string, StringWeigher> blobs(20);
+    blobs.Put("k1", string(6, 'x'));                            // 8
+    blobs.Put("k2", string(6, 'y'));                            // 16
+    blobs.Get("k1");
+    blobs.Put("k3", string(3, 'z'));                            // 21 > 20，淘汰 k2
+    bool weight_ok = !blobs.Contains("k2") && blobs.Contains("k1") && 13 == blobs.weight();
+    weight_ok = weight_ok && !blobs.Put("k1", string(30, 'w')) && !blobs.Contains("k1") && 5 == blobs.weight();
+    blobs.Put("k3", string(16, 'z'));                           // 替换之后权重变化
+    weight_ok = weight_ok && 18 == blobs.weight() && 1 == blobs.size();
+    blobs.set_max_weight(10);
+    weight_ok = weight_ok && blobs.empty() && 0 == blobs.weight() && 2 == blobs.stats().evictions;
+    cout << (weight_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && weight_ok;
+
+    // 4）插入时节点数组加倍，映射值引用缓存中的数据：先构造新数据再重新分配
+    cout << "插入自身的数据" << endl;
+    glib::TimedLruCache<int, string> self(100);
+    for (int key = 0; key < 16; key++)                        // 用满初始的 16 个节点
+        self.Put(key, string(100, static_cast<char>('a' + key)), 50);
+    bool alias_ok = self.Put(100, *self.Peek(3), 10) && 17 == self.size();
+    alias_ok = alias_ok && string(100, 'd') == *self.Peek(100) && string(100, 'd') == *self.Peek(3) &&
+               1 == self.ExpireUpTo(10) && !self.Contains(100);
+    cout << (alias_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && alias_ok;
+
+    // 5）随机操作
+    cout << "随机操作" << endl;
+    bool random_ok = RandomTest();
+    cout << (random_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && random_ok;
+
+    // 6）过期 n 个数据（过期时间分布在 2^20 个时间单位内）的时间与 n 成线性关系，与一次推进的跨度无关
+    cout << "过期时间" << endl;
+    double per_entry[2];
+    const size_t kSizes[2] = {1 << 18, 1 << 21};
+    bool linear_ok = true;
+    for (int round = 0; round < 2; round++) {
+        size_t n = kSizes[round];
+        glib::TimedLruCache<uint64_t, uint64_t> cache(n);
+        mt19937_64 engine(round);
+        for (uint64_t key = 0; key < n; key++)
+            cache.Put(key, key, 1 + engine() % (1 << 20));
+        TicToc timer;
+        size_t expired = 0;
+        for (uint64_t now = 1 << 10; now <= (1 << 20); now += 1 << 10)
+            expired += cache.ExpireUpTo(now);
+        double elapsed = timer.toc();
+        per_entry[round] = elapsed * 1e6 / static_cast<double>(n);
+        linear_ok = linear_ok && n == expired && cache.empty();
+        cout << "  " << n << " entries " << elapsed << " ms, " << per_entry[round] << " ns/entry" << endl;
+    }
+    linear_ok = linear_ok && per_entry[1] < per_entry[0] * 4;    // 容忍缓存未命中带来的常数变化
+    cout << (linear_ok ? " ok" : " error") << endl;
+    all_ok = all_ok && linear_ok;
+
+    return all_ok ? 0 : 1;
+}
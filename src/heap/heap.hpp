@@ -76,7 +76,7 @@ public:  // construct function
         }
     }
     ~Heap() {
-        if (heap_ != nullptr) delete heap_;
+        if (heap_ != nullptr) delete[] heap_;
     }
     GLIB_DISALLOW_IMPLICIT_CONSTRUCTORS_PUBLIC(Heap);
 public:  // external call function
@@ -217,7 +217,7 @@ void Heap<_Scalar,_Option>::HeapifyDown(size_t index) {
     assert(1 <= index && index <= size_ &&
            "index over heap size or index < 1");
     while (true) {
-        ValueType extremum_value_index = index;
+        size_t extremum_value_index = index;
         if (2 * index <= size_ &&
             Compare(heap_[2 * index], heap_[extremum_value_index]))
             extremum_value_index = 2 * index;
@@ -256,7 +256,7 @@ inline void Heap<_Scalar, _Option>::Extend() {
         ValueType* temp_array = new ValueType[2 * capacity_ + 1];
         for (int i = 1; i <= size_; ++i)
             temp_array[i] = heap_[i];
-        delete heap_;
+        delete[] heap_;
         heap_ = temp_array;
         capacity_ = 2 * capacity_;
     }
@@ -272,7 +272,7 @@ inline void Heap<_Scalar, _Option>::Reduce() {
         ValueType* temp_heap = new ValueType[int(0.5 * capacity_ + 1)];
         for (int i = 1; i <= size_; ++i)
             temp_heap[i] = heap_[i];
-        delete heap_;
+        delete[] heap_;
         capacity_ = 0.5 * capacity_;
         heap_ = temp_heap;
     }
@@ -0,0 +1,157 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: test_util.h
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/25
+ * Description: helpers shared by the *.test.cc files
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+#ifndef GLIB_PUBLIC_INTERNAL_TEST_UTIL_H_
+#define GLIB_PUBLIC_INTERNAL_TEST_UTIL_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint64_t
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//! \brief 多个 *.test.cc 共用的测试辅助函数，只在测试中使用
+
+namespace glib {
+namespace test_internal {
+
+//! \brief 启动 num_threads 个线程执行 function(thread_index)，等待全部结束
+template <typename _Function>
+void RunThreads(size_t num_threads, _Function function) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; i++)
+        threads.emplace_back(function, i);
+    for (auto &t: threads)
+        t.join();
+}
+
+// 很差的哈希函数：只有 4 种取值，用来测试冲突严重时的行为（长探测序列、回绕、抛出异常、诊断结果异常）
+struct BadHash {
+    size_t operator()(uint64_t key) const { return key % 4; }
+};
+
+//! \brief 随机 Insert/Delete/Find，与 std::unordered_map 对比，最后比较 ForEach 遍历到的数据
+//!        map 需要 Insert(key, value)、Delete(key)、Find(key) 返回 <是否存在, 映射值>、size()、ForEach()
+template <typename _Map, typename _Key>
+bool MapRandomTest(_Map &map, const std::vector<_Key> &keys, size_t operations, std::mt19937_64 &engine) {
+    std::unordered_map<_Key, uint64_t> expected;
+    for (size_t i = 0; i < operations; i++) {
+        const _Key &key = keys[engine() % keys.size()];
+        uint64_t value = engine();
+        switch (engine() % 3) {
+            case 0:
+                if (map.Insert(key, value) != (expected.count(key) == 0))
+                    return false;
+                expected[key] = value;
+                break;
+            case 1:
+                if (map.Delete(key) != (expected.erase(key) == 1))
+                    return false;
+                break;
+            default: {
+                auto result = map.Find(key);
+                auto iter = expected.find(key);
+                if (result.first != (iter != expected.end()) || (result.first && result.second != iter->second))
+                    return false;
+            }
+        }
+        if (map.size() != expected.size())
+            return false;
+    }
+    size_t count = 0;
+    bool same = true;
+    map.ForEach([&](const _Key &key, const uint64_t &value) {
+        auto iter = expected.find(key);
+        same = same && iter != expected.end() && iter->second == value;
+        count++;
+    });
+    return same && count == expected.size();
+}
+
+//! \brief 缓存随机 Get/Put/Erase/set_capacity：映射值总是最后一次 Put 的值，数据个数不超过容量，
+//!        ForEach() 遍历到的数据个数等于 size()，命中、未命中次数与 stats() 相同
+//!        _Cache 为 <uint64_t, uint64_t> 的 LruCache（任意淘汰策略）
+template <typename _Cache>
+bool CacheRandomTest(const char *name) {
+    std::mt19937_64 engine(2019);
+    _Cache cache(100);
+    std::unordered_map<uint64_t, uint64_t> latest;    // 每个键值最后一次 Put 的值
+    size_t hits = 0, misses = 0;
+    bool ok = true;
+    for (int i = 0; i < 300000 && ok; i++) {
+        uint64_t key = engine() % 400;
+        switch (engine() % 10) {
+            case 0: case 1: case 2: case 3: case 4: {
+                const uint64_t *found = cache.Get(key);
+                if (nullptr != found) {
+                    hits++;
+                    ok = latest.count(key) && latest[key] == *found;
+                } else {
+                    misses++;
+                }
+                break;
+            }
+            case 5: case 6: case 7: {
+                uint64_t value = engine();
+                cache.Put(key, value);
+                latest[key] = value;
+                ok = cache.Contains(key) && cache.size() <= cache.capacity();
+                break;
+            }
+            case 8:
+                cache.Erase(key);
+                ok = !cache.Contains(key);
+                break;
+            default:
+                if (0 == engine() % 200)
+                    cache.set_capacity(1 + engine() % 300);
+        }
+        if (0 == i % 1000) {
+            size_t count = 0;
+            cache.ForEach([&](const uint64_t &key, const uint64_t &value) {
+                count++;
+                ok = ok && latest[key] == value && cache.Contains(key);
+            });
+            ok = ok && count == cache.size() && cache.size() <= cache.capacity();
+        }
+    }
+    ok = ok && hits == cache.stats().hits && misses == cache.stats().misses;
+    std::cout << " " << name << " hit rate " << cache.stats().hit_rate() << (ok ? " ok" : " error") << std::endl;
+    return ok;
+}
+
+//! \brief 扫描：热点数据（容量的一半）与只用一次的冷数据混合访问一段时间之后，顺序访问 3 倍容量的冷数据一次，
+//!        返回扫描之后仍在缓存中的热点数据个数。未命中时插入
+template <typename _Cache>
+size_t HotKeysAfterScan() {
+    const uint64_t kCapacity = 1000, kHotKeys = 500;
+    std::mt19937_64 engine(7);
+    _Cache cache(kCapacity);
+    uint64_t cold = 1000000;
+    auto access = [&cache](uint64_t key) {
+        if (nullptr == cache.Get(key))
+            cache.Put(key, key);
+    };
+    for (int i = 0; i < 50000; i++)
+        access(engine() % 5 ? engine() % kHotKeys : cold++);
+    for (uint64_t i = 0; i < 3 * kCapacity; i++)
+        access(cold++);
+    size_t present = 0;
+    for (uint64_t key = 0; key < kHotKeys; key++)
+        present += cache.Contains(key) ? 1 : 0;
+    return present;
+}
+
+} // namespace test_internal
+} // namespace glib
+
+#endif // GLIB_PUBLIC_INTERNAL_TEST_UTIL_H_
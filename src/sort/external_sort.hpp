@@ -0,0 +1,628 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: external_sort.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/5
+ * Description: external memory sort for fixed-width records
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_EXTERNAL_SORT_HPP_
+#define GLIB_EXTERNAL_SORT_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <cstdio>      // FILE、fread、fwrite
+#include <cstdlib>     // mkstemp
+#include <cstring>     // strerror
+#include <cerrno>
+#include <chrono>
+#include <functional>  // std::less
+#include <future>      // packaged_task、future
+#include <iostream>
+#include <memory>      // unique_ptr、shared_ptr
+#include <stdexcept>   // runtime_error、invalid_argument
+#include <string>
+#include <type_traits> // is_trivially_copyable、result_of
+#include <utility>     // std::move
+#include <vector>
+#include <unistd.h>    // close
+#include "sort.hpp"
+#include "../internal/macros.h"
+#include "../utils/thread_pool.hpp"
+
+//! \brief 外部排序：对大于内存的定长记录文件排序
+//!      基本流程：
+//!         1）生成顺串：每次读入内存上限一半的数据，用 sort.hpp 中的排序算法排序后写入临时文件。
+//!            两块排序缓冲区交替使用，排序当前块时异步读入下一块、异步写出上一块
+//!         2）多路归并：每次最多合并 fan_in 个顺串，用败者树选出最小的记录。
+//!            每个输入、输出都有两块缓冲区（double buffering），处理一块时另一块在后台异步读写。
+//!            顺串个数大于 fan_in 时先合并成更长的中间顺串，直到最后一趟直接写到输出文件
+//!      外部调用接口：
+//!         1）排序器：ExternalSorter::Sort()，统计信息：ExternalSorter::stats()
+//!         2）一次性调用：ExternalSort()
+//!
+//! \Note
+//!      1）记录必须是定长的、可以直接按字节拷贝的类型（trivially copyable），文件就是记录数组的二进制内容，
+//!         文件大小不是记录大小的整数倍时抛出异常
+//!      2）内存上限包括生成顺串时的两块排序缓冲区、合并时所有的读写缓冲区，不包括标准库 FILE 的缓冲区
+//!      3）败者树中相等的记录按照顺串的先后顺序输出，所以 run_option 选择稳定排序（MERGE、PARALLEL_MERGE）时，
+//!         整个外部排序也是稳定的
+//!      4）临时文件用 mkstemp 创建，依赖 POSIX 接口；读写出错时抛出 std::runtime_error，临时文件会被删除
+//!      5）统计信息中第 0 趟是生成顺串，之后每一趟合并记录读写的字节数，可以用来估计磁盘的读写量
+//!
+//! \platform
+//!      ubuntu16.04 g++ version 5.4.0
+//!
+//! \example
+//!      struct LogRecord { uint64_t timestamp; char payload[56]; };
+//!      glib::ExternalSortOptions options;
+//!      options.memory_budget = size_t(4) << 30; // 4GB
+//!      options.fan_in        = 128;
+//!      auto stats = glib::ExternalSort<LogRecord>("input.bin", "output.bin", options,
+//!          [](const LogRecord &a, const LogRecord &b) { return a.timestamp < b.timestamp; });
+
+namespace glib {
+
+//! \brief 外部排序参数
+struct ExternalSortOptions {
+    size_t      memory_budget  = size_t(256) << 20; // 内存上限（字节）
+    size_t      fan_in         = 64;                // 每次最多合并的顺串个数
+    size_t      block_size     = size_t(1) << 20;   // 合并时每个读写缓冲区的最大字节数
+    size_t      io_threads     = 2;                 // 异步读写线程数，至少为 1
+    std::string temp_directory = "/tmp";            // 临时文件目录
+    SortOption  run_option     = SortOption::INTRO; // 生成顺串时使用的内存排序算法
+};
+
+//! \brief 每一趟的读写统计
+struct ExternalSortPassStats {
+    size_t   input_runs    = 0; // 本趟输入的顺串个数（第 0 趟为原始输入文件，记为 0）
+    size_t   output_runs   = 0; // 本趟输出的顺串个数（最后一趟为 1，即输出文件）
+    uint64_t bytes_read    = 0;
+    uint64_t bytes_written = 0;
+    double   seconds       = 0;
+};
+
+//! \brief 整个外部排序的统计信息
+struct ExternalSortStats {
+    uint64_t                           num_records = 0;
+    std::vector<ExternalSortPassStats> passes;
+
+    uint64_t TotalBytesRead() const {
+        uint64_t total = 0;
+        for (const auto &pass: passes)
+            total += pass.bytes_read;
+        return total;
+    }
+
+    uint64_t TotalBytesWritten() const {
+        uint64_t total = 0;
+        for (const auto &pass: passes)
+            total += pass.bytes_written;
+        return total;
+    }
+
+    void print(std::ostream &os = std::cout) const {
+        os << " records: " << num_records << std::endl;
+        for (size_t i = 0; i < passes.size(); i++) {
+            const auto &pass = passes[i];
+            os << "  pass " << i << ": runs " << pass.input_runs << " -> " << pass.output_runs
+               << ", read " << pass.bytes_read << " B, written " << pass.bytes_written
+               << " B, " << pass.seconds << " s" << std::endl;
+        }
+        os << "  total read " << TotalBytesRead() << " B, written " << TotalBytesWritten() << " B" << std::endl;
+    }
+};
+
+namespace external_sort_internal {
+
+// 文件操作出错时抛出异常，带上系统错误信息
+inline void ThrowIoError(const std::string &message, const std::string &path) {
+    throw std::runtime_error("ExternalSort: " + message + " " + path + ": " + std::strerror(errno));
+}
+
+//! \brief FILE 的简单封装，析构时关闭文件
+class File {
+public:
+    File(const std::string &path, const char *mode) : path_(path), file_(std::fopen(path.c_str(), mode)) {
+        if (nullptr == file_)
+            ThrowIoError("cannot open", path_);
+        std::setvbuf(file_, nullptr, _IONBF, 0); // 自己管理缓冲区，不需要再经过 FILE 的缓冲区
+    }
+
+    ~File() {
+        if (nullptr != file_)
+            std::fclose(file_);
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(File);
+
+    //! \brief 读取最多 bytes 个字节，返回实际读取的字节数，只有到达文件末尾时才会少于 bytes
+    size_t Read(void *data, size_t bytes) {
+        size_t read_bytes = std::fread(data, 1, bytes, file_);
+        if (read_bytes < bytes && std::ferror(file_))
+            ThrowIoError("cannot read", path_);
+        return read_bytes;
+    }
+
+    void Write(const void *data, size_t bytes) {
+        if (std::fwrite(data, 1, bytes, file_) != bytes)
+            ThrowIoError("cannot write", path_);
+    }
+
+    // 关闭文件，写入的数据刷新失败时抛出异常（析构函数中不能抛出异常，所以单独提供该函数）
+    void Close() {
+        FILE *file = file_;
+        file_ = nullptr;
+        if (0 != std::fclose(file))
+            ThrowIoError("cannot close", path_);
+    }
+
+    // 文件大小（字节）
+    uint64_t Size() {
+        if (0 != fseeko(file_, 0, SEEK_END))
+            ThrowIoError("cannot seek", path_);
+        off_t size = ftello(file_);
+        if (size < 0 || 0 != fseeko(file_, 0, SEEK_SET))
+            ThrowIoError("cannot seek", path_);
+        return static_cast<uint64_t>(size);
+    }
+
+private:
+    std::string path_;
+    FILE       *file_;
+};
+
+//! \brief 临时文件，析构时删除
+class TempFile {
+public:
+    explicit
+    TempFile(const std::string &directory) {
+        std::string pattern = directory + "/glib_external_sort_XXXXXX";
+        std::vector<char> path(pattern.begin(), pattern.end());
+        path.push_back('\0');
+        int fd = mkstemp(path.data());
+        if (fd < 0)
+            ThrowIoError("cannot create temp file in", directory);
+        ::close(fd);
+        path_ = path.data();
+    }
+
+    ~TempFile() { std::remove(path_.c_str()); }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(TempFile);
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+//! \brief 把任务提交到线程池中异步执行，返回 future，任务中的异常在 future::get() 时抛出
+template <typename _Function>
+std::future<typename std::result_of<_Function()>::type> Async(utils::ThreadPool &pool, _Function function) {
+    using ResultType = typename std::result_of<_Function()>::type;
+    auto task = std::make_shared<std::packaged_task<ResultType()>>(std::move(function));
+    std::future<ResultType> future = task->get_future();
+    pool.Submit([task]() { (*task)(); });
+    return future;
+}
+
+//! \brief 双缓冲的顺序读取器：读取当前块时，下一块已经在后台读取
+template <typename _Record>
+class BlockReader {
+public:
+    BlockReader(const std::string &path, size_t block_records, utils::ThreadPool &io_pool)
+        : file_(path, "rb"), io_pool_(io_pool), block_records_(block_records),
+          current_(0), position_(0), size_(0), bytes_read_(0) {
+        buffers_[0].resize(block_records_);
+        buffers_[1].resize(block_records_);
+        StartRead(); // 读第一块到另一块缓冲区，然后切换过来
+        NextBlock();
+    }
+
+    ~BlockReader() {
+        if (pending_.valid()) // 等待后台读取完成，否则后台线程会写已经释放的缓冲区
+            pending_.wait();
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(BlockReader);
+
+    // 当前记录，读完时返回 nullptr
+    const _Record* Current() const {
+        return position_ < size_ ? &buffers_[current_][position_] : nullptr;
+    }
+
+    void Advance() {
+        if (++position_ == size_)
+            NextBlock();
+    }
+
+    uint64_t bytes_read() const { return bytes_read_; }
+
+private:
+    void StartRead() {
+        File    *file     = &file_;
+        _Record *data     = buffers_[1 - current_].data();
+        size_t   capacity = block_records_;
+        pending_ = Async(io_pool_, [=]() { return file->Read(data, capacity * sizeof(_Record)); });
+    }
+
+    void NextBlock() {
+        if (!pending_.valid()) { // 上一块没有读满，文件已经读完
+            position_ = size_ = 0;
+            return;
+        }
+        size_t read_bytes = pending_.get();
+        if (0 != read_bytes % sizeof(_Record))
+            throw std::runtime_error("ExternalSort: file size is not a multiple of the record size");
+        bytes_read_ += read_bytes;
+        current_  = 1 - current_;
+        position_ = 0;
+        size_     = read_bytes / sizeof(_Record);
+        if (size_ == block_records_) // 没有读到文件末尾，继续读下一块
+            StartRead();
+    }
+
+private:
+    File                  file_;
+    utils::ThreadPool    &io_pool_;
+    size_t                block_records_;
+    std::vector<_Record>  buffers_[2];
+    size_t                current_;    // 当前正在读取的缓冲区
+    size_t                position_;   // 当前记录在缓冲区中的位置
+    size_t                size_;       // 当前缓冲区中的记录个数
+    uint64_t              bytes_read_;
+    std::future<size_t>   pending_;    // 后台读取任务，返回读取的字节数
+};
+
+//! \brief 双缓冲的顺序写入器：一块缓冲区写满后交给后台写入，同时继续填充另一块
+template <typename _Record>
+class BlockWriter {
+public:
+    BlockWriter(const std::string &path, size_t block_records, utils::ThreadPool &io_pool)
+        : file_(path, "wb"), io_pool_(io_pool), block_records_(block_records),
+          current_(0), size_(0), bytes_written_(0) {
+        buffers_[0].resize(block_records_);
+        buffers_[1].resize(block_records_);
+    }
+
+    ~BlockWriter() {
+        if (pending_.valid())
+            pending_.wait();
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(BlockWriter);
+
+    void Push(const _Record &record) {
+        buffers_[current_][size_++] = record;
+        if (size_ == block_records_)
+            Flush();
+    }
+
+    // 写出剩余数据并关闭文件，出错时抛出异常
+    void Close() {
+        Flush();
+        WaitPending();
+        file_.Close();
+    }
+
+    uint64_t bytes_written() const { return bytes_written_; }
+
+private:
+    void Flush() {
+        if (0 == size_)
+            return;
+        WaitPending(); // 同一个文件同时只有一个写入任务，保证写入顺序
+        File          *file  = &file_;
+        const _Record *data  = buffers_[current_].data();
+        size_t         bytes = size_ * sizeof(_Record);
+        pending_ = Async(io_pool_, [=]() { file->Write(data, bytes); });
+        bytes_written_ += bytes;
+        current_ = 1 - current_;
+        size_    = 0;
+    }
+
+    void WaitPending() {
+        if (pending_.valid())
+            pending_.get();
+    }
+
+private:
+    File                  file_;
+    utils::ThreadPool    &io_pool_;
+    size_t                block_records_;
+    std::vector<_Record>  buffers_[2];
+    size_t                current_;       // 当前正在填充的缓冲区
+    size_t                size_;          // 当前缓冲区中的记录个数
+    uint64_t              bytes_written_;
+    std::future<void>     pending_;       // 后台写入任务
+};
+
+//! \brief 败者树：k 路归并时每次选出最小的记录只需要 log(k) 次比较
+//! \note 1）叶子节点 i 对应第 i 路输入，内部节点保存比赛的败者，tree_[0] 保存最终的胜者
+//!       2）某一路输入读完时，当前记录为 nullptr，比任何记录都大
+//!       3）记录相等时编号小的输入胜出，保证归并是稳定的
+template <typename _Record, typename _Compare>
+class LoserTree {
+public:
+    LoserTree(size_t num_ways, _Compare comp)
+        : num_ways_(num_ways), comp_(comp), tree_(num_ways, 0), heads_(num_ways, nullptr) {}
+
+    //! \brief 设置每一路输入的当前记录，并建树
+    //! \complexity O(k)
+    void Build(const std::vector<const _Record*> &heads) {
+        heads_ = heads;
+        std::vector<size_t> winners(2 * num_ways_);
+        for (size_t way = 0; way < num_ways_; way++)
+            winners[num_ways_ + way] = way;
+        for (size_t node = num_ways_ - 1; node >= 1; node--) {
+            size_t left = winners[2 * node], right = winners[2 * node + 1];
+            if (Beats(left, right)) {
+                winners[node] = left;
+                tree_[node]   = right;
+            } else {
+                winners[node] = right;
+                tree_[node]   = left;
+            }
+        }
+        tree_[0] = (1 == num_ways_) ? 0 : winners[1];
+    }
+
+    // 当前最小记录所在的输入编号
+    size_t Winner() const { return tree_[0]; }
+
+    // 当前最小的记录，所有输入都读完时返回 nullptr
+    const _Record* WinnerRecord() const { return heads_[tree_[0]]; }
+
+    //! \brief 第 way 路输入的当前记录变为 head 之后，从叶子节点到根节点重新比赛
+    //! \complexity O(log(k))
+    void Replay(size_t way, const _Record *head) {
+        heads_[way] = head;
+        size_t winner = way;
+        for (size_t node = (num_ways_ + way) / 2; node >= 1; node /= 2) {
+            if (Beats(tree_[node], winner))
+                std::swap(tree_[node], winner);
+        }
+        tree_[0] = winner;
+    }
+
+private:
+    // first 是否胜过 second
+    bool Beats(size_t first, size_t second) const {
+        const _Record *a = heads_[first];
+        const _Record *b = heads_[second];
+        if (nullptr == b) return nullptr != a || first < second;
+        if (nullptr == a) return false;
+        if (comp_(*a, *b)) return true;
+        if (comp_(*b, *a)) return false;
+        return first < second;
+    }
+
+private:
+    size_t                       num_ways_;
+    _Compare                     comp_;
+    std::vector<size_t>          tree_;  // tree_[0] 为胜者，其他为对应内部节点的败者
+    std::vector<const _Record*>  heads_; // 每一路输入的当前记录
+};
+
+} // namespace external_sort_internal
+
+//! \brief 外部排序器
+//! \param _Record 定长记录类型，必须可以按字节拷贝
+//! \param _Compare 记录比较函数，与 glib::Sort 一致
+template <typename _Record, typename _Compare = std::less<_Record>>
+class ExternalSorter {
+    static_assert(std::is_trivially_copyable<_Record>::value, "ExternalSort requires trivially copyable records");
+
+public: // 构造函数相关
+    explicit
+    ExternalSorter(const ExternalSortOptions &options = ExternalSortOptions(), _Compare comp = _Compare())
+        : options_(options), comp_(comp) {
+        if (options_.fan_in < 2)
+            throw std::invalid_argument("ExternalSort: fan_in must be at least 2");
+        if (options_.io_threads < 1) // 没有工作线程时异步读写永远不会执行
+            throw std::invalid_argument("ExternalSort: io_threads must be at least 1");
+        if (options_.memory_budget < 4 * (options_.fan_in + 1) * sizeof(_Record))
+            throw std::invalid_argument("ExternalSort: memory_budget is too small for fan_in");
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(ExternalSorter);
+
+public: // 外部调用核心函数
+    //! \brief 对 input_path 中的记录排序，结果写到 output_path
+    //! \complexity 读写量 O(n * (1 + 合并趟数))，合并趟数为 ceil(log_{fan_in}(顺串个数))
+    //! \return 统计信息
+    const ExternalSortStats& Sort(const std::string &input_path, const std::string &output_path) {
+        stats_ = ExternalSortStats();
+        utils::ThreadPool io_pool(options_.io_threads + 1); // 并发度包含调用线程，这里只让工作线程读写
+        std::vector<std::unique_ptr<TempFile>> runs = FormRuns(input_path, output_path, io_pool);
+        if (runs.empty()) // 没有数据或者只有一个顺串，已经直接写到输出文件
+            return stats_;
+
+        while (runs.size() > options_.fan_in) { // 中间趟：合并成更长的顺串
+            ExternalSortPassStats pass;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::unique_ptr<TempFile>> merged_runs;
+            for (size_t begin = 0; begin < runs.size(); begin += options_.fan_in) {
+                size_t end = std::min(runs.size(), begin + options_.fan_in);
+                std::unique_ptr<TempFile> merged(new TempFile(options_.temp_directory));
+                MergeRuns(runs, begin, end, merged->path(), io_pool, pass);
+                for (size_t i = begin; i < end; i++) // 合并完就删除，减少磁盘占用
+                    runs[i].reset();
+                merged_runs.push_back(std::move(merged));
+            }
+            pass.input_runs  = runs.size();
+            pass.output_runs = merged_runs.size();
+            pass.seconds     = SecondsSince(start);
+            stats_.passes.push_back(pass);
+            runs = std::move(merged_runs);
+        }
+
+        ExternalSortPassStats pass; // 最后一趟：直接写到输出文件
+        auto start = std::chrono::steady_clock::now();
+        MergeRuns(runs, 0, runs.size(), output_path, io_pool, pass);
+        pass.input_runs  = runs.size();
+        pass.output_runs = 1;
+        pass.seconds     = SecondsSince(start);
+        stats_.passes.push_back(pass);
+        return stats_;
+    }
+
+    const ExternalSortStats& stats() const { return stats_; } // 上一次排序的统计信息
+
+private: // 类型声明
+    using File     = external_sort_internal::File;
+    using TempFile = external_sort_internal::TempFile;
+
+private: // helper functions
+    static double SecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //! \brief 生成顺串：两块排序缓冲区交替使用，排序一块的同时后台读入下一块、写出上一块
+    //! \note 只有一个顺串时直接写到输出文件，返回空
+    std::vector<std::unique_ptr<TempFile>> FormRuns(const std::string &input_path,
+                                                    const std::string &output_path,
+                                                    utils::ThreadPool &io_pool) {
+        using external_sort_internal::Async;
+        ExternalSortPassStats pass;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<TempFile>> runs;
+
+        File input(input_path, "rb");
+        uint64_t input_bytes = input.Size();
+        if (0 != input_bytes % sizeof(_Record))
+            throw std::runtime_error("ExternalSort: file size is not a multiple of the record size " + input_path);
+        const uint64_t num_records = input_bytes / sizeof(_Record);
+        const size_t   run_records = std::max<size_t>(1, options_.memory_budget / 2 / sizeof(_Record));
+        const size_t   num_runs    = static_cast<size_t>((num_records + run_records - 1) / run_records);
+        stats_.num_records = num_records;
+        if (0 == num_runs) {
+            File output(output_path, "wb");
+            output.Close();
+        }
+
+        std::vector<_Record>  buffers[2];
+        std::future<size_t>   reading[2];
+        std::future<void>     writing[2];
+        std::unique_ptr<File> run_files[2];  // 正在写入的顺串文件
+        auto run_size = [&](size_t run) {
+            return static_cast<size_t>(std::min<uint64_t>(run_records, num_records - uint64_t(run) * run_records));
+        };
+        auto start_read = [&](size_t run) {
+            std::vector<_Record> &buffer = buffers[run % 2];
+            buffer.resize(run_size(run));
+            File   *file  = &input;
+            void   *data  = buffer.data();
+            size_t  bytes = buffer.size() * sizeof(_Record);
+            reading[run % 2] = Async(io_pool, [=]() { return file->Read(data, bytes); });
+        };
+
+        try {
+            if (num_runs > 0)
+                start_read(0);
+            for (size_t run = 0; run < num_runs; run++) {
+                std::vector<_Record> &buffer = buffers[run % 2];
+                if (reading[run % 2].get() != buffer.size() * sizeof(_Record))
+                    throw std::runtime_error("ExternalSort: unexpected end of file " + input_path);
+                pass.bytes_read += buffer.size() * sizeof(_Record);
+                if (run + 1 < num_runs) { // 另一块缓冲区写完之后，开始读入下一块
+                    if (writing[(run + 1) % 2].valid())
+                        writing[(run + 1) % 2].get();
+                    start_read(run + 1);
+                }
+
+                glib::Sort(buffer.data(), buffer.data() + buffer.size(), comp_, options_.run_option);
+
+                const std::string *path = &output_path;
+                if (num_runs > 1) {
+                    runs.emplace_back(new TempFile(options_.temp_directory));
+                    path = &runs.back()->path();
+                }
+                run_files[run % 2].reset(new File(*path, "wb"));
+                File         *file  = run_files[run % 2].get();
+                const void   *data  = buffer.data();
+                size_t        bytes = buffer.size() * sizeof(_Record);
+                writing[run % 2] = Async(io_pool, [=]() {
+                    file->Write(data, bytes);
+                    file->Close();
+                });
+                pass.bytes_written += bytes;
+            }
+            for (auto &pending: writing) {
+                if (pending.valid())
+                    pending.get();
+            }
+        } catch (...) { // 等待后台任务结束后再释放缓冲区
+            for (auto &pending: reading)
+                if (pending.valid()) pending.wait();
+            for (auto &pending: writing)
+                if (pending.valid()) pending.wait();
+            throw;
+        }
+
+        pass.output_runs = std::max<size_t>(num_runs, 1);
+        pass.seconds     = SecondsSince(start);
+        stats_.passes.push_back(pass);
+        return runs;
+    }
+
+    //! \brief 用败者树合并 runs[begin, end) 到 output_path
+    //! \note 每个输入、输出两块缓冲区，每块大小为 min(block_size, 内存上限 / (2 * (k + 1)))
+    void MergeRuns(const std::vector<std::unique_ptr<TempFile>> &runs, size_t begin, size_t end,
+                   const std::string &output_path, utils::ThreadPool &io_pool,
+                   ExternalSortPassStats &pass) {
+        using external_sort_internal::BlockReader;
+        using external_sort_internal::BlockWriter;
+        const size_t num_ways      = end - begin;
+        const size_t block_bytes   = std::min(options_.block_size,
+                                              options_.memory_budget / (2 * (num_ways + 1)));
+        const size_t block_records = std::max<size_t>(1, block_bytes / sizeof(_Record));
+
+        std::vector<std::unique_ptr<BlockReader<_Record>>> readers;
+        std::vector<const _Record*> heads;
+        for (size_t i = begin; i < end; i++) {
+            readers.emplace_back(new BlockReader<_Record>(runs[i]->path(), block_records, io_pool));
+            heads.push_back(readers.back()->Current());
+        }
+        BlockWriter<_Record> writer(output_path, block_records, io_pool);
+
+        external_sort_internal::LoserTree<_Record, _Compare> tree(num_ways, comp_);
+        tree.Build(heads);
+        while (const _Record *record = tree.WinnerRecord()) {
+            writer.Push(*record);
+            size_t way = tree.Winner();
+            readers[way]->Advance();
+            tree.Replay(way, readers[way]->Current());
+        }
+        writer.Close();
+
+        for (const auto &reader: readers)
+            pass.bytes_read += reader->bytes_read();
+        pass.bytes_written += writer.bytes_written();
+    }
+
+private:
+    ExternalSortOptions options_;
+    _Compare            comp_;
+    ExternalSortStats   stats_;
+}; // class ExternalSorter
+
+//! \brief 外部排序一次性调用接口
+//! \param input_path、output_path 输入、输出文件，内容为 _Record 数组的二进制数据
+//! \param options 内存上限、合并路数、临时目录等参数
+//! \param comp 记录比较函数，默认 std::less<_Record>
+//! \return 统计信息，包括每一趟读写的字节数
+template <typename _Record, typename _Compare = std::less<_Record>>
+ExternalSortStats ExternalSort(const std::string &input_path, const std::string &output_path,
+                               const ExternalSortOptions &options = ExternalSortOptions(),
+                               _Compare comp = _Compare()) {
+    ExternalSorter<_Record, _Compare> sorter(options, comp);
+    return sorter.Sort(input_path, output_path);
+}
+
+} // namespace glib
+
+#endif // GLIB_EXTERNAL_SORT_HPP_
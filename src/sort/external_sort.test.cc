@@ -0,0 +1,132 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: external_sort.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/5
+ * Description: test external sort
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "external_sort.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm> // stable_sort
+using namespace std;
+
+// 定长日志记录
+struct LogRecord {
+    uint64_t timestamp;
+    uint32_t sequence;   // 写入时的顺序，用来验证稳定性
+    char     payload[20];
+};
+
+bool TimestampLess(const LogRecord &a, const LogRecord &b) {
+    return a.timestamp < b.timestamp;
+}
+
+template <typename _Record>
+void WriteRecords(const string &path, const vector<_Record> &records) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!records.empty())
+        fwrite(records.data(), sizeof(_Record), records.size(), file);
+    fclose(file);
+}
+
+template <typename _Record>
+vector<_Record> ReadRecords(const string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    vector<_Record> records;
+    _Record record;
+    while (1 == fread(&record, sizeof(_Record), 1, file))
+        records.push_back(record);
+    fclose(file);
+    return records;
+}
+
+//! \brief 外部排序简单测试：内存上限设置得很小，强制生成多个顺串并进行多趟合并
+//! \run
+//!     g++ external_sort.test.cc -std=c++11 -pthread && ./a.out
+int main(int argc, char const *argv[]) {
+    const string input_path  = "/tmp/glib_external_sort_input.bin";
+    const string output_path = "/tmp/glib_external_sort_output.bin";
+    mt19937_64 engine(2019);
+
+    // 1）多趟合并 + 稳定性：时间戳有大量重复，稳定排序后相同时间戳的记录保持写入顺序
+    cout << "多趟合并测试" << endl;
+    vector<LogRecord> records(200000);
+    for (size_t i = 0; i < records.size(); i++) {
+        records[i].timestamp = engine() % 5000;
+        records[i].sequence  = static_cast<uint32_t>(i);
+        snprintf(records[i].payload, sizeof(records[i].payload), "log-%u", static_cast<unsigned>(i));
+    }
+    WriteRecords(input_path, records);
+    glib::ExternalSortOptions options;
+    options.memory_budget = 256 << 10; // 256KB，每个顺串 128KB，大约 3700 条记录
+    options.fan_in        = 4;
+    options.block_size    = 4 << 10;
+    options.run_option    = glib::SortOption::MERGE;
+    auto stats = glib::ExternalSort<LogRecord>(input_path, output_path, options, TimestampLess);
+    stats.print();
+    std::stable_sort(records.begin(), records.end(), TimestampLess);
+    vector<LogRecord> output = ReadRecords<LogRecord>(output_path);
+    bool same = output.size() == records.size();
+    for (size_t i = 0; same && i < output.size(); i++)
+        same = output[i].timestamp == records[i].timestamp && output[i].sequence == records[i].sequence;
+    cout << (same ? " ok" : " external sort error!") << endl << endl;
+
+    // 2）整数从大到小、并行排序生成顺串、一趟合并
+    cout << "一趟合并测试" << endl;
+    vector<uint64_t> numbers(1000000);
+    for (auto &number: numbers)
+        number = engine();
+    WriteRecords(input_path, numbers);
+    glib::ExternalSortOptions number_options;
+    number_options.memory_budget = 1 << 20;
+    number_options.run_option    = glib::SortOption::PARALLEL_QUICK;
+    glib::ExternalSorter<uint64_t, std::greater<uint64_t>> sorter(number_options);
+    sorter.Sort(input_path, output_path).print();
+    std::sort(numbers.begin(), numbers.end(), std::greater<uint64_t>());
+    cout << (ReadRecords<uint64_t>(output_path) == numbers ? " ok" : " external sort error!") << endl << endl;
+
+    // 3）边界情况：只有一个顺串、空文件、文件大小不是记录大小的整数倍
+    cout << "边界情况测试" << endl;
+    vector<uint64_t> small_numbers(numbers.begin(), numbers.begin() + 1000);
+    std::reverse(small_numbers.begin(), small_numbers.end());
+    WriteRecords(input_path, small_numbers);
+    stats = glib::ExternalSort<uint64_t>(input_path, output_path);
+    std::sort(small_numbers.begin(), small_numbers.end());
+    cout << " single run: passes " << stats.passes.size()
+         << (ReadRecords<uint64_t>(output_path) == small_numbers ? " ok" : " external sort error!") << endl;
+
+    WriteRecords(input_path, vector<uint64_t>());
+    stats = glib::ExternalSort<uint64_t>(input_path, output_path);
+    cout << " empty: records " << stats.num_records
+         << (ReadRecords<uint64_t>(output_path).empty() ? " ok" : " external sort error!") << endl;
+
+    WriteRecords(input_path, vector<char>(13, 'x'));
+    try {
+        glib::ExternalSort<uint64_t>(input_path, output_path);
+        cout << " external sort error! no exception" << endl;
+    } catch (const std::runtime_error &error) {
+        cout << " bad size: " << error.what() << endl;
+    }
+
+    glib::ExternalSortOptions no_io_options;
+    no_io_options.io_threads = 0;
+    try {
+        glib::ExternalSort<uint64_t>(input_path, output_path, no_io_options);
+        cout << " external sort error! no exception" << endl;
+    } catch (const std::invalid_argument &error) {
+        cout << " io_threads = 0: " << error.what() << endl;
+    }
+
+    remove(input_path.c_str());
+    remove(output_path.c_str());
+    return 0;
+}
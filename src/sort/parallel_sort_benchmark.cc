@@ -0,0 +1,89 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: parallel_sort_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/2
+ * Description: scaling benchmark of parallel sort algorithms
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "sort.hpp"
+#include "../utils/tic_toc.hpp"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm> // std::sort is_sorted
+#include <random>
+#include <string>
+
+using namespace std;
+
+//! \brief 并行排序加速比测试：线程数从 1 到硬件线程数（至少到 4），
+//!        分别测试并行归并排序、并行快排，并与单线程内省排序、std::sort 对比
+//! \run
+//!     g++ parallel_sort_benchmark.cc -std=c++11 -O2 -pthread && ./a.out [元素个数]
+
+namespace {
+
+// 多次运行取最短时间，单位 ms
+template <typename _Function>
+double BestOf(const vector<int> &input, size_t repeat, _Function sort_function) {
+    double best = 0;
+    for (size_t i = 0; i < repeat; i++) {
+        vector<int> data(input);
+        TicToc timer;
+        sort_function(data);
+        double elapsed = timer.toc();
+        if (!std::is_sorted(data.begin(), data.end()))
+            cout << "sort error!" << endl;
+        if (0 == i || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    size_t n = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 10000000;
+    const size_t repeat = 3;
+    mt19937 engine(2019);
+    vector<int> input(n);
+    for (auto &value: input)
+        value = static_cast<int>(engine());
+
+    double std_time = BestOf(input, repeat, [](vector<int> &data) {
+        std::sort(data.begin(), data.end());
+    });
+    double intro_time = BestOf(input, repeat, [](vector<int> &data) {
+        glib::Sort(data.begin(), data.end(), glib::SortOption::INTRO);
+    });
+    cout << "n = " << n << endl;
+    cout << fixed << setprecision(2);
+    cout << "std::sort  " << std_time   << " ms" << endl;
+    cout << "INTRO      " << intro_time << " ms" << endl << endl;
+
+    cout << setw(8) << "threads"
+         << setw(18) << "PARALLEL_MERGE" << setw(10) << "speedup"
+         << setw(18) << "PARALLEL_QUICK" << setw(10) << "speedup" << endl;
+    size_t max_threads = std::max<size_t>(4, glib::utils::ThreadPool::HardwareConcurrency());
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        glib::utils::ThreadPool pool(num_threads);
+        double merge_time = BestOf(input, repeat, [&pool](vector<int> &data) {
+            glib::ParallelSort(data.begin(), data.end(), std::less<int>(), pool,
+                               glib::SortOption::PARALLEL_MERGE);
+        });
+        double quick_time = BestOf(input, repeat, [&pool](vector<int> &data) {
+            glib::ParallelSort(data.begin(), data.end(), std::less<int>(), pool,
+                               glib::SortOption::PARALLEL_QUICK);
+        });
+        // 加速比以单线程内省排序为基准
+        cout << setw(8)  << num_threads
+             << setw(15) << merge_time << " ms" << setw(9) << intro_time / merge_time << "x"
+             << setw(15) << quick_time << " ms" << setw(9) << intro_time / quick_time << "x" << endl;
+    }
+
+    return 0;
+}
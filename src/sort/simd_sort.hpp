@@ -0,0 +1,706 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: simd_sort.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/10
+ * Description: SIMD sorting networks and partition kernels
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_SIMD_SORT_HPP_
+#define GLIB_SIMD_SORT_HPP_
+#include <cstddef>     // size_t
+#include <cstdint>     // int32_t、int64_t、uint8_t
+#include <cstring>     // memcpy
+#include <algorithm>   // std::swap
+#include <limits>      // numeric_limits
+#include <type_traits> // enable_if、integral_constant
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GLIB_SIMD_SORT_X86 1
+#include <immintrin.h>
+#endif
+
+//! \brief 排序用的 SIMD 内核：小数组的双调排序网络（bitonic sorting network）、无分支的向量化分区
+//!      外部调用核心函数：
+//!         1）对最多 64 个元素排序（从小到大）：simd::SortSmall
+//!         2）按照 pivot 分区，小于 pivot 的放左边：simd::Partition
+//!            小于等于 pivot 的放左边：simd::PartitionLessEqual
+//!         3）运行时检测到的指令集：simd::DetectSimdLevel，当前使用的指令集：simd::GetSimdLevel、SetSimdLevel
+//!      支持的类型：int32_t、int64_t、float、double
+//!
+//! \Note
+//!      1）运行时检测 CPU 支持的指令集，依次选择 AVX2、SSE4.2、标量实现。SIMD 函数用 GCC 的 target 属性单独编译，
+//!         所以不需要 -mavx2 编译选项，编译出来的程序在不支持 AVX2 的机器上也能运行
+//!      2）排序网络：元素个数补齐到 2 的幂（用最大值填充），放在向量寄存器中比较交换，没有分支。
+//!         跨向量的比较交换直接用 min/max，向量内部的比较交换先用 permute 得到对应元素，再 min/max + blend
+//!      3）分区：每次读入一个向量，比较得到掩码，用查表得到的 permute 把小于 pivot 的元素压缩（compress）到向量前面，
+//!         整个向量同时写到左边和右边的写入位置，左边前进「小于 pivot 的个数」，右边后退「其他元素的个数」。
+//!         一开始先把两端各一个向量保存在寄存器中，保证写入的位置永远不会覆盖还没有读的数据（原地分区）
+//!      4）浮点数中有 NaN 时不满足严格弱序，结果没有意义（与 std::sort 一致）
+//!      5）非 GCC/Clang 的编译器或者非 x86 平台只有标量实现
+//!
+//! \platform
+//!      ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!      Bramas B. A Novel Hybrid Quicksort Algorithm Vectorized using AVX-512 on Intel Skylake
+//!      Blacher M. et al. Vectorized and performance-portable Quicksort
+//!
+//! \example
+//!      int32_t data[20] = {...};
+//!      glib::simd::SortSmall(data, 20);
+//!      size_t num_less = glib::simd::Partition(array.data(), array.size(), pivot);
+
+namespace glib {
+namespace simd {
+
+// 指令集级别
+enum class SimdLevel {
+    SCALAR,
+    SSE4,
+    AVX2
+};
+
+const size_t kMaxSmallSort = 64; // SortSmall 最多排序的元素个数
+
+// 支持 SIMD 排序的类型
+template <typename _Scalar>
+struct IsSimdSortable : std::integral_constant<bool,
+    std::is_same<_Scalar, int32_t>::value || std::is_same<_Scalar, int64_t>::value ||
+    std::is_same<_Scalar, float>::value   || std::is_same<_Scalar, double>::value> {};
+
+//! \brief CPU 支持的最高指令集，只检测一次
+inline SimdLevel DetectSimdLevel() {
+#ifdef GLIB_SIMD_SORT_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx2")   ? SimdLevel::AVX2 :
+                                   __builtin_cpu_supports("sse4.2") ? SimdLevel::SSE4 : SimdLevel::SCALAR;
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+} // namespace simd
+
+namespace simd_internal {
+    inline simd::SimdLevel& ActiveSimdLevel() {
+        static simd::SimdLevel level = simd::DetectSimdLevel();
+        return level;
+    }
+} // namespace simd_internal
+
+namespace simd {
+
+// 当前使用的指令集
+inline SimdLevel GetSimdLevel() { return simd_internal::ActiveSimdLevel(); }
+
+//! \brief 设置使用的指令集，用于测试、对比不同实现。超过 CPU 支持的级别时使用 CPU 支持的最高级别
+//! \note 不是线程安全的，应该在排序之前设置
+inline void SetSimdLevel(SimdLevel level) {
+    simd_internal::ActiveSimdLevel() = (level > DetectSimdLevel()) ? DetectSimdLevel() : level;
+}
+
+} // namespace simd
+
+namespace simd_internal {
+
+//-----------------------------------标量实现------------------------------------------
+
+//! \brief 无分支的 Lomuto 分区：每个元素都与左边界交换，只有满足条件时左边界才前进
+//! \param kOrEqual false：小于 pivot 的放左边；true：小于等于 pivot 的放左边
+//! \return 左边的元素个数
+template <bool kOrEqual, typename _Scalar>
+size_t ScalarPartition(_Scalar *data, size_t n, _Scalar pivot, size_t *num_equal) {
+    size_t left  = 0;
+    size_t equal = 0;
+    for (size_t i = 0; i < n; i++) {
+        _Scalar value = data[i];
+        bool goes_left = kOrEqual ? !(pivot < value) : (value < pivot);
+        equal += (value == pivot);
+        data[i]    = data[left];
+        data[left] = value;
+        left += goes_left;
+    }
+    if (nullptr != num_equal)
+        *num_equal = equal;
+    return left;
+}
+
+template <typename _Scalar>
+void ScalarSortSmall(_Scalar *data, size_t n) { // 插入排序
+    for (size_t i = 1; i < n; i++) {
+        _Scalar value = data[i];
+        size_t j = i;
+        for (; j > 0 && value < data[j - 1]; --j)
+            data[j] = data[j - 1];
+        data[j] = value;
+    }
+}
+
+// 排序网络补齐用的最大值
+template <typename _Scalar>
+_Scalar PaddingValue() {
+    return std::numeric_limits<_Scalar>::has_infinity ? std::numeric_limits<_Scalar>::infinity()
+                                                      : std::numeric_limits<_Scalar>::max();
+}
+
+#ifdef GLIB_SIMD_SORT_X86
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi" // 向量类型作为参数的 ABI 提示，这些函数都会被内联
+
+#define GLIB_TARGET_AVX2   __attribute__((target("avx2")))
+#define GLIB_TARGET_SSE4   __attribute__((target("sse4.2")))
+#define GLIB_ALWAYS_INLINE inline __attribute__((always_inline))
+
+//! \brief 向量重排表：permute 的下标以 unit 为单位（AVX2 为 32 位，SSE 为字节），每个元素占 kUnitsPerLane 个 unit
+//!        compress[mask] 把 mask 中为 1 的元素按顺序放到前面，其他元素按顺序放到后面
+template <size_t kLanes, size_t kUnitsPerLane>
+struct PermuteTable {
+    static const size_t kUnits = kLanes * kUnitsPerLane;
+    alignas(16) uint8_t compress[size_t(1) << kLanes][kUnits];
+
+    PermuteTable() {
+        for (size_t mask = 0; mask < (size_t(1) << kLanes); mask++) {
+            size_t lanes[kLanes];
+            size_t count = 0;
+            for (size_t lane = 0; lane < kLanes; lane++)
+                if (mask & (size_t(1) << lane)) lanes[count++] = lane;
+            for (size_t lane = 0; lane < kLanes; lane++)
+                if (!(mask & (size_t(1) << lane))) lanes[count++] = lane;
+            Units(lanes, compress[mask]);
+        }
+    }
+
+    // 元素下标转换为 unit 下标
+    static void Units(const size_t *lanes, uint8_t *units) {
+        for (size_t i = 0; i < kUnits; i++)
+            units[i] = static_cast<uint8_t>(lanes[i / kUnitsPerLane] * kUnitsPerLane + i % kUnitsPerLane);
+    }
+
+    static const PermuteTable& Get() {
+        static const PermuteTable table;
+        return table;
+    }
+};
+
+//-----------------------------------各个指令集、类型的向量操作------------------------------------
+// 每个结构体提供相同的接口，排序网络、分区内核按照模板参数使用：
+//     Load/Store/Set1、Min/Max、Permute（按下标重排）、Blend（mask 为 1 的元素取 b）、LoadMask（读取 blend 掩码）、
+//     LessMask/LessEqualMask/EqualMask（比较结果转换为整数位掩码）、Compress（按位掩码压缩）
+//     Min(a, b)/Max(a, b) 必须是一次真正的交换：相等时 Min 取 a、Max 取 b。浮点数不能用 min_ps/max_ps，
+//     它们在 -0.0 与 +0.0 比较相等时都返回 b，比较交换之后一个零会被复制、另一个丢失，所以用 b < a 的掩码 blend
+
+struct Avx2Int32 {
+    using Scalar = int32_t;
+    using Vec    = __m256i;
+    using Table  = PermuteTable<8, 1>;
+    static const size_t kLanes = 8;
+
+    GLIB_TARGET_AVX2 static Vec Load(const Scalar *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    GLIB_TARGET_AVX2 static void Store(Scalar *p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    GLIB_TARGET_AVX2 static Vec Set1(Scalar value) { return _mm256_set1_epi32(value); }
+    GLIB_TARGET_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+    GLIB_TARGET_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+    GLIB_TARGET_AVX2 static __m256i Index(const uint8_t *units) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(units)));
+    }
+    GLIB_TARGET_AVX2 static Vec Permute(Vec v, __m256i index) { return _mm256_permutevar8x32_epi32(v, index); }
+    GLIB_TARGET_AVX2 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm256_blendv_epi8(a, b, mask); }
+    GLIB_TARGET_AVX2 static Vec LoadMask(const uint8_t *mask) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(mask)); }
+    GLIB_TARGET_AVX2 static int LessMask(Vec v, Vec pivot) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot, v)));
+    }
+    GLIB_TARGET_AVX2 static int LessEqualMask(Vec v, Vec pivot) {
+        return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivot))) & 0xff;
+    }
+    GLIB_TARGET_AVX2 static int EqualMask(Vec v, Vec pivot) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, pivot)));
+    }
+    GLIB_TARGET_AVX2 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Avx2Float {
+    using Scalar = float;
+    using Vec    = __m256;
+    using Table  = PermuteTable<8, 1>;
+    static const size_t kLanes = 8;
+
+    GLIB_TARGET_AVX2 static Vec Load(const Scalar *p) { return _mm256_loadu_ps(p); }
+    GLIB_TARGET_AVX2 static void Store(Scalar *p, Vec v) { _mm256_storeu_ps(p, v); }
+    GLIB_TARGET_AVX2 static Vec Set1(Scalar value) { return _mm256_set1_ps(value); }
+    GLIB_TARGET_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_blendv_ps(a, b, _mm256_cmp_ps(b, a, _CMP_LT_OQ)); }
+    GLIB_TARGET_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_blendv_ps(b, a, _mm256_cmp_ps(b, a, _CMP_LT_OQ)); }
+    GLIB_TARGET_AVX2 static __m256i Index(const uint8_t *units) { return Avx2Int32::Index(units); }
+    GLIB_TARGET_AVX2 static Vec Permute(Vec v, __m256i index) { return _mm256_permutevar8x32_ps(v, index); }
+    GLIB_TARGET_AVX2 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm256_blendv_ps(a, b, mask); }
+    GLIB_TARGET_AVX2 static Vec LoadMask(const uint8_t *mask) { return _mm256_load_ps(reinterpret_cast<const float*>(mask)); }
+    GLIB_TARGET_AVX2 static int LessMask(Vec v, Vec pivot) { return _mm256_movemask_ps(_mm256_cmp_ps(v, pivot, _CMP_LT_OQ)); }
+    GLIB_TARGET_AVX2 static int LessEqualMask(Vec v, Vec pivot) { return _mm256_movemask_ps(_mm256_cmp_ps(v, pivot, _CMP_LE_OQ)); }
+    GLIB_TARGET_AVX2 static int EqualMask(Vec v, Vec pivot) { return _mm256_movemask_ps(_mm256_cmp_ps(v, pivot, _CMP_EQ_OQ)); }
+    GLIB_TARGET_AVX2 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Avx2Int64 {
+    using Scalar = int64_t;
+    using Vec    = __m256i;
+    using Table  = PermuteTable<4, 2>;
+    static const size_t kLanes = 4;
+
+    GLIB_TARGET_AVX2 static Vec Load(const Scalar *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    GLIB_TARGET_AVX2 static void Store(Scalar *p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    GLIB_TARGET_AVX2 static Vec Set1(Scalar value) { return _mm256_set1_epi64x(value); }
+    GLIB_TARGET_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+    GLIB_TARGET_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+    GLIB_TARGET_AVX2 static __m256i Index(const uint8_t *units) { return Avx2Int32::Index(units); }
+    GLIB_TARGET_AVX2 static Vec Permute(Vec v, __m256i index) { return _mm256_permutevar8x32_epi32(v, index); }
+    GLIB_TARGET_AVX2 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm256_blendv_epi8(a, b, mask); }
+    GLIB_TARGET_AVX2 static Vec LoadMask(const uint8_t *mask) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(mask)); }
+    GLIB_TARGET_AVX2 static int LessMask(Vec v, Vec pivot) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(pivot, v)));
+    }
+    GLIB_TARGET_AVX2 static int LessEqualMask(Vec v, Vec pivot) {
+        return ~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, pivot))) & 0xf;
+    }
+    GLIB_TARGET_AVX2 static int EqualMask(Vec v, Vec pivot) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, pivot)));
+    }
+    GLIB_TARGET_AVX2 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Avx2Double {
+    using Scalar = double;
+    using Vec    = __m256d;
+    using Table  = PermuteTable<4, 2>;
+    static const size_t kLanes = 4;
+
+    GLIB_TARGET_AVX2 static Vec Load(const Scalar *p) { return _mm256_loadu_pd(p); }
+    GLIB_TARGET_AVX2 static void Store(Scalar *p, Vec v) { _mm256_storeu_pd(p, v); }
+    GLIB_TARGET_AVX2 static Vec Set1(Scalar value) { return _mm256_set1_pd(value); }
+    GLIB_TARGET_AVX2 static Vec Min(Vec a, Vec b) { return _mm256_blendv_pd(a, b, _mm256_cmp_pd(b, a, _CMP_LT_OQ)); }
+    GLIB_TARGET_AVX2 static Vec Max(Vec a, Vec b) { return _mm256_blendv_pd(b, a, _mm256_cmp_pd(b, a, _CMP_LT_OQ)); }
+    GLIB_TARGET_AVX2 static __m256i Index(const uint8_t *units) { return Avx2Int32::Index(units); }
+    GLIB_TARGET_AVX2 static Vec Permute(Vec v, __m256i index) {
+        return _mm256_castsi256_pd(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(v), index));
+    }
+    GLIB_TARGET_AVX2 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm256_blendv_pd(a, b, mask); }
+    GLIB_TARGET_AVX2 static Vec LoadMask(const uint8_t *mask) { return _mm256_load_pd(reinterpret_cast<const double*>(mask)); }
+    GLIB_TARGET_AVX2 static int LessMask(Vec v, Vec pivot) { return _mm256_movemask_pd(_mm256_cmp_pd(v, pivot, _CMP_LT_OQ)); }
+    GLIB_TARGET_AVX2 static int LessEqualMask(Vec v, Vec pivot) { return _mm256_movemask_pd(_mm256_cmp_pd(v, pivot, _CMP_LE_OQ)); }
+    GLIB_TARGET_AVX2 static int EqualMask(Vec v, Vec pivot) { return _mm256_movemask_pd(_mm256_cmp_pd(v, pivot, _CMP_EQ_OQ)); }
+    GLIB_TARGET_AVX2 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Sse4Int32 {
+    using Scalar = int32_t;
+    using Vec    = __m128i;
+    using Table  = PermuteTable<4, 4>;
+    static const size_t kLanes = 4;
+
+    GLIB_TARGET_SSE4 static Vec Load(const Scalar *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    GLIB_TARGET_SSE4 static void Store(Scalar *p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    GLIB_TARGET_SSE4 static Vec Set1(Scalar value) { return _mm_set1_epi32(value); }
+    GLIB_TARGET_SSE4 static Vec Min(Vec a, Vec b) { return _mm_min_epi32(a, b); }
+    GLIB_TARGET_SSE4 static Vec Max(Vec a, Vec b) { return _mm_max_epi32(a, b); }
+    GLIB_TARGET_SSE4 static __m128i Index(const uint8_t *units) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(units)); }
+    GLIB_TARGET_SSE4 static Vec Permute(Vec v, __m128i index) { return _mm_shuffle_epi8(v, index); }
+    GLIB_TARGET_SSE4 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm_blendv_epi8(a, b, mask); }
+    GLIB_TARGET_SSE4 static Vec LoadMask(const uint8_t *mask) { return _mm_load_si128(reinterpret_cast<const __m128i*>(mask)); }
+    GLIB_TARGET_SSE4 static int LessMask(Vec v, Vec pivot) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, pivot))); }
+    GLIB_TARGET_SSE4 static int LessEqualMask(Vec v, Vec pivot) {
+        return ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, pivot))) & 0xf;
+    }
+    GLIB_TARGET_SSE4 static int EqualMask(Vec v, Vec pivot) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, pivot))); }
+    GLIB_TARGET_SSE4 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Sse4Float {
+    using Scalar = float;
+    using Vec    = __m128;
+    using Table  = PermuteTable<4, 4>;
+    static const size_t kLanes = 4;
+
+    GLIB_TARGET_SSE4 static Vec Load(const Scalar *p) { return _mm_loadu_ps(p); }
+    GLIB_TARGET_SSE4 static void Store(Scalar *p, Vec v) { _mm_storeu_ps(p, v); }
+    GLIB_TARGET_SSE4 static Vec Set1(Scalar value) { return _mm_set1_ps(value); }
+    GLIB_TARGET_SSE4 static Vec Min(Vec a, Vec b) { return _mm_blendv_ps(a, b, _mm_cmplt_ps(b, a)); }
+    GLIB_TARGET_SSE4 static Vec Max(Vec a, Vec b) { return _mm_blendv_ps(b, a, _mm_cmplt_ps(b, a)); }
+    GLIB_TARGET_SSE4 static __m128i Index(const uint8_t *units) { return Sse4Int32::Index(units); }
+    GLIB_TARGET_SSE4 static Vec Permute(Vec v, __m128i index) {
+        return _mm_castsi128_ps(_mm_shuffle_epi8(_mm_castps_si128(v), index));
+    }
+    GLIB_TARGET_SSE4 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm_blendv_ps(a, b, mask); }
+    GLIB_TARGET_SSE4 static Vec LoadMask(const uint8_t *mask) { return _mm_load_ps(reinterpret_cast<const float*>(mask)); }
+    GLIB_TARGET_SSE4 static int LessMask(Vec v, Vec pivot) { return _mm_movemask_ps(_mm_cmplt_ps(v, pivot)); }
+    GLIB_TARGET_SSE4 static int LessEqualMask(Vec v, Vec pivot) { return _mm_movemask_ps(_mm_cmple_ps(v, pivot)); }
+    GLIB_TARGET_SSE4 static int EqualMask(Vec v, Vec pivot) { return _mm_movemask_ps(_mm_cmpeq_ps(v, pivot)); }
+    GLIB_TARGET_SSE4 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Sse4Int64 {
+    using Scalar = int64_t;
+    using Vec    = __m128i;
+    using Table  = PermuteTable<2, 8>;
+    static const size_t kLanes = 2;
+
+    GLIB_TARGET_SSE4 static Vec Load(const Scalar *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    GLIB_TARGET_SSE4 static void Store(Scalar *p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    GLIB_TARGET_SSE4 static Vec Set1(Scalar value) { return _mm_set1_epi64x(value); }
+    GLIB_TARGET_SSE4 static Vec Min(Vec a, Vec b) { return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b)); }
+    GLIB_TARGET_SSE4 static Vec Max(Vec a, Vec b) { return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b)); }
+    GLIB_TARGET_SSE4 static __m128i Index(const uint8_t *units) { return Sse4Int32::Index(units); }
+    GLIB_TARGET_SSE4 static Vec Permute(Vec v, __m128i index) { return _mm_shuffle_epi8(v, index); }
+    GLIB_TARGET_SSE4 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm_blendv_epi8(a, b, mask); }
+    GLIB_TARGET_SSE4 static Vec LoadMask(const uint8_t *mask) { return _mm_load_si128(reinterpret_cast<const __m128i*>(mask)); }
+    GLIB_TARGET_SSE4 static int LessMask(Vec v, Vec pivot) { return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(pivot, v))); }
+    GLIB_TARGET_SSE4 static int LessEqualMask(Vec v, Vec pivot) {
+        return ~_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(v, pivot))) & 0x3;
+    }
+    GLIB_TARGET_SSE4 static int EqualMask(Vec v, Vec pivot) { return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, pivot))); }
+    GLIB_TARGET_SSE4 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+struct Sse4Double {
+    using Scalar = double;
+    using Vec    = __m128d;
+    using Table  = PermuteTable<2, 8>;
+    static const size_t kLanes = 2;
+
+    GLIB_TARGET_SSE4 static Vec Load(const Scalar *p) { return _mm_loadu_pd(p); }
+    GLIB_TARGET_SSE4 static void Store(Scalar *p, Vec v) { _mm_storeu_pd(p, v); }
+    GLIB_TARGET_SSE4 static Vec Set1(Scalar value) { return _mm_set1_pd(value); }
+    GLIB_TARGET_SSE4 static Vec Min(Vec a, Vec b) { return _mm_blendv_pd(a, b, _mm_cmplt_pd(b, a)); }
+    GLIB_TARGET_SSE4 static Vec Max(Vec a, Vec b) { return _mm_blendv_pd(b, a, _mm_cmplt_pd(b, a)); }
+    GLIB_TARGET_SSE4 static __m128i Index(const uint8_t *units) { return Sse4Int32::Index(units); }
+    GLIB_TARGET_SSE4 static Vec Permute(Vec v, __m128i index) {
+        return _mm_castsi128_pd(_mm_shuffle_epi8(_mm_castpd_si128(v), index));
+    }
+    GLIB_TARGET_SSE4 static Vec Blend(Vec a, Vec b, Vec mask) { return _mm_blendv_pd(a, b, mask); }
+    GLIB_TARGET_SSE4 static Vec LoadMask(const uint8_t *mask) { return _mm_load_pd(reinterpret_cast<const double*>(mask)); }
+    GLIB_TARGET_SSE4 static int LessMask(Vec v, Vec pivot) { return _mm_movemask_pd(_mm_cmplt_pd(v, pivot)); }
+    GLIB_TARGET_SSE4 static int LessEqualMask(Vec v, Vec pivot) { return _mm_movemask_pd(_mm_cmple_pd(v, pivot)); }
+    GLIB_TARGET_SSE4 static int EqualMask(Vec v, Vec pivot) { return _mm_movemask_pd(_mm_cmpeq_pd(v, pivot)); }
+    GLIB_TARGET_SSE4 static Vec Compress(Vec v, int mask, const Table &table) {
+        return Permute(v, Index(table.compress[mask]));
+    }
+};
+
+// 类型对应的向量操作
+template <typename _Scalar> struct SimdOps;
+template <> struct SimdOps<int32_t> { using Avx2 = Avx2Int32;  using Sse4 = Sse4Int32;  };
+template <> struct SimdOps<float>   { using Avx2 = Avx2Float;  using Sse4 = Sse4Float;  };
+template <> struct SimdOps<int64_t> { using Avx2 = Avx2Int64;  using Sse4 = Sse4Int64;  };
+template <> struct SimdOps<double>  { using Avx2 = Avx2Double; using Sse4 = Sse4Double; };
+
+//-----------------------------------双调排序网络------------------------------------------
+
+//! \brief 排序网络中向量内比较交换用的重排下标和 blend 掩码
+//!        flip_*[k] 对应块大小 2^(k+1) 的翻转比较，exchange_*[k] 对应距离 2^k 的比较，掩码为 1 的元素取较大值
+template <typename _Ops>
+struct NetworkTable {
+    using Table = typename _Ops::Table;
+    static const size_t kLanes      = _Ops::kLanes;
+    static const size_t kLaneBytes  = sizeof(typename _Ops::Vec) / kLanes;
+    static const size_t kMaxLevels  = 3; // 每个向量最多 8 个元素
+
+    alignas(32) uint8_t flip_take[kMaxLevels][kLanes * kLaneBytes];
+    alignas(32) uint8_t exchange_take[kMaxLevels][kLanes * kLaneBytes];
+    alignas(16) uint8_t flip_units[kMaxLevels][Table::kUnits];
+    alignas(16) uint8_t exchange_units[kMaxLevels][Table::kUnits];
+    size_t num_levels;
+
+    NetworkTable() : num_levels(0) {
+        for (size_t step = 1; step < kLanes; step *= 2, num_levels++) {
+            size_t flip[kLanes], exchange[kLanes];
+            size_t block = 2 * step;
+            for (size_t lane = 0; lane < kLanes; lane++) {
+                flip[lane]     = lane / block * block + block - 1 - lane % block;
+                exchange[lane] = lane ^ step;
+                uint8_t flip_byte     = (lane % block >= step) ? 0xff : 0; // 块的后一半取较大值
+                uint8_t exchange_byte = (0 != (lane & step)) ? 0xff : 0;
+                memset(flip_take[num_levels] + lane * kLaneBytes, flip_byte, kLaneBytes);
+                memset(exchange_take[num_levels] + lane * kLaneBytes, exchange_byte, kLaneBytes);
+            }
+            Table::Units(flip, flip_units[num_levels]);
+            Table::Units(exchange, exchange_units[num_levels]);
+        }
+    }
+
+    static const NetworkTable& Get() {
+        static const NetworkTable table;
+        return table;
+    }
+};
+
+//! \brief 对 kSize 个元素（2 的幂，至少一个向量）从小到大排序
+//! \method 非交替形式的双调排序：对每个块大小 s = 2、4、...、kSize，先做一次「翻转」比较（i 与块内对称位置比较），
+//!         再做距离为 s/4、s/8、...、1 的半清洁（half-cleaner）比较，每次比较都把较小值放到较小的下标
+//!         距离不小于一个向量时，整个向量之间 min/max；小于一个向量时，向量内 permute 后 min/max，再按掩码 blend
+template <typename _Ops, size_t kSize>
+GLIB_ALWAYS_INLINE void BitonicSort(typename _Ops::Scalar *data) {
+    using Vec = typename _Ops::Vec;
+    const size_t kLanes   = _Ops::kLanes;
+    const size_t kVectors = kSize / kLanes;
+
+    const NetworkTable<_Ops> &table = NetworkTable<_Ops>::Get();
+
+    Vec v[kVectors];
+    for (size_t i = 0; i < kVectors; i++)
+        v[i] = _Ops::Load(data + i * kLanes);
+    const auto reverse = _Ops::Index(table.flip_units[table.num_levels - 1]);
+
+    for (size_t block = 2, level = 0; block <= kSize; block *= 2, level++) {
+        if (block <= kLanes) { // 翻转比较在向量内部
+            auto index = _Ops::Index(table.flip_units[level]);
+            Vec  take  = _Ops::LoadMask(table.flip_take[level]);
+            for (size_t i = 0; i < kVectors; i++) {
+                Vec partner = _Ops::Permute(v[i], index);
+                v[i] = _Ops::Blend(_Ops::Min(v[i], partner), _Ops::Max(partner, v[i]), take);
+            }
+        } else {               // 翻转比较在向量之间：与对称位置的向量比较，对方需要先逆序
+            size_t block_vectors = block / kLanes;
+            for (size_t begin = 0; begin < kVectors; begin += block_vectors) {
+                for (size_t j = 0; j < block_vectors / 2; j++) {
+                    Vec &low  = v[begin + j];
+                    Vec &high = v[begin + block_vectors - 1 - j];
+                    Vec  reversed = _Ops::Permute(high, reverse);
+                    Vec  min_value = _Ops::Min(low, reversed);
+                    high = _Ops::Permute(_Ops::Max(low, reversed), reverse);
+                    low  = min_value;
+                }
+            }
+        }
+        for (size_t distance = block / 4; distance >= 1; distance /= 2) {
+            if (distance >= kLanes) { // 向量之间
+                size_t distance_vectors = distance / kLanes;
+                for (size_t i = 0; i < kVectors; i++) {
+                    if (0 == (i & distance_vectors)) {
+                        Vec min_value = _Ops::Min(v[i], v[i + distance_vectors]);
+                        v[i + distance_vectors] = _Ops::Max(v[i], v[i + distance_vectors]);
+                        v[i] = min_value;
+                    }
+                }
+            } else {                  // 向量内部
+                size_t exchange_level = 0;
+                while ((size_t(1) << exchange_level) < distance)
+                    exchange_level++;
+                auto index = _Ops::Index(table.exchange_units[exchange_level]);
+                Vec  take  = _Ops::LoadMask(table.exchange_take[exchange_level]);
+                for (size_t i = 0; i < kVectors; i++) {
+                    Vec partner = _Ops::Permute(v[i], index);
+                    v[i] = _Ops::Blend(_Ops::Min(v[i], partner), _Ops::Max(partner, v[i]), take);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < kVectors; i++)
+        _Ops::Store(data + i * kLanes, v[i]);
+}
+
+// 元素个数补齐到 2 的幂（至少一个向量），再调用对应大小的排序网络
+template <typename _Ops>
+GLIB_ALWAYS_INLINE void SortSmallKernel(typename _Ops::Scalar *data, size_t n) {
+    using Scalar = typename _Ops::Scalar;
+    const size_t kLanes = _Ops::kLanes;
+    size_t padded = kLanes;
+    while (padded < n)
+        padded *= 2;
+    Scalar buffer[simd::kMaxSmallSort];
+    Scalar *block = data;
+    if (padded != n) {
+        memcpy(buffer, data, n * sizeof(Scalar));
+        for (size_t i = n; i < padded; i++)
+            buffer[i] = PaddingValue<Scalar>();
+        block = buffer;
+    }
+    switch (padded) {
+        case 2:  BitonicSort<_Ops, (2  < kLanes ? kLanes : 2)>(block);  break;
+        case 4:  BitonicSort<_Ops, (4  < kLanes ? kLanes : 4)>(block);  break;
+        case 8:  BitonicSort<_Ops, (8  < kLanes ? kLanes : 8)>(block);  break;
+        case 16: BitonicSort<_Ops, 16>(block); break;
+        case 32: BitonicSort<_Ops, 32>(block); break;
+        default: BitonicSort<_Ops, 64>(block); break;
+    }
+    if (block != data)
+        memcpy(data, buffer, n * sizeof(Scalar));
+}
+
+//-----------------------------------向量化分区------------------------------------------
+
+// 分区一个向量：压缩后整个向量同时写到左右两边，左边前进 num_left，右边后退 kLanes - num_left
+template <typename _Ops, bool kOrEqual>
+GLIB_ALWAYS_INLINE void PartitionVector(const typename _Ops::Vec &v, const typename _Ops::Vec &pivot,
+                                        typename _Ops::Scalar *data, size_t &left_write, size_t &right_write,
+                                        size_t &num_equal, const typename _Ops::Table &table) {
+    int mask = kOrEqual ? _Ops::LessEqualMask(v, pivot) : _Ops::LessMask(v, pivot);
+    if (!kOrEqual)
+        num_equal += __builtin_popcount(_Ops::EqualMask(v, pivot));
+    size_t num_left = __builtin_popcount(mask);
+    typename _Ops::Vec compressed = _Ops::Compress(v, mask, table);
+    _Ops::Store(data + left_write, compressed);
+    _Ops::Store(data + right_write - _Ops::kLanes, compressed);
+    left_write  += num_left;
+    right_write -= _Ops::kLanes - num_left;
+}
+
+//! \brief 原地向量化分区
+//! \method 1）先把两端各一个向量读到寄存器中，此时左右两边各空出一个向量的位置
+//!         2）每次从空闲位置较少的一边读一个向量，保证两边空闲位置都至少有一个向量，压缩后两边各写一个整向量，
+//!            多写的部分只会落在空闲位置中
+//!         3）最后不足一个向量的元素和一开始保存的两个向量放到临时数组中，逐个写到剩余的空闲位置
+template <typename _Ops, bool kOrEqual>
+GLIB_ALWAYS_INLINE size_t PartitionKernel(typename _Ops::Scalar *data, size_t n,
+                                          typename _Ops::Scalar pivot, size_t *num_equal) {
+    using Scalar = typename _Ops::Scalar;
+    using Vec    = typename _Ops::Vec;
+    const size_t kLanes = _Ops::kLanes;
+    if (n < 2 * kLanes)
+        return ScalarPartition<kOrEqual>(data, n, pivot, num_equal);
+
+    const typename _Ops::Table &table = _Ops::Table::Get();
+    const Vec pivot_vec  = _Ops::Set1(pivot);
+    const Vec first_vec  = _Ops::Load(data);
+    const Vec last_vec   = _Ops::Load(data + n - kLanes);
+    size_t left_write  = 0, right_write = n;
+    size_t left_read   = kLanes, right_read = n - kLanes;
+    size_t equal       = 0;
+    while (right_read - left_read >= kLanes) {
+        Vec v;
+        if (left_read - left_write <= right_write - right_read) {
+            v = _Ops::Load(data + left_read);
+            left_read += kLanes;
+        } else {
+            right_read -= kLanes;
+            v = _Ops::Load(data + right_read);
+        }
+        PartitionVector<_Ops, kOrEqual>(v, pivot_vec, data, left_write, right_write, equal, table);
+    }
+
+    Scalar rest[3 * kLanes]; // 剩余的元素个数正好等于空闲位置的个数
+    size_t num_rest = right_read - left_read;
+    memcpy(rest, data + left_read, num_rest * sizeof(Scalar));
+    _Ops::Store(rest + num_rest, first_vec);
+    _Ops::Store(rest + num_rest + kLanes, last_vec);
+    num_rest += 2 * kLanes;
+    for (size_t i = 0; i < num_rest; i++) {
+        Scalar value = rest[i];
+        bool goes_left = kOrEqual ? !(pivot < value) : (value < pivot);
+        equal += (value == pivot);
+        if (goes_left)
+            data[left_write++] = value;
+        else
+            data[--right_write] = value;
+    }
+    if (nullptr != num_equal)
+        *num_equal = equal;
+    return left_write;
+}
+
+// 各个指令集的入口函数，只有这里带 target 属性，内核都内联到这里
+template <typename _Scalar>
+GLIB_TARGET_AVX2 void SortSmallAvx2(_Scalar *data, size_t n) {
+    SortSmallKernel<typename SimdOps<_Scalar>::Avx2>(data, n);
+}
+
+template <typename _Scalar>
+GLIB_TARGET_SSE4 void SortSmallSse4(_Scalar *data, size_t n) {
+    SortSmallKernel<typename SimdOps<_Scalar>::Sse4>(data, n);
+}
+
+template <bool kOrEqual, typename _Scalar>
+GLIB_TARGET_AVX2 size_t PartitionAvx2(_Scalar *data, size_t n, _Scalar pivot, size_t *num_equal) {
+    return PartitionKernel<typename SimdOps<_Scalar>::Avx2, kOrEqual>(data, n, pivot, num_equal);
+}
+
+template <bool kOrEqual, typename _Scalar>
+GLIB_TARGET_SSE4 size_t PartitionSse4(_Scalar *data, size_t n, _Scalar pivot, size_t *num_equal) {
+    return PartitionKernel<typename SimdOps<_Scalar>::Sse4, kOrEqual>(data, n, pivot, num_equal);
+}
+
+#undef GLIB_TARGET_AVX2
+#undef GLIB_TARGET_SSE4
+#undef GLIB_ALWAYS_INLINE
+
+#pragma GCC diagnostic pop
+
+#endif // GLIB_SIMD_SORT_X86
+
+// 根据当前指令集分发
+template <bool kOrEqual, typename _Scalar>
+size_t DispatchPartition(_Scalar *data, size_t n, _Scalar pivot, size_t *num_equal) {
+#ifdef GLIB_SIMD_SORT_X86
+    switch (simd::GetSimdLevel()) {
+        case simd::SimdLevel::AVX2: return PartitionAvx2<kOrEqual>(data, n, pivot, num_equal);
+        case simd::SimdLevel::SSE4: return PartitionSse4<kOrEqual>(data, n, pivot, num_equal);
+        default: break;
+    }
+#endif
+    return ScalarPartition<kOrEqual>(data, n, pivot, num_equal);
+}
+
+} // namespace simd_internal
+
+namespace simd {
+
+//! \brief 对最多 64 个元素从小到大排序
+//! \note 不是稳定排序（对于数值类型没有区别）；n 大于 kMaxSmallSort 时排序网络的缓冲区放不下，改用插入排序
+//! \complexity 排序网络：O(log^2(n)) 层比较交换，没有分支
+template <typename _Scalar>
+typename std::enable_if<IsSimdSortable<_Scalar>::value>::type
+SortSmall(_Scalar *data, size_t n) {
+    if (n < 2)
+        return;
+    if (n > kMaxSmallSort) {
+        simd_internal::ScalarSortSmall(data, n);
+        return;
+    }
+#ifdef GLIB_SIMD_SORT_X86
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2: simd_internal::SortSmallAvx2(data, n); return;
+        case SimdLevel::SSE4: simd_internal::SortSmallSse4(data, n); return;
+        default: break;
+    }
+#endif
+    simd_internal::ScalarSortSmall(data, n);
+}
+
+//! \brief 分区：小于 pivot 的元素放到左边，大于等于 pivot 的元素放到右边（两边内部的顺序不确定）
+//! \param num_equal 不为空时，返回等于 pivot 的元素个数（分区时顺便统计，几乎没有额外开销）
+//! \return 小于 pivot 的元素个数
+//! \complexity O(n)，没有分支预测失败
+template <typename _Scalar>
+typename std::enable_if<IsSimdSortable<_Scalar>::value, size_t>::type
+Partition(_Scalar *data, size_t n, _Scalar pivot, size_t *num_equal = nullptr) {
+    return simd_internal::DispatchPartition<false>(data, n, pivot, num_equal);
+}
+
+//! \brief 分区：小于等于 pivot 的元素放到左边，大于 pivot 的元素放到右边
+//! \return 小于等于 pivot 的元素个数
+template <typename _Scalar>
+typename std::enable_if<IsSimdSortable<_Scalar>::value, size_t>::type
+PartitionLessEqual(_Scalar *data, size_t n, _Scalar pivot) {
+    return simd_internal::DispatchPartition<true>(data, n, pivot, nullptr);
+}
+
+} // namespace simd
+} // namespace glib
+
+#endif // GLIB_SIMD_SORT_HPP_
@@ -0,0 +1,187 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: simd_sort.test.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/10
+ * Description: test SIMD sorting networks, partition kernels and their use in sort.hpp
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "sort.hpp"
+#include <cmath>   // signbit
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm> // std::sort count_if
+#include <limits>
+using namespace std;
+
+namespace {
+
+const char* LevelName(glib::simd::SimdLevel level) {
+    switch (level) {
+        case glib::simd::SimdLevel::AVX2: return "AVX2";
+        case glib::simd::SimdLevel::SSE4: return "SSE4";
+        default:                          return "SCALAR";
+    }
+}
+
+// 数据范围较小时有大量重复元素
+template <typename _Scalar>
+vector<_Scalar> RandomData(mt19937_64 &engine, size_t n, uint64_t range) {
+    vector<_Scalar> data(n);
+    for (auto &value: data)
+        value = static_cast<_Scalar>(static_cast<int64_t>(engine() % range) - static_cast<int64_t>(range / 2));
+    return data;
+}
+
+//! \brief 0 到 66 个元素的排序网络，与 std::sort 的结果对比
+template <typename _Scalar>
+bool TestSortSmall(mt19937_64 &engine) {
+    for (size_t n = 0; n <= glib::simd::kMaxSmallSort + 2; n++) {     // 超过 kMaxSmallSort 时改用插入排序
+        for (uint64_t range: {uint64_t(4), uint64_t(1000), uint64_t(1) << 31}) {
+            vector<_Scalar> data = RandomData<_Scalar>(engine, n, range);
+            if (n > 1) data[0] = numeric_limits<_Scalar>::max();    // 与补齐用的值相同
+            if (n > 2) data[1] = numeric_limits<_Scalar>::lowest();
+            vector<_Scalar> expected(data);
+            std::sort(expected.begin(), expected.end());
+            glib::simd::SortSmall(data.data(), n);
+            if (data != expected) {
+                cout << "  SortSmall error, n = " << n << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//! \brief 分区结果：左边都满足条件、右边都不满足，元素个数、等于 pivot 的个数正确，并且元素没有丢失
+template <typename _Scalar>
+bool TestPartition(mt19937_64 &engine) {
+    for (size_t n: {0, 1, 7, 16, 17, 31, 64, 100, 1000, 65537}) {
+        for (uint64_t range: {uint64_t(3), uint64_t(1000), uint64_t(1) << 31}) {
+            vector<_Scalar> data = RandomData<_Scalar>(engine, n, range);
+            _Scalar pivot = n > 0 ? data[engine() % n] : _Scalar(0);
+            vector<_Scalar> original(data);
+            size_t num_equal = 0;
+            size_t num_less  = glib::simd::Partition(data.data(), n, pivot, &num_equal);
+            size_t expected_less  = count_if(original.begin(), original.end(), [pivot](_Scalar x) { return x < pivot; });
+            size_t expected_equal = count(original.begin(), original.end(), pivot);
+            bool ok = num_less == expected_less && num_equal == expected_equal;
+            for (size_t i = 0; i < n; i++)
+                ok = ok && ((i < num_less) == (data[i] < pivot));
+
+            size_t num_less_equal = glib::simd::PartitionLessEqual(data.data(), n, pivot);
+            ok = ok && num_less_equal == expected_less + expected_equal;
+            for (size_t i = 0; i < n; i++)
+                ok = ok && ((i < num_less_equal) == !(pivot < data[i]));
+
+            std::sort(data.begin(), data.end());
+            std::sort(original.begin(), original.end());
+            if (!ok || data != original) {
+                cout << "  Partition error, n = " << n << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//! \brief 经过 sort.hpp 的内省排序、并行快速排序，包括有序、逆序、全部相等的输入
+//! \note 快速排序以最后一个值为分界点，有序、重复输入会退化为 O(n^2)，所以只测试随机输入
+template <typename _Scalar>
+bool TestSortOptions(mt19937_64 &engine, glib::utils::ThreadPool &pool) {
+    vector<vector<_Scalar>> inputs;
+    inputs.push_back(RandomData<_Scalar>(engine, 100000, 1u << 31));
+    inputs.push_back(RandomData<_Scalar>(engine, 100000, 10));
+    inputs.push_back(RandomData<_Scalar>(engine, 50000, 1u << 31));
+    std::sort(inputs.back().begin(), inputs.back().end());
+    inputs.push_back(vector<_Scalar>(inputs.back().rbegin(), inputs.back().rend()));
+    inputs.push_back(vector<_Scalar>(50000, _Scalar(7)));
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const vector<_Scalar> &input = inputs[i];
+        vector<_Scalar> expected(input);
+        std::sort(expected.begin(), expected.end());
+
+        vector<_Scalar> intro(input), quick(input), parallel(input);
+        glib::Sort(intro.begin(), intro.end(), glib::SortOption::INTRO);
+        if (0 == i)
+            glib::Sort(quick.data(), quick.data() + quick.size(), std::less<_Scalar>(), glib::SortOption::QUICK);
+        else
+            quick = expected;
+        glib::ParallelSort(parallel.begin(), parallel.end(), std::less<_Scalar>(), pool,
+                           glib::SortOption::PARALLEL_QUICK);
+        if (intro != expected || quick != expected || parallel != expected) {
+            cout << "  Sort error" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+//! \brief 只有 -0.0、+0.0（以及少量其他值）的输入：排序网络、glib::Sort 之后负零的个数不变（元素没有被复制或丢失）
+template <typename _Scalar>
+bool TestSignedZero(mt19937_64 &engine) {
+    auto negative_zeros = [](const vector<_Scalar> &data) {
+        return count_if(data.begin(), data.end(), [](_Scalar x) { return 0 == x && signbit(x); });
+    };
+    for (int round = 0; round < 2000; round++) {
+        size_t n = engine() % (glib::simd::kMaxSmallSort + 1);
+        vector<_Scalar> data(n);
+        for (auto &value: data)
+            value = 0 == engine() % 8 ? _Scalar(engine() % 3) - 1 : (engine() % 2 ? _Scalar(-0.0) : _Scalar(0.0));
+        vector<_Scalar> small(data), sorted(data);
+        glib::simd::SortSmall(small.data(), n);
+        glib::Sort(sorted.begin(), sorted.end(), glib::SortOption::INTRO);
+        if (negative_zeros(small) != negative_zeros(data) || negative_zeros(sorted) != negative_zeros(data) ||
+            !is_sorted(small.begin(), small.end()) || !is_sorted(sorted.begin(), sorted.end())) {
+            cout << "  signed zero error, n = " << n << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename _Scalar>
+bool TestType(mt19937_64 &engine, glib::utils::ThreadPool &pool) {
+    return TestSortSmall<_Scalar>(engine) && TestPartition<_Scalar>(engine) && TestSortOptions<_Scalar>(engine, pool);
+}
+
+} // namespace
+
+//! \brief SIMD 排序内核测试：依次强制使用 AVX2、SSE4、标量实现（超过 CPU 支持的级别时自动降级），
+//!        结果都与 std::sort 对比
+//! \run
+//!     g++ simd_sort.test.cc -std=c++11 -O2 -pthread && ./a.out
+int main(int argc, char const *argv[]) {
+    mt19937_64 engine(2019);
+    glib::utils::ThreadPool pool(4);
+    cout << "detected: " << LevelName(glib::simd::DetectSimdLevel()) << endl;
+    bool all_ok = true;
+    for (auto level: {glib::simd::SimdLevel::AVX2, glib::simd::SimdLevel::SSE4, glib::simd::SimdLevel::SCALAR}) {
+        glib::simd::SetSimdLevel(level);
+        cout << LevelName(glib::simd::GetSimdLevel()) << endl;
+        bool ok_int32  = TestType<int32_t>(engine, pool);
+        bool ok_int64  = TestType<int64_t>(engine, pool);
+        bool ok_float  = TestType<float>(engine, pool) && TestSignedZero<float>(engine);
+        bool ok_double = TestType<double>(engine, pool) && TestSignedZero<double>(engine);
+        cout << " int32 "  << (ok_int32  ? "ok" : "error")
+             << " int64 "  << (ok_int64  ? "ok" : "error")
+             << " float "  << (ok_float  ? "ok" : "error")
+             << " double " << (ok_double ? "ok" : "error") << endl;
+        all_ok = all_ok && ok_int32 && ok_int64 && ok_float && ok_double;
+    }
+
+    // 浮点数的正负无穷、负零
+    glib::simd::SetSimdLevel(glib::simd::DetectSimdLevel());
+    vector<double> special = {3.5, -0.0, numeric_limits<double>::infinity(), 0.0, -1e300,
+                              -numeric_limits<double>::infinity(), 1e-300, 2.0};
+    glib::simd::SortSmall(special.data(), special.size());
+    bool special_ok = is_sorted(special.begin(), special.end());
+    cout << "infinity " << (special_ok ? "ok" : "error") << endl;
+
+    return (all_ok && special_ok) ? 0 : 1;
+}
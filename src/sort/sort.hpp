@@ -11,42 +11,72 @@
 
 #ifndef GLIB_SORT_HPP_
 #define GLIB_SORT_HPP_
-#include <cstddef> // 定义了 size_t 类型
+#include <cstddef>     // 定义了 size_t 类型
+#include <cstdint>     // uint32_t、uint64_t
+#include <cstring>     // memcpy
+#include <cmath>       // log、exp、sqrt、pow
 #include <vector>
 #include <assert.h>
 #include <iostream>
 #include <algorithm>
+#include <iterator>    // iterator_traits、make_move_iterator
+#include <memory>      // unique_ptr
+#include <random>      // mt19937_64
+#include <string>
+#include <functional>  // std::less
+#include <type_traits> // enable_if、is_same
+#include <utility>     // std::move
+#include "../utils/thread_pool.hpp" // 并行排序使用的任务窃取线程池
+#include "simd_sort.hpp"                // 排序网络、向量化分区
 
 namespace glib {
 using namespace std;
 
-//! \brief 简单实现一些排序算法：冒泡排序、插入排序、选择排序、快速排序、归并排序、计数排序
+//! \brief 简单实现一些排序算法：冒泡排序、插入排序、选择排序、快速排序、归并排序、内省排序、计数排序、基数排序、
+//!        桶排序（样本排序）
 //!        以及一个应用实例，在 O(n) 复杂度下，在数组中找到第 k 大元素。
 //!      核心函数：
 //!         1）第一类排序算法（O(n^2)）：冒泡排序、插入排序、选择排序（稳定版本、不稳定版本）
 //!             对应函数：Bubble、Insertion、SelectionStable、SelectionUnstable
-//!         2）第二类排序算法（O(nlog(n))）：快速排序、归并排序
-//!             对应函数：QuickSort、MergeSort
-//!         3）第三类排序算法（O(n)）：计数排序
-//!             对应函数：CountingSort
-//!         4）利用快排思路，在数组中找到第 k 大元素
-//!             对应函数： QuickFind
+//!         2）第二类排序算法（O(nlog(n))）：快速排序、归并排序、内省排序
+//!             对应函数：QuickSort、MergeSort、IntroSort
+//!            以及利用数据中有序部分的自然归并排序：TIM 排序（稳定，部分有序的数据接近 O(n)）
+//!             对应函数：TimSort
+//!            以及对应的多线程版本：并行归并排序、并行快速排序
+//!             对应函数：ParallelMergeSort、ParallelQuickSort
+//!         3）第三类排序算法（O(n)）：计数排序、基数排序（整数、浮点数 LSD，字符串 MSD）
+//!             对应函数：CountingSort、RadixSort
+//!            以及桶排序：用随机样本确定桶的边界（样本排序），数据分布不均匀时每个桶的大小也比较均衡
+//!             对应函数：SampleSort
+//!         4）利用快排思路，在数组中找到第 k 小/第 k 大元素（introselect + Floyd-Rivest），以及并行版本
+//!             对应函数：SelectBase、ParallelSelectBase
 //!
 //!      外部调用接口：
-//!         1）排序函数：Sort。通过设置排序算法选项选择不同的排序算法
-//!         2）在数组中查找第 k 大元素：FindKthBigElement
+//!         1）排序函数：Sort。通过设置排序算法选项选择不同的排序算法，默认使用内省排序
+//!            支持 vector 以及任意随机访问迭代器区间（deque、裸指针等），可以传入比较函数
+//!         2）按照某个键值排序：SortByKey。传入键值提取函数，可以同时传入键值的比较函数
+//!         3）指定线程池的并行排序：ParallelSort。Sort 中的并行选项使用全局共享线程池。
+//!            ParallelSort 传入 BUCKET 时，各个桶在线程池中并行排序
+//!         4）在数组中查找第 k 大元素：FindKthBigElement
+//!         5）选择第 k 小的元素、部分排序、Top-K：Select、PartialSort、TopK、StreamingTopK，
+//!            以及并行版本：ParallelSelect、ParallelTopK
 //!
 //! \Note
 //!      1）最底部是外部调用的接口，类内部是相应功能的详细实现细节
-//!      2）目前的实现版本是从小到大排序。没有进行大到小的转换
-//!      3）该排序算法输入仅仅支持 vector，若是要排序其他类型，需要进行转换为 vector 元素
-//!      4）对于计数排序，目前实现版本，仅仅支持整数 vector，对于其他可以转换为整数类型的数据，
-//!         需要自己转换为整数后在调用计数排序。并且需要知道计数排序适合什么类型的问题。参考「排序」笔记
-//!
-//! \TODO
-//!     1）桶排序、基数排序的基本实现，
-//!     2) 将下面排序实现版本改进，使其适用从大到小的排序
-//!     3）转换为 stl 接口形式。可以接受一个外部的谓语。比较 Key 值来排序类元素！
+//!      2）所有排序算法都是模板化的迭代器 + 比较函数形式，比较函数作为模板参数传入，可以被编译器内联，
+//!         没有 std::function 的开销，并且直接在原区间上排序，不需要先拷贝到 vector 中
+//!      3）比较函数 comp(a, b) 的含义与 std::sort 一致：a 应该排在 b 前面时返回 true（严格弱序）。
+//!         默认是 std::less，即从小到大排序；传入 std::greater 即可从大到小排序
+//!      4）计数排序仅仅用于 int 且从小到大排序、数据范围不超过数据个数的情况，不满足时自动改用基数排序。
+//!         基数排序支持整数、float、double（comp 为 std::less/std::greater）以及 string（std::less/std::greater），
+//!         其他类型或者自定义比较函数自动改用内省排序，所以 COUNTING、RADIX 对任意输入都能得到正确结果
+//!      5）快速排序以最后一个元素为分界点，对于有序、全部相等的数据会退化为 O(n^2)，并且递归深度为 O(n)，
+//!         数据量大时会栈溢出。一般情况下使用内省排序（INTRO），最坏情况也是 O(nlog(n))
+//!      6）并行排序（PARALLEL_MERGE、PARALLEL_QUICK）要求比较函数可以在多个线程中同时调用。
+//!         并行归并排序是稳定排序，只申请一块与输入等长的辅助空间，两块空间交替（ping-pong）作为归并的输入输出
+//!      7）int32_t、int64_t、float、double 在连续内存中（指针、vector 迭代器）并且 comp 为 std::less 时，
+//!         内省排序、快速排序、并行快速排序的分区改用 SIMD 向量化分区，小于等于 64 个元素的区间改用排序网络，
+//!         运行时检测 AVX2/SSE4.2，都不支持时使用标量实现（见 simd_sort.hpp）
 //!
 //! \conclusion
 //!     1）在数值排序时，推荐使用插入排序(二分形式)。其次是不稳定的选择排序。
@@ -55,9 +85,35 @@ using namespace std;
 //!          插入排序 > 选择排序 > 冒泡排序。倍数关系依次为 5 倍、2 倍
 //!          在插入排序中，自己的实现方式：二分查找 > 后向比较 > 前向比较。依次相差 50ms、20ms
 //!          在选择排序中，自己实现方式：不稳定选择排序 > 稳定选择排序(类似冒泡)。约为 2 倍的关系
+//!     3）内省排序 = 快排（三数取中/九数取中 + 三路分区）+ 堆排序（递归过深时）+ 插入排序（小区间）。
+//!        对于已经有序、逆序、大量重复的数据，不会再像上面的快排一样退化
+//!     4）并行排序的加速比可以运行 parallel_sort_benchmark.cc 查看。并行快排最顶层的分区是单线程的，
+//!        所以加速比要低于并行归并排序；并行归并排序需要 O(n) 的额外空间
+//!     5）基数排序对 64 位整数只需要 4~8 趟线性扫描，所有数据某一位都相同时（比如 id 的高位都是 0）会跳过这一趟
+//!     6）桶排序（样本排序）不依赖数据的取值范围，时间戳、延迟这种范围很大、分布倾斜的数据，
+//!        桶的大小也比较均衡；每个桶的大小接近 L2 缓存，桶内排序基本都在缓存中完成
+//!     7）TIM 排序对由少数几段有序数据组成的输入（比如有序日志后追加一段数据）接近 O(n)；
+//!        只是随机交换了少量元素的数据没有长的有序段，TIM 并不比归并排序快（见下面的测试结果）
+//!     8）所有排序选项在不同分布、规模、元素类型下的耗时、比较次数、移动次数、内存分配次数，
+//!        可以运行 sort_benchmark.cc 得到（CSV/JSON 格式），修改排序实现前后各运行一次对比即可发现性能退化
+//!     9）sort_benchmark.cc 的测试结果（ns/元素，越小越好），Intel Xeon（虚拟机，支持 AVX2）、g++ 12.2.0 -O2，
+//!        ./sort_benchmark --sizes=1000000 --types=int32,int64,double --distributions=random,nearly_sorted --repeat=3：
+//!                                 INTRO   RADIX   MERGE     TIM   std::sort   std::stable_sort
+//!          int32  random           25.9    17.4    93.6   103.2        80.3              117.8
+//!          int64  random           52.1    45.0    96.2   108.3        88.3              118.2
+//!          double random           42.7    42.7   119.1   119.5        99.3              122.1
+//!          int64  nearly_sorted    25.2    35.8    18.6    27.2        15.0               23.2
+//!        INTRO 的分区和小区间排序使用 AVX2（见 Note 7），随机 int32 比 std::sort 快 3 倍左右，int64/double 快 2 倍左右
 //!
 //! \platform
 //!      ubuntu16.04 g++ version 5.4.0
+//!
+//! \example
+//!      deque<Record> records;
+//!      glib::Sort(records.begin(), records.end(),
+//!                 [](const Record &a, const Record &b) { return a.id < b.id; });
+//!      glib::SortByKey(records.begin(), records.end(),
+//!                      [](const Record &r) { return r.timestamp; }, std::greater<int64_t>());
 
 
 // 选择某个排序方法
@@ -67,9 +123,159 @@ enum class SortOption {
     SELECTION,
     MERGE,
     QUICK,
-    COUNTING
+    INTRO,
+    COUNTING,
+    RADIX,
+    BUCKET,
+    PARALLEL_MERGE,
+    PARALLEL_QUICK,
+    TIM
 };
 
+namespace sort_internal {
+    const size_t kInsertionSortThreshold = 16;  // 内省排序中，区间长度小于等于该值时直接用插入排序
+    const size_t kNintherThreshold       = 128; // 区间长度大于该值时用九数取中，否则三数取中
+    const size_t kMergeInsertionThreshold = 32;      // 并行归并排序中，小于等于该值的区间直接插入排序
+    const size_t kParallelSortCutoff      = 1 << 14; // 并行排序中，小于等于该值的区间不再派生任务
+    const size_t kParallelMergeGrain      = 1 << 14; // 并行合并时，每个任务至少合并的元素个数
+    const size_t kRadixSortThreshold      = 256;     // 基数排序中，数据个数小于等于该值时直接用内省排序
+    const size_t kStringInsertionThreshold = 32;     // 字符串 MSD 基数排序中，小于等于该值的桶直接插入排序
+    const size_t kSampleBucketBytes       = 1 << 17; // 样本排序中每个桶的目标大小（字节），大约为 L2 缓存的一半
+    const size_t kSampleMinBucketSize     = 256;     // 样本排序中每个桶的最少元素个数
+    const size_t kSampleOversampling      = 16;      // 样本排序中每个桶对应的样本个数
+    const size_t kSampleMaxLogBuckets     = 10;      // 样本排序中一次最多分 2^10 个桶
+    const size_t kSimdSortThreshold       = simd::kMaxSmallSort; // 可以用 SIMD 时，小于等于该值的区间直接用排序网络
+    const ptrdiff_t kFloydRivestThreshold = 600;     // 快速选择中，区间长度大于该值时用 Floyd-Rivest 选择分界点
+    const size_t kSelectMinSamples        = 1024;    // 并行选择中最少的样本个数
+    const size_t kTimMinMerge             = 64;      // TIM 排序中，小于该值的区间直接插入排序
+    const ptrdiff_t kTimMinGallop         = 7;       // TIM 排序中，连续从同一个顺串取这么多个元素后进入跳跃模式
+    const size_t kTimMaxRuns              = 85;      // TIM 排序顺串栈的最大深度，满足栈的不变式时 2^64 个元素也足够
+
+    //! \brief 把键值提取函数和键值比较函数组合成元素的比较函数
+    //! \note 两个函数都是按值保存的函数对象，调用时可以被内联
+    template <typename _KeyExtractor, typename _Compare>
+    struct KeyCompare {
+        _KeyExtractor key;
+        _Compare      comp;
+
+        template <typename _T>
+        bool operator()(const _T &first, const _T &second) const {
+            return comp(key(first), key(second));
+        }
+    };
+
+    //! \brief 基数排序的键值转换：把数值映射为无符号整数，并且无符号整数的大小顺序与原来的顺序一致
+    //! \note 1）有符号整数：符号位取反
+    //!       2）IEEE-754 浮点数：正数符号位取反，负数所有位取反（负数越小，二进制表示越大）
+    //!       3）小于 32 位的类型也用 32 位键值，只对低 kKeyBits 位排序
+    template <typename _Scalar, bool = is_floating_point<_Scalar>::value>
+    struct RadixKey { // 整数
+        using KeyType  = typename conditional<sizeof(_Scalar) <= 4, uint32_t, uint64_t>::type;
+        using Unsigned = typename make_unsigned<_Scalar>::type;
+        static const size_t  kKeyBits = sizeof(_Scalar) * 8;
+        static const KeyType kSignBit = is_signed<_Scalar>::value ? KeyType(1) << (kKeyBits - 1) : 0;
+
+        static KeyType ToKey(_Scalar value) { return KeyType(static_cast<Unsigned>(value)) ^ kSignBit; }
+        static _Scalar FromKey(KeyType key) { return static_cast<_Scalar>(static_cast<Unsigned>(key ^ kSignBit)); }
+    };
+
+    template <typename _Scalar>
+    struct RadixKey<_Scalar, true> { // float、double
+        using KeyType = typename conditional<sizeof(_Scalar) == 4, uint32_t, uint64_t>::type;
+        static const size_t  kKeyBits = sizeof(_Scalar) * 8;
+        static const KeyType kSignBit = KeyType(1) << (kKeyBits - 1);
+
+        static KeyType ToKey(_Scalar value) {
+            KeyType bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return (bits & kSignBit) ? ~bits : (bits | kSignBit);
+        }
+        static _Scalar FromKey(KeyType key) {
+            KeyType bits = (key & kSignBit) ? (key & ~kSignBit) : ~key;
+            _Scalar value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    };
+
+    // 基数排序支持的数据类别
+    enum class RadixKind { UNSUPPORTED, NUMBER, STRING };
+
+    //! \brief 判断数据类型、比较函数组合能否用基数排序，以及排序方向
+    //! \note 只识别 std::less、std::greater，其他比较函数无法知道对应的键值顺序
+    template <typename _Scalar, typename _Compare>
+    struct RadixTraits {
+        static const RadixKind kKind       = RadixKind::UNSUPPORTED;
+        static const bool      kDescending = false;
+    };
+
+    template <typename _Scalar>
+    struct RadixKindOf {
+        static const RadixKind kKind =
+            is_same<_Scalar, string>::value ? RadixKind::STRING :
+            ((is_integral<_Scalar>::value && !is_same<_Scalar, bool>::value) ||
+              is_same<_Scalar, float>::value || is_same<_Scalar, double>::value) ? RadixKind::NUMBER
+                                                                                 : RadixKind::UNSUPPORTED;
+    };
+
+    template <typename _Scalar>
+    struct RadixTraits<_Scalar, std::less<_Scalar>> {
+        static const RadixKind kKind       = RadixKindOf<_Scalar>::kKind;
+        static const bool      kDescending = false;
+    };
+
+    template <typename _Scalar>
+    struct RadixTraits<_Scalar, std::greater<_Scalar>> {
+        static const RadixKind kKind       = RadixKindOf<_Scalar>::kKind;
+        static const bool      kDescending = true;
+    };
+
+    //! \brief 判断能否使用 SIMD 内核：数据在连续内存中（指针或者 vector 迭代器）、类型为 int32_t/int64_t/float/double、
+    //!        比较函数为 std::less（其他比较函数无法知道对应的向量比较指令）
+    template <typename _RandomIt, typename _Compare>
+    struct UseSimdSort {
+        using ValueType = typename iterator_traits<_RandomIt>::value_type;
+        static const bool value = simd::IsSimdSortable<ValueType>::value &&
+                                  is_same<_Compare, std::less<ValueType>>::value &&
+                                  (is_same<_RandomIt, ValueType*>::value ||
+                                   is_same<_RandomIt, typename vector<ValueType>::iterator>::value);
+    };
+
+    template <typename _RandomIt, typename _Compare>
+    using SimdTag = integral_constant<bool, UseSimdSort<_RandomIt, _Compare>::value>;
+
+    //! \brief TIM 排序的状态：等待合并的顺串栈、唯一的合并缓冲区、跳跃模式的阈值
+    //! \note 缓冲区只在合并时按需增长（vector::assign 复用已有容量），大部分有序的数据缓冲区一直很小
+    template <typename _Scalar>
+    struct TimState {
+        vector<_Scalar> buffer;
+        ptrdiff_t       min_gallop = kTimMinGallop;
+        size_t          num_runs   = 0;
+        size_t          run_base[kTimMaxRuns];   // 每个顺串的起点
+        size_t          run_length[kTimMaxRuns]; // 每个顺串的长度
+    };
+
+    // 交换参数顺序的比较函数：comp 从小到大时，它从大到小
+    template <typename _Compare>
+    struct ReverseCompare {
+        _Compare comp;
+
+        template <typename _T>
+        bool operator()(const _T &first, const _T &second) const {
+            return comp(second, first);
+        }
+    };
+} // namespace sort_internal
+
+// 排序接口声明，默认参数只能在这里给出（友元声明中不能带默认参数）
+template <typename _RandomIt, typename _Compare>
+void Sort(_RandomIt first, _RandomIt last, _Compare comp,
+          const SortOption option = SortOption::INTRO);
+
+template <typename _RandomIt, typename _Compare>
+void ParallelSort(_RandomIt first, _RandomIt last, _Compare comp, utils::ThreadPool &pool,
+                  const SortOption option = SortOption::PARALLEL_QUICK);
+
 // 打印当前数组元素顺序值
 template <typename _Scalar>
 void SortDebug(const vector<_Scalar> &array) {
@@ -78,29 +284,31 @@ void SortDebug(const vector<_Scalar> &array) {
     cout << endl;
 }
 
-// 排序算法详细实现---冒泡排序、插入排序、选择排序、归并排序、快速排序
+// 排序算法详细实现---冒泡排序、插入排序、选择排序、归并排序、快速排序、内省排序、计数排序、基数排序、桶排序
+// 所有函数都作用在随机访问迭代器区间 [first, last) 上，comp 为严格弱序比较函数
 class SortDetail {
+friend class SortAppDetail; // 查找第 k 个元素等应用复用这里的分区、插入排序
 
-template <typename _Scalar>
-friend void Sort(vector<_Scalar> &array, const SortOption option = SortOption::INSERTION);
+template <typename _RandomIt, typename _Compare>
+friend void Sort(_RandomIt first, _RandomIt last, _Compare comp, const SortOption option);
+template <typename _RandomIt, typename _Compare>
+friend void ParallelSort(_RandomIt first, _RandomIt last, _Compare comp, utils::ThreadPool &pool,
+                         const SortOption option);
 
 //-----------------------------冒泡排序-----------------------------------------------
 
 //! \brief 一个冒泡排序简单实现
 //! \complexity 最好：O(n) 最坏：O(n^2) 平均：O(n^2)
-template <typename _Scalar>
-void Bubble(vector<_Scalar> &array) {
+template <typename _RandomIt, typename _Compare>
+void Bubble(_RandomIt first, _RandomIt last, _Compare comp) {
     // cout << "Bubble Sort" << endl;
-    assert(array.size() != 0);
-    auto n = array.size();
-    for (size_t i = 0; i < n; i++) {
+    auto n = last - first;
+    for (decltype(n) i = 0; i < n; i++) {
         bool success_sort = false;
-        for (size_t j = 0; j < n - 1 - i; j++) {
-            if (array[j] > array[j+1]) {
-                // 满足交换顺序，可以直接交换
-                _Scalar temp = array[j];
-                array[j]     = array[j+1];
-                array[j+1]   = temp;
+        for (decltype(n) j = 0; j < n - 1 - i; j++) {
+            if (comp(first[j+1], first[j])) {
+                // 满足交换顺序，可以直接交换。严格小于才交换，保证稳定
+                std::iter_swap(first + j, first + j + 1);
                 success_sort = true;
             }
         }
@@ -115,70 +323,44 @@ void Bubble(vector<_Scalar> &array) {
 //!       可以分别注释下面的三种遍历方式 1)二分查找方式 2）前向遍历 3）后向遍历 看看不同的效果对应的时间
 //! \complexity 最好：O(n) 最坏：O(n^2) 平均：O(n^2)
 //! \conclusion经过测试 二分查找方式执行时间最短。是因为交换移动次数是固定的，只要比较的次数少一些。时间就会少！
-template <typename _Scalar>
-void Insertion(vector<_Scalar> &array) {
+template <typename _RandomIt, typename _Compare>
+void Insertion(_RandomIt first, _RandomIt last, _Compare comp) {
     // cout << "Insertion Sort" << endl;
-    assert(array.size() != 0);
-    auto n = array.size();
-    if (1 == n) return;
+    if (last - first < 2) return;
 
     // 查找插入方法用的是从头到尾的方法
-    for (size_t separate_point = 1; separate_point < n; ++separate_point) {
-        auto separate_point_value = array[separate_point];
+    for (auto separate_point = first + 1; separate_point != last; ++separate_point) {
+        auto separate_point_value = std::move(*separate_point);
         //------分割线---------------
         // 1)利用二分查找方式:从前到后 。这种方式的运行效率最高。比下面的尾到头的方式时间要短了 50 ms
-        size_t low_limit = 0;
-        size_t up_limit = separate_point - 1;
-        // size_t middle = (low_limit + up_limit)/2;
-        size_t middle = low_limit + (up_limit - low_limit)/2;
-        while (low_limit <= up_limit) { // 二分查找
-            if ((0 == middle && array[middle] > separate_point_value) || // 保证稳定排序，只有大于当前 separate_point 对应的值才会交换
-                (middle >= 1 &&
-                array[middle] > separate_point_value &&
-                array[middle-1] <= separate_point_value)) {
-                // 插入第一个位置或者中间某个位置，交换
-                auto temp_value = array[separate_point];
-                for (size_t j = separate_point; j > middle; --j)
-                    array[j] = array[j-1];
-                array[middle] = temp_value;
-                break;
-            }
-
-            if (array[middle] <= separate_point_value) { // 保证稳定排序
+        //   找到第一个「大于」当前值的位置，相等的元素不越过，保证稳定排序
+        auto low_limit = first;
+        auto up_limit  = separate_point;
+        while (low_limit < up_limit) { // 二分查找
+            auto middle = low_limit + (up_limit - low_limit)/2;
+            if (comp(separate_point_value, *middle))
+                up_limit  = middle;
+            else
                 low_limit = middle + 1;
-            } else {
-                up_limit  = middle - 1;
-            }
-            middle = low_limit + (up_limit - low_limit)/2;
-            // middle = (low_limit + up_limit)/2;
         }
+        // 插入第一个位置或者中间某个位置，后面的元素整体后移一位
+        std::move_backward(low_limit, separate_point, separate_point + 1);
+        *low_limit = std::move(separate_point_value);
 
         // 2)遍历循环查找：从头到尾。实现的方式效率最低。
-        // for (size_t i = 0; i < separate_point; ++i) { // 遍历查找复杂度高，因为假定前面已经是有序的了，所以可以使用二分查找
-        //     if (separate_point_value < array[i]) {
-        //         // 交换位置
-        //         auto temp_value = array[separate_point];
-        //         for (size_t j = separate_point; j > i ; --j)
-        //             array[j] = array[j-1];
-        //         array[i] = temp_value;
+        // for (auto i = first; i != separate_point; ++i) { // 遍历查找复杂度高，因为假定前面已经是有序的了，所以可以使用二分查找
+        //     if (comp(separate_point_value, *i)) {
+        //         std::move_backward(i, separate_point, separate_point + 1);
+        //         *i = std::move(separate_point_value);
         //         break; // 交换完成后直接退出当前循环
         //     }
         // }
 
         // 3)遍历循环查找：从尾到头，一遍比较一遍交换。当前实现的效率不是最高的。比上面第 2 中方式高些。1000 个数句差了 20 ms 左右
-        // int i = separate_point - 1;
-        // for (; i >= 0 ; --i) {
-        //     if (array[i] > separate_point_value) // 向后移动一位
-        //         array[i+1] = array[i];
-        //     else
-        //         break;
-        // }
-        // array[i+1] = separate_point_value;
-
-        // debug
-        // 每次排序完成，打印一下顺序
-        // cout << "separate_point: " << separate_point << " and its value: " << separate_point_value << endl;
-        // SortDebug(array);
+        // auto i = separate_point;
+        // for (; i != first && comp(separate_point_value, *(i-1)); --i) // 向后移动一位
+        //     *i = std::move(*(i-1));
+        // *i = std::move(separate_point_value);
     }
 }
 
@@ -188,21 +370,18 @@ void Insertion(vector<_Scalar> &array) {
 //! \note 该选择排序是稳定版,下面的实现方式，本质上与冒泡排序一致。是一个稳定的选择排序
 //! \complexity 最好：O(n^2) 最坏：O(n^2) 平均：O(n^2)
 //! \method从剩下的未排序数组中找到最小值，然后放到已排序序列的后面。
-template <typename _Scalar>
-void SelectionStable(vector<_Scalar> &array) {
-    assert(array.size() != 0);
+template <typename _RandomIt, typename _Compare>
+void SelectionStable(_RandomIt first, _RandomIt last, _Compare comp) {
     // cout << "Selection Sort" << endl;
 
     // 需要遍历 n 次，每次寻找一个最小值。可以从后向前遍历。一边遍历一边交换顺序，实际上是上面插入排序以及冒泡排序实现的思路。
-    for (size_t i = 0; i < array.size(); ++i) {
-        int j = array.size() - 1;
+    auto n = last - first;
+    for (decltype(n) i = 0; i < n; ++i) {
         bool success_sort = false;
-        for (; j > i; --j) { // 在剩下的未排序数组中找到最小值
-            if (array[j] < array[j-1]) {
-                auto temp_value = array[j-1];
-                array[j-1]      = array[j];
-                array[j]        = temp_value;
-                success_sort    = true;
+        for (auto j = n - 1; j > i; --j) { // 在剩下的未排序数组中找到最小值
+            if (comp(first[j], first[j-1])) {
+                std::iter_swap(first + j - 1, first + j);
+                success_sort = true;
             }
         }
         if (!success_sort) return;
@@ -212,22 +391,19 @@ void SelectionStable(vector<_Scalar> &array) {
 //! \brief 一个不稳定的选择排序
 //! \complexity 最好：O(n) 最坏：O(n^2) 平均：O(n^2)
 //! \conclusion 其时间要比上面的稳定选择排序快。仅仅针对数值内置类型。
-template <typename _Scalar>
-void SelectionUnstable(vector<_Scalar> &array) {
-    assert(array.size() != 0);
+template <typename _RandomIt, typename _Compare>
+void SelectionUnstable(_RandomIt first, _RandomIt last, _Compare comp) {
     // cout << "Unstable Selection" << endl;
-    for (size_t i = 0; i < array.size() - 1; ++i) {
+    if (last - first < 2) return;
+    for (auto i = first; i != last - 1; ++i) {
         auto min_index = i;
-        for (size_t j = i + 1; j < array.size(); ++j) {
-            if (array[j] < array[min_index])
+        for (auto j = i + 1; j != last; ++j) {
+            if (comp(*j, *min_index))
                 min_index = j;
         }
         // 交换元素
-        if (min_index != i) {
-            auto temp_value  = array[min_index];
-            array[min_index] = array[i];
-            array[i]         = temp_value;
-        }
+        if (min_index != i)
+            std::iter_swap(min_index, i);
     }
 }
 
@@ -278,53 +454,39 @@ void SelectionUnstable(vector<_Scalar> &array) {
 //     return merge_array;
 // }
 
-//! \brief 融合两个有序数组
-//! \note 这种合并的方式要比上面的合并方式快 10 倍。 O(n)。一般实际存储的是指针或者引用，所以下面的
-//!      实现还不理想，存储的是值。
-//! \method 比较两个有序数组的最低位元素。哪个小就复制哪个元素到 merge_array 中。然后移动到下一个元素在与其比较。
-//! \TODO
-//!     1）修改成存储指针/引用的形式，这样就不会进行数据的直接拷贝，节省了时间
-template <typename _Scalar>
-vector<_Scalar> Merge(const vector<_Scalar> &ordered_array1,const vector<_Scalar> &ordered_array2) {
-    vector<_Scalar> merge_array(ordered_array1.size() + ordered_array2.size());
-    auto iter1 = ordered_array1.begin();
-    auto iter2 = ordered_array2.begin();
-    auto iter = merge_array.begin();
-
-    for (; iter != merge_array.end(); ++iter) {
-        if (iter1 != ordered_array1.end() && iter2 != ordered_array2.end()) {
-            if (*iter1 > *iter2) { // 保证了稳定排序
-                *iter = *iter2;
-                ++iter2;
-            }
-            else {
-                *iter = *iter1;
-                ++iter1;
-            }
+//! \brief 融合两个有序区间，结果写入 result 开始的位置
+//! \note 这种合并的方式要比上面的合并方式快 10 倍。 O(n)。输入区间的元素是被移动（std::move）过去的，
+//!       不会进行深拷贝，合并完成后输入区间内的元素处于被移走的状态
+//! \method 比较两个有序数组的最低位元素。哪个小就移动哪个元素到 result 中。然后移动到下一个元素在与其比较。
+//! \return 输出区间的尾部
+template <typename _InputIt1, typename _InputIt2, typename _OutputIt, typename _Compare>
+_OutputIt Merge(_InputIt1 first1, _InputIt1 last1,
+                _InputIt2 first2, _InputIt2 last2,
+                _OutputIt result, _Compare comp) {
+    for (; first1 != last1 && first2 != last2; ++result) {
+        if (comp(*first2, *first1)) { // 保证了稳定排序，只有 2 严格小于 1 时才先取 2
+            *result = std::move(*first2);
+            ++first2;
         } else {
-            if (iter1 == ordered_array1.end()) {
-                *iter = *iter2;
-                ++iter2;
-            } else {
-                *iter = *iter1;
-                ++iter1;
-            }
+            *result = std::move(*first1);
+            ++first1;
         }
     }
-    return merge_array;
+    result = std::move(first1, last1, result);
+    return std::move(first2, last2, result);
 }
 
-//! \brief 利用引用方式归并排序
-//! \complexity 最好、最坏、平均都是 O(nlog(n))
-template <typename _Scalar>
-void MergeSort(vector<_Scalar> &array) {
-    if (1 == array.size())
+//! \brief 归并排序
+//! \note 只申请一块与输入等长的辅助空间，每一层在输入区间和辅助空间之间交替归并（与并行归并排序相同的实现，
+//!       单线程执行），不再在每一层递归中拷贝出两个 vector
+//! \complexity 最好、最坏、平均都是 O(nlog(n))，空间复杂度 O(n)
+template <typename _RandomIt, typename _Compare>
+void MergeSort(_RandomIt first, _RandomIt last, _Compare comp) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    if (last - first < 2)
         return ;
-    vector<_Scalar> array1(array.begin(), array.begin() + array.size() / 2); // 不包含最后一位
-    vector<_Scalar> array2(array.begin() + array.size() / 2, array.end());
-    MergeSort(array1);
-    MergeSort(array2);
-    array = Merge(array1, array2); // 这里可以改为将 array 写入到 Merge() 形参里面，
+    vector<ValueType> buffer(make_move_iterator(first), make_move_iterator(last));
+    MergeSortPingPong(buffer.begin(), first, buffer.size(), true, comp, nullptr);
 }
 
 // 利用 vector 拷贝的引用方式。比较直观！
@@ -343,6 +505,248 @@ void MergeSort(vector<_Scalar> &array) {
 //     array = MergeSortBase(array);
 // }
 
+//-----------------------------TIM 排序-----------------------------------------------
+
+//! \brief TIM 排序（TimSort）：自然归并排序，利用数据中已经有序的部分
+//! \method 1）从左向右找出自然有序的顺串（严格递减的顺串原地翻转），短于 minrun 的顺串用插入排序补齐到 minrun
+//!         2）顺串压入栈中，维持栈的不变式 len[i-2] > len[i-1] + len[i]、len[i-1] > len[i]，
+//!            不满足时合并相邻顺串，保证合并的两个顺串长度接近，栈的深度为 O(log(n))
+//!         3）合并前先用跳跃搜索（galloping）去掉两个顺串中已经在最终位置上的头部、尾部，
+//!            只把较短的一个顺串移动到缓冲区中，从前向后（MergeLow）或者从后向前（MergeHigh）合并
+//!         4）合并时连续 min_gallop 次从同一个顺串取元素，就进入跳跃模式，用指数搜索 + 二分查找一次移动一整段
+//! \note 所有合并共用同一个缓冲区，整个排序中只有缓冲区增长时才申请内存
+//! \complexity 最好：O(n)（有序、逆序、追加少量数据的有序数据） 最坏：O(nlog(n)) 空间复杂度 O(n)
+//!             稳定排序
+//! \reference https://github.com/python/cpython/blob/main/Objects/listsort.txt
+//!            de Gouw S. et al. OpenJDK's java.utils.Collection.sort() is broken（栈不变式的修正）
+
+//! \brief 计算最小顺串长度：在 [32, 64] 之间，使 n / minrun 等于或者略小于 2 的幂，最后的合并比较均衡
+static size_t TimMinRun(size_t n) {
+    size_t remainder = 0;
+    while (n >= sort_internal::kTimMinMerge) {
+        remainder |= n & 1;
+        n >>= 1;
+    }
+    return n + remainder;
+}
+
+//! \brief 找出从 begin 开始的顺串，严格递减的顺串翻转为递增（严格递减保证翻转后仍然稳定）
+//! \return 顺串的尾部
+template <typename _RandomIt, typename _Compare>
+_RandomIt CountRunAndMakeAscending(_RandomIt begin, _RandomIt end, _Compare comp) {
+    auto run_end = begin + 1;
+    if (run_end == end)
+        return run_end;
+    if (comp(*run_end, *begin)) { // 严格递减
+        while (++run_end != end && comp(*run_end, *(run_end - 1))) {}
+        std::reverse(begin, run_end);
+    } else {                      // 非递减
+        while (++run_end != end && !comp(*run_end, *(run_end - 1))) {}
+    }
+    return run_end;
+}
+
+//! \brief 跳跃搜索：先以 1、3、7、15... 的步长指数搜索确定范围，再在范围内二分查找
+//! \param from_back 从尾部开始搜索（从后向前合并时，要找的位置一般靠近尾部）
+//! \param upper true：返回第一个大于 key 的位置（upper_bound）；false：第一个不小于 key 的位置（lower_bound）
+template <typename _RandomIt, typename _Scalar, typename _Compare>
+_RandomIt Gallop(const _Scalar &key, _RandomIt begin, _RandomIt end, bool from_back, bool upper, _Compare comp) {
+    // before(x)：x 是否排在结果位置之前
+    auto before = [&](const _Scalar &x) { return upper ? !comp(key, x) : comp(x, key); };
+    auto n = end - begin;
+    decltype(n) low = 0, high = n; // 结果在 [begin + low, begin + high] 中
+    if (!from_back) {
+        decltype(n) offset = 1;
+        while (offset <= n && before(begin[offset - 1])) {
+            low    = offset;
+            offset = 2 * offset + 1;
+        }
+        high = std::min(offset - 1, n);
+    } else {
+        decltype(n) offset = 1;
+        while (offset <= n && !before(end[-offset])) {
+            high   = n - offset;
+            offset = 2 * offset + 1;
+        }
+        low = std::max<decltype(n)>(n - offset + 1, 0);
+    }
+    return upper ? std::upper_bound(begin + low, begin + high, key, comp)
+                 : std::lower_bound(begin + low, begin + high, key, comp);
+}
+
+//! \brief 从前向后合并相邻顺串 [first, middle)、[middle, last)，要求第一个顺串较短
+//! \note 第一个顺串移动到缓冲区中，相等元素优先取第一个顺串，保证稳定
+template <typename _RandomIt, typename _Compare, typename _Scalar>
+void MergeLow(_RandomIt first, _RandomIt middle, _RandomIt last, _Compare comp,
+              sort_internal::TimState<_Scalar> &state) {
+    state.buffer.assign(make_move_iterator(first), make_move_iterator(middle));
+    auto cursor1 = state.buffer.begin(), end1 = state.buffer.end();
+    auto cursor2 = middle;
+    auto dest    = first;
+    ptrdiff_t min_gallop = state.min_gallop;
+    while (cursor1 != end1 && cursor2 != last) {
+        ptrdiff_t count1 = 0, count2 = 0; // 连续从同一个顺串取出的元素个数
+        // 逐个比较模式
+        while (cursor1 != end1 && cursor2 != last && count1 < min_gallop && count2 < min_gallop) {
+            if (comp(*cursor2, *cursor1)) {
+                *dest++ = std::move(*cursor2++);
+                ++count2;
+                count1 = 0;
+            } else {
+                *dest++ = std::move(*cursor1++);
+                ++count1;
+                count2 = 0;
+            }
+        }
+        // 跳跃模式：每次移动一整段，段长都小于 kTimMinGallop 时退出
+        while (cursor1 != end1 && cursor2 != last) {
+            auto run1_end = Gallop(*cursor2, cursor1, end1, false, true, comp);
+            count1 = run1_end - cursor1;
+            dest    = std::move(cursor1, run1_end, dest);
+            cursor1 = run1_end;
+            if (cursor1 == end1) break;
+            *dest++ = std::move(*cursor2++);
+            if (cursor2 == last) break;
+
+            auto run2_end = Gallop(*cursor1, cursor2, last, false, false, comp);
+            count2 = run2_end - cursor2;
+            dest    = std::move(cursor2, run2_end, dest); // dest 在 cursor2 之前，向前移动不会覆盖
+            cursor2 = run2_end;
+            if (cursor2 == last) break;
+            *dest++ = std::move(*cursor1++);
+
+            --min_gallop;
+            if (count1 < sort_internal::kTimMinGallop && count2 < sort_internal::kTimMinGallop)
+                break;
+        }
+        min_gallop = std::max<ptrdiff_t>(min_gallop, 0) + 2; // 跳跃模式效果不好，提高再次进入的门槛
+    }
+    std::move(cursor1, end1, dest); // 第二个顺串剩下的元素已经在最终位置上
+    state.min_gallop = std::max<ptrdiff_t>(min_gallop, 1);
+}
+
+//! \brief 从后向前合并相邻顺串 [first, middle)、[middle, last)，要求第二个顺串较短
+//! \note 第二个顺串移动到缓冲区中，相等元素优先把第二个顺串的元素放到后面，保证稳定
+template <typename _RandomIt, typename _Compare, typename _Scalar>
+void MergeHigh(_RandomIt first, _RandomIt middle, _RandomIt last, _Compare comp,
+               sort_internal::TimState<_Scalar> &state) {
+    state.buffer.assign(make_move_iterator(middle), make_move_iterator(last));
+    auto begin2  = state.buffer.begin();
+    auto cursor2 = state.buffer.end(); // 两个游标都指向还没有合并的部分的尾后位置
+    auto cursor1 = middle;
+    auto dest    = last;
+    ptrdiff_t min_gallop = state.min_gallop;
+    while (cursor1 != first && cursor2 != begin2) {
+        ptrdiff_t count1 = 0, count2 = 0;
+        while (cursor1 != first && cursor2 != begin2 && count1 < min_gallop && count2 < min_gallop) {
+            if (comp(*(cursor2 - 1), *(cursor1 - 1))) {
+                *--dest = std::move(*--cursor1);
+                ++count1;
+                count2 = 0;
+            } else {
+                *--dest = std::move(*--cursor2);
+                ++count2;
+                count1 = 0;
+            }
+        }
+        while (cursor1 != first && cursor2 != begin2) {
+            auto run1_begin = Gallop(*(cursor2 - 1), first, cursor1, true, true, comp);
+            count1 = cursor1 - run1_begin;
+            dest    = std::move_backward(run1_begin, cursor1, dest);
+            cursor1 = run1_begin;
+            if (cursor1 == first) break;
+            *--dest = std::move(*--cursor2);
+            if (cursor2 == begin2) break;
+
+            auto run2_begin = Gallop(*(cursor1 - 1), begin2, cursor2, true, false, comp);
+            count2 = cursor2 - run2_begin;
+            dest    = std::move_backward(run2_begin, cursor2, dest);
+            cursor2 = run2_begin;
+            if (cursor2 == begin2) break;
+            *--dest = std::move(*--cursor1);
+
+            --min_gallop;
+            if (count1 < sort_internal::kTimMinGallop && count2 < sort_internal::kTimMinGallop)
+                break;
+        }
+        min_gallop = std::max<ptrdiff_t>(min_gallop, 0) + 2;
+    }
+    std::move_backward(begin2, cursor2, dest); // 第一个顺串剩下的元素已经在最终位置上
+    state.min_gallop = std::max<ptrdiff_t>(min_gallop, 1);
+}
+
+//! \brief 合并栈中第 i 个和第 i+1 个顺串
+template <typename _RandomIt, typename _Compare, typename _Scalar>
+void MergeAt(_RandomIt first, size_t i, _Compare comp, sort_internal::TimState<_Scalar> &state) {
+    auto begin  = first + state.run_base[i];
+    auto middle = begin + state.run_length[i];
+    auto end    = middle + state.run_length[i + 1];
+    state.run_length[i] += state.run_length[i + 1];
+    if (i + 3 == state.num_runs) { // 合并的是倒数第 3、2 个顺串，最后一个顺串前移
+        state.run_base[i + 1]   = state.run_base[i + 2];
+        state.run_length[i + 1] = state.run_length[i + 2];
+    }
+    --state.num_runs;
+
+    // 第一个顺串中不大于第二个顺串首元素的部分、第二个顺串中不小于第一个顺串尾元素的部分已经在最终位置上
+    begin = Gallop(*middle, begin, middle, false, true, comp);
+    if (begin == middle)
+        return;
+    end = Gallop(*(middle - 1), middle, end, true, false, comp);
+    if (middle - begin <= end - middle)
+        MergeLow(begin, middle, end, comp, state);
+    else
+        MergeHigh(begin, middle, end, comp, state);
+}
+
+//! \brief 合并栈顶的顺串，直到满足栈的不变式
+template <typename _RandomIt, typename _Compare, typename _Scalar>
+void MergeCollapse(_RandomIt first, _Compare comp, sort_internal::TimState<_Scalar> &state) {
+    const size_t *length = state.run_length;
+    while (state.num_runs > 1) {
+        size_t i = state.num_runs - 2;
+        if ((i > 0 && length[i - 1] <= length[i] + length[i + 1]) ||
+            (i > 1 && length[i - 2] <= length[i - 1] + length[i])) {
+            if (length[i - 1] < length[i + 1])
+                --i;
+        } else if (length[i] > length[i + 1]) {
+            break;
+        }
+        MergeAt(first, i, comp, state);
+    }
+}
+
+//! \brief TIM 排序函数接口
+template <typename _RandomIt, typename _Compare>
+void TimSort(_RandomIt first, _RandomIt last, _Compare comp) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    size_t n = last - first;
+    if (n < sort_internal::kTimMinMerge) { // 数据很少时插入排序（本身就是稳定的）
+        InsertionRange(first, last, comp);
+        return;
+    }
+    sort_internal::TimState<ValueType> state;
+    size_t min_run = TimMinRun(n);
+    for (auto run_begin = first; run_begin != last; ) {
+        auto run_end = CountRunAndMakeAscending(run_begin, last, comp);
+        if (static_cast<size_t>(run_end - run_begin) < min_run) { // 插入排序补齐到 min_run
+            run_end = run_begin + std::min<size_t>(min_run, last - run_begin);
+            InsertionRange(run_begin, run_end, comp);
+        }
+        state.run_base[state.num_runs]   = run_begin - first;
+        state.run_length[state.num_runs] = run_end - run_begin;
+        ++state.num_runs;
+        MergeCollapse(first, comp, state);
+        run_begin = run_end;
+    }
+    while (state.num_runs > 1) { // 合并剩下的顺串
+        size_t i = state.num_runs - 2;
+        if (i > 0 && state.run_length[i - 1] < state.run_length[i + 1])
+            --i;
+        MergeAt(first, i, comp, state);
+    }
+}
+
 //-----------------------------快速排序-----------------------------------------------
 
 //! \brief 快速排序的简单实现
@@ -394,26 +798,20 @@ void MergeSort(vector<_Scalar> &array) {
 
 //! \complexity 空间复杂度为 O(1)
 //! \conclusion 此时的分区函数速度最快，是上面分区函数的 10 倍。
-template <typename _Scalar>
-void Partition(typename vector<_Scalar>::iterator begin,
-               typename vector<_Scalar>::iterator end,
-               typename vector<_Scalar>::iterator &temp_start,
-               typename vector<_Scalar>::iterator &temp_end) {
+template <typename _RandomIt, typename _Compare>
+void Partition(_RandomIt begin, _RandomIt end,
+               _RandomIt &temp_start, _RandomIt &temp_end, _Compare comp) {
     auto pivot = end-1; // 以数组的最后一个值为分界点
     temp_start = begin; // 仅仅把这两个值当做循环变量来用。
     temp_end = begin;
     for (; temp_end != end; ++temp_end) {
-        if (*temp_end < *pivot) {
-            auto temp   = *temp_start;
-            *temp_start = *temp_end;
-            *temp_end   = temp;
+        if (comp(*temp_end, *pivot)) {
+            std::iter_swap(temp_start, temp_end);
             ++temp_start;
         }
     }
     // 交换最后一个 pivot 值
-    auto temp   = *pivot;
-    *pivot      = *temp_start;
-    *temp_start = temp;
+    std::iter_swap(pivot, temp_start);
 
     // 把下一次分区的起始和结尾更新
     temp_end   = temp_start;
@@ -422,59 +820,530 @@ void Partition(typename vector<_Scalar>::iterator begin,
 
 //! \brief 快速排序递归函数，是快排函数的基函数
 //! \note 这里的 end 数据是不使用的
-template <typename _Scalar>
-void QuickSortBase(typename vector<_Scalar>::iterator begin,
-                   typename vector<_Scalar>::iterator end) { // note 这里忘了加 typename 了引起了歧义
-    // 选择中间的元素
-    if (begin == end)
-        return;
-    decltype(begin) temp_end; // 左边界尾部
-    decltype(begin) temp_start; // 右边界起点
-    Partition<_Scalar>(begin, end, temp_start, temp_end);
-    QuickSortBase<_Scalar>(begin, temp_end);
-    QuickSortBase<_Scalar>(temp_start, end);
+template <typename _RandomIt, typename _Compare>
+void QuickSortBase(_RandomIt begin, _RandomIt end, _Compare comp) {
+    QuickSortBase(begin, end, comp, sort_internal::SimdTag<_RandomIt, _Compare>());
+}
+
+//! \note 只对较短的一边递归，较长的一边在循环中继续分区，有序、逆序输入退化为 O(n^2) 时递归深度仍然是 O(log(n))
+template <typename _RandomIt, typename _Compare>
+void QuickSortBase(_RandomIt begin, _RandomIt end, _Compare comp, false_type) {
+    while (begin != end) {
+        _RandomIt temp_end;   // 左边界尾部
+        _RandomIt temp_start; // 右边界起点
+        Partition(begin, end, temp_start, temp_end, comp);
+        if (temp_end - begin < end - temp_start) {
+            QuickSortBase(begin, temp_end, comp, false_type());
+            begin = temp_start;
+        } else {
+            QuickSortBase(temp_start, end, comp, false_type());
+            end = temp_end;
+        }
+    }
+}
+
+//! \brief 可以使用 SIMD 时的快排：分界点仍然取最后一个值，分区改用向量化分区，小区间改用排序网络
+template <typename _RandomIt, typename _Compare>
+void QuickSortBase(_RandomIt begin, _RandomIt end, _Compare comp, true_type) {
+    for (;;) {
+        size_t n = end - begin;
+        if (n <= sort_internal::kSimdSortThreshold) {
+            SmallSort(begin, end, comp, true_type());
+            return;
+        }
+        auto data  = &*begin;
+        auto pivot = data[n - 1];
+        size_t num_less = simd::Partition(data, n - 1, pivot); // 分界点不参与分区
+        std::swap(data[num_less], data[n - 1]);
+        if (num_less < n - num_less - 1) { // 同上，只对较短的一边递归
+            QuickSortBase(begin, begin + num_less, comp, true_type());
+            begin = begin + num_less + 1;
+        } else {
+            QuickSortBase(begin + num_less + 1, end, comp, true_type());
+            end = begin + num_less;
+        }
+    }
 }
 
 //! \brief 快速排序函数接口
 //! \complexity 最好：O(nlog(n)) 最坏：O(n^2) 平均：O(nlog(n))
 //! 非稳定排序、原地排序：空间复杂度为 O(1)
-template <typename _Scalar>
-void QuickSort(vector<_Scalar> &array) {
+template <typename _RandomIt, typename _Compare>
+void QuickSort(_RandomIt first, _RandomIt last, _Compare comp) {
     // cout << "Quick Sort" << endl;
-    QuickSortBase<_Scalar>(array.begin(), array.end());
+    QuickSortBase(first, last, comp);
+}
+
+
+//-----------------------------内省排序-----------------------------------------------
+
+//! \brief 内省排序（Introsort）简单实现
+//! \method 以快排为主体，同时做如下改进：
+//!         1）三数取中/九数取中选择分界点，有序、逆序数据不会再退化
+//!         2）三路分区，将等于分界点的元素聚在中间，大量重复元素时不再退化
+//!         3）递归深度超过 2*log(n) 时，改用堆排序，保证最坏 O(nlog(n))
+//!         4）区间足够小时改用插入排序，减少递归调用次数
+//! \reference https://en.wikipedia.org/wiki/Introsort
+
+//! \brief 对 [begin, end) 区间进行插入排序，后向比较方式（与上面插入排序的第 3 种方式一致）
+//! \note 区间很小，二分查找省下的比较次数抵不上分支开销，所以这里直接后向比较
+template <typename _RandomIt, typename _Compare>
+void InsertionRange(_RandomIt begin, _RandomIt end, _Compare comp) {
+    if (end - begin < 2)
+        return;
+    for (auto separate_point = begin + 1; separate_point != end; ++separate_point) {
+        auto separate_point_value = std::move(*separate_point);
+        auto i = separate_point;
+        for (; i != begin && comp(separate_point_value, *(i-1)); --i) // 向后移动一位
+            *i = std::move(*(i-1));
+        *i = std::move(separate_point_value);
+    }
+}
+
+//! \brief 返回三个位置中，值处于中间的那个位置
+template <typename _RandomIt, typename _Compare>
+_RandomIt MedianOfThree(_RandomIt a, _RandomIt b, _RandomIt c, _Compare comp) {
+    if (comp(*a, *b)) {
+        if (comp(*b, *c)) return b;      // a < b < c
+        return comp(*a, *c) ? c : a;     // a < b, c <= b
+    }
+    if (comp(*a, *c)) return a;          // b <= a < c
+    return comp(*b, *c) ? c : b;         // b <= a, c <= a
+}
+
+//! \brief 选择分界点：区间较小时三数取中，较大时九数取中（Tukey's ninther）
+//! \complexity O(1)
+template <typename _RandomIt, typename _Compare>
+_RandomIt SelectPivot(_RandomIt begin, _RandomIt end, _Compare comp) {
+    auto n      = end - begin;
+    auto middle = begin + n/2;
+    auto last   = end - 1;
+    if (static_cast<size_t>(n) <= sort_internal::kNintherThreshold)
+        return MedianOfThree(begin, middle, last, comp);
+
+    auto step = n/8;
+    auto a = MedianOfThree(begin, begin + step, begin + 2*step, comp);
+    auto b = MedianOfThree(middle - step, middle, middle + step, comp);
+    auto c = MedianOfThree(last - 2*step, last - step, last, comp);
+    return MedianOfThree(a, b, c, comp);
+}
+
+//! \brief 三路分区（Dijkstra 荷兰国旗问题）
+//! \note 分区之后：[begin, less_end) < pivot，[less_end, greater_begin) == pivot，[greater_begin, end) > pivot
+//! \complexity 时间复杂度 O(n) 空间复杂度 O(1)
+//! \param pivot_value 分界点的值，分区过程中原位置的元素会被移动，所以调用方需要传入一份拷贝
+//! \param less_end 小于区间的尾部（下一次左边区间的终点）
+//! \param greater_begin 大于区间的起点（下一次右边区间的起点）
+template <typename _RandomIt, typename _Scalar, typename _Compare>
+void PartitionThreeWay(_RandomIt begin, _RandomIt end, const _Scalar &pivot_value,
+                       _RandomIt &less_end, _RandomIt &greater_begin, _Compare comp) {
+    less_end      = begin;
+    greater_begin = end;
+    auto current  = begin;
+    while (current != greater_begin) {
+        if (comp(*current, pivot_value)) {
+            std::iter_swap(less_end, current);
+            ++less_end;
+            ++current;
+        } else if (comp(pivot_value, *current)) {
+            --greater_begin;
+            std::iter_swap(current, greater_begin); // 换过来的元素还没有比较过，current 不移动
+        } else {
+            ++current;
+        }
+    }
+}
+
+//! \brief 小区间排序：一般类型用插入排序，可以使用 SIMD 时用排序网络（最多 kSimdSortThreshold 个元素）
+template <typename _RandomIt, typename _Compare>
+void SmallSort(_RandomIt begin, _RandomIt end, _Compare comp, false_type) {
+    InsertionRange(begin, end, comp);
+}
+
+template <typename _RandomIt, typename _Compare>
+void SmallSort(_RandomIt begin, _RandomIt end, _Compare, true_type) {
+    if (end - begin > 1)
+        simd::SortSmall(&*begin, end - begin);
+}
+
+//! \brief 内省排序的分区步骤，结果与 PartitionThreeWay 一致
+//! \note 可以使用 SIMD 时先向量化分区出 < pivot 的部分，同时统计等于 pivot 的个数。重复元素较多
+//!       （或者左边为空）时再对右边分区一次，把等于 pivot 的元素聚在中间；否则等于区间为空，
+//!       分界点留在右边，由于左边非空，右边区间一定变短
+template <typename _RandomIt, typename _Scalar, typename _Compare>
+void PartitionStep(_RandomIt begin, _RandomIt end, const _Scalar &pivot_value,
+                   _RandomIt &less_end, _RandomIt &greater_begin, _Compare comp, false_type) {
+    PartitionThreeWay(begin, end, pivot_value, less_end, greater_begin, comp);
+}
+
+template <typename _RandomIt, typename _Scalar, typename _Compare>
+void PartitionStep(_RandomIt begin, _RandomIt end, const _Scalar &pivot_value,
+                   _RandomIt &less_end, _RandomIt &greater_begin, _Compare, true_type) {
+    auto   data = &*begin;
+    size_t n    = end - begin;
+    size_t num_equal = 0;
+    size_t num_less  = simd::Partition(data, n, pivot_value, &num_equal);
+    less_end      = begin + num_less;
+    greater_begin = less_end;
+    if (num_equal > 1 || 0 == num_less)
+        greater_begin += simd::PartitionLessEqual(data + num_less, n - num_less, pivot_value);
+}
+
+//! \brief 从上向下堆化（大顶堆，下标从 0 开始），与 Heap::HeapifyDown 思路一致
+//! \complexity 时间复杂度为 O(logn) 空间复杂度为 O(1)
+template <typename _RandomIt, typename _Distance, typename _Compare>
+void HeapifyDown(_RandomIt first, _Distance index, _Distance size, _Compare comp) {
+    while (true) {
+        auto extremum_value_index = index;
+        auto left  = 2 * index + 1;
+        auto right = left + 1;
+        if (left < size && comp(first[extremum_value_index], first[left]))
+            extremum_value_index = left;
+        if (right < size && comp(first[extremum_value_index], first[right]))
+            extremum_value_index = right;
+
+        // 如果没有交换，那么堆化成功
+        if (extremum_value_index == index) break;
+
+        std::iter_swap(first + extremum_value_index, first + index);
+        index = extremum_value_index;
+    }
+}
+
+//! \brief 递归过深时的退化方案：原地堆排序
+//! \note glib::Heap 需要把数据拷贝到堆内部，并且只支持 < > 比较，所以这里按照同样的思路，
+//!       直接在区间上建堆、排序
+//! \complexity 时间复杂度 O(nlog(n)) 空间复杂度 O(1)
+template <typename _RandomIt, typename _Compare>
+void HeapSortRange(_RandomIt begin, _RandomIt end, _Compare comp) {
+    auto size = end - begin;
+    for (auto index = size/2 - 1; index >= 0; --index) // 建堆
+        HeapifyDown(begin, index, size, comp);
+    while (size > 1) {                                 // 每次把堆顶元素放到末尾
+        --size;
+        std::iter_swap(begin, begin + size);
+        HeapifyDown(begin, decltype(size)(0), size, comp);
+    }
+}
+
+//! \brief 内省排序递归函数
+//! \note 只对较短的一边递归，较长的一边继续循环，保证递归栈深度为 O(log(n))
+//! \param depth_limit 剩余允许的快排递归深度，为 0 时改用堆排序
+template <typename _RandomIt, typename _Compare>
+void IntroSortBase(_RandomIt begin, _RandomIt end, size_t depth_limit, _Compare comp) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    using SimdTag   = sort_internal::SimdTag<_RandomIt, _Compare>;
+    const size_t small_size = SimdTag::value ? sort_internal::kSimdSortThreshold
+                                             : sort_internal::kInsertionSortThreshold;
+    while (static_cast<size_t>(end - begin) > small_size) {
+        if (0 == depth_limit) {
+            HeapSortRange(begin, end, comp);
+            return;
+        }
+        --depth_limit;
+
+        _RandomIt less_end;      // 左边界尾部
+        _RandomIt greater_begin; // 右边界起点
+        const ValueType pivot_value = *SelectPivot(begin, end, comp);
+        PartitionStep(begin, end, pivot_value, less_end, greater_begin, comp, SimdTag());
+        if (less_end - begin < end - greater_begin) {
+            IntroSortBase(begin, less_end, depth_limit, comp);
+            begin = greater_begin;
+        } else {
+            IntroSortBase(greater_begin, end, depth_limit, comp);
+            end = less_end;
+        }
+    }
+    SmallSort(begin, end, comp, SimdTag());
+}
+
+//! \brief 内省排序函数接口
+//! \complexity 最好：O(n)（全部相等） 最坏：O(nlog(n)) 平均：O(nlog(n))
+//! 非稳定排序、原地排序，空间复杂度：O(log(n))
+template <typename _RandomIt, typename _Compare>
+void IntroSort(_RandomIt first, _RandomIt last, _Compare comp) {
+    size_t depth_limit = 0;
+    for (auto n = last - first; n > 1; n >>= 1) // 2*floor(log2(n))
+        depth_limit += 2;
+    IntroSortBase(first, last, depth_limit, comp);
+}
+
+//-----------------------------并行排序-----------------------------------------------
+
+//! \brief 多线程排序：并行归并排序、并行快速排序
+//! \note 任务都提交到同一个任务窃取线程池，区间小于 kParallelSortCutoff 时不再派生任务，
+//!       避免任务太碎，调度开销超过排序本身
+
+//! \brief 计算归并输出位置 k 的划分（co-rank）：输出的前 k 个元素由 A 的前 i 个和 B 的前 k-i 个组成
+//! \note 相等元素优先取 A，与 Merge 保持一致，保证稳定
+//! \complexity O(log(min(n1, n2)))
+//! \return i
+template <typename _InputIt1, typename _InputIt2, typename _Compare>
+size_t CoRank(size_t k, _InputIt1 first1, size_t n1, _InputIt2 first2, size_t n2, _Compare comp) {
+    size_t low_limit = (k > n2) ? k - n2 : 0;
+    size_t up_limit  = std::min(k, n1);
+    while (low_limit < up_limit) { // 找到第一个使 B[j-1] < A[i] 成立（或者不存在 B[j-1]）的 i
+        size_t i = low_limit + (up_limit - low_limit)/2;
+        size_t j = k - i;
+        if (j > 0 && !comp(first2[j-1], first1[i])) // B[j-1] >= A[i]，A 取得太少
+            low_limit = i + 1;
+        else
+            up_limit  = i;
+    }
+    return low_limit;
+}
+
+//! \brief 并行合并两个有序区间
+//! \method 把输出区间平均分成若干块，每块的起点用 CoRank 二分查找到对应的输入位置，之后每块独立合并
+//! \note 先把所有划分点算出来再开始合并，合并时会移走输入元素，不能与 CoRank 的读取同时进行
+//! \param pool 为 nullptr 时串行合并
+template <typename _InputIt1, typename _InputIt2, typename _OutputIt, typename _Compare>
+void ParallelMerge(_InputIt1 first1, _InputIt1 last1, _InputIt2 first2, _InputIt2 last2,
+                   _OutputIt result, _Compare comp, utils::ThreadPool *pool) {
+    size_t n1 = last1 - first1;
+    size_t n2 = last2 - first2;
+    size_t total = n1 + n2;
+    if (nullptr == pool || pool->size() < 2 || total <= 2 * sort_internal::kParallelMergeGrain) {
+        Merge(first1, last1, first2, last2, result, comp);
+        return;
+    }
+
+    size_t num_chunks = std::min(pool->size() * 4, total / sort_internal::kParallelMergeGrain);
+    vector<size_t> splits(num_chunks + 1);
+    for (size_t chunk = 0; chunk <= num_chunks; chunk++)
+        splits[chunk] = CoRank(total * chunk / num_chunks, first1, n1, first2, n2, comp);
+
+    utils::TaskGroup group(*pool);
+    for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+        size_t k_begin = total * chunk / num_chunks;
+        size_t k_end   = total * (chunk + 1) / num_chunks;
+        size_t i_begin = splits[chunk];
+        size_t i_end   = splits[chunk + 1];
+        auto merge_chunk = [=]() {
+            Merge(first1 + i_begin, first1 + i_end,
+                  first2 + (k_begin - i_begin), first2 + (k_end - i_end),
+                  result + k_begin, comp);
+        };
+        if (chunk + 1 < num_chunks)
+            group.Run(merge_chunk);
+        else
+            merge_chunk(); // 最后一块在当前线程完成
+    }
+    group.Wait();
+}
+
+//! \brief 乒乓（ping-pong）归并排序：数据在 source 中，other 是等长的另一块空间
+//! \method 两半分别排序到「另一块空间」中，然后再合并回目标空间，这样每一层只需要交换输入输出的角色，
+//!         整个排序过程只用到一块辅助空间，不需要每一层都申请内存
+//! \param to_other true: 排序结果放到 other 中；false: 排序结果放回 source 中
+//! \param pool 为 nullptr 时串行排序
+template <typename _SourceIt, typename _OtherIt, typename _Compare>
+void MergeSortPingPong(_SourceIt source, _OtherIt other, size_t n, bool to_other,
+                       _Compare comp, utils::ThreadPool *pool) {
+    if (n <= sort_internal::kMergeInsertionThreshold) {
+        InsertionRange(source, source + n, comp); // 后向比较的插入排序是稳定的
+        if (to_other)
+            std::move(source, source + n, other);
+        return;
+    }
+
+    size_t half = n/2;
+    if (nullptr != pool && n > sort_internal::kParallelSortCutoff) {
+        utils::TaskGroup group(*pool);
+        group.Run([=]() { MergeSortPingPong(source, other, half, !to_other, comp, pool); });
+        MergeSortPingPong(source + half, other + half, n - half, !to_other, comp, pool);
+        group.Wait();
+    } else {
+        MergeSortPingPong(source, other, half, !to_other, comp, pool);
+        MergeSortPingPong(source + half, other + half, n - half, !to_other, comp, pool);
+    }
+
+    // 两半的结果都在「另一块空间」中
+    if (to_other)
+        ParallelMerge(source, source + half, source + half, source + n, other, comp, pool);
+    else
+        ParallelMerge(other, other + half, other + half, other + n, source, comp, pool);
+}
+
+//! \brief 并行归并排序
+//! \note 稳定排序。先把数据移动到辅助空间中，再从辅助空间排序回原区间，
+//!       这样只要求元素可以移动构造、移动赋值，不要求有默认构造函数
+//! \complexity 时间复杂度 O(nlog(n)/p + n)，p 为线程数；空间复杂度 O(n)
+template <typename _RandomIt, typename _Compare>
+void ParallelMergeSort(_RandomIt first, _RandomIt last, _Compare comp, utils::ThreadPool &pool) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    vector<ValueType> buffer(make_move_iterator(first), make_move_iterator(last));
+    MergeSortPingPong(buffer.begin(), first, buffer.size(), true, comp,
+                      pool.size() > 1 ? &pool : nullptr);
+}
+
+//! \brief 并行快速排序递归函数
+//! \method 与内省排序一致，分区后把较短的一边作为新任务派生出去，较长的一边在当前线程继续分区，
+//!         区间足够小时直接调用串行的内省排序
+template <typename _RandomIt, typename _Compare>
+void ParallelQuickSortBase(_RandomIt begin, _RandomIt end, size_t depth_limit,
+                           _Compare comp, utils::TaskGroup &group) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    while (static_cast<size_t>(end - begin) > sort_internal::kParallelSortCutoff) {
+        if (0 == depth_limit) {
+            HeapSortRange(begin, end, comp);
+            return;
+        }
+        --depth_limit;
+
+        _RandomIt less_end;      // 左边界尾部
+        _RandomIt greater_begin; // 右边界起点
+        const ValueType pivot_value = *SelectPivot(begin, end, comp);
+        PartitionStep(begin, end, pivot_value, less_end, greater_begin, comp,
+                      sort_internal::SimdTag<_RandomIt, _Compare>());
+        if (less_end - begin < end - greater_begin) {
+            group.Run([=, &group]() { ParallelQuickSortBase(begin, less_end, depth_limit, comp, group); });
+            begin = greater_begin;
+        } else {
+            group.Run([=, &group]() { ParallelQuickSortBase(greater_begin, end, depth_limit, comp, group); });
+            end = less_end;
+        }
+    }
+    IntroSortBase(begin, end, depth_limit, comp);
+}
+
+//! \brief 并行快速排序（并行内省排序）
+//! \complexity 平均时间复杂度 O(n + nlog(n)/p)，最坏 O(nlog(n))；非稳定排序、原地排序
+template <typename _RandomIt, typename _Compare>
+void ParallelQuickSort(_RandomIt first, _RandomIt last, _Compare comp, utils::ThreadPool &pool) {
+    size_t depth_limit = 0;
+    for (auto n = last - first; n > 1; n >>= 1) // 2*floor(log2(n))
+        depth_limit += 2;
+    if (pool.size() < 2) {
+        IntroSortBase(first, last, depth_limit, comp);
+        return;
+    }
+    utils::TaskGroup group(pool);
+    ParallelQuickSortBase(first, last, depth_limit, comp, group);
+    group.Wait();
+}
+
+
+//-----------------------------桶排序（样本排序）-------------------------------------------
+
+//! \brief 样本排序：桶排序的一种，用随机样本确定桶的边界，而不是按照取值范围等分
+//! \method 1）随机抽取 桶数 * kSampleOversampling 个样本并排序，等间隔选出 桶数 - 1 个分割点
+//!         2）分割点按照完全二叉树（Eytzinger）的顺序存放，每个元素查找所在的桶只需要 log(桶数) 次比较，
+//!            并且没有分支预测失败
+//!         3）先统计每个桶的大小，再把元素分发到各自的桶中，每个桶是原区间中连续的一段
+//!         4）每个桶独立排序：桶的大小接近缓存大小，直接基数排序（不支持时为内省排序）；
+//!            样本不理想导致某个桶过大时对这个桶递归样本排序；pool 不为空时各个桶在线程池中并行排序
+//! \note 非稳定排序；只需要比较函数，适用于任意类型。大量重复元素会落到同一个桶中，桶内排序可以处理
+//! \complexity 时间复杂度 O(nlog(桶数) + 桶内排序)，数据分布已知、桶大小均衡时接近线性；空间复杂度 O(n)
+//! \param pool 为 nullptr 时串行排序
+template <typename _RandomIt, typename _Compare>
+void SampleSort(_RandomIt first, _RandomIt last, _Compare comp, utils::ThreadPool *pool) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    const size_t n = last - first;
+    const size_t bucket_capacity = std::max(sort_internal::kSampleMinBucketSize,
+                                            sort_internal::kSampleBucketBytes / sizeof(ValueType));
+    if (n <= 2 * bucket_capacity) {
+        IntroSort(first, last, comp);
+        return;
+    }
+    size_t log_buckets = 1;
+    while (log_buckets < sort_internal::kSampleMaxLogBuckets && (n >> log_buckets) > bucket_capacity)
+        ++log_buckets;
+    const size_t num_buckets = size_t(1) << log_buckets;
+
+    // 随机采样，固定随机数种子，相同的输入每次的分桶结果都一样
+    const size_t oversampling = sort_internal::kSampleOversampling;
+    vector<ValueType> sample;
+    sample.reserve(num_buckets * oversampling);
+    mt19937_64 engine(n);
+    for (size_t i = 0; i < num_buckets * oversampling; i++)
+        sample.push_back(first[engine() % n]);
+    IntroSort(sample.begin(), sample.end(), comp);
+
+    // tree[j-1] 为完全二叉树第 j 个节点（从 1 开始）的分割点，中序遍历即为从小到大的分割点
+    vector<ValueType> tree;
+    tree.reserve(num_buckets - 1);
+    for (size_t depth = 0; depth < log_buckets; depth++) {
+        for (size_t position = 0; position < (size_t(1) << depth); position++) {
+            size_t rank = (2 * position + 1) * (size_t(1) << (log_buckets - 1 - depth)); // 中序遍历的序号（从 1 开始）
+            tree.push_back(sample[rank * oversampling - 1]);
+        }
+    }
+    sample.clear();
+    sample.shrink_to_fit();
+
+    // 分类：大于等于分割点时走右子树，最后到达的叶子节点就是所在的桶
+    vector<size_t> bucket_begin(num_buckets + 1, 0);
+    {
+        vector<ValueType> buffer(make_move_iterator(first), make_move_iterator(last));
+        vector<uint16_t>  bucket_ids(n);
+        for (size_t i = 0; i < n; i++) {
+            size_t node = 1;
+            for (size_t level = 0; level < log_buckets; level++)
+                node = 2 * node + !comp(buffer[i], tree[node - 1]);
+            bucket_ids[i] = static_cast<uint16_t>(node - num_buckets);
+            bucket_begin[node - num_buckets + 1]++;
+        }
+        for (size_t b = 0; b < num_buckets; b++)
+            bucket_begin[b + 1] += bucket_begin[b];
+        vector<size_t> offsets(bucket_begin.begin(), bucket_begin.end() - 1);
+        for (size_t i = 0; i < n; i++)
+            first[offsets[bucket_ids[i]]++] = std::move(buffer[i]);
+    }
+
+    // 桶内排序
+    auto sort_bucket = [=](size_t begin, size_t end) {
+        size_t size = end - begin;
+        if (size > 8 * bucket_capacity && size <= n/2) // 桶过大时递归，每次至少减半，一定会结束
+            SampleSort(first + begin, first + end, comp, nullptr);
+        else // 数值、字符串用基数排序，其他类型会改用内省排序
+            RadixSort(first + begin, first + end, comp);
+    };
+    if (nullptr != pool && pool->size() > 1) {
+        utils::TaskGroup group(*pool);
+        for (size_t b = 0; b < num_buckets; b++) {
+            size_t begin = bucket_begin[b], end = bucket_begin[b + 1];
+            if (end - begin > 1)
+                group.Run([=]() { sort_bucket(begin, end); });
+        }
+        group.Wait();
+    } else {
+        for (size_t b = 0; b < num_buckets; b++)
+            sort_bucket(bucket_begin[b], bucket_begin[b + 1]);
+    }
 }
 
 
 //-----------------------------计数排序-----------------------------------------------
 
-// 除了特殊的 int 类型可以处理，其他类型暂时都不可处理!
-template <typename _Scalar>
-void CountingSort(vector<_Scalar> &array) {
-    cout << "该数据不适合计数排序，本实现仅仅用于「int」类型的数据排序。" << endl
-         << "请先转换到「int」后，在调用计数排序函数，或者选择其他排序！" << endl;
-    return;
+// 除了特殊的 int 类型从小到大排序可以用计数排序，其他类型改用基数排序（基数排序不支持时会改用内省排序）
+template <typename _RandomIt, typename _Compare>
+void CountingSort(_RandomIt first, _RandomIt last, _Compare comp) {
+    RadixSort(first, last, comp);
 }
 
 //! \brief 计数排序
-//! \note 该计数排序仅仅适用于整数，且数据范围小于数据个数的情况！
+//! \note 该计数排序仅仅适用于整数，且数据范围小于数据个数的情况！范围更大时改用基数排序
+//!       类内不能显式特化成员模板，这里用比较函数为 std::less<int> 的重载代替，重载决议时优先匹配该版本
 //! \complexity 时间复杂度：最好：O(n)，最坏：O(n) 平均：O(n) 空间复杂度：O(n)
 //! \method 将所有数据分桶，每个桶内不需要排序
-template <>
-void CountingSort(vector<int> &array) {
-    assert(array.size() > 0);
+template <typename _RandomIt>
+typename enable_if<is_same<typename iterator_traits<_RandomIt>::value_type, int>::value>::type
+CountingSort(_RandomIt first, _RandomIt last, std::less<int>) {
+    assert(last - first > 0);
 
     // 找到数组中上下限。判断当前数组能够用计数排序。不能用计数排序，需要调用其他排序方法。或者提示失败
-    int max_value = *std::max_element(array.begin(), array.end());
-    int min_value = *std::min_element(array.begin(), array.end());
-    size_t bucket_num = max_value - min_value + 1;
-    if (bucket_num > array.size()) {
-        std::cerr << "该组数据不适合用计数排序，请选择合适的排序方法" << '\n';
+    int max_value = *std::max_element(first, last);
+    int min_value = *std::min_element(first, last);
+    size_t bucket_num = static_cast<size_t>(static_cast<long long>(max_value) - min_value) + 1;
+    if (bucket_num > static_cast<size_t>(last - first)) { // 计数器数组会比数据本身还大
+        RadixSort(first, last, std::less<int>());
         return;
     } else if (1 == bucket_num)                   // 已经是有序的,内部只有一种元素
         return;
     vector<size_t> counting_array(bucket_num, 0); // 桶计数器
-    for (const auto &element: array)              // 计算每个索引对应多少个相同的数据
-        counting_array[element - min_value]++;
+    for (auto iter = first; iter != last; ++iter) // 计算每个索引对应多少个相同的数据
+        counting_array[*iter - min_value]++;
 
     // 记录小于等于当前索引的数量,这里对于对应索引为的也会进行填充。因为后面不会用到索引为 0 的数据
     size_t sum = 0;
@@ -484,92 +1353,354 @@ void CountingSort(vector<int> &array) {
     }
 
     // 计数排序核心: 根据计数器的值对数组 array 进行排序。从后向前遍历 array
-    vector<int> temp_array(array.size());
-    vector<int>::const_reverse_iterator iter = array.rbegin();
-    for (; iter != array.rend(); ++iter) {
+    vector<int> temp_array(last - first);
+    for (auto iter = last; iter != first; ) {
+        --iter;
         auto array_index = counting_array[*iter - min_value] - 1;
         counting_array[*iter - min_value]--;
         temp_array[array_index] = *iter;
     }
 
-    // 拷贝临时数组到要排序的 array 中
-    std::copy(temp_array.begin(), temp_array.end(), array.begin());
+    // 拷贝临时数组到要排序的区间中
+    std::copy(temp_array.begin(), temp_array.end(), first);
 }
 
 
 //-----------------------------基数排序-----------------------------------------------
 
-// TODO 待实现！目前没法对最后一个字符进行排序，然后影响到整个 string。需要前面的排序算法有通用实现
-// 仅仅适用于 string 中的每个字符的排序
-// template <>
-// void RadixSort(vector<string> &array) {
-//     // 在所有的 string 中，找到最大的长度。其他不足的补全为 "0"
-//     size_t max_length = array[0].size();
-//     for (const auto &p: array) {
-//         if (p.size() > max_length)
-//             max_length = p.size();
-//     }
-//
-//     // 对每个字符串的最低位进行排序
-//
-// }
+//! \brief 基数排序入口：根据数据类型、比较函数选择 LSD 数值基数排序、MSD 字符串基数排序，或者内省排序
+template <typename _RandomIt, typename _Compare>
+void RadixSort(_RandomIt first, _RandomIt last, _Compare comp) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    using Traits    = sort_internal::RadixTraits<ValueType, _Compare>;
+    if (static_cast<size_t>(last - first) <= sort_internal::kRadixSortThreshold ||
+        sort_internal::RadixKind::UNSUPPORTED == Traits::kKind) {
+        IntroSort(first, last, comp);
+        return;
+    }
+    RadixSortDispatch(first, last, Traits::kDescending,
+                      integral_constant<sort_internal::RadixKind, Traits::kKind>());
+}
+
+template <typename _RandomIt>
+void RadixSortDispatch(_RandomIt, _RandomIt, bool,
+                       integral_constant<sort_internal::RadixKind, sort_internal::RadixKind::UNSUPPORTED>) {
+    // 入口函数已经改用内省排序，这里仅仅为了编译通过
+}
+
+template <typename _RandomIt>
+void RadixSortDispatch(_RandomIt first, _RandomIt last, bool descending,
+                       integral_constant<sort_internal::RadixKind, sort_internal::RadixKind::NUMBER>) {
+    NumberRadixSort(first, last, descending);
+}
+
+template <typename _RandomIt>
+void RadixSortDispatch(_RandomIt first, _RandomIt last, bool descending,
+                       integral_constant<sort_internal::RadixKind, sort_internal::RadixKind::STRING>) {
+    StringRadixSort(first, last);
+    if (descending) // 相等的字符串无法区分，直接逆序不影响结果
+        std::reverse(first, last);
+}
+
+//! \brief 每一趟处理的位数：数据少时用 8 位（计数器数组小，清零、求前缀和开销低），
+//!        32 位键值用 11 位（3 趟），64 位键值数据很多时用 16 位（4 趟），否则用 11 位（6 趟）
+size_t RadixDigitBits(size_t n, size_t key_bits) {
+    if (key_bits <= 8 || n < (size_t(1) << 16))
+        return 8;
+    if (key_bits <= 32 || n < (size_t(1) << 24))
+        return 11;
+    return 16;
+}
+
+//! \brief 整数、浮点数 LSD 基数排序
+//! \method 1）把数据转换为顺序一致的无符号键值，逆序排序时把键值取反。键值和数值可以随时互相转换，
+//!            所以原区间和一块键值数组交替作为每一趟的输入输出，只需要 n 个键值的辅助空间
+//!         2）一次遍历同时统计所有趟的计数器（只顺序读一遍数据），之后每一趟只需要求前缀和并分发
+//!         3）某一趟所有键值的这一位都相同时跳过这一趟，比如 64 位 id 的高位都是 0
+//! \complexity 时间复杂度 O(d*(n + 2^r))，d 为趟数，r 为每趟的位数；空间复杂度 O(n + d*2^r)；稳定排序
+template <typename _RandomIt>
+void NumberRadixSort(_RandomIt first, _RandomIt last, bool descending) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    using Key       = sort_internal::RadixKey<ValueType>;
+    using KeyType   = typename Key::KeyType;
+    const size_t  n         = last - first;
+    const KeyType flip_mask = descending ? (~KeyType(0) >> (sizeof(KeyType)*8 - Key::kKeyBits)) : 0;
+
+    const size_t  digit_bits = RadixDigitBits(n, Key::kKeyBits);
+    const size_t  num_passes = (Key::kKeyBits + digit_bits - 1) / digit_bits;
+    const size_t  radix      = size_t(1) << digit_bits;
+    const KeyType digit_mask = static_cast<KeyType>(radix - 1);
+    vector<size_t> histograms(num_passes * radix, 0);
+    for (size_t i = 0; i < n; i++) { // 一次遍历统计所有趟的计数器
+        KeyType key = Key::ToKey(first[i]) ^ flip_mask;
+        for (size_t pass = 0; pass < num_passes; pass++)
+            histograms[pass * radix + ((key >> (pass * digit_bits)) & digit_mask)]++;
+    }
+
+    unique_ptr<KeyType[]> buffer(new KeyType[n]); // 不需要初始化
+    bool in_buffer = false; // 当前数据在原区间还是键值数组中
+    for (size_t pass = 0; pass < num_passes; pass++) {
+        size_t *histogram = histograms.data() + pass * radix;
+        size_t  shift     = pass * digit_bits;
+        KeyType sample    = in_buffer ? buffer[0] : (Key::ToKey(first[0]) ^ flip_mask);
+        if (n == histogram[(sample >> shift) & digit_mask]) // 这一位全部相同，跳过
+            continue;
+        size_t sum = 0; // 计数器转换为每个桶的起始位置
+        for (size_t digit = 0; digit < radix; digit++) {
+            size_t count = histogram[digit];
+            histogram[digit] = sum;
+            sum += count;
+        }
+        if (in_buffer) {
+            for (size_t i = 0; i < n; i++) {
+                KeyType key = buffer[i];
+                first[histogram[(key >> shift) & digit_mask]++] = Key::FromKey(key ^ flip_mask);
+            }
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                KeyType key = Key::ToKey(first[i]) ^ flip_mask;
+                buffer[histogram[(key >> shift) & digit_mask]++] = key;
+            }
+        }
+        in_buffer = !in_buffer;
+    }
+    if (in_buffer) {
+        for (size_t i = 0; i < n; i++)
+            first[i] = Key::FromKey(buffer[i] ^ flip_mask);
+    }
+}
+
+// 字符串第 depth 个字符对应的桶：0 表示字符串已经结束，其他字符对应 1~256
+inline size_t StringBucket(const string &str, size_t depth) {
+    return depth < str.size() ? static_cast<unsigned char>(str[depth]) + 1 : 0;
+}
+
+//! \brief 字符串 MSD 基数排序（从小到大）
+//! \method 1）按第 depth 个字符把区间分到 257 个桶中，再对每个桶比较下一个字符，用显式栈代替递归，
+//!            公共前缀很长时也不会栈溢出
+//!         2）桶内元素较少时直接插入排序，只比较 depth 之后的部分
+//!         3）区间内所有字符串第 depth 个字符都相同时不分发，直接处理下一个字符
+//! \note 字符串只移动不拷贝，辅助空间只申请一次
+//! \complexity 时间复杂度 O(总字符数 + 桶个数)；空间复杂度 O(n)；稳定排序
+template <typename _RandomIt>
+void StringRadixSort(_RandomIt first, _RandomIt last) {
+    struct Bucket {
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+    const size_t kNumBuckets = 257;
+    vector<string> buffer(last - first);
+    vector<size_t> count(kNumBuckets + 1);
+    vector<Bucket> stack = {{0, static_cast<size_t>(last - first), 0}};
+    while (!stack.empty()) {
+        Bucket bucket = stack.back();
+        stack.pop_back();
+        size_t depth = bucket.depth;
+        if (bucket.end - bucket.begin <= sort_internal::kStringInsertionThreshold) {
+            InsertionRange(first + bucket.begin, first + bucket.end,
+                           [depth](const string &a, const string &b) {
+                               return a.compare(depth, string::npos, b, depth, string::npos) < 0;
+                           });
+            continue;
+        }
+
+        std::fill(count.begin(), count.end(), 0);
+        for (size_t i = bucket.begin; i < bucket.end; i++)
+            count[StringBucket(first[i], depth) + 1]++;
+        size_t common = StringBucket(first[bucket.begin], depth);
+        if (count[common + 1] == bucket.end - bucket.begin) { // 第 depth 个字符全部相同
+            if (0 != common) // 全部结束说明字符串都相等
+                stack.push_back({bucket.begin, bucket.end, depth + 1});
+            continue;
+        }
+
+        for (size_t b = 1; b <= kNumBuckets; b++) // count[b] 为第 b 个桶的起始位置
+            count[b] += count[b - 1];
+        for (size_t i = bucket.begin; i < bucket.end; i++) {
+            size_t b = StringBucket(first[i], depth);
+            buffer[bucket.begin + count[b]++] = std::move(first[i]);
+        }
+        std::move(buffer.begin() + bucket.begin, buffer.begin() + bucket.end, first + bucket.begin);
+
+        // 现在 count[b] 为第 b 个桶的结束位置，第 0 个桶（已经结束的字符串）不需要再排序
+        for (size_t b = 1; b < kNumBuckets; b++) {
+            if (count[b] - count[b - 1] > 1)
+                stack.push_back({bucket.begin + count[b - 1], bucket.begin + count[b], depth + 1});
+        }
+    }
+}
 
 
 }; // class SortDetail
 
 // 上述排序算法/思想简单应用
 class SortAppDetail {
-template <typename _Scalar>
-friend _Scalar FindKthBigElement(vector<_Scalar> array, int kth);
-
-//--------------------快排思路{分治+分区}查找第 K 大元素----------------------------------
+template <typename _RandomIt, typename _Compare>
+friend _RandomIt Select(_RandomIt first, _RandomIt last, size_t k, _Compare comp);
+template <typename _RandomIt, typename _Compare>
+friend void PartialSort(_RandomIt first, _RandomIt middle, _RandomIt last, _Compare comp);
+template <typename _RandomIt, typename _Compare>
+friend typename iterator_traits<_RandomIt>::value_type
+ParallelSelect(_RandomIt first, _RandomIt last, size_t k, _Compare comp, utils::ThreadPool &pool);
+
+//--------------------快排思路{分治+分区}查找第 k 小元素（introselect）----------------------
+
+//! \brief 中位数的中位数（BFPRT）选择分界点：每 5 个一组求中位数，再递归求这些中位数的中位数
+//! \note 各组的中位数被移动到区间前部。得到的分界点保证左右两边都至少有 3n/10 个元素，
+//!       在快速选择退化时使用，保证最坏 O(n)
+//! \return 分界点的值
+template <typename _RandomIt, typename _Compare>
+typename iterator_traits<_RandomIt>::value_type
+MedianOfMedians(_RandomIt begin, _RandomIt end, _Compare comp) {
+    SortDetail sort;
+    size_t num_groups = (end - begin) / 5;
+    for (size_t i = 0; i < num_groups; i++) {
+        auto group = begin + 5 * i;
+        sort.InsertionRange(group, group + 5, comp);
+        std::iter_swap(begin + i, group + 2); // 前面的组已经处理完，不会覆盖还没有处理的组
+    }
+    auto median = begin + num_groups / 2;
+    SelectBase(begin, begin + num_groups, median, 0, comp);
+    return *median;
+}
 
-// 分区函数，第 k 大元素，核心函数
-template <typename _Scalar>
-void FindPartition(typename vector<_Scalar>::iterator begin,
-                   typename vector<_Scalar>::iterator end,
-                   typename vector<_Scalar>::iterator &temp_start,
-                   typename vector<_Scalar>::iterator &temp_end) {
-    auto pivot = end-1; // 以数组的最后一个值为分界点
-    temp_start = begin; // 仅仅把这两个值当做循环变量来用。
-    temp_end = begin;
-    for (; temp_end != end; ++temp_end) {
-       if (*temp_end > *pivot) {
-           auto temp   = *temp_start;
-           *temp_start = *temp_end;
-           *temp_end   = temp;
-           ++temp_start;
-       }
+//! \brief 快速选择中选择分界点，见 SelectBase 中的说明
+//! \note Floyd-Rivest 会重排 nth 附近的子区间，分界点就是重排后的 *nth
+template <typename _RandomIt, typename _Compare>
+typename iterator_traits<_RandomIt>::value_type
+SelectPivotValue(_RandomIt begin, _RandomIt end, _RandomIt nth, size_t &depth_limit, _Compare comp) {
+    if (0 == depth_limit)
+        return MedianOfMedians(begin, end, comp);
+    --depth_limit;
+    if (end - begin <= sort_internal::kFloydRivestThreshold) {
+        SortDetail sort;
+        return *sort.SelectPivot(begin, end, comp);
     }
-    // 交换最后一个 pivot 值
-    auto temp   = *pivot;
-    *pivot      = *temp_start;
-    *temp_start = temp;
+    double n    = static_cast<double>(end - begin);
+    double i    = static_cast<double>(nth - begin);
+    double z    = std::log(n);
+    double size = 0.5 * std::exp(2 * z / 3);   // 子区间长度
+    double sd   = 0.5 * std::sqrt(z * size * (n - size) / n) * (i < n / 2 ? -1 : 1);
+    auto sub_begin = static_cast<ptrdiff_t>(std::max(0.0, i - i * size / n + sd));
+    auto sub_end   = static_cast<ptrdiff_t>(std::min(n - 1, i + (n - i) * size / n + sd)) + 1;
+    SelectBase(begin + sub_begin, begin + sub_end, nth, depth_limit, comp);
+    return *nth;
+}
 
-    // 把下一次分区的起始和结尾更新
-    temp_end    = temp_start; // 就是 pivot 点
-    temp_start  = temp_end + 1;
+//! \brief 快速选择递归函数：使 *nth 为排序后该位置的元素，左边都不大于它，右边都不小于它
+//! \method 与内省排序相同的三路分区（可以使用 SIMD 时为向量化分区），只在 nth 所在的一边继续：
+//!         1）区间较大时用 Floyd-Rivest 算法选择分界点：从 nth 附近抽取一个子区间，递归选择出子区间中对应位置的
+//!            元素作为分界点，分界点与第 k 个元素非常接近，一般 1~2 次分区就能结束，比较次数接近 n + min(k, n-k)
+//!         2）区间较小时九数取中/三数取中
+//!         3）分区次数超过 depth_limit 时改用中位数的中位数选择分界点，保证最坏 O(n)
+//! \param depth_limit 剩余允许的普通分区次数，为 0 时每次都用中位数的中位数
+//! \reference Floyd R W, Rivest R L. Algorithm 489: The Algorithm SELECT
+//!            https://en.wikipedia.org/wiki/Introselect
+template <typename _RandomIt, typename _Compare>
+void SelectBase(_RandomIt begin, _RandomIt end, _RandomIt nth, size_t depth_limit, _Compare comp) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    using SimdTag   = sort_internal::SimdTag<_RandomIt, _Compare>;
+    SortDetail sort;
+    while (static_cast<size_t>(end - begin) > sort_internal::kInsertionSortThreshold) {
+        const ValueType pivot_value = SelectPivotValue(begin, end, nth, depth_limit, comp);
+
+        _RandomIt less_end;      // 左边界尾部
+        _RandomIt greater_begin; // 右边界起点
+        sort.PartitionStep(begin, end, pivot_value, less_end, greater_begin, comp, SimdTag());
+        if (nth < less_end)
+            end = less_end;
+        else if (nth >= greater_begin)
+            begin = greater_begin;
+        else
+            return;              // nth 落在等于分界点的区间中
+    }
+    sort.SmallSort(begin, end, comp, SimdTag());
 }
 
-// 第 k 大元素，核心函数
-template <typename _Scalar>
-_Scalar QuickFind(typename vector<_Scalar>::iterator begin,
-                  typename vector<_Scalar>::iterator end, int kth) {
-    decltype(begin) temp_end; // 左边界尾部
-    decltype(begin) temp_start; // 右边界起点
-    FindPartition<_Scalar>(begin, end, temp_start, temp_end); // 左边是大的元素，右边是小的元素
+//! \brief 并行选择：各个分块并行统计、收集候选元素，再合并候选元素串行选择
+//! \method 1）随机抽取 n^(2/3) 个样本并排序，按照 k 在样本中的位置选出上下界 [low, high]，
+//!            第 k 个元素以很大概率落在上下界之间（与 Floyd-Rivest 相同的思路）
+//!         2）每个分块一个任务，统计小于 low 的元素个数，并把上下界之间的元素收集到分块自己的候选数组中
+//!         3）合并各个分块的计数和候选数组，如果第 k 个元素确实在候选元素中，在候选元素中选择；
+//!            否则（概率很小）拷贝全部数据串行选择
+//! \note 输入区间只读，可以是 const 迭代器；候选元素个数大约为 2n*sqrt(log(n)/n^(2/3))，10^8 个数据时约为 1%
+template <typename _RandomIt, typename _Compare>
+typename iterator_traits<_RandomIt>::value_type
+ParallelSelectBase(_RandomIt first, _RandomIt last, size_t k, _Compare comp, utils::ThreadPool &pool) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    size_t n = last - first;
+
+    // 1）抽样，确定上下界。下标超出样本范围时不设置对应的界
+    size_t num_samples = std::min(n, std::max<size_t>(sort_internal::kSelectMinSamples,
+                                                      static_cast<size_t>(std::pow(static_cast<double>(n), 2.0 / 3))));
+    vector<ValueType> samples;
+    samples.reserve(num_samples);
+    mt19937_64 engine(n);
+    for (size_t i = 0; i < num_samples; i++)
+        samples.push_back(first[engine() % n]);
+    SortDetail sort;
+    sort.IntroSort(samples.begin(), samples.end(), comp);
+    double position  = static_cast<double>(k) * num_samples / n;
+    double deviation = std::sqrt(num_samples * std::log(static_cast<double>(n)));
+    bool has_low  = position - deviation >= 0;
+    bool has_high = position + deviation < num_samples - 1;
+    const ValueType low  = samples[has_low  ? static_cast<size_t>(position - deviation) : 0];
+    const ValueType high = samples[has_high ? static_cast<size_t>(position + deviation) : num_samples - 1];
+
+    // 2）分块统计、收集候选元素
+    size_t num_chunks = (pool.size() > 1 && n > sort_internal::kParallelSortCutoff) ? pool.size() : 1;
+    vector<size_t>            num_less(num_chunks, 0);
+    vector<vector<ValueType>> candidates(num_chunks);
+    auto collect = [&](size_t chunk) {
+        auto chunk_first = first + n * chunk / num_chunks;
+        auto chunk_last  = first + n * (chunk + 1) / num_chunks;
+        size_t less = 0;
+        for (auto iter = chunk_first; iter != chunk_last; ++iter) {
+            bool below = has_low && comp(*iter, low);
+            less += below;
+            if (!below && !(has_high && comp(high, *iter)))
+                candidates[chunk].push_back(*iter);
+        }
+        num_less[chunk] = less;
+    };
+    if (1 == num_chunks) {
+        collect(0);
+    } else {
+        utils::TaskGroup group(pool);
+        for (size_t chunk = 1; chunk < num_chunks; chunk++)
+            group.Run([&collect, chunk]() { collect(chunk); });
+        collect(0);
+        group.Wait();
+    }
 
-    auto pivot = temp_end - begin; // 分界点位置索引
-    if (pivot  == kth - 1)
-        return *temp_end;
-    else if (pivot > kth - 1) // 在左边找
-        return QuickFind<_Scalar>(begin, temp_end, kth);
-    else { // 在右边找
-        kth = kth - 1 - pivot;
-        return QuickFind<_Scalar>(temp_start, end, kth);
+    // 3）合并
+    size_t total_less = 0, total_candidates = 0;
+    for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+        total_less       += num_less[chunk];
+        total_candidates += candidates[chunk].size();
     }
+    vector<ValueType> merged;
+    if (total_less <= k && k < total_less + total_candidates) {
+        merged.reserve(total_candidates);
+        for (auto &chunk: candidates)
+            merged.insert(merged.end(), make_move_iterator(chunk.begin()), make_move_iterator(chunk.end()));
+        k -= total_less;
+    } else { // 第 k 个元素不在上下界之间
+        merged.assign(first, last);
+    }
+    auto nth = merged.begin() + k;
+    SelectBase(merged.begin(), merged.end(), nth, SelectDepthLimit(merged.size()), comp);
+    return *nth;
 }
 
+// 快速选择允许的普通分区次数：2*floor(log2(n))
+static size_t SelectDepthLimit(size_t n) {
+    size_t depth_limit = 0;
+    for (; n > 1; n >>= 1)
+        depth_limit += 2;
+    return depth_limit;
+}
 
 //-----------------------------------------------------------------------------------
 
@@ -579,62 +1710,326 @@ _Scalar QuickFind(typename vector<_Scalar>::iterator begin,
 //--------------------------------------外部功能接口--------------------------------------
 
 
-//! \brief 各种排序算法接口
-//! \note 调用是需要给定一个 vector 实例。不能是简单临时构造。
-//! 对于计数排序，保证输入的是整数。如果是小数，那么需要自己转换成整数。如果是字符，可以自己转换成整数。
+//! \brief 各种排序算法接口（迭代器 + 比较函数版本），其他排序接口最终都会调用该函数
+//! \note 1）区间必须是随机访问迭代器，比如 vector、deque、array、裸指针（mmap 映射的内存）等，直接原地排序
+//!       2）比较函数按值传递，作为模板参数可以被内联。不要用 std::function 包装，否则每次比较都是间接调用
+//!       3）计数排序只适用于 int 且 comp 为 std::less<int>，其他情况改用基数排序；
+//!          基数排序只适用于整数、浮点数、字符串且 comp 为 std::less/std::greater，其他情况改用内省排序
 //! \complexity 下面是平均复杂度
 //!             冒泡：O(n^2)       插入: O(n^2)      选择：O(n^2)
-//!             归并：O(nlog(n))   快排：O(nlog(n))  计数：O(n)
-//! \param array 输入的数据元素，只支持 vector 容器
-template <typename _Scalar>
-void Sort(vector<_Scalar> &array, const SortOption option = SortOption::INSERTION) {
+//!             归并：O(nlog(n))   快排：O(nlog(n))  内省：O(nlog(n))（最坏也是）  计数：O(n)
+//!             基数：O(d*n)，d 为趟数（与键值位数、字符串长度有关）
+//!             桶（样本排序）：O(nlog(桶数) + 桶内排序)，桶大小均衡时接近线性
+//!             并行归并、并行快排：O(nlog(n)/p)，p 为全局线程池的线程数
+//! \param first、last 待排序区间 [first, last)
+//! \param comp 比较函数，comp(a, b) 为 true 表示 a 排在 b 前面
+//! \param option 排序算法选项，默认是内省排序
+template <typename _RandomIt, typename _Compare>
+void Sort(_RandomIt first, _RandomIt last, _Compare comp, const SortOption option) {
+    if (last - first < 2) return;
     SortDetail sort;
     switch (option) {
         case SortOption::BUBBLE: {
-            cout << "Bubble Sort" << endl;
-            sort.Bubble(array);
+            sort.Bubble(first, last, comp);
             break;
         }
         case SortOption::INSERTION: {
-            cout << "Insertion Sort" << endl;
-            sort.Insertion(array);
+            sort.Insertion(first, last, comp);
             break;
         }
         case SortOption::SELECTION: {
-            cout << "Selection Sort" << endl;
-            // SelectionStable(array); // 稳定版本选择排序
-            sort.SelectionUnstable(array); // 不稳定排序算法，对于排序和交换的原始是内置数值类型，
-                                              // 此时不稳定的排序要快于稳定的排序。
+            // sort.SelectionStable(first, last, comp); // 稳定版本选择排序
+            sort.SelectionUnstable(first, last, comp); // 不稳定排序算法，对于排序和交换的原始是内置数值类型，
+                                                       // 此时不稳定的排序要快于稳定的排序。
             break;
         }
         case SortOption::MERGE: {
-            cout << "Merge Sort" << endl;
-            sort.MergeSort(array);
+            sort.MergeSort(first, last, comp);
+            break;
+        }
+        case SortOption::TIM: {
+            sort.TimSort(first, last, comp);
             break;
         }
         case SortOption::QUICK: {
-            cout << "Quick Sort" << endl;
-            sort.QuickSort(array);
+            sort.QuickSort(first, last, comp);
             break;
         }
-        case SortOption::COUNTING: { // 仅仅适用于 int 类型
-            cout << "Counting Sort" << endl;
-            sort.CountingSort(array);
+        case SortOption::INTRO: {
+            sort.IntroSort(first, last, comp);
+            break;
+        }
+        case SortOption::COUNTING: { // 仅仅适用于 int 类型，不适用时改用基数排序
+            sort.CountingSort(first, last, comp);
+            break;
+        }
+        case SortOption::RADIX: { // 适用于整数、浮点数、字符串，不适用时改用内省排序
+            sort.RadixSort(first, last, comp);
+            break;
+        }
+        case SortOption::BUCKET: {
+            sort.SampleSort(first, last, comp, nullptr);
+            break;
+        }
+        case SortOption::PARALLEL_MERGE:
+        case SortOption::PARALLEL_QUICK: { // 使用全局共享线程池
+            ParallelSort(first, last, comp, utils::ThreadPool::Default(), option);
             break;
         }
     }
 }
 
-//! \brief 在无序数组中找到第 K 大元素
-//! \note 对于重复的元素也会算进去。如果想找不包含重复的元素中的第 K 大元素，
-//!       那么需要自己实现把重复的元素剔除掉，然后在调用该函数即可找到第 k 大元素
-//! \complexity 时间复杂度 O(n) 空间复杂度 O(1)
+//! \brief 在指定线程池中并行排序
+//! \note 1）比较函数会在多个线程中同时调用，不能有数据竞争
+//!       2）option 为 BUCKET 时，分桶之后各个桶并行排序；其他非并行选项直接调用对应的串行排序
+//! \param pool 使用的线程池，线程池的并发度决定了最多用多少个线程
+//! \param option PARALLEL_MERGE（稳定，额外 O(n) 空间）、PARALLEL_QUICK（原地）或者 BUCKET，默认并行快排
+template <typename _RandomIt, typename _Compare>
+void ParallelSort(_RandomIt first, _RandomIt last, _Compare comp, utils::ThreadPool &pool,
+                  const SortOption option) {
+    if (last - first < 2) return;
+    SortDetail sort;
+    switch (option) {
+        case SortOption::PARALLEL_MERGE: {
+            sort.ParallelMergeSort(first, last, comp, pool);
+            break;
+        }
+        case SortOption::PARALLEL_QUICK: {
+            sort.ParallelQuickSort(first, last, comp, pool);
+            break;
+        }
+        case SortOption::BUCKET: {
+            sort.SampleSort(first, last, comp, &pool);
+            break;
+        }
+        default: {
+            Sort(first, last, comp, option);
+            break;
+        }
+    }
+}
+
+//! \brief 同上，默认从小到大排序（std::less）
+template <typename _RandomIt>
+void Sort(_RandomIt first, _RandomIt last, const SortOption option = SortOption::INTRO) {
+    Sort(first, last, std::less<typename iterator_traits<_RandomIt>::value_type>(), option);
+}
+
+//! \brief 按照键值排序：先用 key 提取元素的键值，再用 comp 比较键值
+//! \note key 每次比较都会调用两次，应该返回轻量的值或者引用，比如结构体中的某个成员
+//! \param key 键值提取函数，key(element) 返回用来排序的键值
+//! \param comp 键值比较函数
+//! \example
+//!      glib::SortByKey(records.begin(), records.end(),
+//!                      [](const Record &r) -> const string& { return r.name; });
+template <typename _RandomIt, typename _KeyExtractor, typename _Compare>
+void SortByKey(_RandomIt first, _RandomIt last, _KeyExtractor key, _Compare comp,
+               const SortOption option = SortOption::INTRO) {
+    sort_internal::KeyCompare<_KeyExtractor, _Compare> key_comp = {key, comp};
+    Sort(first, last, key_comp, option);
+}
+
+//! \brief 同上，键值默认从小到大排序
+template <typename _RandomIt, typename _KeyExtractor>
+void SortByKey(_RandomIt first, _RandomIt last, _KeyExtractor key,
+               const SortOption option = SortOption::INTRO) {
+    using KeyType = typename decay<decltype(key(*first))>::type;
+    SortByKey(first, last, key, std::less<KeyType>(), option);
+}
+
+//! \brief 各种排序算法接口（vector 版本）
+//! \note 调用是需要给定一个 vector 实例。不能是简单临时构造。会打印所选择的排序算法名字。
+//! 对于计数排序、基数排序，不适用的数据会自动改用其他排序算法。
+//! \param array 输入的数据元素
+//! \param option 排序算法选项，默认是内省排序
+template <typename _Scalar>
+void Sort(vector<_Scalar> &array, const SortOption option = SortOption::INTRO) {
+    switch (option) {
+        case SortOption::BUBBLE:    cout << "Bubble Sort"    << endl; break;
+        case SortOption::INSERTION: cout << "Insertion Sort" << endl; break;
+        case SortOption::SELECTION: cout << "Selection Sort" << endl; break;
+        case SortOption::MERGE:     cout << "Merge Sort"     << endl; break;
+        case SortOption::QUICK:     cout << "Quick Sort"     << endl; break;
+        case SortOption::INTRO:     cout << "Intro Sort"     << endl; break;
+        case SortOption::COUNTING:  cout << "Counting Sort"  << endl; break;
+        case SortOption::RADIX:     cout << "Radix Sort"     << endl; break;
+        case SortOption::BUCKET:    cout << "Bucket Sort"    << endl; break;
+        case SortOption::PARALLEL_MERGE: cout << "Parallel Merge Sort" << endl; break;
+        case SortOption::PARALLEL_QUICK: cout << "Parallel Quick Sort" << endl; break;
+        case SortOption::TIM:       cout << "Tim Sort"       << endl; break;
+    }
+    Sort(array.begin(), array.end(), std::less<_Scalar>(), option);
+}
+
+//! \brief 选择第 k 小的元素（k 从 0 开始，与 std::nth_element 一致），原地修改区间
+//! \note 返回后 first[k] 为排序后该位置的元素，[first, first + k) 中的元素都不大于它，
+//!       (first + k, last) 中的元素都不小于它，两边内部的顺序不确定
+//! \complexity 时间复杂度 平均 O(n) 最坏 O(n)（introselect） 空间复杂度 O(log(n))
+//! \param k 要求 k < last - first
+//! \return first + k
+//! \example
+//!      auto p99 = *glib::Select(latency.begin(), latency.end(), latency.size() * 99 / 100);
+template <typename _RandomIt, typename _Compare>
+_RandomIt Select(_RandomIt first, _RandomIt last, size_t k, _Compare comp) {
+    assert(k < static_cast<size_t>(last - first));
+    SortAppDetail select;
+    select.SelectBase(first, last, first + k, select.SelectDepthLimit(last - first), comp);
+    return first + k;
+}
+
+//! \brief 同上，默认从小到大（std::less）
+template <typename _RandomIt>
+_RandomIt Select(_RandomIt first, _RandomIt last, size_t k) {
+    return Select(first, last, k, std::less<typename iterator_traits<_RandomIt>::value_type>());
+}
+
+//! \brief 部分排序：[first, middle) 为整个区间中最小的 middle - first 个元素，并且有序，其余元素顺序不确定
+//! \complexity 时间复杂度 O(n + mlog(m))，m = middle - first；空间复杂度 O(log(n))
+template <typename _RandomIt, typename _Compare>
+void PartialSort(_RandomIt first, _RandomIt middle, _RandomIt last, _Compare comp) {
+    if (first == middle)
+        return;
+    if (middle == last) {
+        Sort(first, last, comp);
+        return;
+    }
+    SortAppDetail select;
+    // 第 m 小的元素放到 middle - 1，前面的元素都不大于它，再排序前面的元素
+    select.SelectBase(first, last, middle - 1, select.SelectDepthLimit(last - first), comp);
+    Sort(first, middle - 1, comp);
+}
+
+//! \brief 同上，默认从小到大（std::less）
+template <typename _RandomIt>
+void PartialSort(_RandomIt first, _RandomIt middle, _RandomIt last) {
+    PartialSort(first, middle, last, std::less<typename iterator_traits<_RandomIt>::value_type>());
+}
+
+//! \brief 流式 Top-K：数据逐个到达（或者分批到达），只保留按照 comp 最大的 k 个元素
+//! \note 内部是大小为 k 的堆，堆顶为保留元素中最小的一个（当前的第 k 大元素）。新元素不大于堆顶时直接丢弃，
+//!       随机数据中绝大部分元素只需要一次比较
+//! \complexity Push：O(log(k)) 空间复杂度：O(k)
+//! \example
+//!      glib::StreamingTopK<int64_t> slowest(100);
+//!      for (auto latency: stream) slowest.Push(latency);
+//!      vector<int64_t> top = slowest.Sorted(); // 从大到小
+template <typename _Scalar, typename _Compare = std::less<_Scalar>>
+class StreamingTopK {
+public: // 构造函数相关
+    explicit
+    StreamingTopK(size_t k, _Compare comp = _Compare()) : k_(k), heap_comp_{comp} {
+        heap_.reserve(k);
+    }
+
+public: // 外部调用核心函数
+    void Push(const _Scalar &value) {
+        if (heap_.size() < k_) {
+            heap_.push_back(value);
+            std::push_heap(heap_.begin(), heap_.end(), heap_comp_);
+        } else if (k_ > 0 && heap_comp_.comp(heap_.front(), value)) { // 比当前第 k 大的元素大，替换堆顶
+            std::pop_heap(heap_.begin(), heap_.end(), heap_comp_);
+            heap_.back() = value;
+            std::push_heap(heap_.begin(), heap_.end(), heap_comp_);
+        }
+    }
+
+    template <typename _InputIt>
+    void Push(_InputIt first, _InputIt last) {
+        for (; first != last; ++first)
+            Push(*first);
+    }
+
+    //! \brief 合并另一个 Top-K 的结果（比如多个线程各自统计后合并）
+    void Merge(const StreamingTopK &other) { Push(other.heap_.begin(), other.heap_.end()); }
+
+    //! \brief 保留的元素，按照 comp 从大到小排序
+    vector<_Scalar> Sorted() const {
+        vector<_Scalar> result(heap_);
+        Sort(result.begin(), result.end(), heap_comp_);
+        return result;
+    }
+
+    void Clear() { heap_.clear(); }
+
+public: // 外部调用状态函数
+    //! \brief 当前保留元素中最小的一个，size() == k() 时就是目前为止的第 k 大元素
+    //! \note 要求 !empty()
+    const _Scalar& Threshold() const { return heap_.front(); }
+
+    size_t size() const { return heap_.size(); }
+    size_t k() const { return k_; }
+    bool empty() const { return heap_.empty(); }
+
+private:
+    size_t                                  k_;
+    sort_internal::ReverseCompare<_Compare> heap_comp_; // 以它为比较函数的大顶堆，堆顶是按照 comp 最小的元素
+    vector<_Scalar>                         heap_;
+}; // class StreamingTopK
+
+//! \brief 按照 comp 最大的 k 个元素，从大到小排列，不修改输入
+//! \complexity 时间复杂度 O(nlog(k)) 空间复杂度 O(k)
+template <typename _InputIt, typename _Compare>
+vector<typename iterator_traits<_InputIt>::value_type>
+TopK(_InputIt first, _InputIt last, size_t k, _Compare comp) {
+    StreamingTopK<typename iterator_traits<_InputIt>::value_type, _Compare> top(k, comp);
+    top.Push(first, last);
+    return top.Sorted();
+}
+
+//! \brief 同上，默认最大的 k 个元素（std::less）
+template <typename _InputIt>
+vector<typename iterator_traits<_InputIt>::value_type>
+TopK(_InputIt first, _InputIt last, size_t k) {
+    return TopK(first, last, k, std::less<typename iterator_traits<_InputIt>::value_type>());
+}
+
+//! \brief 并行选择第 k 小的元素（k 从 0 开始），不修改输入，返回该元素的值
+//! \note 每个分块并行收集第 k 个元素附近的候选元素，合并后再选择，适合在大量数据上求分位数，
+//!       比如 10^8 个延迟数据的 p99、p999。比较函数会在多个线程中同时调用
+//! \complexity 时间复杂度 O(n/p + n^(2/3)log(n)) 额外空间 O(n^(2/3) + 候选元素个数)
+//! \param k 要求 k < last - first
+template <typename _RandomIt, typename _Compare>
+typename iterator_traits<_RandomIt>::value_type
+ParallelSelect(_RandomIt first, _RandomIt last, size_t k, _Compare comp, utils::ThreadPool &pool) {
+    assert(k < static_cast<size_t>(last - first));
+    SortAppDetail select;
+    return select.ParallelSelectBase(first, last, k, comp, pool);
+}
+
+//! \brief 并行 Top-K：每个分块各自求 Top-K，再合并，不修改输入
+//! \complexity 时间复杂度 O(nlog(k)/p + pklog(k)) 空间复杂度 O(pk)
+template <typename _RandomIt, typename _Compare>
+vector<typename iterator_traits<_RandomIt>::value_type>
+ParallelTopK(_RandomIt first, _RandomIt last, size_t k, _Compare comp, utils::ThreadPool &pool) {
+    using ValueType = typename iterator_traits<_RandomIt>::value_type;
+    size_t n = last - first;
+    size_t num_chunks = (pool.size() > 1 && n > sort_internal::kParallelSortCutoff) ? pool.size() : 1;
+    vector<StreamingTopK<ValueType, _Compare>> tops(num_chunks, StreamingTopK<ValueType, _Compare>(k, comp));
+    utils::TaskGroup group(pool);
+    for (size_t chunk = 1; chunk < num_chunks; chunk++) {
+        group.Run([&tops, first, n, num_chunks, chunk]() {
+            tops[chunk].Push(first + n * chunk / num_chunks, first + n * (chunk + 1) / num_chunks);
+        });
+    }
+    tops[0].Push(first, first + n / num_chunks);
+    group.Wait();
+    for (size_t chunk = 1; chunk < num_chunks; chunk++)
+        tops[0].Merge(tops[chunk]);
+    return tops[0].Sorted();
+}
+
+//! \brief 在无序数组中找到第 K 大元素（k 从 1 开始）
+//! \note 1）对于重复的元素也会算进去。如果想找不包含重复的元素中的第 K 大元素，
+//!          那么需要自己实现把重复的元素剔除掉，然后在调用该函数即可找到第 k 大元素
+//!       2）按值传入，调用者的数组不变；在拷贝上用 Select 原地查找。不需要保留原数组时可以 std::move 传入，
+//!          或者直接用 Select 原地查找
+//! \complexity 时间复杂度 O(n)（最坏也是 O(n)） 空间复杂度 O(n)（数组拷贝）
 //! \param array 输入的无序 vector
 //! \return 第 k 大元素对应的值
 template <typename _Scalar>
 _Scalar FindKthBigElement(vector<_Scalar> array, int kth) {
-    SortAppDetail findkth;
-    return findkth.QuickFind<_Scalar>(array.begin(), array.end(), kth);
+    assert(kth >= 1 && static_cast<size_t>(kth) <= array.size());
+    return *Select(array.begin(), array.end(), kth - 1, std::greater<_Scalar>());
 }
 
 } // namespace glib
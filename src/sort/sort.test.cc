@@ -12,6 +12,12 @@
 #include "sort.hpp"
 #include <iostream>
 #include <chrono>
+#include <algorithm> // is_sorted
+#include <deque>
+#include <string>
+#include <functional> // greater
+#include <cstdint>
+#include <random>
 
 using namespace std;
 
@@ -19,9 +25,15 @@ size_t Random(int x) {
     return rand()%x;
 }
 
+// 测试按照键值、自定义比较函数排序的记录
+struct Record {
+    int    id;
+    string name;
+};
+
 //! \brief 排序算法简单测试，通过随机生成 10000 个数据，分别测试不同排序算法的执行时间。
 //! \run
-//!     g++ sort.test.cc -std=c++11 && ./a.out
+//!     g++ sort.test.cc -std=c++11 -pthread && ./a.out
 
 int main(int argc, char const *argv[]) {
     // 随机生成一个大的数列，测试下面排序算法效率
@@ -32,7 +44,9 @@ int main(int argc, char const *argv[]) {
     vector<int> vec_selection(n);
     vector<int> vec_merge(n);
     vector<int> vec_quick(n);
+    vector<int> vec_intro(n);
     vector<int> vec_counting(n);
+    vector<int> vec_radix(n);
     for (size_t i = 0; i < n; i++) {
         size_t re = Random(n);
         vec_bubble[i] = re;
@@ -40,7 +54,9 @@ int main(int argc, char const *argv[]) {
         vec_selection[i] = re;
         vec_merge[i] = re;
         vec_quick[i] = re;
+        vec_intro[i] = re;
         vec_counting[i] = re;
+        vec_radix[i] = re;
     }
 
 
@@ -109,6 +125,15 @@ int main(int argc, char const *argv[]) {
     cout << endl;
 
 
+    // 内省排序测试
+    auto start_intro = chrono::system_clock::now();
+    glib::Sort(vec_intro, glib::SortOption::INTRO);
+    auto end_intro = chrono::system_clock::now();
+    chrono::duration<double> elaspsed_seconds_intro = end_intro - start_intro;
+    cout << " intro elaspsed_seconds: " << elaspsed_seconds_intro.count() << endl;
+    cout << endl;
+
+
     // 计数排序测试
     // vector<int> vec_counting = {6, 5, 4, 3, 2, 1, 6, 2, 0, 3, -1, -1, -2, -2, -3, -3};
     // vector<int> vec_counting = {1};
@@ -121,6 +146,14 @@ int main(int argc, char const *argv[]) {
     //     cout << " " << p;
     cout << endl;
 
+    // 基数排序测试
+    auto start_radix = chrono::system_clock::now();
+    glib::Sort(vec_radix, glib::SortOption::RADIX);
+    auto end_radix = chrono::system_clock::now();
+    chrono::duration<double> elaspsed_seconds_radix = end_radix - start_radix;
+    cout << " radix elaspsed_seconds: " << elaspsed_seconds_radix.count() << endl;
+    cout << endl;
+
     // 验证后面的的排序结果是否与冒泡排序一致！进而检验后面排序算法的实现是否正确
     for (size_t i = 0; i < n; i++) {
         // cout << vec_bubble[i] << " ";
@@ -140,19 +173,363 @@ int main(int argc, char const *argv[]) {
             cout << "quick sort error!" << endl;
             break;
         }
+        if (vec_bubble[i] != vec_intro[i]) {
+            cout << "intro sort error!" << endl;
+            break;
+        }
         if (vec_bubble[i] != vec_counting[i]) {
             cout << "counting sort error!" << endl;
             break;
         }
+        if (vec_bubble[i] != vec_radix[i]) {
+            cout << "radix sort error!" << endl;
+            break;
+        }
+    }
+
+    // 内省排序对于快排的最坏输入（有序、逆序、全部相等、管风琴形）不会退化，也不会栈溢出
+    cout << "内省排序最坏输入测试" << endl;
+    size_t big_n = 1000000;
+    vector<vector<int>> worst_inputs(4, vector<int>(big_n));
+    for (size_t i = 0; i < big_n; i++) {
+        worst_inputs[0][i] = i;                                    // 有序
+        worst_inputs[1][i] = big_n - i;                            // 逆序
+        worst_inputs[2][i] = 6;                                    // 全部相等
+        worst_inputs[3][i] = (i < big_n/2) ? i : big_n - i;        // 管风琴形
+    }
+    for (auto &input: worst_inputs) {
+        auto start_worst = chrono::system_clock::now();
+        glib::Sort(input); // 默认就是内省排序
+        auto end_worst = chrono::system_clock::now();
+        chrono::duration<double> elaspsed_seconds_worst = end_worst - start_worst;
+        cout << " elaspsed_seconds: " << elaspsed_seconds_worst.count()
+             << (std::is_sorted(input.begin(), input.end()) ? " ok" : " intro sort error!") << endl;
+    }
+    cout << endl;
+
+    // 迭代器 + 比较函数接口测试：deque、裸指针、从大到小、按键值排序
+    cout << "迭代器 + 比较函数接口测试" << endl;
+    const glib::SortOption options[] = {
+        glib::SortOption::BUBBLE, glib::SortOption::INSERTION, glib::SortOption::SELECTION,
+        glib::SortOption::MERGE,  glib::SortOption::QUICK,     glib::SortOption::INTRO,
+        glib::SortOption::RADIX,  glib::SortOption::BUCKET,
+        glib::SortOption::PARALLEL_MERGE, glib::SortOption::PARALLEL_QUICK, glib::SortOption::TIM
+    };
+    for (auto option: options) {
+        deque<int> deque_input(vec_bubble.rbegin(), vec_bubble.rend());
+        glib::Sort(deque_input.begin(), deque_input.end(), option);
+        if (!std::equal(deque_input.begin(), deque_input.end(), vec_bubble.begin()))
+            cout << "deque sort error! option: " << static_cast<int>(option) << endl;
+
+        vector<int> greater_input(vec_bubble);
+        glib::Sort(greater_input.data(), greater_input.data() + n, std::greater<int>(), option);
+        if (!std::is_sorted(greater_input.begin(), greater_input.end(), std::greater<int>()))
+            cout << "greater sort error! option: " << static_cast<int>(option) << endl;
+    }
+
+    deque<int> deque_counting(vec_bubble.rbegin(), vec_bubble.rend());
+    glib::Sort(deque_counting.begin(), deque_counting.end(), glib::SortOption::COUNTING);
+    if (!std::equal(deque_counting.begin(), deque_counting.end(), vec_bubble.begin()))
+        cout << "deque counting sort error!" << endl;
+
+    vector<Record> records = {{3, "c"}, {1, "b"}, {2, "a"}, {1, "a"}, {3, "a"}};
+    glib::SortByKey(records.begin(), records.end(),
+                    [](const Record &r) -> const string& { return r.name; },
+                    glib::SortOption::MERGE); // 稳定排序，name 相同的按照原来的顺序
+    glib::SortByKey(records.begin(), records.end(),
+                    [](const Record &r) { return r.id; }, std::greater<int>(),
+                    glib::SortOption::MERGE);
+    for (auto &record: records)
+        cout << " " << record.id << record.name; // 3a 3c 2a 1a 1b
+    cout << endl << endl;
+
+    // 并行排序测试：数据量要大于任务切分阈值，才会真正派生任务
+    cout << "并行排序测试" << endl;
+    vector<int> parallel_expected(big_n);
+    for (auto &value: parallel_expected)
+        value = rand();
+    vector<int> parallel_input(parallel_expected);
+    std::sort(parallel_expected.begin(), parallel_expected.end());
+    const glib::SortOption parallel_options[] = {
+        glib::SortOption::PARALLEL_MERGE, glib::SortOption::PARALLEL_QUICK
+    };
+    for (auto option: parallel_options) {
+        for (size_t num_threads = 1; num_threads <= 4; num_threads++) {
+            glib::utils::ThreadPool pool(num_threads);
+            deque<int> deque_input(parallel_input.begin(), parallel_input.end());
+            glib::ParallelSort(deque_input.begin(), deque_input.end(), std::less<int>(), pool, option);
+            if (!std::equal(deque_input.begin(), deque_input.end(), parallel_expected.begin()))
+                cout << "parallel sort error! option: " << static_cast<int>(option)
+                     << " threads: " << num_threads << endl;
+        }
+    }
+    for (auto &input: worst_inputs) { // 上面已经排好序，逆序后再排序
+        std::reverse(input.begin(), input.end());
+        glib::Sort(input.begin(), input.end(), glib::SortOption::PARALLEL_QUICK);
+        if (!std::is_sorted(input.begin(), input.end()))
+            cout << "parallel quick sort worst input error!" << endl;
+    }
+    // 并行归并排序是稳定排序：按 id 排序后，id 相同的记录保持原来的顺序（这里 name 就是原来的序号）
+    vector<Record> parallel_records(big_n/4);
+    for (size_t i = 0; i < parallel_records.size(); i++)
+        parallel_records[i] = {static_cast<int>(Random(100)), to_string(i)};
+    glib::Sort(parallel_records.begin(), parallel_records.end(),
+               [](const Record &a, const Record &b) { return a.id < b.id; },
+               glib::SortOption::PARALLEL_MERGE);
+    bool parallel_stable = true;
+    for (size_t i = 1; i < parallel_records.size(); i++) {
+        const Record &prev = parallel_records[i - 1], &curr = parallel_records[i];
+        if (prev.id > curr.id || (prev.id == curr.id && stoul(prev.name) > stoul(curr.name)))
+            parallel_stable = false;
+    }
+    cout << (parallel_stable ? " parallel merge sort stable ok" : " parallel merge sort stable error!")
+         << endl << endl;
+
+    // TIM 排序测试：稳定性，以及大部分有序（有序日志后面追加少量乱序数据）、分段有序、逆序的输入
+    cout << "TIM 排序测试" << endl;
+    {
+        vector<Record> tim_records(big_n/4);
+        for (size_t i = 0; i < tim_records.size(); i++)
+            tim_records[i] = {static_cast<int>(Random(100)), to_string(i)};
+        vector<Record> merge_records(tim_records);
+        auto id_less = [](const Record &a, const Record &b) { return a.id < b.id; };
+        glib::Sort(tim_records.begin(), tim_records.end(), id_less, glib::SortOption::TIM);
+        glib::Sort(merge_records.begin(), merge_records.end(), id_less, glib::SortOption::MERGE);
+        bool stable = true;
+        for (size_t i = 0; i < tim_records.size(); i++) {
+            stable = stable && tim_records[i].name == merge_records[i].name;
+            if (i > 0 && tim_records[i - 1].id == tim_records[i].id)
+                stable = stable && stoul(tim_records[i - 1].name) < stoul(tim_records[i].name);
+        }
+        cout << (stable ? " stable ok" : " stable error!") << endl;
+
+        vector<vector<int64_t>> inputs(3);
+        for (size_t i = 0; i < big_n; i++) {
+            inputs[0].push_back(static_cast<int64_t>(i));                          // 有序日志
+            inputs[1].push_back(static_cast<int64_t>((i % 1000) * big_n + i));     // 1000 个有序段交错
+            inputs[2].push_back(static_cast<int64_t>(big_n - i) / 3);              // 逆序，有重复
+        }
+        for (size_t i = 0; i < big_n / 100; i++)                                   // 追加 1% 的乱序数据
+            inputs[0].push_back(static_cast<int64_t>(Random(static_cast<int>(big_n))));
+        for (auto &input: inputs) {
+            vector<int64_t> expected(input);
+            std::sort(expected.begin(), expected.end());
+            auto start = chrono::system_clock::now();
+            glib::Sort(input.begin(), input.end(), glib::SortOption::TIM);
+            chrono::duration<double> elapsed = chrono::system_clock::now() - start;
+            cout << " elaspsed_seconds: " << elapsed.count() << (input == expected ? " ok" : " tim sort error!") << endl;
+        }
+    }
+    cout << endl;
+
+    // 基数排序测试：有符号/无符号整数、浮点数（包含负数）、字符串，从小到大、从大到小，结果与 std::sort 对比
+    cout << "基数排序测试" << endl;
+    mt19937_64 engine(2019);
+    vector<int64_t> int64_input(big_n);
+    vector<uint64_t> id_input(big_n);
+    vector<double> double_input(big_n);
+    vector<float> float_input(big_n);
+    for (size_t i = 0; i < big_n; i++) {
+        int64_input[i]  = static_cast<int64_t>(engine());
+        id_input[i]     = engine() >> 24;                   // 高位都是 0 的 id，会跳过高位的几趟
+        double_input[i] = static_cast<double>(static_cast<int64_t>(engine() >> 11)) / (1 << 20)
+                        - static_cast<double>(1ll << 31);
+        float_input[i]  = static_cast<float>(double_input[i] / 1024);
+    }
+    double_input[0] = -0.0;
+    double_input[1] = 0.0;
+    auto check_radix = [](const char *name, bool ok) {
+        cout << " " << name << (ok ? " ok" : " radix sort error!") << endl;
+    };
+    {
+        vector<int64_t> radix(int64_input), expected(int64_input);
+        auto start = chrono::system_clock::now();
+        glib::Sort(radix.begin(), radix.end(), glib::SortOption::RADIX);
+        chrono::duration<double> radix_seconds = chrono::system_clock::now() - start;
+        start = chrono::system_clock::now();
+        glib::Sort(expected.begin(), expected.end(), glib::SortOption::INTRO);
+        chrono::duration<double> intro_seconds = chrono::system_clock::now() - start;
+        cout << " int64 radix: " << radix_seconds.count() << "s intro: " << intro_seconds.count() << "s" << endl;
+        check_radix("int64", radix == expected);
+    }
+    {
+        vector<uint64_t> radix(id_input), expected(id_input);
+        glib::Sort(radix.begin(), radix.end(), std::greater<uint64_t>(), glib::SortOption::RADIX);
+        std::sort(expected.begin(), expected.end(), std::greater<uint64_t>());
+        check_radix("uint64 greater", radix == expected);
+    }
+    {
+        vector<double> radix(double_input), expected(double_input);
+        glib::Sort(radix.begin(), radix.end(), glib::SortOption::RADIX);
+        std::sort(expected.begin(), expected.end());
+        check_radix("double", radix == expected);
+    }
+    {
+        vector<float> radix(float_input), expected(float_input);
+        glib::Sort(radix.begin(), radix.end(), std::greater<float>(), glib::SortOption::RADIX);
+        std::sort(expected.begin(), expected.end(), std::greater<float>());
+        check_radix("float greater", radix == expected);
+    }
+    {
+        vector<short> radix(big_n/10);
+        for (auto &value: radix)
+            value = static_cast<short>(engine());
+        vector<short> expected(radix);
+        glib::Sort(radix.begin(), radix.end(), glib::SortOption::RADIX);
+        std::sort(expected.begin(), expected.end());
+        check_radix("short", radix == expected);
+    }
+    {
+        // 字符串：随机长度、较长的公共前缀、空串、包含 '\0' 的字符串
+        vector<string> radix(big_n/10);
+        for (auto &str: radix) {
+            str = (engine() % 2) ? "common/prefix/" : "";
+            size_t length = engine() % 12;
+            for (size_t i = 0; i < length; i++)
+                str.push_back(static_cast<char>(engine() % 4 ? 'a' + engine() % 3 : engine() % 256));
+        }
+        deque<string> radix_deque(radix.begin(), radix.end());
+        vector<string> expected(radix);
+        glib::Sort(radix.begin(), radix.end(), glib::SortOption::RADIX);
+        std::sort(expected.begin(), expected.end());
+        check_radix("string", radix == expected);
+        glib::Sort(radix_deque.begin(), radix_deque.end(), std::greater<string>(), glib::SortOption::RADIX);
+        check_radix("string greater", std::equal(radix_deque.rbegin(), radix_deque.rend(), expected.begin()));
+    }
+    {
+        // 不支持的比较函数改用内省排序；数据范围大于个数时计数排序改用基数排序
+        vector<Record> radix_records(1000);
+        for (auto &record: radix_records)
+            record.id = static_cast<int>(engine() % 100);
+        glib::Sort(radix_records.begin(), radix_records.end(),
+                   [](const Record &a, const Record &b) { return a.id < b.id; }, glib::SortOption::RADIX);
+        check_radix("record fallback", std::is_sorted(radix_records.begin(), radix_records.end(),
+                   [](const Record &a, const Record &b) { return a.id < b.id; }));
+        vector<int> counting(1000);
+        for (auto &value: counting)
+            value = static_cast<int>(engine());
+        glib::Sort(counting, glib::SortOption::COUNTING);
+        check_radix("counting large range", std::is_sorted(counting.begin(), counting.end()));
+    }
+    cout << endl;
+
+    // 桶排序（样本排序）测试：均匀分布、倾斜分布（指数分布的延迟、聚集的时间戳）、大量重复、字符串
+    cout << "桶排序测试" << endl;
+    {
+        exponential_distribution<double> latency(1.0 / 300);
+        vector<vector<int64_t>> bucket_inputs(4, vector<int64_t>(big_n));
+        for (size_t i = 0; i < big_n; i++) {
+            bucket_inputs[0][i] = static_cast<int64_t>(engine());                          // 均匀分布
+            bucket_inputs[1][i] = static_cast<int64_t>(latency(engine) * 1000);           // 延迟（ns），指数分布
+            bucket_inputs[2][i] = 1546300800000ll + (engine() % 8 ? engine() % 1000 : engine() % 86400000); // 时间戳
+            bucket_inputs[3][i] = static_cast<int64_t>(engine() % 3);                     // 大量重复
+        }
+        for (auto &input: bucket_inputs) {
+            vector<int64_t> expected(input), parallel_input(input);
+            std::sort(expected.begin(), expected.end());
+            auto start = chrono::system_clock::now();
+            glib::Sort(input.begin(), input.end(), glib::SortOption::BUCKET);
+            chrono::duration<double> bucket_seconds = chrono::system_clock::now() - start;
+            glib::utils::ThreadPool pool(4);
+            glib::ParallelSort(parallel_input.begin(), parallel_input.end(), std::less<int64_t>(), pool,
+                               glib::SortOption::BUCKET);
+            cout << " elaspsed_seconds: " << bucket_seconds.count()
+                 << (input == expected && parallel_input == expected ? " ok" : " bucket sort error!") << endl;
+        }
+        vector<string> strings(big_n/10);
+        for (auto &str: strings)
+            str = to_string(engine() % 100000);
+        deque<string> bucket_strings(strings.begin(), strings.end());
+        std::sort(strings.begin(), strings.end(), std::greater<string>());
+        glib::Sort(bucket_strings.begin(), bucket_strings.end(), std::greater<string>(), glib::SortOption::BUCKET);
+        cout << " string" << (std::equal(strings.begin(), strings.end(), bucket_strings.begin())
+                              ? " ok" : " bucket sort error!") << endl;
     }
+    cout << endl;
 
     // 利用快速排序思路查找第 k 大元素
     vector<int> vev{1, 2, 3, 4, 5, 6, 6, 6};
     cout << "kth ---> value " << glib::FindKthBigElement(vev, 3) << endl;
 
-    // 验证，提示其他类型数据不能使用计数排序！
+    // 选择第 k 小元素、部分排序、Top-K
+    cout << "选择测试" << endl;
+    {
+        mt19937_64 engine(2019);
+        const size_t n = 200000;
+        vector<vector<int64_t>> inputs(5, vector<int64_t>(n));
+        for (size_t i = 0; i < n; i++) {
+            inputs[0][i] = static_cast<int64_t>(engine() % 1000000000); // 随机
+            inputs[1][i] = static_cast<int64_t>(i);                     // 有序
+            inputs[2][i] = static_cast<int64_t>(n - i);                 // 逆序
+            inputs[3][i] = static_cast<int64_t>(engine() % 4);          // 大量重复
+            inputs[4][i] = static_cast<int64_t>(i < n/2 ? i : n - i);   // 先升后降
+        }
+        bool select_ok = true;
+        for (const auto &input: inputs) {
+            vector<int64_t> expected(input);
+            std::sort(expected.begin(), expected.end());
+            for (size_t k: {size_t(0), n/100, n/2, n*99/100, n*999/1000, n-1}) {
+                vector<int64_t> data(input);
+                auto nth = glib::Select(data.begin(), data.end(), k);
+                select_ok = select_ok && *nth == expected[k] &&
+                            std::all_of(data.begin(), nth, [nth](int64_t x) { return x <= *nth; }) &&
+                            std::all_of(nth, data.end(), [nth](int64_t x) { return x >= *nth; });
+            }
+        }
+        cout << " select " << (select_ok ? "ok" : "error!") << endl;
+
+        // 有序输入：原来以最后一个元素为分界点时是 O(n^2)
+        vector<int> sorted_input(1000000);
+        for (size_t i = 0; i < sorted_input.size(); i++)
+            sorted_input[i] = static_cast<int>(i);
+        auto start = chrono::system_clock::now();
+        int kth_big = glib::FindKthBigElement(sorted_input, 10);
+        chrono::duration<double> elapsed = chrono::system_clock::now() - start;
+        cout << " kth big on sorted input: " << elapsed.count() << "s"
+             << (kth_big == 999990 ? " ok" : " error!") << endl;
+        cout << " kth big keeps input order"
+             << (std::is_sorted(sorted_input.begin(), sorted_input.end()) ? " ok" : " error!") << endl;
+
+        deque<string> strings;
+        for (size_t i = 0; i < 5000; i++)
+            strings.push_back(to_string(engine() % 100000));
+        vector<string> expected_strings(strings.begin(), strings.end());
+        std::sort(expected_strings.begin(), expected_strings.end(), std::greater<string>());
+        glib::PartialSort(strings.begin(), strings.begin() + 100, strings.end(), std::greater<string>());
+        cout << " partial sort " << (std::equal(strings.begin(), strings.begin() + 100, expected_strings.begin())
+                                     ? "ok" : "error!") << endl;
+
+        const vector<int64_t> &latency = inputs[0];
+        vector<int64_t> expected(latency);
+        std::sort(expected.begin(), expected.end(), std::greater<int64_t>());
+        vector<int64_t> top = glib::TopK(latency.begin(), latency.end(), 1000);
+        glib::StreamingTopK<int64_t> stream_a(1000), stream_b(1000);
+        stream_a.Push(latency.begin(), latency.begin() + n/3);
+        stream_b.Push(latency.begin() + n/3, latency.end());
+        stream_a.Merge(stream_b);
+        glib::utils::ThreadPool pool(4);
+        vector<int64_t> parallel_top = glib::ParallelTopK(latency.begin(), latency.end(), 1000,
+                                                          std::less<int64_t>(), pool);
+        bool top_ok = std::equal(top.begin(), top.end(), expected.begin()) && top == stream_a.Sorted() &&
+                      top == parallel_top && stream_a.Threshold() == expected[999];
+        cout << " top k " << (top_ok ? "ok" : "error!") << endl;
+
+        bool quantile_ok = true;
+        for (const auto &input: inputs) {
+            vector<int64_t> ascending(input);
+            std::sort(ascending.begin(), ascending.end());
+            for (size_t k: {size_t(0), n/2, n*99/100, n*999/1000, n-1})
+                quantile_ok = quantile_ok &&
+                              glib::ParallelSelect(input.begin(), input.end(), k, std::less<int64_t>(), pool) == ascending[k];
+        }
+        cout << " parallel select " << (quantile_ok ? "ok" : "error!") << endl;
+    }
+
+    // 其他类型数据不能使用计数排序，自动改用基数排序/内省排序
     vector<char> vec_char_counting = {'c', 'a'};
     glib::Sort(vec_char_counting, glib::SortOption::COUNTING);
+    if (!std::is_sorted(vec_char_counting.begin(), vec_char_counting.end()))
+        cout << "char counting sort error!" << endl;
 
     return 0;
 }
@@ -0,0 +1,460 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: sort_benchmark.cc
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/14
+ * Description: benchmark of all sort options over input distributions and element types
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#include "sort.hpp"
+#include "../utils/tic_toc.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <algorithm> // std::sort stable_sort is_sorted
+#include <fstream>
+#include <iostream>
+#include <new>       // bad_alloc
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! \brief 排序算法基准测试：所有 SortOption（以及 std::sort、std::stable_sort 作为对照），
+//!        在不同的输入分布、数据规模、元素类型下运行，输出 CSV 或者 JSON，方便不同版本之间对比
+//!     输入分布：random、sorted、reverse、organ_pipe（先升后降）、few_unique（16 种取值）、
+//!              zipf（s = 1）、nearly_sorted（有序数据中随机交换 1% 的元素）
+//!     元素类型：int32、int64、double、string（16 位十六进制字符串）、struct（40 字节记录，按 int64 键值比较）
+//!     指标：
+//!         1）ns_per_elem：多次运行取最短时间，除以元素个数。计时运行使用 std::less，与实际使用时走相同的代码路径
+//!         2）comparisons：单独运行一次，用计数的比较函数统计比较次数。计数比较函数不是 std::less，
+//!            基数排序、SIMD 分区等只识别 std::less 的路径会改用通用实现，此时 counts_exact 为 false，
+//!            统计的是通用实现的比较次数
+//!         3）moves：元素的拷贝、移动构造与赋值次数，只有 struct 类型统计（记录类型中计数），其他类型为空
+//!         4）allocations：计时运行中 operator new 的调用次数（替换了全局 operator new）
+//!     O(n^2) 的算法（BUBBLE、INSERTION、SELECTION）以及快速排序在有序、重复数据上（QUICK 以最后一个元素为分界点，
+//!     退化为 O(n^2) 并且递归深度为 O(n)）只运行到 kQuadraticMaxSize 个元素
+//! \run
+//!     g++ sort_benchmark.cc -std=c++11 -O2 -pthread -o sort_benchmark
+//!     ./sort_benchmark [--format=csv|json] [--output=文件] [--sizes=10,1000,100000] [--max-size=100000000]
+//!                      [--types=int32,string] [--distributions=random,zipf] [--options=INTRO,TIM,std::sort]
+//!                      [--repeat=5]
+//!     默认：所有类型、分布、选项，规模 10、100、...、10^6，CSV 输出到标准输出
+
+namespace {
+
+const size_t kQuadraticMaxSize  = 10000;   // O(n^2) 算法的最大规模
+const size_t kMinElementsPerRun = 1000000; // 规模较小时多次运行，每个规模累计排序的元素个数至少为该值
+const size_t kFewUniqueValues   = 16;
+const size_t kZipfUniverse      = 1000000; // Zipf 分布的取值个数（规模更小时为规模本身）
+
+//-----------------------------计数：内存分配、比较、移动-----------------------------------
+
+atomic<size_t> g_allocations(0);
+atomic<size_t> g_moves(0);
+bool           g_count_moves = false; // 只在统计移动次数的那次运行中打开
+
+} // namespace
+
+namespace {
+
+void* CountedMalloc(size_t size) {
+    g_allocations.fetch_add(1, memory_order_relaxed);
+    if (void *pointer = malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    return CountedMalloc(size);
+}
+
+void* operator new[](size_t size) {
+    return CountedMalloc(size);
+}
+
+// 不内联，否则编译器会把 new[] 与 free 配对，给出 -Wmismatched-new-delete 警告
+__attribute__((noinline)) void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+// C++14 起按大小释放的版本，也要替换，否则释放会绕过上面的版本
+__attribute__((noinline)) void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete[](void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+namespace {
+
+// 40 字节的记录，按照 key 比较，拷贝、移动时计数
+struct Record {
+    int64_t key;
+    int64_t id;
+    char    payload[24];
+
+    Record() : key(0), id(0) { memset(payload, 0, sizeof(payload)); }
+    Record(const Record &other) { Assign(other); }
+    Record& operator=(const Record &other) { Assign(other); return *this; }
+    // 成员都是平凡类型，移动与拷贝相同，这里只是为了分别计数时语义清楚
+    Record(Record &&other) { Assign(other); }
+    Record& operator=(Record &&other) { Assign(other); return *this; }
+
+    bool operator<(const Record &other) const { return key < other.key; }
+
+private:
+    void Assign(const Record &other) {
+        key = other.key;
+        id  = other.id;
+        memcpy(payload, other.payload, sizeof(payload));
+        if (g_count_moves)
+            g_moves.fetch_add(1, memory_order_relaxed);
+    }
+};
+
+// 统计比较次数的比较函数，并行排序中会在多个线程中同时调用
+template <typename _Scalar>
+struct CountingLess {
+    atomic<size_t> *count;
+
+    bool operator()(const _Scalar &a, const _Scalar &b) const {
+        count->fetch_add(1, memory_order_relaxed);
+        return a < b;
+    }
+};
+
+//-----------------------------输入数据生成-----------------------------------------------
+
+// 把 64 位键值转换为各种元素类型，保持键值的大小顺序
+template <typename _Scalar> _Scalar MakeValue(uint64_t key, size_t index);
+
+template <> int32_t MakeValue<int32_t>(uint64_t key, size_t) {
+    return static_cast<int32_t>(static_cast<int64_t>(key % (1ull << 32)) - (1ll << 31));
+}
+template <> int64_t MakeValue<int64_t>(uint64_t key, size_t) {
+    return static_cast<int64_t>(key ^ (1ull << 63));
+}
+template <> double MakeValue<double>(uint64_t key, size_t) { // 键值小于 2^53，转换是精确的，不会合并相邻键值
+    return static_cast<double>(static_cast<int64_t>(key) - (1ll << 31)) / 1024.0;
+}
+template <> string MakeValue<string>(uint64_t key, size_t) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(key));
+    return buffer;
+}
+template <> Record MakeValue<Record>(uint64_t key, size_t index) {
+    Record record;
+    record.key = static_cast<int64_t>(key ^ (1ull << 63));
+    record.id  = static_cast<int64_t>(index);
+    return record;
+}
+
+//! \brief 生成键值序列。键值范围都在 32 位以内，转换为 int32 时也不会改变顺序
+vector<uint64_t> MakeKeys(const string &distribution, size_t n, mt19937_64 &engine) {
+    vector<uint64_t> keys(n);
+    const uint64_t kMaxKey = (1ull << 32) - 1;
+    if ("random" == distribution) {
+        for (auto &key: keys) key = engine() & kMaxKey;
+    } else if ("sorted" == distribution) {
+        for (size_t i = 0; i < n; i++) keys[i] = i;
+    } else if ("reverse" == distribution) {
+        for (size_t i = 0; i < n; i++) keys[i] = n - i;
+    } else if ("organ_pipe" == distribution) {
+        for (size_t i = 0; i < n; i++) keys[i] = (i < n / 2) ? i : n - i;
+    } else if ("few_unique" == distribution) {
+        for (auto &key: keys) key = (engine() % kFewUniqueValues) * 1000;
+    } else if ("zipf" == distribution) {       // 第 r 个取值出现的概率与 1/r 成正比，逆变换采样
+        size_t universe = std::min(n, kZipfUniverse);
+        vector<double> cdf(universe);
+        double sum = 0;
+        for (size_t r = 0; r < universe; r++)
+            cdf[r] = (sum += 1.0 / (r + 1));
+        uniform_real_distribution<double> uniform(0, sum);
+        vector<uint64_t> value_of_rank(universe);    // 出现次数最多的取值不一定是最小的值
+        for (auto &value: value_of_rank) value = engine() & kMaxKey;
+        for (auto &key: keys) {
+            size_t rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(engine)) - cdf.begin();
+            key = value_of_rank[std::min(rank, universe - 1)];
+        }
+    } else if ("nearly_sorted" == distribution) {
+        for (size_t i = 0; i < n; i++) keys[i] = i;
+        for (size_t i = 0; i < n / 100; i++)
+            std::swap(keys[engine() % n], keys[engine() % n]);
+    } else {
+        cerr << "unknown distribution: " << distribution << endl;
+        exit(1);
+    }
+    return keys;
+}
+
+//-----------------------------被测排序-----------------------------------------------
+
+struct SortEntry {
+    const char        *name;
+    glib::SortOption   option;
+    int                baseline; // 0：glib::Sort，1：std::sort，2：std::stable_sort
+};
+
+const SortEntry kEntries[] = {
+    {"BUBBLE",          glib::SortOption::BUBBLE,         0},
+    {"INSERTION",       glib::SortOption::INSERTION,      0},
+    {"SELECTION",       glib::SortOption::SELECTION,      0},
+    {"MERGE",           glib::SortOption::MERGE,          0},
+    {"QUICK",           glib::SortOption::QUICK,          0},
+    {"INTRO",           glib::SortOption::INTRO,          0},
+    {"COUNTING",        glib::SortOption::COUNTING,       0},
+    {"RADIX",           glib::SortOption::RADIX,          0},
+    {"BUCKET",          glib::SortOption::BUCKET,         0},
+    {"PARALLEL_MERGE",  glib::SortOption::PARALLEL_MERGE, 0},
+    {"PARALLEL_QUICK",  glib::SortOption::PARALLEL_QUICK, 0},
+    {"TIM",             glib::SortOption::TIM,            0},
+    {"std::sort",        glib::SortOption::INTRO,         1},
+    {"std::stable_sort", glib::SortOption::INTRO,         2},
+};
+
+template <typename _RandomIt, typename _Compare>
+void RunSort(const SortEntry &entry, _RandomIt first, _RandomIt last, _Compare comp) {
+    switch (entry.baseline) {
+        case 1:  std::sort(first, last, comp);                break;
+        case 2:  std::stable_sort(first, last, comp);         break;
+        default: glib::Sort(first, last, comp, entry.option); break;
+    }
+}
+
+// 时间复杂度为 O(n^2) 的情况：规模超过 kQuadraticMaxSize 时不运行，小规模时也只排序一份数据
+bool IsQuadratic(const SortEntry &entry, const string &distribution) {
+    if (0 != entry.baseline)
+        return false;
+    switch (entry.option) {
+        case glib::SortOption::BUBBLE:
+        case glib::SortOption::INSERTION:
+        case glib::SortOption::SELECTION:
+            return true;
+        case glib::SortOption::QUICK:
+            return "random" != distribution && "zipf" != distribution;
+        default:
+            return false;
+    }
+}
+
+//! \brief 计数比较函数是否与 std::less 走相同的代码路径（见文件开头的说明）
+template <typename _Scalar>
+bool CountsExact(const SortEntry &entry) {
+    using Iterator = typename vector<_Scalar>::iterator;
+    if (0 != entry.baseline)
+        return true;
+    bool radix = glib::sort_internal::RadixTraits<_Scalar, std::less<_Scalar>>::kKind !=
+                 glib::sort_internal::RadixKind::UNSUPPORTED;
+    bool simd  = glib::sort_internal::UseSimdSort<Iterator, std::less<_Scalar>>::value;
+    switch (entry.option) {
+        case glib::SortOption::COUNTING:
+        case glib::SortOption::RADIX:
+        case glib::SortOption::BUCKET:         return !radix;
+        case glib::SortOption::QUICK:
+        case glib::SortOption::INTRO:
+        case glib::SortOption::PARALLEL_QUICK: return !simd;
+        default:                               return true;
+    }
+}
+
+//-----------------------------结果输出-----------------------------------------------
+
+struct Result {
+    string type, distribution, option;
+    size_t n;
+    double ns_per_elem;
+    size_t comparisons;
+    long long moves;       // -1 表示没有统计
+    size_t allocations;
+    bool   counts_exact;
+    bool   sorted;
+};
+
+class Reporter {
+public:
+    Reporter(ostream &out, bool json) : out_(out), json_(json), count_(0) {
+        if (json_)
+            out_ << "[" << endl;
+        else
+            out_ << "type,distribution,n,option,ns_per_elem,comparisons,moves,allocations,counts_exact,sorted" << endl;
+    }
+
+    ~Reporter() {
+        if (json_)
+            out_ << endl << "]" << endl;
+    }
+
+    void Add(const Result &result) {
+        char ns[32];
+        snprintf(ns, sizeof(ns), "%.3f", result.ns_per_elem);
+        string moves = result.moves < 0 ? (json_ ? "null" : "") : to_string(result.moves);
+        if (json_) {
+            out_ << (count_ > 0 ? ",\n" : "")
+                 << "  {\"type\": \"" << result.type << "\", \"distribution\": \"" << result.distribution
+                 << "\", \"n\": " << result.n << ", \"option\": \"" << result.option
+                 << "\", \"ns_per_elem\": " << ns << ", \"comparisons\": " << result.comparisons
+                 << ", \"moves\": " << moves << ", \"allocations\": " << result.allocations
+                 << ", \"counts_exact\": " << (result.counts_exact ? "true" : "false")
+                 << ", \"sorted\": " << (result.sorted ? "true" : "false") << "}";
+        } else {
+            out_ << result.type << "," << result.distribution << "," << result.n << "," << result.option << ","
+                 << ns << "," << result.comparisons << "," << moves << "," << result.allocations << ","
+                 << (result.counts_exact ? "true" : "false") << "," << (result.sorted ? "true" : "false") << endl;
+        }
+        out_.flush();
+        ++count_;
+    }
+
+private:
+    ostream &out_;
+    bool     json_;
+    size_t   count_;
+};
+
+//-----------------------------运行-----------------------------------------------
+
+struct Config {
+    vector<size_t> sizes;
+    vector<string> types;
+    vector<string> distributions;
+    vector<string> options;
+    size_t         repeat;
+};
+
+template <typename _Container>
+bool Contains(const _Container &values, const string &value) {
+    return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+template <typename _Scalar>
+void RunType(const string &type, const Config &config, Reporter &reporter) {
+    if (!Contains(config.types, type))
+        return;
+    for (const auto &distribution: config.distributions) {
+        for (size_t n: config.sizes) {
+            mt19937_64 engine(n);
+            vector<uint64_t> keys = MakeKeys(distribution, n, engine);
+            vector<_Scalar> input;
+            input.reserve(n);
+            for (size_t i = 0; i < n; i++)
+                input.push_back(MakeValue<_Scalar>(keys[i], i));
+            keys = vector<uint64_t>();
+
+            // 小规模时一次计时排序多份数据，减少计时误差
+            size_t batch_copies = std::max<size_t>(1, std::min<size_t>(1000, kMinElementsPerRun / std::max<size_t>(n, 1)));
+            for (const auto &entry: kEntries) {
+                bool quadratic = IsQuadratic(entry, distribution);
+                if (!Contains(config.options, entry.name) || (quadratic && n > kQuadraticMaxSize))
+                    continue;
+                size_t copies = quadratic ? 1 : batch_copies;
+                Result result = {type, distribution, entry.name, n, 0, 0, -1, 0, CountsExact<_Scalar>(entry), true};
+
+                // 1）计时
+                double best = 0;
+                for (size_t r = 0; r < config.repeat; r++) {
+                    vector<vector<_Scalar>> data(copies, input);
+                    size_t allocations = g_allocations.load();
+                    TicToc timer;
+                    for (auto &copy: data)
+                        RunSort(entry, copy.begin(), copy.end(), std::less<_Scalar>());
+                    double elapsed = timer.toc();
+                    allocations = g_allocations.load() - allocations;
+                    for (auto &copy: data)
+                        result.sorted = result.sorted && std::is_sorted(copy.begin(), copy.end());
+                    if (0 == r || elapsed < best) {
+                        best = elapsed;
+                        result.allocations = allocations / copies;
+                    }
+                }
+                result.ns_per_elem = (n > 0) ? best * 1e6 / (static_cast<double>(n) * copies) : 0;
+
+                // 2）比较次数、移动次数
+                vector<_Scalar> data(input);
+                atomic<size_t> comparisons(0);
+                CountingLess<_Scalar> counting_less = {&comparisons};
+                g_moves = 0;
+                g_count_moves = true;
+                RunSort(entry, data.begin(), data.end(), counting_less);
+                g_count_moves = false;
+                result.comparisons = comparisons.load();
+                if (std::is_same<_Scalar, Record>::value)
+                    result.moves = static_cast<long long>(g_moves.load());
+                reporter.Add(result);
+            }
+        }
+    }
+}
+
+vector<string> Split(const string &text) {
+    vector<string> items;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+    Config config;
+    config.types         = {"int32", "int64", "double", "string", "struct"};
+    config.distributions = {"random", "sorted", "reverse", "organ_pipe", "few_unique", "zipf", "nearly_sorted"};
+    for (const auto &entry: kEntries)
+        config.options.push_back(entry.name);
+    config.repeat = 3;
+    size_t max_size = 1000000;
+    bool   sizes_given = false;
+    string format = "csv", output;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        size_t equal = arg.find('=');
+        string key   = arg.substr(0, equal);
+        string value = (equal == string::npos) ? "" : arg.substr(equal + 1);
+        if ("--format" == key)             format = value;
+        else if ("--output" == key)        output = value;
+        else if ("--types" == key)         config.types = Split(value);
+        else if ("--distributions" == key) config.distributions = Split(value);
+        else if ("--options" == key)       config.options = Split(value);
+        else if ("--repeat" == key)        config.repeat = std::max<size_t>(1, strtoul(value.c_str(), nullptr, 10));
+        else if ("--max-size" == key)      max_size = strtoull(value.c_str(), nullptr, 10);
+        else if ("--sizes" == key) {
+            sizes_given = true;
+            for (const auto &size: Split(value))
+                config.sizes.push_back(strtoull(size.c_str(), nullptr, 10));
+        } else {
+            cerr << "unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+    if (!sizes_given)
+        for (size_t n = 10; n <= max_size; n *= 10)
+            config.sizes.push_back(n);
+
+    ofstream file;
+    if (!output.empty())
+        file.open(output);
+    Reporter reporter(output.empty() ? cout : file, "json" == format);
+    RunType<int32_t>("int32", config, reporter);
+    RunType<int64_t>("int64", config, reporter);
+    RunType<double>("double", config, reporter);
+    RunType<string>("string", config, reporter);
+    RunType<Record>("struct", config, reporter);
+    return 0;
+}
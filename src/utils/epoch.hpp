@@ -0,0 +1,248 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: epoch.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/18
+ * Description: epoch based memory reclamation for lock-free data structures
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_EPOCH_HPP_
+#define GLIB_EPOCH_HPP_
+
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t uintptr_t
+#include <atomic>
+#include <new>         // operator new、placement new
+#include <vector>
+#include "../internal/macros.h"
+
+//! \brief 基于纪元（epoch）的内存回收：无锁数据结构中摘除的节点不能立即释放，
+//!        因为其他线程可能还在读它，等所有可能读到它的线程都离开之后再释放
+//!     外部调用核心函数：
+//!         1）进入、离开临界区：EpochGuard（RAII），访问无锁数据结构之前构造
+//!         2）延迟释放：EpochDomain::Retire()，摘除节点之后调用
+//!         3）尝试推进纪元并释放安全的对象：EpochDomain::Collect()
+//!     外部调用状态函数：
+//!         1）当前线程还没有释放的对象个数：pending()，全局纪元：epoch()
+//!
+//! \Note
+//!     1）全局纪元 global 单调递增。线程进入临界区时把 global 记录到自己的槽中，离开时标记为不活跃。
+//!        所有活跃线程的纪元都等于 global 时，global 才能加一
+//!     2）在纪元 e 摘除并 Retire() 的对象，global >= e + 2 时一定没有线程还能读到它：
+//!        能读到它的线程进入临界区时的纪元 <= e，global 要推进两次，这些线程都必须离开
+//!     3）读者只写自己的线程槽（按缓存行对齐，不和其他线程共享缓存行），不加锁、不等待，
+//!        也不写任何共享的缓存行。线程第一次进入时注册线程槽，线程退出后槽被后来的线程复用
+//!     4）每个线程在自己的槽中保存待释放列表，超过 kCollectThreshold 个时尝试推进纪元并释放，
+//!        不需要后台线程。线程退出时没能释放的对象留在槽中，由复用该槽的线程或者进程退出时释放
+//!     5）临界区可以嵌套，只有最外层的 EpochGuard 会修改线程槽。临界区内不能阻塞太久，
+//!        否则纪元无法推进，待释放的内存会一直增长
+//!     6）整个进程共享一个 EpochDomain::Instance()，进程退出时释放所有剩下的对象
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \reference
+//!     1）Keir Fraser, Practical lock-freedom, 2004（epoch based reclamation）
+//!     2）Hart et al., Performance of memory reclamation for lockless synchronization, 2007
+//!
+//! \example
+//!     {
+//!         glib::utils::EpochGuard guard;
+//!         Node *node = Unlink(list);              // 摘除节点
+//!         glib::utils::EpochDomain::Instance().Retire(node);
+//!     }
+
+namespace glib {
+namespace utils {
+
+class EpochDomain {
+public: // 外部调用核心函数
+    //! \brief 进程内唯一的纪元域，第一次调用时创建
+    static EpochDomain& Instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    //! \brief 延迟释放 object：等所有可能读到它的线程都离开临界区之后 delete
+    //! \note object 必须已经从数据结构中摘除，之后进入临界区的线程不可能再读到它
+    template <typename _Tp>
+    void Retire(_Tp *object) {
+        Retire(object, &DeleteObject<_Tp>);
+    }
+    void Retire(void *object, void (*deleter)(void*)) {
+        ThreadRecord *record = CurrentRecord();
+        record->retired.push_back(RetiredObject{object, deleter, global_epoch_.load(std::memory_order_seq_cst)});
+        if (record->retired.size() >= kCollectThreshold)
+            Collect(record);
+    }
+
+    //! \brief 尝试推进全局纪元，然后释放当前线程中已经安全的对象
+    void Collect() { Collect(CurrentRecord()); }
+
+    // 当前线程还没有释放的对象个数
+    size_t   pending() const { return CurrentRecord()->retired.size();                   }
+    // 全局纪元
+    uint64_t epoch()   const { return global_epoch_.load(std::memory_order_relaxed);     }
+
+private: // 类型声明
+    friend class EpochGuard;
+
+    struct RetiredObject {
+        void     *object;
+        void    (*deleter)(void*);
+        uint64_t  epoch;           // Retire() 时的全局纪元
+    };
+
+    // 线程槽：按缓存行对齐，只有所属线程会写 epoch，其他线程推进纪元时只读
+    struct ThreadRecord {
+        std::atomic<uint64_t>      epoch;    // 进入临界区时的全局纪元，不活跃时为 kInactive
+        std::atomic<bool>          in_use;   // 是否属于某个线程
+        ThreadRecord              *next;     // 所有线程槽组成的链表，只增不减
+        void                      *buffer;   // 对齐之前的原始内存
+        size_t                     nesting;  // 临界区嵌套层数，只有所属线程访问
+        std::vector<RetiredObject> retired;  // 待释放的对象，只有所属线程访问
+    };
+
+    // 线程退出时归还线程槽
+    struct ThreadHandle {
+        ThreadRecord *record = nullptr;
+        ~ThreadHandle() {
+            if (nullptr == record)
+                return;
+            Instance().Collect(record);
+            record->in_use.store(false, std::memory_order_release);
+        }
+    };
+
+private: // 构造函数相关
+    EpochDomain() : global_epoch_(0), records_(nullptr) {}
+
+    ~EpochDomain() {
+        ThreadRecord *record = records_.load(std::memory_order_acquire);
+        while (nullptr != record) {
+            for (auto &retired: record->retired)
+                retired.deleter(retired.object);
+            ThreadRecord *next = record->next;
+            void *buffer = record->buffer;
+            record->~ThreadRecord();
+            ::operator delete(buffer);
+            record = next;
+        }
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(EpochDomain);
+
+private: // helper functions
+    template <typename _Tp>
+    static void DeleteObject(void *object) { delete static_cast<_Tp*>(object); }
+
+    //! \brief 当前线程的线程槽：先复用已经退出的线程留下的槽，没有时新建一个加入链表
+    ThreadRecord* CurrentRecord() const {
+        static thread_local ThreadHandle handle;
+        if (nullptr != handle.record)
+            return handle.record;
+        EpochDomain *domain = const_cast<EpochDomain*>(this);
+        for (ThreadRecord *record = records_.load(std::memory_order_acquire); nullptr != record;
+             record = record->next) {
+            bool expected = false;
+            if (!record->in_use.load(std::memory_order_relaxed) &&
+                record->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire,
+                                                       std::memory_order_relaxed)) {
+                handle.record = record;
+                return record;
+            }
+        }
+        handle.record = domain->NewRecord();
+        return handle.record;
+    }
+
+    //! \brief 新建一个按缓存行对齐的线程槽（C++17 之前 new 不保证超过 16 字节的对齐），加入链表头部
+    ThreadRecord* NewRecord() {
+        void *buffer = ::operator new(kRecordBytes + kCacheLineSize);
+        uintptr_t address = (reinterpret_cast<uintptr_t>(buffer) + kCacheLineSize - 1) &
+                            ~static_cast<uintptr_t>(kCacheLineSize - 1);
+        ThreadRecord *record = new (reinterpret_cast<void*>(address)) ThreadRecord;
+        record->epoch.store(kInactive, std::memory_order_relaxed);
+        record->in_use.store(true, std::memory_order_relaxed);
+        record->buffer  = buffer;
+        record->nesting = 0;
+        ThreadRecord *head = records_.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!records_.compare_exchange_weak(head, record, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+        return record;
+    }
+
+    //! \brief 所有活跃线程都已经看到当前的全局纪元时，把全局纪元加一
+    //! \note 只读其他线程的槽，不会等待
+    bool TryAdvance() {
+        uint64_t global = global_epoch_.load(std::memory_order_seq_cst);
+        for (ThreadRecord *record = records_.load(std::memory_order_acquire); nullptr != record;
+             record = record->next) {
+            uint64_t local = record->epoch.load(std::memory_order_seq_cst);
+            if (kInactive != local && global != local)
+                return false;
+        }
+        return global_epoch_.compare_exchange_strong(global, global + 1, std::memory_order_seq_cst);
+    }
+
+    //! \brief 推进纪元，释放 record 中 Retire() 之后全局纪元已经推进了至少两次的对象
+    void Collect(ThreadRecord *record) {
+        TryAdvance();
+        uint64_t global = global_epoch_.load(std::memory_order_seq_cst);
+        std::vector<RetiredObject> &retired = record->retired;
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); i++) {
+            if (retired[i].epoch + 2 <= global)
+                retired[i].deleter(retired[i].object);
+            else
+                retired[kept++] = retired[i];
+        }
+        retired.resize(kept);
+    }
+
+    // 进入、离开临界区，由 EpochGuard 调用
+    void Enter() {
+        ThreadRecord *record = CurrentRecord();
+        if (0 == record->nesting++) {
+            // 先公开自己的纪元，再读数据结构：seq_cst 的读-改-写保证之后的读不会重排到它前面
+            // （不用 atomic_thread_fence，ThreadSanitizer 不支持独立的内存屏障）
+            record->epoch.exchange(global_epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+    }
+
+    void Leave() {
+        ThreadRecord *record = CurrentRecord();
+        if (0 == --record->nesting)
+            record->epoch.store(kInactive, std::memory_order_release);
+    }
+
+private:
+    static const size_t   kCacheLineSize    = 64;
+    static const size_t   kCollectThreshold = 128;        // 每个线程待释放对象达到这个数量时尝试回收
+    static const uint64_t kInactive         = ~uint64_t(0);
+    // 线程槽占用的字节数，向上取整到缓存行，相邻的槽不会共享缓存行
+    static const size_t   kRecordBytes      = (sizeof(ThreadRecord) + kCacheLineSize - 1) /
+                                              kCacheLineSize * kCacheLineSize;
+
+    std::atomic<uint64_t>      global_epoch_;  // 全局纪元
+    std::atomic<ThreadRecord*> records_;       // 所有线程槽
+}; // class EpochDomain
+
+//! \brief 临界区：构造时进入，析构时离开。临界区内读到的无锁数据结构中的节点都不会被释放
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::Instance().Enter(); }
+    ~EpochGuard() { EpochDomain::Instance().Leave(); }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(EpochGuard);
+};
+
+} // namespace utils
+} // namespace glib
+
+#endif // GLIB_EPOCH_HPP_
@@ -0,0 +1,271 @@
+/*
+ * CopyRight (c) 2019 gcj
+ * File: thread_pool.hpp
+ * Project: algorithm
+ * Author: gcj
+ * Date: 2019/9/2
+ * Description: work-stealing thread pool and fork-join task group
+ * License: see the LICENSE.txt file
+ * github: https://github.com/saber/algorithm
+ */
+
+#ifndef GLIB_THREAD_POOL_HPP_
+#define GLIB_THREAD_POOL_HPP_
+
+#include <cstddef>            // size_t
+#include <atomic>
+#include <deque>
+#include <exception>          // exception_ptr
+#include <functional>         // std::function
+#include <memory>             // unique_ptr
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>            // std::move
+#include <vector>
+#include "../internal/macros.h"
+
+//! \brief 一个简单的任务窃取（work-stealing）线程池，以及配套的 fork-join 任务组
+//!     外部调用核心函数：
+//!         1）提交任务：ThreadPool::Submit()
+//!         2）在当前线程执行一个待处理任务：ThreadPool::RunPendingTask()
+//!         3）全局共享线程池：ThreadPool::Default()
+//!         4）任务组提交任务、等待任务组完成：TaskGroup::Run()、TaskGroup::Wait()
+//!     外部调用状态函数：
+//!         1）线程池并发度：size()
+//!
+//! \Note
+//!     1）每个工作线程有一个自己的任务队列。工作线程提交的任务放到自己队列的尾部，自己从尾部取（LIFO，
+//!        刚分出来的子任务数据还在缓存中），空闲线程从别的队列头部窃取（FIFO，窃取到的一般是较大的任务）
+//!     2）并发度 num_threads 包含了调用线程：TaskGroup::Wait() 等待时，调用线程也会执行任务，
+//!        所以内部只创建 num_threads - 1 个工作线程。num_threads = 1 时所有任务都在调用线程执行
+//!     3）任务队列用互斥锁保护，没有实现 Chase-Lev 无锁双端队列。排序等场景下任务粒度都比较大，
+//!        锁的开销可以忽略
+//!     4）任务中抛出的异常会被 TaskGroup 捕获，在 Wait() 中重新抛出
+//!
+//! \platform
+//!     ubuntu16.04 g++ version 5.4.0
+//!
+//! \example
+//!     glib::utils::TaskGroup group(glib::utils::ThreadPool::Default());
+//!     group.Run([&] { SortLeft(); });
+//!     SortRight();
+//!     group.Wait();
+
+namespace glib {
+namespace utils {
+
+class ThreadPool {
+public: // 类型声明
+    using Task = std::function<void()>;
+
+public: // 构造函数相关
+    //! \param num_threads 并发度（包含调用线程），0 表示使用硬件线程数
+    explicit
+    ThreadPool(size_t num_threads = 0) : stop_(false), pending_(0), next_queue_(0) {
+        if (0 == num_threads)
+            num_threads = HardwareConcurrency();
+        num_threads_ = num_threads;
+        // 队列个数至少为 1，外部线程提交的任务也需要放到某个队列中
+        size_t num_queues = (num_threads_ > 1) ? num_threads_ - 1 : 1;
+        for (size_t i = 0; i < num_queues; i++)
+            queues_.emplace_back(new WorkQueue);
+        for (size_t i = 0; i + 1 < num_threads_; i++)
+            workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto &worker: workers_)
+            worker.join();
+    }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(ThreadPool);
+
+public: // 外部调用核心函数
+    //! \brief 提交一个任务
+    //! \note 工作线程提交的任务放到自己的队列中，外部线程提交的任务轮流放到各个队列中
+    //! \complexity O(1)
+    void Submit(Task task) {
+        WorkerIdentity &identity = CurrentWorker();
+        size_t index = (identity.pool == this)
+                     ? identity.index
+                     : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        pending_.fetch_add(1, std::memory_order_release);
+        {
+            // 加锁后再通知，防止工作线程检查完 pending_ 之后、睡眠之前错过通知
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        sleep_cv_.notify_one();
+    }
+
+    //! \brief 在当前线程执行一个待处理的任务：先取自己队列的尾部，再从其他队列的头部窃取
+    //! \return 是否执行了任务
+    bool RunPendingTask() {
+        Task task;
+        if (!PopTask(task))
+            return false;
+        task();
+        return true;
+    }
+
+    //! \brief 全局共享的线程池，并发度为硬件线程数，第一次调用时创建
+    static ThreadPool& Default() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // 硬件线程数，获取不到时返回 1
+    static size_t HardwareConcurrency() {
+        size_t hardware_threads = std::thread::hardware_concurrency();
+        return (hardware_threads > 0) ? hardware_threads : 1;
+    }
+
+    size_t size() const { return num_threads_; } // 线程池并发度（包含调用线程）
+
+private: // 类型声明
+    // 每个工作线程的任务队列，每个队列单独分配内存，减少不同队列的锁之间伪共享
+    struct WorkQueue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    // 记录当前线程属于哪个线程池以及在其中的编号
+    struct WorkerIdentity {
+        ThreadPool *pool;
+        size_t      index;
+    };
+
+private: // helper functions
+    static WorkerIdentity& CurrentWorker() {
+        static thread_local WorkerIdentity identity = {nullptr, 0};
+        return identity;
+    }
+
+    // 工作线程主循环：有任务就执行，没有任务就睡眠，线程池析构时把剩下的任务执行完再退出
+    void WorkerLoop(size_t index) {
+        CurrentWorker().pool  = this;
+        CurrentWorker().index = index;
+        while (true) {
+            if (RunPendingTask())
+                continue;
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.wait(lock, [this] {
+                return stop_ || pending_.load(std::memory_order_acquire) > 0;
+            });
+            if (stop_ && 0 == pending_.load(std::memory_order_acquire))
+                return;
+        }
+    }
+
+    //! \brief 取出一个任务：自己的队列从尾部取，其他队列从头部窃取
+    bool PopTask(Task &task) {
+        if (0 == pending_.load(std::memory_order_acquire))
+            return false;
+        WorkerIdentity &identity = CurrentWorker();
+        size_t num_queues = queues_.size();
+        size_t start = 0;
+        if (identity.pool == this) {
+            WorkQueue &own = *queues_[identity.index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            start = identity.index + 1;
+        }
+        for (size_t i = 0; i < num_queues; i++) {
+            WorkQueue &victim = *queues_[(start + i) % num_queues];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    size_t                                  num_threads_; // 并发度，包含调用线程
+    std::vector<std::unique_ptr<WorkQueue>> queues_;      // 每个工作线程一个任务队列
+    std::vector<std::thread>                workers_;     // 工作线程
+    std::mutex                              sleep_mutex_; // 空闲线程睡眠用
+    std::condition_variable                 sleep_cv_;
+    bool                                    stop_;        // 线程池是否正在析构，由 sleep_mutex_ 保护
+    std::atomic<size_t>                     pending_;     // 所有队列中待执行任务的数量
+    std::atomic<size_t>                     next_queue_;  // 外部线程提交任务时轮流选择的队列
+}; // class ThreadPool
+
+//! \brief fork-join 任务组：Run() 派生任务，Wait() 等待本组所有任务（包括任务中继续派生的任务）完成
+//! \note Wait() 不会阻塞睡眠，而是在等待期间帮助线程池执行任务，所以在任务内部嵌套使用也不会死锁
+class TaskGroup {
+public: // 构造函数相关
+    explicit
+    TaskGroup(ThreadPool &pool) : pool_(pool), unfinished_(0) {}
+
+    ~TaskGroup() { WaitUnfinished(); }
+
+    GLIB_DISALLOW_COPY_AND_ASSIGN_PUBLIC(TaskGroup);
+
+public: // 外部调用核心函数
+    //! \brief 派生一个任务，任务可以在任意线程中执行
+    template <typename _Function>
+    void Run(_Function function) {
+        unfinished_.fetch_add(1, std::memory_order_relaxed);
+        pool_.Submit([this, function]() {
+            try {
+                function();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exception_mutex_);
+                if (!exception_)
+                    exception_ = std::current_exception();
+            }
+            unfinished_.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    //! \brief 等待任务组中所有任务完成，如果有任务抛出了异常，在这里重新抛出第一个异常
+    void Wait() {
+        WaitUnfinished();
+        std::exception_ptr exception;
+        {
+            std::lock_guard<std::mutex> lock(exception_mutex_);
+            exception.swap(exception_);
+        }
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    ThreadPool& pool() const { return pool_; } // 任务组所在的线程池
+
+private: // helper functions
+    void WaitUnfinished() {
+        while (unfinished_.load(std::memory_order_acquire) > 0) {
+            if (!pool_.RunPendingTask())
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    ThreadPool&         pool_;
+    std::atomic<size_t> unfinished_;      // 还没有执行完的任务个数
+    std::mutex          exception_mutex_;
+    std::exception_ptr  exception_;       // 任务中抛出的第一个异常
+}; // class TaskGroup
+
+} // namespace utils
+} // namespace glib
+
+#endif // GLIB_THREAD_POOL_HPP_